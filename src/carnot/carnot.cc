@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -30,6 +31,7 @@
 #include "src/carnot/plan/plan.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
+#include "src/carnot/plan_cache.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/perf/perf.h"
 #include "src/shared/types/type_utils.h"
@@ -60,6 +62,11 @@ class CarnotImpl final : public Carnot {
 
   Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze) override;
 
+  StatusOr<std::unique_ptr<StandingQuery>> CreateStandingQuery(
+      const planpb::Plan& plan, const sole::uuid& query_id) override {
+    return StandingQuery::Create(plan, query_id, engine_state_.get(), GetMetadataState());
+  }
+
   void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) override {
     agent_md_callback_ = func;
   };
@@ -69,10 +76,6 @@ class CarnotImpl final : public Carnot {
   EngineState* GetEngineState() override { return engine_state_.get(); }
 
  private:
-  Status RegisterUDFs(exec::ExecState* exec_state, plan::Plan* plan);
-
-  Status RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan::PlanFragment* pf);
-  Status WalkExpression(exec::ExecState* exec_state, const plan::ScalarExpression& expr);
   /**
    * Returns the Table Store.
    */
@@ -92,6 +95,7 @@ class CarnotImpl final : public Carnot {
   AgentMetadataCallbackFunc agent_md_callback_;
   planner::compiler::Compiler compiler_;
   std::unique_ptr<EngineState> engine_state_;
+  std::unique_ptr<PlanCache> plan_cache_;
 
   std::unique_ptr<std::thread> grpc_server_thread_;
   std::unique_ptr<grpc::Server> grpc_server_;
@@ -118,6 +122,7 @@ Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registr
                                                  clients_config_->stub_generator,
                                                  clients_config_->add_auth_to_grpc_context_func,
                                                  &server_config_->grpc_router));
+  plan_cache_ = std::make_unique<PlanCache>(std::max(FLAGS_carnot_plan_cache_size, 0));
   return Status::OK();
 }
 
@@ -138,52 +143,6 @@ Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& quer
   return ExecutePlan(plan_proto, query_id, analyze);
 }
 
-/**
- * @brief LogicalPlanUDFRegister takes in an exec_state and a plan, finds all of the
- * UDF/UDA definitions and then tracks them with the ids provided by the Logical Plan.
- *
- * This assumes that the logical plan has valid ids for each udf/uda and that ids
- * aren't shared by non-matching RegistryKeys.
- */
-
-Status CarnotImpl::RegisterUDFs(exec::ExecState* exec_state, plan::Plan* plan) {
-  return plan::PlanWalker()
-      .OnPlanFragment(std::bind(&CarnotImpl::RegisterUDFsInPlanFragment, this, exec_state,
-                                std::placeholders::_1))
-      .Walk(plan);
-}
-
-Status CarnotImpl::RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan::PlanFragment* pf) {
-  auto no_op = [&](const auto&) { return Status::OK(); };
-  return plan::PlanFragmentWalker()
-      .OnMap([&](const plan::MapOperator& map) {
-        for (const auto& expr : map.expressions()) {
-          PX_RETURN_IF_ERROR(WalkExpression(exec_state, *expr));
-        }
-        return Status::OK();
-      })
-      .OnAggregate([&](const plan::AggregateOperator& agg) {
-        for (const auto& expr : agg.values()) {
-          PX_RETURN_IF_ERROR(WalkExpression(exec_state, *expr));
-        }
-        return Status::OK();
-      })
-      .OnFilter([&](const plan::FilterOperator& filter) {
-        return WalkExpression(exec_state, *filter.expression());
-      })
-      .OnLimit(no_op)
-      .OnMemorySink(no_op)
-      .OnMemorySource(no_op)
-      .OnUnion(no_op)
-      .OnJoin(no_op)
-      .OnGRPCSource(no_op)
-      .OnGRPCSink(no_op)
-      .OnUDTFSource(no_op)
-      .OnEmptySource(no_op)
-      .OnOTelSink(no_op)
-      .Walk(pf);
-}
-
 absl::flat_hash_map<std::string, carnotpb::ResultSinkService::StubInterface*> GetOutgoingConns(
     exec::ExecState* exec_state, const planpb::Plan& plan) {
   absl::flat_hash_map<std::string, carnotpb::ResultSinkService::StubInterface*> outgoing_conns;
@@ -194,31 +153,6 @@ absl::flat_hash_map<std::string, carnotpb::ResultSinkService::StubInterface*> Ge
   return outgoing_conns;
 }
 
-Status CarnotImpl::WalkExpression(exec::ExecState* exec_state, const plan::ScalarExpression& expr) {
-  StatusOr<bool> walk_result =
-      plan::ExpressionWalker<bool>()
-          .OnAggregateExpression([&](const plan::AggregateExpression& func, std::vector<bool>) {
-            CHECK_EQ(func.registry_arg_types().size(),
-                     func.init_arguments().size() + func.arg_deps().size());
-            Status s = exec_state->AddUDA(func.uda_id(), func.name(), func.registry_arg_types());
-            return s.ok();
-          })
-          .OnColumn([&](const auto&, std::vector<bool>) { return true; })
-          .OnScalarFunc([&](const plan::ScalarFunc& func, std::vector<bool>) {
-            CHECK_EQ(func.registry_arg_types().size(),
-                     func.init_arguments().size() + func.arg_deps().size());
-            Status s =
-                exec_state->AddScalarUDF(func.udf_id(), func.name(), func.registry_arg_types());
-            return s.ok();
-          })
-          .OnScalarValue([&](const auto&, std::vector<bool>) { return true; })
-          .Walk(expr);
-  if (!walk_result.ok() || !walk_result.ConsumeValueOrDie()) {
-    return error::Internal("Error walking expression.");
-  }
-  return Status::OK();
-}
-
 void CarnotImpl::GRPCServerFunc() {
   CHECK(server_config_ != nullptr);
 
@@ -321,9 +255,25 @@ Status InitiateOutgoingConns(
 Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
                                bool analyze) {
   auto timer = ElapsedTimer();
-  plan::Plan plan;
-
-  PX_RETURN_IF_ERROR(plan.Init(logical_plan));
+  // Measures the time spent preparing the plan and initializing the execution graphs, as opposed
+  // to running them.
+  auto setup_timer = ElapsedTimer();
+  setup_timer.Start();
+
+  std::string plan_key;
+  std::unique_ptr<PreparedPlan> prepared;
+  if (plan_cache_->capacity() > 0) {
+    plan_key = PlanCache::Key(logical_plan);
+    prepared = plan_cache_->Acquire(plan_key);
+  }
+  // Only the plan is reused. The execution graphs below are built for every query, see PlanCache.
+  if (prepared != nullptr) {
+    PX_RETURN_IF_ERROR(prepared->RebindTimeBounds(logical_plan));
+  } else {
+    PX_ASSIGN_OR_RETURN(prepared,
+                        PreparedPlan::Create(logical_plan, engine_state_->func_registry()));
+  }
+  plan::Plan* plan = prepared->plan();
 
   // For each of the plan fragments in the plan, execute the query.
   std::vector<std::string> output_table_strs;
@@ -340,13 +290,14 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
     exec_state->set_metadata_state(metadata_state);
   }
 
-  PX_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
+  prepared->RegisterFuncs(exec_state.get());
 
   auto plan_state = engine_state_->CreatePlanState();
   int64_t bytes_processed = 0;
   int64_t rows_processed = 0;
   queryresultspb::AgentExecutionStats agent_operator_exec_stats;
   ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
+  setup_timer.Stop();
   timer.Start();
   // Unclear how we'll use plan fragments in the future (they're currently unused). For now, we will
   // share the schema between plan fragments.
@@ -356,8 +307,10 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
       plan::PlanWalker()
           .OnPlanFragment([&](auto* pf) {
             auto exec_graph = exec::ExecutionGraph();
+            setup_timer.Resume();
             PX_RETURN_IF_ERROR(exec_graph.Init(schema.get(), plan_state.get(), exec_state.get(), pf,
                                                /* collect_exec_node_stats */ analyze));
+            setup_timer.Stop();
             PX_RETURN_IF_ERROR(exec_graph.Execute());
 
             // We must get this while exec_graph is alive. ExecutionGraph destructor calls
@@ -404,7 +357,9 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
             }
             return Status::OK();
           })
-          .Walk(&plan);
+          .Walk(plan);
+  // The plan is not modified by executing it, so it can be reused even if the query failed.
+  plan_cache_->Release(std::move(plan_key), std::move(prepared));
   if (!s.ok()) {
     PX_RETURN_IF_ERROR(SendErrorToOutgoingConns(query_id, outgoing_conns,
                                                 engine_state_->add_auth_to_grpc_context_func(), s));
@@ -448,8 +403,10 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   }
 
   agent_operator_exec_stats.set_execution_time_ns(timer.ElapsedTime_us() * 1000);
+  agent_operator_exec_stats.set_setup_time_ns(setup_timer.ElapsedTime_us() * 1000);
   agent_operator_exec_stats.set_bytes_processed(bytes_processed);
   agent_operator_exec_stats.set_records_processed(rows_processed);
+  agent_operator_exec_stats.set_peak_memory_bytes(exec_state->exec_mem_pool()->max_memory());
 
   std::vector<queryresultspb::AgentExecutionStats> all_agent_stats;
   if (analyze) {
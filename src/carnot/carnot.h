@@ -28,6 +28,7 @@
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/queryresultspb/query_results.pb.h"
+#include "src/carnot/standing_query.h"
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/table_store/table_store.h"
@@ -81,6 +82,17 @@ class Carnot : public NotCopyable {
   virtual Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id,
                              bool analyze = false) = 0;
 
+  /**
+   * Creates a standing query for the given logical plan, which the caller then executes once per
+   * period with StandingQuery::ExecutePeriod().
+   *
+   * @param plan the plan protobuf describing what should be executed. See StandingQuery for the
+   * plans that are supported.
+   * @return the standing query if successful. Error status otherwise.
+   */
+  virtual StatusOr<std::unique_ptr<StandingQuery>> CreateStandingQuery(
+      const planpb::Plan& plan, const sole::uuid& query_id) = 0;
+
   /**
    * Registers the callback for updating the agents metadata state.
    */
@@ -19,10 +19,14 @@
 #include <google/protobuf/text_format.h>
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <pypa/parser/parser.hh>
@@ -280,6 +284,35 @@ px.display(queryDF, 'range_output'))pxl";
   EXPECT_TRUE(rb1.ColumnAt(2)->Equals(types::ToArrow(col2_out1, arrow::default_memory_pool())));
 }
 
+TEST_F(CarnotTest, repeated_range_query_rebinds_time_bounds) {
+  std::string query = R"pxl(
+import px
+queryDF = px.DataFrame(table='big_test_table', select=['time_', 'col2'], start_time=$0, end_time=$1)
+px.display(queryDF, 'range_output'))pxl";
+
+  // The second query only differs in its time bounds, so it reuses the prepared plan of the first.
+  for (const auto& [start_time, stop_time] : std::vector<std::pair<int64_t, int64_t>>{
+           {9, 12}, {2, 12}}) {
+    result_server_->ResetQueryResults();
+    ASSERT_OK(carnot_->ExecuteQuery(absl::Substitute(query, start_time, stop_time),
+                                    sole::uuid4(), 0));
+
+    int64_t expected_rows = 0;
+    for (const auto& t : CarnotTestUtils::big_test_col1) {
+      expected_rows += t.val >= start_time && t.val < stop_time;
+    }
+    int64_t num_rows = 0;
+    for (const auto& rb : result_server_->query_results("range_output")) {
+      num_rows += rb.num_rows();
+    }
+    EXPECT_EQ(expected_rows, num_rows);
+
+    auto exec_stats = result_server_->exec_stats().ConsumeValueOrDie();
+    ASSERT_EQ(1, exec_stats.agent_execution_stats_size());
+    EXPECT_LT(0, exec_stats.agent_execution_stats(0).setup_time_ns());
+  }
+}
+
 TEST_F(CarnotTest, empty_range_test) {
   // Tests that a table that has no rows that fall within the query's range, doesn't write any
   // rowbatches to the output table.
@@ -731,6 +764,153 @@ TEST_F(CarnotTest, empty_source_test) {
   }
 }
 
+TEST_F(CarnotTest, standing_query_requires_memory_sources) {
+  planpb::Plan plan;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kEmptySourcePlan, &plan));
+  EXPECT_NOT_OK(carnot_->CreateStandingQuery(plan, sole::uuid4()));
+}
+
+class StandingQueryTest : public CarnotTest {
+ protected:
+  StatusOr<planpb::Plan> CompileQuery(const std::string& query) {
+    Compiler compiler;
+    auto compiler_state = carnot_->GetEngineState()->CreateLocalExecutionCompilerState(0);
+    return compiler.Compile(query, compiler_state.get());
+  }
+
+  // Expects the results of the last period to be a single row with the given two columns.
+  void ExpectPeriodOutput(int64_t col0, int64_t col1) {
+    // The stream to the result server stays open between periods, so the results of a period may
+    // arrive after ExecutePeriod() returns.
+    std::vector<table_store::schema::RowBatch> non_empty;
+    for (int i = 0; i < 500 && non_empty.empty(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      for (const auto& rb : result_server_->query_results("standing_output")) {
+        if (rb.num_rows() > 0) {
+          non_empty.push_back(rb);
+        }
+      }
+    }
+    ASSERT_EQ(1, non_empty.size());
+    std::vector<types::Int64Value> col0_out = {col0};
+    std::vector<types::Int64Value> col1_out = {col1};
+    EXPECT_TRUE(
+        non_empty[0].ColumnAt(0)->Equals(types::ToArrow(col0_out, arrow::default_memory_pool())));
+    EXPECT_TRUE(
+        non_empty[0].ColumnAt(1)->Equals(types::ToArrow(col1_out, arrow::default_memory_pool())));
+    result_server_->ResetQueryResults();
+  }
+
+  // Appends two rows, with col2 values 7 and 8, to test_table.
+  void AppendRows() {
+    auto rb = table_store::schema::RowBatch(
+        table_store::schema::RowDescriptor({types::DataType::FLOAT64, types::DataType::INT64}), 2);
+    std::vector<types::Float64Value> col1 = {1.5, 2.5};
+    std::vector<types::Int64Value> col2 = {7, 8};
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col2, arrow::default_memory_pool())));
+    ASSERT_OK(table_store_->GetTable("test_table")->WriteRowBatch(rb));
+  }
+
+  void ExpectRejected(const std::string& query, const std::string& error_substr) {
+    ASSERT_OK_AND_ASSIGN(auto plan, CompileQuery(query));
+    auto standing_query_or_s = carnot_->CreateStandingQuery(plan, sole::uuid4());
+    ASSERT_NOT_OK(standing_query_or_s);
+    EXPECT_THAT(standing_query_or_s.status().msg(), ::testing::HasSubstr(error_substr));
+  }
+};
+
+TEST_F(StandingQueryTest, blocking_aggregate) {
+  ASSERT_OK_AND_ASSIGN(auto plan, CompileQuery(R"pxl(
+import px
+df = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df = df.agg(count=('col2', px.count), sum=('col2', px.sum))
+px.display(df, 'standing_output'))pxl"));
+  ASSERT_OK_AND_ASSIGN(auto standing_query, carnot_->CreateStandingQuery(plan, sole::uuid4()));
+
+  // The first period reads everything that is already in the table.
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(5, 17);
+
+  // Later periods only read the rows that were appended since the previous period, and add them
+  // to the aggregate of the previous periods.
+  AppendRows();
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(7, 32);
+  EXPECT_EQ(7, standing_query->GetStats().rows_processed);
+
+  EXPECT_OK(standing_query->Close());
+  EXPECT_NOT_OK(standing_query->ExecutePeriod());
+}
+
+TEST_F(StandingQueryTest, windowed_aggregate) {
+  ASSERT_OK_AND_ASSIGN(auto plan, CompileQuery(R"pxl(
+import px
+df = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df = df.agg(count=('col2', px.count), sum=('col2', px.sum))
+px.display(df, 'standing_output'))pxl"));
+  for (auto& pf : *plan.mutable_nodes()) {
+    for (auto& node : *pf.mutable_nodes()) {
+      if (node.op().op_type() == planpb::AGGREGATE_OPERATOR) {
+        node.mutable_op()->mutable_agg_op()->set_windowed(true);
+      }
+    }
+  }
+  ASSERT_OK_AND_ASSIGN(auto standing_query, carnot_->CreateStandingQuery(plan, sole::uuid4()));
+
+  // Windowed aggregates emit the aggregate of each period.
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(5, 17);
+  AppendRows();
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(2, 15);
+}
+
+TEST_F(StandingQueryTest, aggregate_of_aggregate) {
+  ASSERT_OK_AND_ASSIGN(auto plan, CompileQuery(R"pxl(
+import px
+df = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df = df.groupby('col2').agg(count=('col1', px.count))
+df = df.agg(groups=('count', px.count), total=('count', px.sum))
+px.display(df, 'standing_output'))pxl"));
+  ASSERT_OK_AND_ASSIGN(auto standing_query, carnot_->CreateStandingQuery(plan, sole::uuid4()));
+
+  // The outer aggregate gets all of the groups of the inner one every period, so it starts over
+  // every period instead of counting the groups again.
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(5, 5);
+  AppendRows();
+  ASSERT_OK(standing_query->ExecutePeriod());
+  ExpectPeriodOutput(7, 7);
+}
+
+TEST_F(StandingQueryTest, reject_join) {
+  ExpectRejected(R"pxl(
+import px
+df1 = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df2 = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df = df1.merge(df2, how='inner', left_on='col2', right_on='col2', suffixes=['', '_x'])
+px.display(df, 'standing_output'))pxl",
+                 "don't support joins");
+}
+
+TEST_F(StandingQueryTest, reject_limit) {
+  ExpectRejected(R"pxl(
+import px
+df = px.DataFrame(table='test_table', select=['col1', 'col2'])
+df = df.head(n=2)
+px.display(df, 'standing_output'))pxl",
+                 "don't support limits");
+}
+
+TEST_F(StandingQueryTest, reject_bounded_source) {
+  ExpectRejected(R"pxl(
+import px
+df = px.DataFrame(table='big_test_table', select=['time_', 'col2'], start_time=2, end_time=12)
+px.display(df, 'standing_output'))pxl",
+                 "don't support bounded sources");
+}
+
 const char kPxCluster[] = R"pxl(
 import px
 
@@ -23,6 +23,7 @@
 #include <arrow/status.h>
 #include <algorithm>
 #include <cstdint>
+#include <set>
 
 #include <magic_enum.hpp>
 
@@ -105,6 +106,17 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     }
   }
 
+  std::set<int64_t> cols;
+  for (const auto& group : plan_node_->groups()) {
+    cols.insert(group.idx);
+  }
+  for (const auto& value : plan_node_->values()) {
+    for (const plan::Column* col : value->ColumnDeps()) {
+      cols.insert(col->Index());
+    }
+  }
+  columns_read_.assign(cols.begin(), cols.end());
+
   size_t output_size = plan_node_->values().size() + plan_node_->groups().size();
   if (output_size != output_descriptor_->size()) {
     return error::InvalidArgument("Output size mismatch in aggregate");
@@ -169,7 +181,7 @@ Status AggNode::CloseImpl(ExecState*) {
 }
 
 bool AggNode::ReadyToEmitBatches(const RowBatch& rb) const {
-  return rb.eos() || (rb.eow() && plan_node_->windowed());
+  return rb.eos() || (rb.eow() && (plan_node_->windowed() || plan_node_->cumulative()));
 }
 
 Status AggNode::ClearAggState(ExecState* exec_state) {
@@ -214,7 +226,10 @@ Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb)
     output_rb.set_eow(rb.eow());
     output_rb.set_eos(rb.eos());
     PX_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
-    PX_RETURN_IF_ERROR(ClearAggState(exec_state));
+    // A cumulative aggregate keeps aggregating the next windows into the results it emitted.
+    if (!plan_node_->cumulative()) {
+      PX_RETURN_IF_ERROR(ClearAggState(exec_state));
+    }
   }
   return Status::OK();
 }
@@ -400,7 +415,9 @@ Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb
     output_rb.set_eow(rb.eow());
     output_rb.set_eos(rb.eos());
     PX_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
-    PX_RETURN_IF_ERROR(ClearAggState(exec_state));
+    if (!plan_node_->cumulative()) {
+      PX_RETURN_IF_ERROR(ClearAggState(exec_state));
+    }
   }
   return Status::OK();
 }
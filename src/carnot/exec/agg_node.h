@@ -84,13 +84,19 @@ class AggNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  // A finalize agg reads every column of its input: the groups and one serialized UDA per value.
+  const std::vector<int64_t>* InputColumnsRead(size_t) const override {
+    return plan_node_->partial_agg() ? &columns_read_ : nullptr;
+  }
 
  private:
+  // The group columns and the columns the values aggregate, in increasing order.
+  std::vector<int64_t> columns_read_;
   AggHashMap agg_hash_map_;
   bool HasNoGroups() const { return plan_node_->groups().empty(); }
   // ReadyToEmitBatches returns true when the input stream has reached a point where output batches
-  // can be emitted. In the windowed aggregate case, this happens whenever end of window (eow) is
-  // reached. In the blocking aggregate case, this happens at eos only.
+  // can be emitted. In the windowed and cumulative aggregate cases, this happens whenever end of
+  // window (eow) is reached. In the blocking aggregate case, this happens at eos only.
   bool ReadyToEmitBatches(const table_store::schema::RowBatch& rb) const;
   // When we see a new window, we need to be able to clear the aggregate state.
   Status ClearAggState(ExecState* exec_state);
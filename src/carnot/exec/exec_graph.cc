@@ -293,26 +293,79 @@ Status ExecutionGraph::ExecuteSources() {
  * @return a status of whether execution succeeded.
  */
 Status ExecutionGraph::Execute() {
-  query_start_time_ = std::chrono::system_clock::now();
+  PX_RETURN_IF_ERROR(Open());
 
-  // Get vector of nodes.
-  std::vector<ExecNode*> nodes(nodes_.size());
-  transform(nodes_.begin(), nodes_.end(), nodes.begin(), [](auto pair) { return pair.second; });
+  // We don't PX_RETURN_IF_ERROR here because we want to make sure we close all of our
+  // nodes, even if there was an error during execution.
+  Status source_status = ExecuteSources();
+  Status close_status = CloseNodes();
 
-  for (auto node : nodes) {
+  if (!source_status.ok()) {
+    return source_status;
+  }
+  return close_status;
+}
+
+Status ExecutionGraph::Open() {
+  query_start_time_ = std::chrono::system_clock::now();
+
+  for (const auto& [id, node] : nodes_) {
     PX_RETURN_IF_ERROR(node->Prepare(exec_state_));
   }
 
-  for (auto node : nodes) {
+  for (const auto& [id, node] : nodes_) {
     PX_RETURN_IF_ERROR(node->Open(exec_state_));
   }
+  return Status::OK();
+}
 
-  // We don't PX_RETURN_IF_ERROR here because we want to make sure we close all of our
-  // nodes, even if there was an error during execution.
-  Status source_status = ExecuteSources();
-  Status close_status = Status::OK();
+Status ExecutionGraph::ExecutePeriod() {
+  for (int64_t source_id : sources_) {
+    auto node = nodes_.find(source_id);
+    if (node == nodes_.end()) {
+      return error::NotFound("Could not find SourceNode $0.", source_id);
+    }
+    auto* source = static_cast<SourceNode*>(node->second);
+    exec_state_->SetCurrentSource(source_id);
+    // Skip sources that already ended their stream, e.g. because the query was stopped.
+    if (!source->HasBatchesRemaining() || !exec_state_->keep_running()) {
+      continue;
+    }
 
-  for (auto node : nodes) {
+    while (source->NextBatchReady() && exec_state_->keep_running()) {
+      PX_RETURN_IF_ERROR(source->GenerateNext(exec_state_));
+    }
+
+    if (source->HasBatchesRemaining() && exec_state_->keep_running()) {
+      PX_RETURN_IF_ERROR(source->SendEndOfWindow(exec_state_));
+    }
+  }
+  return Status::OK();
+}
+
+Status ExecutionGraph::Close() {
+  Status eos_status = Status::OK();
+  for (int64_t source_id : sources_) {
+    auto* source = static_cast<SourceNode*>(nodes_.at(source_id));
+    exec_state_->SetCurrentSource(source_id);
+    if (source->HasBatchesRemaining() && exec_state_->keep_running()) {
+      auto s = source->SendEndOfStream(exec_state_);
+      if (!s.ok()) {
+        eos_status = s;
+      }
+    }
+  }
+
+  Status close_status = CloseNodes();
+  if (!eos_status.ok()) {
+    return eos_status;
+  }
+  return close_status;
+}
+
+Status ExecutionGraph::CloseNodes() {
+  Status close_status = Status::OK();
+  for (const auto& [id, node] : nodes_) {
     auto s = node->Close(exec_state_);
     if (!s.ok()) {
       // Since we only return a single error status if there are multiple errors,
@@ -323,10 +376,6 @@ Status ExecutionGraph::Execute() {
       close_status = s;
     }
   }
-
-  if (!source_status.ok()) {
-    return source_status;
-  }
   return close_status;
 }
 
@@ -126,6 +126,27 @@ class ExecutionGraph {
    */
   Status Execute();
 
+  /**
+   * Prepares and opens the nodes of a standing query, which is then run by calling
+   * ExecutePeriod() once per period, and finished with Close().
+   *
+   * The sources of a standing query must be streaming memory sources, so that their cursors stay
+   * open across periods.
+   */
+  Status Open();
+
+  /**
+   * Feeds the batches that were appended to the source tables since the previous period through
+   * the graph, then ends the window of every source, so that windowed operators emit their results
+   * for the period and start over.
+   */
+  Status ExecutePeriod();
+
+  /**
+   * Ends the stream of every source that hasn't ended yet and closes the nodes.
+   */
+  Status Close();
+
   /**
    * Re-awakens Execute() when there is more work available to do.
    */
@@ -208,6 +229,7 @@ class ExecutionGraph {
   }
 
   Status ExecuteSources();
+  Status CloseNodes();
 
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
@@ -220,6 +220,14 @@ class ExecNode {
     }
     stats_->AddInputStats(rb);
     stats_->ResumeTotalTimer();
+    // Gathering can fail once the query hits its memory limit, so do it here where the failure
+    // can be returned, rather than on first column access.
+    const std::vector<int64_t>* cols_read = InputColumnsRead(parent_index);
+    if (cols_read == nullptr) {
+      PX_RETURN_IF_ERROR(rb.Materialize());
+    } else {
+      PX_RETURN_IF_ERROR(rb.MaterializeColumns(*cols_read));
+    }
     PX_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, rb, parent_index));
     stats_->StopTotalTimer();
     return Status::OK();
@@ -313,6 +321,13 @@ class ExecNode {
   virtual Status ConsumeNextImpl(ExecState*, const table_store::schema::RowBatch&, size_t) {
     return error::Unimplemented("Implement in derived class (if sink or processing)");
   }
+
+  // The columns of the input from `parent_index` that ConsumeNextImpl reads with ColumnAt, or
+  // nullptr if it reads all of them. Only these columns of a row batch with a selection vector are
+  // gathered before ConsumeNextImpl; the others may only be passed through (Project/Slice).
+  virtual const std::vector<int64_t>* InputColumnsRead(size_t /*parent_index*/) const {
+    return nullptr;
+  }
   bool is_closed() { return is_closed_; }
 
   std::unique_ptr<table_store::schema::RowDescriptor> output_descriptor_;
@@ -366,6 +381,11 @@ class SourceNode : public ExecNode {
                                      *output_descriptor_, /*eow*/ true, /*eos*/ true));
     return SendRowBatchToChildren(exec_state, *rb);
   }
+  Status SendEndOfWindow(ExecState* exec_state) {
+    PX_ASSIGN_OR_RETURN(auto rb, table_store::schema::RowBatch::WithZeroRows(
+                                     *output_descriptor_, /*eow*/ true, /*eos*/ false));
+    return SendRowBatchToChildren(exec_state, *rb);
+  }
 
  protected:
   int64_t rows_processed_ = 0;
@@ -31,6 +31,7 @@
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/exec_metrics.h"
 #include "src/carnot/exec/grpc_router.h"
+#include "src/carnot/exec/query_memory_pool.h"
 #include "src/carnot/udf/model_pool.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
@@ -41,6 +42,8 @@
 #include "opentelemetry/proto/collector/trace/v1/trace_service.grpc.pb.h"
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 
+DECLARE_int64(carnot_query_memory_limit_bytes);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -82,18 +85,21 @@ class ExecState {
         model_pool_(model_pool),
         grpc_router_(grpc_router),
         add_auth_to_grpc_client_context_func_(add_auth_func),
-        exec_metrics_(exec_metrics) {}
+        exec_metrics_(exec_metrics),
+        exec_mem_pool_(QueryMemoryPool::Create(arrow::default_memory_pool(),
+                                               FLAGS_carnot_query_memory_limit_bytes)) {}
 
   ~ExecState() {
     if (grpc_router_ != nullptr) {
       grpc_router_->DeleteQuery(query_id_);
     }
-  }
-  arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
-    return arrow::default_memory_pool();
+    // The pool frees itself once all buffers allocated by this query have been freed.
+    exec_mem_pool_->Release();
   }
 
+  // The memory pool used for all allocations made while executing this query.
+  QueryMemoryPool* exec_mem_pool() { return exec_mem_pool_; }
+
   udf::Registry* func_registry() { return func_registry_; }
 
   table_store::TableStore* table_store() { return table_store_.get(); }
@@ -115,6 +121,11 @@ class ExecState {
     return Status::OK();
   }
 
+  // Registers a definition that was already looked up in the function registry, eg. by a
+  // PreparedPlan that is reused across queries.
+  void AddScalarUDF(int64_t id, udf::ScalarUDFDefinition* def) { id_to_scalar_udf_map_[id] = def; }
+  void AddUDA(int64_t id, udf::UDADefinition* def) { id_to_uda_map_[id] = def; }
+
   // This function returns a stub to a service that is responsible for receiving results.
   // Currently, it will either be a Kelvin instance or a query broker.
   carnotpb::ResultSinkService::StubInterface* ResultSinkServiceStub(
@@ -216,6 +227,8 @@ class ExecState {
   GRPCRouter* grpc_router_ = nullptr;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_client_context_func_;
   ExecMetrics* exec_metrics_;
+  // Owned, but released (rather than deleted) in the destructor. See QueryMemoryPool.
+  QueryMemoryPool* exec_mem_pool_;
 
   int64_t current_source_ = 0;
   bool current_source_set_ = false;
@@ -21,6 +21,7 @@
 #include <benchmark/benchmark.h>
 #include <cstddef>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <google/protobuf/text_format.h>
@@ -28,7 +29,9 @@
 
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/fused_expression_evaluator.h"
 #include "src/carnot/exec/test_utils.h"
+#include "src/carnot/funcs/builtins/builtins.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
@@ -46,6 +49,7 @@
 using ScalarExpression = px::carnot::plan::ScalarExpression;
 using ScalarExpressionVector = std::vector<std::shared_ptr<ScalarExpression>>;
 using px::carnot::exec::ExecState;
+using px::carnot::exec::FusedScalarExpressionEvaluator;
 using px::carnot::exec::MockMetricsStubGenerator;
 using px::carnot::exec::MockResultSinkStubGenerator;
 using px::carnot::exec::MockTraceStubGenerator;
@@ -62,6 +66,7 @@ using px::table_store::schema::RowBatch;
 using px::table_store::schema::RowDescriptor;
 using px::types::DataType;
 using px::types::Int64Value;
+using px::types::StringValue;
 using px::types::ToArrow;
 
 class AddUDF : public ScalarUDF {
@@ -114,6 +119,116 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
   state.SetBytesProcessed(int64_t(state.iterations()) * 2 * in1.size() * sizeof(int64_t));
 }
 
+// (a > 20) and (b < 80) and (c == "x"), with the ids of the functions as registered below.
+constexpr char kConjunctionPredicatePbtxt[] = R"(
+func {
+  name: "logicalAnd"
+  id: 4
+  args {
+    func {
+      name: "logicalAnd"
+      id: 3
+      args {
+        func {
+          name: "greaterThan"
+          id: 0
+          args { column { index: 0 } }
+          args { constant { data_type: INT64 int64_value: 20 } }
+          args_data_types: INT64
+          args_data_types: INT64
+        }
+      }
+      args {
+        func {
+          name: "lessThan"
+          id: 1
+          args { column { index: 1 } }
+          args { constant { data_type: INT64 int64_value: 80 } }
+          args_data_types: INT64
+          args_data_types: INT64
+        }
+      }
+      args_data_types: BOOLEAN
+      args_data_types: BOOLEAN
+    }
+  }
+  args {
+    func {
+      name: "equal"
+      id: 2
+      args { column { index: 2 } }
+      args { constant { data_type: STRING string_value: "x" } }
+      args_data_types: STRING
+      args_data_types: STRING
+    }
+  }
+  args_data_types: BOOLEAN
+  args_data_types: BOOLEAN
+})";
+
+// Evaluates a filter predicate over the builtins. If selection is true, the predicate is evaluated
+// to a selection vector the way the filter node does with the fused evaluator, rather than to a
+// boolean column.
+// NOLINTNEXTLINE : runtime/references.
+void BM_ScalarExpressionPredicate(benchmark::State& state,
+                                  const ScalarExpressionEvaluatorType& eval_type, bool selection) {
+  px::carnot::planpb::ScalarExpression se_pb;
+  size_t data_size = state.range(0);
+
+  CHECK(google::protobuf::TextFormat::MergeFromString(kConjunctionPredicatePbtxt, &se_pb));
+  auto s_or_se = px::carnot::plan::ScalarExpression::FromProto(se_pb);
+  CHECK(s_or_se.ok());
+  std::shared_ptr<ScalarExpression> se = s_or_se.ConsumeValueOrDie();
+
+  auto func_registry = std::make_unique<Registry>("test_registry");
+  px::carnot::builtins::RegisterBuiltinsOrDie(func_registry.get());
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, MockMetricsStubGenerator,
+      MockTraceStubGenerator, sole::uuid4(), nullptr);
+  PX_CHECK_OK(exec_state->AddScalarUDF(0, "greaterThan", {DataType::INT64, DataType::INT64}));
+  PX_CHECK_OK(exec_state->AddScalarUDF(1, "lessThan", {DataType::INT64, DataType::INT64}));
+  PX_CHECK_OK(exec_state->AddScalarUDF(2, "equal", {DataType::STRING, DataType::STRING}));
+  PX_CHECK_OK(exec_state->AddScalarUDF(3, "logicalAnd", {DataType::BOOLEAN, DataType::BOOLEAN}));
+  PX_CHECK_OK(exec_state->AddScalarUDF(4, "logicalAnd", {DataType::BOOLEAN, DataType::BOOLEAN}));
+
+  auto in1 = px::datagen::CreateLargeData<Int64Value>(data_size);
+  auto in2 = px::datagen::CreateLargeData<Int64Value>(data_size);
+  std::vector<StringValue> in3;
+  for (size_t i = 0; i < data_size; ++i) {
+    in3.emplace_back(std::string(1, "wxyz"[in1[i].val % 4]));
+  }
+
+  RowDescriptor rd({DataType::INT64, DataType::INT64, DataType::STRING});
+  auto input_rb = std::make_unique<RowBatch>(rd, in1.size());
+
+  PX_CHECK_OK(input_rb->AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+  PX_CHECK_OK(input_rb->AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+  PX_CHECK_OK(input_rb->AddColumn(ToArrow(in3, arrow::default_memory_pool())));
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    auto function_ctx = std::make_unique<px::carnot::udf::FunctionContext>(nullptr, nullptr);
+    if (selection) {
+      FusedScalarExpressionEvaluator evaluator({se}, function_ctx.get());
+      PX_CHECK_OK(evaluator.Open(exec_state.get()));
+      auto rows = evaluator.EvaluatePredicate(*input_rb, *se).ConsumeValueOrDie();
+      PX_CHECK_OK(evaluator.Close(exec_state.get()));
+      benchmark::DoNotOptimize(rows);
+      continue;
+    }
+    RowDescriptor rd_output({DataType::BOOLEAN});
+    RowBatch output_rb(rd_output, input_rb->num_rows());
+    auto evaluator = ScalarExpressionEvaluator::Create({se}, eval_type, function_ctx.get());
+    PX_CHECK_OK(evaluator->Open(exec_state.get()));
+    PX_CHECK_OK(evaluator->Evaluate(exec_state.get(), *input_rb, &output_rb));
+    PX_CHECK_OK(evaluator->Close(exec_state.get()));
+
+    benchmark::DoNotOptimize(output_rb);
+    CHECK_EQ(static_cast<size_t>(output_rb.ColumnAt(0)->length()), data_size);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * data_size);
+}
+
 BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, eval_col_arrow,
                   ScalarExpressionEvaluatorType::kArrowNative, kColumnReferencePbtxt)
     ->RangeMultiplier(2)
@@ -149,3 +264,33 @@ BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_simple_add_vector,
                   ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt)
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_arrow,
+                  ScalarExpressionEvaluatorType::kArrowNative, kAddScalarFuncPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_vector,
+                  ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_fused,
+                  ScalarExpressionEvaluatorType::kFused, kAddScalarFuncPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionPredicate, conjunction_arrow,
+                  ScalarExpressionEvaluatorType::kArrowNative, false)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionPredicate, conjunction_vector,
+                  ScalarExpressionEvaluatorType::kVectorNative, false)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionPredicate, conjunction_fused,
+                  ScalarExpressionEvaluatorType::kFused, false)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionPredicate, conjunction_fused_selection,
+                  ScalarExpressionEvaluatorType::kFused, true)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
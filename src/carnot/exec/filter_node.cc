@@ -60,78 +60,42 @@ Status FilterNode::InitImpl(const plan::Operator& plan_node) {
 
 Status FilterNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
-  evaluator_ = std::make_unique<VectorNativeScalarExpressionEvaluator>(
-      plan::ConstScalarExpressionVector{plan_node_->expression()}, function_ctx_.get());
+  plan::ConstScalarExpressionVector expressions{plan_node_->expression()};
+  if (ChooseScalarExpressionEvaluator(exec_state, expressions,
+                                      ScalarExpressionEvaluatorType::kVectorNative) ==
+      ScalarExpressionEvaluatorType::kFused) {
+    fused_evaluator_ =
+        std::make_unique<FusedScalarExpressionEvaluator>(expressions, function_ctx_.get());
+  } else {
+    evaluator_ =
+        std::make_unique<VectorNativeScalarExpressionEvaluator>(expressions, function_ctx_.get());
+  }
   return Status::OK();
 }
 
 Status FilterNode::OpenImpl(ExecState* exec_state) {
+  if (fused_evaluator_ != nullptr) {
+    return fused_evaluator_->Open(exec_state);
+  }
   PX_RETURN_IF_ERROR(evaluator_->Open(exec_state));
   return Status::OK();
 }
 
 Status FilterNode::CloseImpl(ExecState* exec_state) {
-  PX_RETURN_IF_ERROR(evaluator_->Close(exec_state));
-  return Status::OK();
-}
-
-template <types::DataType T>
-Status PredicateCopyValues(const types::BoolValueColumnWrapper& pred, const arrow::Array* input_col,
-                           RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  auto output_col_builder_generic = MakeArrowBuilder(T, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-  PX_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      output_col_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, idx));
-    }
+  if (fused_evaluator_ != nullptr) {
+    return fused_evaluator_->Close(exec_state);
   }
-  std::shared_ptr<arrow::Array> output_array;
-  PX_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PX_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
+  PX_RETURN_IF_ERROR(evaluator_->Close(exec_state));
   return Status::OK();
 }
 
-template <>
-Status PredicateCopyValues<types::STRING>(const types::BoolValueColumnWrapper& pred,
-                                          const arrow::Array* input_col, RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  size_t reserved =
-      100;  // This can be an arbritrary number, since we do exponential doubling below.
-  size_t total_size = 0;
-
-  auto output_col_builder_generic = MakeArrowBuilder(types::STRING, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<types::DataTypeTraits<types::STRING>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-
-  PX_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  PX_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      auto res = types::GetValueFromArrowArray<types::STRING>(input_col, idx);
-      total_size += res.size();
-      while (total_size >= reserved) {
-        reserved *= 2;
-      }
-      PX_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-      output_col_builder->UnsafeAppend(std::move(res));
-    }
+StatusOr<table_store::schema::SelectionVector> FilterNode::EvaluatePredicate(ExecState* exec_state,
+                                                                             const RowBatch& rb) {
+  if (fused_evaluator_ != nullptr) {
+    // The fused evaluator produces the selection directly, without a predicate column.
+    return fused_evaluator_->EvaluatePredicate(rb, *plan_node_->expression());
   }
-  std::shared_ptr<arrow::Array> output_array;
-  PX_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PX_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
-  return Status::OK();
-}
 
-Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
-  // Current implementation does not merge across row batches, we should
-  // consider this for cases where the filter has really low selectivity.
   PX_ASSIGN_OR_RETURN(auto pred_col, evaluator_->EvaluateSingleExpression(
                                          exec_state, rb, *plan_node_->expression()));
 
@@ -152,21 +116,38 @@ Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, si
     }
   }
 
-  RowBatch output_rb(*output_descriptor_, num_output_records);
-  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
+  table_store::schema::SelectionVector selection;
+  selection.reserve(num_output_records);
+  for (size_t i = 0; i < num_pred; ++i) {
+    if (pred_col_wrapper[i].val) {
+      selection.push_back(i);
+    }
+  }
+  return selection;
+}
 
-  for (const auto& [output_col_idx, input_col_idx] : Enumerate(plan_node_->selected_cols())) {
-    auto input_col = rb.ColumnAt(input_col_idx);
-    auto col_type = output_descriptor_->type(output_col_idx);
-#define TYPE_CASE(_dt_) \
-  PX_RETURN_IF_ERROR(PredicateCopyValues<_dt_>(pred_col_wrapper, input_col.get(), &output_rb));
-    PX_SWITCH_FOREACH_DATATYPE(col_type, TYPE_CASE);
-#undef TYPE_CASE
+Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  // Current implementation does not merge across row batches, we should
+  // consider this for cases where the filter has really low selectivity.
+  PX_ASSIGN_OR_RETURN(table_store::schema::SelectionVector selection,
+                      EvaluatePredicate(exec_state, rb));
+
+  // Rather than copying the selected values of every column, pass on a selection vector over the
+  // input columns. Columns are only gathered when a downstream operator reads them, so e.g. a
+  // filter followed by a limit copies at most `limit` rows of each column.
+  std::unique_ptr<RowBatch> output_rb;
+  if (static_cast<int64_t>(selection.size()) == rb.num_rows()) {
+    PX_ASSIGN_OR_RETURN(output_rb, rb.Project(*output_descriptor_, plan_node_->selected_cols()));
+  } else {
+    PX_ASSIGN_OR_RETURN(output_rb,
+                        rb.Select(*output_descriptor_, plan_node_->selected_cols(),
+                                  std::move(selection), exec_state->exec_mem_pool()));
   }
+  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
 
-  output_rb.set_eow(rb.eow());
-  output_rb.set_eos(rb.eos());
-  PX_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+  output_rb->set_eow(rb.eow());
+  output_rb->set_eos(rb.eos());
+  PX_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *output_rb));
   return Status::OK();
 }
 
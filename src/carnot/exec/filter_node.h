@@ -26,6 +26,7 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/fused_expression_evaluator.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/udf/base.h"
 #include "src/common/base/base.h"
@@ -51,7 +52,13 @@ class FilterNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
+  StatusOr<table_store::schema::SelectionVector> EvaluatePredicate(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
+
+  // Exactly one of the evaluators is set. The fused evaluator is used when the predicate only
+  // consists of builtin functions that have fused kernels.
   std::unique_ptr<VectorNativeScalarExpressionEvaluator> evaluator_;
+  std::unique_ptr<FusedScalarExpressionEvaluator> fused_evaluator_;
   std::unique_ptr<plan::FilterOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
 };
@@ -18,8 +18,11 @@
 
 #include "src/carnot/exec/filter_node.h"
 
+#include <string>
+
 #include <sole.hpp>
 
+#include "src/carnot/exec/fused_expression_evaluator.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/planpb/test_proto.h"
 #include "src/carnot/udf/registry.h"
@@ -187,6 +190,80 @@ TEST_F(FilterNodeTest, zero_row_row_batch) {
       .Close();
 }
 
+planpb::Operator CreateFilter(const std::string& expression) {
+  planpb::Operator op;
+  auto op_proto =
+      absl::Substitute(planpb::testutils::kOperatorProtoTmpl, "FILTER_OPERATOR", "filter_op",
+                       absl::Substitute(planpb::testutils::kFilterOperatorTmpl, expression));
+  CHECK(google::protobuf::TextFormat::MergeFromString(op_proto, &op))
+      << "Failed to parse proto";
+  return op;
+}
+
+// Bare columns and constants are predicates too, and are fused like any other predicate.
+TEST_F(FilterNodeTest, bool_column_pred) {
+  PX_SET_FOR_SCOPE(FLAGS_carnot_fused_expression_evaluation, true);
+  plan_node_ = plan::FilterOperator::FromProto(CreateFilter("column { node: 0 index: 2 }"),
+                                               /*id*/ 1);
+
+  RowDescriptor input_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::BOOLEAN});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::BOOLEAN});
+
+  auto tester = exec::ExecNodeTester<FilterNode, plan::FilterOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({5, 6, 7, 8})
+                       .AddColumn<types::BoolValue>({true, false, false, true})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 4})
+                          .AddColumn<types::Int64Value>({5, 8})
+                          .AddColumn<types::BoolValue>({true, true})
+                          .get())
+      .Close();
+}
+
+TEST_F(FilterNodeTest, literal_pred) {
+  PX_SET_FOR_SCOPE(FLAGS_carnot_fused_expression_evaluation, true);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  auto input_rb = RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                      .AddColumn<types::Int64Value>({1, 2})
+                      .AddColumn<types::Int64Value>({3, 4})
+                      .AddColumn<types::StringValue>({"ABC", "DEF"})
+                      .get();
+
+  plan_node_ = plan::FilterOperator::FromProto(
+      CreateFilter("constant { data_type: BOOLEAN bool_value: true }"), /*id*/ 1);
+  exec::ExecNodeTester<FilterNode, plan::FilterOperator>(*plan_node_, output_rd, {input_rd},
+                                                         exec_state_.get())
+      .ConsumeNext(input_rb, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({3, 4})
+                          .AddColumn<types::StringValue>({"ABC", "DEF"})
+                          .get())
+      .Close();
+
+  plan_node_ = plan::FilterOperator::FromProto(
+      CreateFilter("constant { data_type: BOOLEAN bool_value: false }"), /*id*/ 1);
+  exec::ExecNodeTester<FilterNode, plan::FilterOperator>(*plan_node_, output_rd, {input_rd},
+                                                         exec_state_.get())
+      .ConsumeNext(input_rb, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 0, true, true)
+                          .AddColumn<types::Int64Value>({})
+                          .AddColumn<types::Int64Value>({})
+                          .AddColumn<types::StringValue>({})
+                          .get())
+      .Close();
+}
+
 TEST_F(FilterNodeTest, string_pred) {
   auto op_proto = planpb::testutils::CreateTestFilterTwoColsString();
   plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
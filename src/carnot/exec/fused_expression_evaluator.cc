@@ -0,0 +1,957 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression_evaluator.h"
+
+#include <arrow/array.h>
+#include <arrow/builder.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+#include "src/shared/types/types.h"
+
+DEFINE_bool(carnot_fused_expression_evaluation,
+            gflags::BoolFromEnv("PL_CARNOT_FUSED_EXPRESSION_EVALUATION", true),
+            "Whether Map and Filter evaluate expressions of builtin functions with fused kernels.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::SelectionVector;
+using types::DataType;
+
+namespace {
+
+/*************************************************
+ * Row sets.
+ *************************************************/
+
+// The rows of the input batch that a kernel is evaluated on: either the first `size` rows, or the
+// `size` rows listed in `rows`, in increasing order.
+struct RowSet {
+  const int64_t* rows = nullptr;
+  int64_t size = 0;
+
+  static RowSet All(int64_t num_rows) { return {nullptr, num_rows}; }
+  static RowSet Of(const SelectionVector& rows) {
+    return {rows.data(), static_cast<int64_t>(rows.size())};
+  }
+};
+
+// Calls fn(i, row) for the i-th row of the set. The dense case gets its own loop, so that kernels
+// over all the rows of a batch are free of the indirection and can be vectorized.
+template <typename TFn>
+inline void ForEachRow(const RowSet& set, TFn&& fn) {
+  if (set.rows == nullptr) {
+    for (int64_t i = 0; i < set.size; ++i) {
+      fn(i, i);
+    }
+  } else {
+    for (int64_t i = 0; i < set.size; ++i) {
+      fn(i, set.rows[i]);
+    }
+  }
+}
+
+void AssignRows(const RowSet& in, SelectionVector* out) {
+  out->resize(in.size);
+  ForEachRow(in, [out](int64_t i, int64_t row) { (*out)[i] = row; });
+}
+
+// Sets out to the rows of in that are not in sub, which must be a subset of in.
+void DifferenceRows(const RowSet& in, const SelectionVector& sub, SelectionVector* out) {
+  out->resize(in.size - sub.size());
+  size_t j = 0;
+  size_t n = 0;
+  ForEachRow(in, [&](int64_t, int64_t row) {
+    if (j < sub.size() && sub[j] == row) {
+      ++j;
+    } else {
+      (*out)[n++] = row;
+    }
+  });
+}
+
+/*************************************************
+ * Kernel interfaces.
+ *************************************************/
+
+// The native type that kernels use for the values of each data type.
+template <DataType TDataType>
+struct FusedTypeTraits {
+  using native_type = typename types::DataTypeTraits<TDataType>::native_type;
+};
+
+template <>
+struct FusedTypeTraits<DataType::STRING> {
+  using native_type = std::string_view;
+};
+
+// A kernel that computes values of type T.
+template <typename T>
+class ValueKernel {
+ public:
+  virtual ~ValueKernel() = default;
+  // Binds the kernel to the columns of the input batch.
+  virtual Status Bind(const RowBatch& input) = 0;
+  // Writes the value for the i-th row of the set to out[i].
+  virtual void Eval(const RowSet& rows, T* out) = 0;
+};
+
+// A kernel that computes a BOOLEAN value, by selecting the rows for which it is true.
+class PredicateKernel {
+ public:
+  virtual ~PredicateKernel() = default;
+  // Binds the kernel to the columns of the input batch.
+  virtual Status Bind(const RowBatch& input) = 0;
+  // Sets out to the rows of in for which the predicate is true. out must not alias in.
+  virtual void Filter(const RowSet& in, SelectionVector* out) = 0;
+};
+
+/*************************************************
+ * Operands.
+ *************************************************/
+
+// The operands of the binary kernels. Each kernel is instantiated for the kinds of its two
+// operands, so that reading a column or a constant compiles down to a load.
+
+template <typename T>
+class ColumnOperand {
+ public:
+  ColumnOperand(int64_t index, DataType data_type) : index_(index), data_type_(data_type) {}
+
+  Status Bind(const RowBatch& input) {
+    column_ = input.ColumnAt(index_);
+    if (types::ArrowToDataType(column_->type_id()) != data_type_) {
+      return error::Internal("Column $0 has type $1, expected $2", index_,
+                             types::ToString(types::ArrowToDataType(column_->type_id())),
+                             types::ToString(data_type_));
+    }
+    if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+      values_ = column_->data()->template GetValues<T>(1);
+    }
+    return Status::OK();
+  }
+  void Prepare(const RowSet&) {}
+  T Get(int64_t, int64_t row) const {
+    if constexpr (std::is_same_v<T, bool>) {
+      return static_cast<const arrow::BooleanArray*>(column_.get())->Value(row);
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+      return types::GetStringViewFromArrowArray(column_.get(), row);
+    } else {
+      return values_[row];
+    }
+  }
+
+ private:
+  int64_t index_;
+  DataType data_type_;
+  std::shared_ptr<arrow::Array> column_;
+  const T* values_ = nullptr;
+};
+
+// Constant strings are owned by the operand, which hands out views of them.
+template <typename T>
+using OwnedType = std::conditional_t<std::is_same_v<T, std::string_view>, std::string, T>;
+
+template <typename T>
+class ConstantOperand {
+ public:
+  explicit ConstantOperand(OwnedType<T> value) : value_(std::move(value)) {}
+
+  Status Bind(const RowBatch&) { return Status::OK(); }
+  void Prepare(const RowSet&) {}
+  T Get(int64_t, int64_t) const { return value_; }
+
+ private:
+  OwnedType<T> value_;
+};
+
+// The result of a nested function, computed for all the rows of the set before they are read.
+template <typename T>
+class ComputedOperand {
+ public:
+  explicit ComputedOperand(std::unique_ptr<ValueKernel<T>> kernel) : kernel_(std::move(kernel)) {}
+
+  Status Bind(const RowBatch& input) { return kernel_->Bind(input); }
+  void Prepare(const RowSet& rows) {
+    // The buffer is reused across batches, so this only allocates when the batches grow.
+    values_.resize(rows.size);
+    kernel_->Eval(rows, values_.data());
+  }
+  T Get(int64_t i, int64_t) const { return values_[i]; }
+
+ private:
+  std::unique_ptr<ValueKernel<T>> kernel_;
+  std::vector<T> values_;
+};
+
+/*************************************************
+ * Kernels.
+ *************************************************/
+
+template <typename TOp, typename T, typename TLeft, typename TRight>
+class ArithmeticKernel : public ValueKernel<T> {
+ public:
+  ArithmeticKernel(TLeft left, TRight right) : left_(std::move(left)), right_(std::move(right)) {}
+
+  Status Bind(const RowBatch& input) override {
+    PX_RETURN_IF_ERROR(left_.Bind(input));
+    return right_.Bind(input);
+  }
+  void Eval(const RowSet& rows, T* out) override {
+    left_.Prepare(rows);
+    right_.Prepare(rows);
+    ForEachRow(rows, [&](int64_t i, int64_t row) {
+      out[i] = TOp{}(left_.Get(i, row), right_.Get(i, row));
+    });
+  }
+
+ private:
+  TLeft left_;
+  TRight right_;
+};
+
+template <typename TOp, typename TLeft, typename TRight>
+class ComparisonKernel : public PredicateKernel {
+ public:
+  ComparisonKernel(TLeft left, TRight right) : left_(std::move(left)), right_(std::move(right)) {}
+
+  Status Bind(const RowBatch& input) override {
+    PX_RETURN_IF_ERROR(left_.Bind(input));
+    return right_.Bind(input);
+  }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    left_.Prepare(in);
+    right_.Prepare(in);
+    // Writes every row and only advances past the ones that pass, which avoids a branch per row.
+    out->resize(in.size);
+    int64_t* selected = out->data();
+    int64_t n = 0;
+    ForEachRow(in, [&](int64_t i, int64_t row) {
+      selected[n] = row;
+      n += TOp{}(left_.Get(i, row), right_.Get(i, row));
+    });
+    out->resize(n);
+  }
+
+ private:
+  TLeft left_;
+  TRight right_;
+};
+
+class BoolColumnPredicate : public PredicateKernel {
+ public:
+  explicit BoolColumnPredicate(int64_t index) : column_(index, DataType::BOOLEAN) {}
+
+  Status Bind(const RowBatch& input) override { return column_.Bind(input); }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    out->resize(in.size);
+    int64_t n = 0;
+    ForEachRow(in, [&](int64_t i, int64_t row) {
+      (*out)[n] = row;
+      n += column_.Get(i, row);
+    });
+    out->resize(n);
+  }
+
+ private:
+  ColumnOperand<bool> column_;
+};
+
+class ConstantPredicate : public PredicateKernel {
+ public:
+  explicit ConstantPredicate(bool value) : value_(value) {}
+
+  Status Bind(const RowBatch&) override { return Status::OK(); }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    if (value_) {
+      AssignRows(in, out);
+    } else {
+      out->clear();
+    }
+  }
+
+ private:
+  bool value_;
+};
+
+class AndPredicate : public PredicateKernel {
+ public:
+  AndPredicate(std::unique_ptr<PredicateKernel> left, std::unique_ptr<PredicateKernel> right)
+      : left_(std::move(left)), right_(std::move(right)) {}
+
+  Status Bind(const RowBatch& input) override {
+    PX_RETURN_IF_ERROR(left_->Bind(input));
+    return right_->Bind(input);
+  }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    left_->Filter(in, &left_rows_);
+    // The right side only sees the rows for which the left side is true.
+    right_->Filter(RowSet::Of(left_rows_), out);
+  }
+
+ private:
+  std::unique_ptr<PredicateKernel> left_;
+  std::unique_ptr<PredicateKernel> right_;
+  SelectionVector left_rows_;
+};
+
+class OrPredicate : public PredicateKernel {
+ public:
+  OrPredicate(std::unique_ptr<PredicateKernel> left, std::unique_ptr<PredicateKernel> right)
+      : left_(std::move(left)), right_(std::move(right)) {}
+
+  Status Bind(const RowBatch& input) override {
+    PX_RETURN_IF_ERROR(left_->Bind(input));
+    return right_->Bind(input);
+  }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    left_->Filter(in, &left_rows_);
+    if (static_cast<int64_t>(left_rows_.size()) == in.size) {
+      AssignRows(in, out);
+      return;
+    }
+    // The right side only sees the rows for which the left side is false.
+    DifferenceRows(in, left_rows_, &rest_rows_);
+    right_->Filter(RowSet::Of(rest_rows_), &right_rows_);
+    out->resize(left_rows_.size() + right_rows_.size());
+    std::merge(left_rows_.begin(), left_rows_.end(), right_rows_.begin(), right_rows_.end(),
+               out->begin());
+  }
+
+ private:
+  std::unique_ptr<PredicateKernel> left_;
+  std::unique_ptr<PredicateKernel> right_;
+  SelectionVector left_rows_;
+  SelectionVector rest_rows_;
+  SelectionVector right_rows_;
+};
+
+class NotPredicate : public PredicateKernel {
+ public:
+  explicit NotPredicate(std::unique_ptr<PredicateKernel> child) : child_(std::move(child)) {}
+
+  Status Bind(const RowBatch& input) override { return child_->Bind(input); }
+  void Filter(const RowSet& in, SelectionVector* out) override {
+    child_->Filter(in, &child_rows_);
+    DifferenceRows(in, child_rows_, out);
+  }
+
+ private:
+  std::unique_ptr<PredicateKernel> child_;
+  SelectionVector child_rows_;
+};
+
+/*************************************************
+ * Compilation.
+ *************************************************/
+
+enum class FusedOp {
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kEqual,
+  kNotEqual,
+  kLessThan,
+  kLessThanEqual,
+  kGreaterThan,
+  kGreaterThanEqual,
+  kLogicalAnd,
+  kLogicalOr,
+  kLogicalNot,
+};
+
+const absl::flat_hash_map<std::string, FusedOp>& FusedOps() {
+  static const auto* kOps = new absl::flat_hash_map<std::string, FusedOp>{
+      {"add", FusedOp::kAdd},
+      {"subtract", FusedOp::kSubtract},
+      {"multiply", FusedOp::kMultiply},
+      {"equal", FusedOp::kEqual},
+      {"notEqual", FusedOp::kNotEqual},
+      {"lessThan", FusedOp::kLessThan},
+      {"lessThanEqual", FusedOp::kLessThanEqual},
+      {"greaterThan", FusedOp::kGreaterThan},
+      {"greaterThanEqual", FusedOp::kGreaterThanEqual},
+      {"logicalAnd", FusedOp::kLogicalAnd},
+      {"logicalOr", FusedOp::kLogicalOr},
+      {"logicalNot", FusedOp::kLogicalNot},
+  };
+  return *kOps;
+}
+
+bool IsArithmetic(FusedOp op) {
+  return op == FusedOp::kAdd || op == FusedOp::kSubtract || op == FusedOp::kMultiply;
+}
+
+bool IsLogical(FusedOp op) {
+  return op == FusedOp::kLogicalAnd || op == FusedOp::kLogicalOr || op == FusedOp::kLogicalNot;
+}
+
+// Returns the return type of the builtin op for the given argument types, or UNKNOWN if there is
+// no fused kernel for them. Only the overloads whose semantics the kernels reproduce exactly are
+// fused: eg. equality of FLOAT64 is approximate in the builtins, so it isn't fused.
+DataType FusedReturnType(FusedOp op, const std::vector<DataType>& arg_types) {
+  if (IsLogical(op)) {
+    size_t num_args = op == FusedOp::kLogicalNot ? 1 : 2;
+    if (arg_types.size() != num_args) {
+      return DataType::DATA_TYPE_UNKNOWN;
+    }
+    for (auto type : arg_types) {
+      if (type != DataType::BOOLEAN) {
+        return DataType::DATA_TYPE_UNKNOWN;
+      }
+    }
+    return DataType::BOOLEAN;
+  }
+
+  if (arg_types.size() != 2 || arg_types[0] != arg_types[1]) {
+    return DataType::DATA_TYPE_UNKNOWN;
+  }
+  DataType type = arg_types[0];
+  if (IsArithmetic(op)) {
+    return type == DataType::INT64 || type == DataType::FLOAT64 ? type
+                                                                : DataType::DATA_TYPE_UNKNOWN;
+  }
+  bool is_equality = op == FusedOp::kEqual || op == FusedOp::kNotEqual;
+  switch (type) {
+    case DataType::INT64:
+    case DataType::TIME64NS:
+    case DataType::STRING:
+      return DataType::BOOLEAN;
+    case DataType::FLOAT64:
+      return is_equality ? DataType::DATA_TYPE_UNKNOWN : DataType::BOOLEAN;
+    case DataType::BOOLEAN:
+      return is_equality ? DataType::BOOLEAN : DataType::DATA_TYPE_UNKNOWN;
+    default:
+      return DataType::DATA_TYPE_UNKNOWN;
+  }
+}
+
+// An operand as compiled from an argument expression, before the kernel that reads it is
+// instantiated for its kind.
+template <typename T>
+struct CompiledOperand {
+  enum Kind { kColumn, kConstant, kComputed };
+  Kind kind;
+  int64_t column_index = -1;
+  DataType data_type = DataType::DATA_TYPE_UNKNOWN;
+  OwnedType<T> constant{};
+  std::unique_ptr<ValueKernel<T>> kernel;
+};
+
+// Only INT64 and FLOAT64 values are computed by kernels, so only they can be nested functions.
+template <typename T>
+constexpr bool kHasValueKernels = std::is_same_v<T, int64_t> || std::is_same_v<T, double>;
+
+// Calls fn with the operand of the compiled operand's kind.
+template <typename T, typename TFn>
+auto VisitOperand(CompiledOperand<T> op, TFn&& fn) {
+  if constexpr (kHasValueKernels<T>) {
+    if (op.kind == CompiledOperand<T>::kComputed) {
+      return fn(ComputedOperand<T>(std::move(op.kernel)));
+    }
+  }
+  DCHECK_NE(op.kind, CompiledOperand<T>::kComputed);
+  if (op.kind == CompiledOperand<T>::kColumn) {
+    return fn(ColumnOperand<T>(op.column_index, op.data_type));
+  }
+  return fn(ConstantOperand<T>(std::move(op.constant)));
+}
+
+template <typename TKernel, template <typename, typename> class TMake, typename T>
+std::unique_ptr<TKernel> MakeBinaryKernel(CompiledOperand<T> left, CompiledOperand<T> right) {
+  return VisitOperand(std::move(left), [&right](auto left_operand) {
+    return VisitOperand(std::move(right), [&left_operand](auto right_operand) {
+      using TLeft = decltype(left_operand);
+      using TRight = decltype(right_operand);
+      using TMadeKernel = typename TMake<TLeft, TRight>::type;
+      return std::unique_ptr<TKernel>(
+          new TMadeKernel(std::move(left_operand), std::move(right_operand)));
+    });
+  });
+}
+
+template <typename TOp, typename T>
+struct MakeArithmetic {
+  template <typename TLeft, typename TRight>
+  struct Of {
+    using type = ArithmeticKernel<TOp, T, TLeft, TRight>;
+  };
+};
+
+template <typename TOp>
+struct MakeComparison {
+  template <typename TLeft, typename TRight>
+  struct Of {
+    using type = ComparisonKernel<TOp, TLeft, TRight>;
+  };
+};
+
+template <typename T>
+std::unique_ptr<ValueKernel<T>> MakeArithmeticKernel(FusedOp op, CompiledOperand<T> left,
+                                                     CompiledOperand<T> right) {
+  switch (op) {
+    case FusedOp::kAdd:
+      return MakeBinaryKernel<ValueKernel<T>, MakeArithmetic<std::plus<>, T>::template Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kSubtract:
+      return MakeBinaryKernel<ValueKernel<T>, MakeArithmetic<std::minus<>, T>::template Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kMultiply:
+      return MakeBinaryKernel<ValueKernel<T>, MakeArithmetic<std::multiplies<>, T>::template Of>(
+          std::move(left), std::move(right));
+    default:
+      return nullptr;
+  }
+}
+
+template <typename T>
+std::unique_ptr<PredicateKernel> MakeComparisonKernel(FusedOp op, CompiledOperand<T> left,
+                                                      CompiledOperand<T> right) {
+  switch (op) {
+    case FusedOp::kEqual:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::equal_to<>>::Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kNotEqual:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::not_equal_to<>>::Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kLessThan:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::less<>>::Of>(std::move(left),
+                                                                                std::move(right));
+    case FusedOp::kLessThanEqual:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::less_equal<>>::Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kGreaterThan:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::greater<>>::Of>(
+          std::move(left), std::move(right));
+    case FusedOp::kGreaterThanEqual:
+      return MakeBinaryKernel<PredicateKernel, MakeComparison<std::greater_equal<>>::Of>(
+          std::move(left), std::move(right));
+    default:
+      return nullptr;
+  }
+}
+
+// Compiles expression trees into kernels. Returns an error for any expression that has no fused
+// kernel, in which case the expression should be evaluated by one of the other evaluators.
+class KernelCompiler {
+ public:
+  // exec_state is used to check that the functions resolve to the expected builtins. It may be
+  // null, in which case only the function names and types are checked.
+  explicit KernelCompiler(ExecState* exec_state) : exec_state_(exec_state) {}
+
+  StatusOr<std::unique_ptr<PredicateKernel>> CompilePredicate(const plan::ScalarExpression& expr) {
+    switch (expr.ExpressionType()) {
+      case plan::Expression::kColumn:
+        return std::unique_ptr<PredicateKernel>(new BoolColumnPredicate(
+            static_cast<const plan::Column&>(expr).Index()));
+      case plan::Expression::kConstant: {
+        const auto& val = static_cast<const plan::ScalarValue&>(expr);
+        if (val.DataType() != DataType::BOOLEAN) {
+          return error::InvalidArgument("Expected a BOOLEAN constant");
+        }
+        return std::unique_ptr<PredicateKernel>(new ConstantPredicate(val.BoolValue()));
+      }
+      case plan::Expression::kFunc:
+        break;
+      default:
+        return error::Unimplemented("Unsupported expression type");
+    }
+
+    const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+    PX_ASSIGN_OR_RETURN(FusedOp op, ResolveFunc(fn, DataType::BOOLEAN));
+    const auto& args = fn.arg_deps();
+    switch (op) {
+      case FusedOp::kLogicalAnd:
+      case FusedOp::kLogicalOr: {
+        PX_ASSIGN_OR_RETURN(auto left, CompilePredicate(*args[0]));
+        PX_ASSIGN_OR_RETURN(auto right, CompilePredicate(*args[1]));
+        if (op == FusedOp::kLogicalAnd) {
+          return std::unique_ptr<PredicateKernel>(
+              new AndPredicate(std::move(left), std::move(right)));
+        }
+        return std::unique_ptr<PredicateKernel>(new OrPredicate(std::move(left), std::move(right)));
+      }
+      case FusedOp::kLogicalNot: {
+        PX_ASSIGN_OR_RETURN(auto child, CompilePredicate(*args[0]));
+        return std::unique_ptr<PredicateKernel>(new NotPredicate(std::move(child)));
+      }
+      default:
+        break;
+    }
+
+    // PX_CARNOT_UPDATE_FOR_NEW_TYPES.
+    switch (fn.registry_arg_types()[0]) {
+      case DataType::BOOLEAN:
+        return CompileComparison<DataType::BOOLEAN>(op, fn);
+      case DataType::INT64:
+        return CompileComparison<DataType::INT64>(op, fn);
+      case DataType::FLOAT64:
+        return CompileComparison<DataType::FLOAT64>(op, fn);
+      case DataType::TIME64NS:
+        return CompileComparison<DataType::TIME64NS>(op, fn);
+      case DataType::STRING:
+        return CompileComparison<DataType::STRING>(op, fn);
+      default:
+        return error::Unimplemented("Unsupported comparison type");
+    }
+  }
+
+  template <DataType TDataType>
+  StatusOr<std::unique_ptr<ValueKernel<typename FusedTypeTraits<TDataType>::native_type>>>
+  CompileValue(const plan::ScalarExpression& expr) {
+    if (expr.ExpressionType() != plan::Expression::kFunc) {
+      return error::Unimplemented("Only functions compile to value kernels");
+    }
+    const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+    PX_ASSIGN_OR_RETURN(FusedOp op, ResolveFunc(fn, TDataType));
+    if (!IsArithmetic(op)) {
+      return error::Unimplemented("$0 does not compile to a value kernel", fn.name());
+    }
+    PX_ASSIGN_OR_RETURN(auto left, CompileOperand<TDataType>(*fn.arg_deps()[0]));
+    PX_ASSIGN_OR_RETURN(auto right, CompileOperand<TDataType>(*fn.arg_deps()[1]));
+    return MakeArithmeticKernel(op, std::move(left), std::move(right));
+  }
+
+ private:
+  // Checks that the function has a fused kernel and returns the given type.
+  StatusOr<FusedOp> ResolveFunc(const plan::ScalarFunc& fn, DataType return_type) {
+    auto it = FusedOps().find(fn.name());
+    if (it == FusedOps().end()) {
+      return error::Unimplemented("No fused kernel for $0", fn.name());
+    }
+    if (!fn.init_arguments().empty() || fn.arg_deps().size() != fn.registry_arg_types().size()) {
+      return error::Unimplemented("Unexpected arguments to $0", fn.name());
+    }
+    if (FusedReturnType(it->second, fn.registry_arg_types()) != return_type) {
+      return error::Unimplemented("No fused kernel for $0 with these types", fn.name());
+    }
+    if (exec_state_ != nullptr) {
+      // Catch registries that register a different function under a builtin's name.
+      const auto& udfs = exec_state_->id_to_scalar_udf_map();
+      auto def = udfs.find(fn.udf_id());
+      if (def == udfs.end() || def->second->exec_return_type() != return_type) {
+        return error::Unimplemented("$0 does not resolve to a builtin", fn.name());
+      }
+    }
+    return it->second;
+  }
+
+  template <DataType TDataType>
+  StatusOr<CompiledOperand<typename FusedTypeTraits<TDataType>::native_type>> CompileOperand(
+      const plan::ScalarExpression& expr) {
+    using T = typename FusedTypeTraits<TDataType>::native_type;
+    CompiledOperand<T> operand;
+    operand.data_type = TDataType;
+    switch (expr.ExpressionType()) {
+      case plan::Expression::kColumn:
+        operand.kind = CompiledOperand<T>::kColumn;
+        operand.column_index = static_cast<const plan::Column&>(expr).Index();
+        return operand;
+      case plan::Expression::kConstant: {
+        const auto& val = static_cast<const plan::ScalarValue&>(expr);
+        if (val.DataType() != TDataType) {
+          return error::Unimplemented("Constant of unexpected type");
+        }
+        operand.kind = CompiledOperand<T>::kConstant;
+        // PX_CARNOT_UPDATE_FOR_NEW_TYPES.
+        if constexpr (TDataType == DataType::BOOLEAN) {
+          operand.constant = val.BoolValue();
+        } else if constexpr (TDataType == DataType::INT64) {
+          operand.constant = val.Int64Value();
+        } else if constexpr (TDataType == DataType::FLOAT64) {
+          operand.constant = val.Float64Value();
+        } else if constexpr (TDataType == DataType::TIME64NS) {
+          operand.constant = val.Time64NSValue();
+        } else if constexpr (TDataType == DataType::STRING) {
+          operand.constant = val.StringValue();
+        }
+        return operand;
+      }
+      case plan::Expression::kFunc:
+        if constexpr (kHasValueKernels<T>) {
+          operand.kind = CompiledOperand<T>::kComputed;
+          PX_ASSIGN_OR_RETURN(operand.kernel, CompileValue<TDataType>(expr));
+          return operand;
+        }
+        return error::Unimplemented("Nested functions of this type can't be fused");
+      default:
+        return error::Unimplemented("Unsupported expression type");
+    }
+  }
+
+  template <DataType TDataType>
+  StatusOr<std::unique_ptr<PredicateKernel>> CompileComparison(FusedOp op,
+                                                               const plan::ScalarFunc& fn) {
+    PX_ASSIGN_OR_RETURN(auto left, CompileOperand<TDataType>(*fn.arg_deps()[0]));
+    PX_ASSIGN_OR_RETURN(auto right, CompileOperand<TDataType>(*fn.arg_deps()[1]));
+    return MakeComparisonKernel(op, std::move(left), std::move(right));
+  }
+
+  ExecState* exec_state_;
+};
+
+}  // namespace
+
+/*************************************************
+ * Compiled expressions.
+ *************************************************/
+
+class FusedExpression {
+ public:
+  virtual ~FusedExpression() = default;
+
+  virtual StatusOr<std::shared_ptr<arrow::Array>> Evaluate(ExecState* exec_state,
+                                                           const RowBatch& input) = 0;
+
+  virtual StatusOr<SelectionVector> Select(const RowBatch&) {
+    return error::InvalidArgument("Expression is not a predicate");
+  }
+};
+
+namespace {
+
+// Selects the rows of the input for which the kernel is true.
+StatusOr<SelectionVector> SelectRows(PredicateKernel* kernel, const RowBatch& input) {
+  PX_RETURN_IF_ERROR(kernel->Bind(input));
+  SelectionVector rows;
+  kernel->Filter(RowSet::All(input.num_rows()), &rows);
+  return rows;
+}
+
+class ColumnExpression : public FusedExpression {
+ public:
+  explicit ColumnExpression(int64_t index) : index_(index), predicate_(index) {}
+
+  StatusOr<std::shared_ptr<arrow::Array>> Evaluate(ExecState*, const RowBatch& input) override {
+    return input.ColumnAt(index_);
+  }
+
+  // A bare BOOLEAN column is a predicate, eg. df[df.bool_col]. Binding fails for other types.
+  StatusOr<SelectionVector> Select(const RowBatch& input) override {
+    return SelectRows(&predicate_, input);
+  }
+
+ private:
+  int64_t index_;
+  BoolColumnPredicate predicate_;
+};
+
+class ConstantExpression : public FusedExpression {
+ public:
+  explicit ConstantExpression(const plan::ScalarValue& value)
+      : value_(value),
+        predicate_(value.DataType() == DataType::BOOLEAN && value.BoolValue()) {}
+
+  StatusOr<std::shared_ptr<arrow::Array>> Evaluate(ExecState* exec_state,
+                                                   const RowBatch& input) override {
+    return EvalScalarToArrow(exec_state, value_, input.num_rows());
+  }
+
+  StatusOr<SelectionVector> Select(const RowBatch& input) override {
+    if (value_.DataType() != DataType::BOOLEAN) {
+      return FusedExpression::Select(input);
+    }
+    return SelectRows(&predicate_, input);
+  }
+
+ private:
+  plan::ScalarValue value_;
+  ConstantPredicate predicate_;
+};
+
+class PredicateExpression : public FusedExpression {
+ public:
+  explicit PredicateExpression(std::unique_ptr<PredicateKernel> kernel)
+      : kernel_(std::move(kernel)) {}
+
+  StatusOr<std::shared_ptr<arrow::Array>> Evaluate(ExecState* exec_state,
+                                                   const RowBatch& input) override {
+    PX_ASSIGN_OR_RETURN(SelectionVector rows, Select(input));
+    arrow::BooleanBuilder builder(exec_state->exec_mem_pool());
+    PX_RETURN_IF_ERROR(builder.Reserve(input.num_rows()));
+    size_t j = 0;
+    for (int64_t i = 0; i < input.num_rows(); ++i) {
+      bool selected = j < rows.size() && rows[j] == i;
+      j += selected;
+      builder.UnsafeAppend(selected);
+    }
+    std::shared_ptr<arrow::Array> out;
+    PX_RETURN_IF_ERROR(builder.Finish(&out));
+    return out;
+  }
+
+  StatusOr<SelectionVector> Select(const RowBatch& input) override {
+    return SelectRows(kernel_.get(), input);
+  }
+
+ private:
+  std::unique_ptr<PredicateKernel> kernel_;
+};
+
+template <DataType TDataType>
+class ValueExpression : public FusedExpression {
+  using T = typename FusedTypeTraits<TDataType>::native_type;
+
+ public:
+  explicit ValueExpression(std::unique_ptr<ValueKernel<T>> kernel) : kernel_(std::move(kernel)) {}
+
+  StatusOr<std::shared_ptr<arrow::Array>> Evaluate(ExecState* exec_state,
+                                                   const RowBatch& input) override {
+    PX_RETURN_IF_ERROR(kernel_->Bind(input));
+    values_.resize(input.num_rows());
+    kernel_->Eval(RowSet::All(input.num_rows()), values_.data());
+    auto builder = types::GetArrowBuilder<TDataType>(exec_state->exec_mem_pool());
+    PX_RETURN_IF_ERROR(builder->AppendValues(values_.data(), values_.size()));
+    std::shared_ptr<arrow::Array> out;
+    PX_RETURN_IF_ERROR(builder->Finish(&out));
+    return out;
+  }
+
+ private:
+  std::unique_ptr<ValueKernel<T>> kernel_;
+  std::vector<T> values_;
+};
+
+StatusOr<std::unique_ptr<FusedExpression>> CompileExpression(ExecState* exec_state,
+                                                             const plan::ScalarExpression& expr) {
+  switch (expr.ExpressionType()) {
+    case plan::Expression::kColumn:
+      return std::unique_ptr<FusedExpression>(
+          new ColumnExpression(static_cast<const plan::Column&>(expr).Index()));
+    case plan::Expression::kConstant:
+      return std::unique_ptr<FusedExpression>(
+          new ConstantExpression(static_cast<const plan::ScalarValue&>(expr)));
+    case plan::Expression::kFunc:
+      break;
+    default:
+      return error::Unimplemented("Unsupported expression type");
+  }
+
+  const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+  auto it = FusedOps().find(fn.name());
+  if (it == FusedOps().end()) {
+    return error::Unimplemented("No fused kernel for $0", fn.name());
+  }
+  KernelCompiler compiler(exec_state);
+  switch (FusedReturnType(it->second, fn.registry_arg_types())) {
+    case DataType::BOOLEAN: {
+      PX_ASSIGN_OR_RETURN(auto kernel, compiler.CompilePredicate(expr));
+      return std::unique_ptr<FusedExpression>(new PredicateExpression(std::move(kernel)));
+    }
+    case DataType::INT64: {
+      PX_ASSIGN_OR_RETURN(auto kernel, compiler.CompileValue<DataType::INT64>(expr));
+      return std::unique_ptr<FusedExpression>(
+          new ValueExpression<DataType::INT64>(std::move(kernel)));
+    }
+    case DataType::FLOAT64: {
+      PX_ASSIGN_OR_RETURN(auto kernel, compiler.CompileValue<DataType::FLOAT64>(expr));
+      return std::unique_ptr<FusedExpression>(
+          new ValueExpression<DataType::FLOAT64>(std::move(kernel)));
+    }
+    default:
+      return error::Unimplemented("No fused kernel for $0 with these types", fn.name());
+  }
+}
+
+}  // namespace
+
+/*************************************************
+ * Evaluator.
+ *************************************************/
+
+FusedScalarExpressionEvaluator::FusedScalarExpressionEvaluator(
+    const plan::ConstScalarExpressionVector& expressions, udf::FunctionContext* function_ctx)
+    : ScalarExpressionEvaluator(expressions, function_ctx) {}
+
+FusedScalarExpressionEvaluator::~FusedScalarExpressionEvaluator() = default;
+
+bool FusedScalarExpressionEvaluator::CanFuse(
+    ExecState* exec_state, const plan::ConstScalarExpressionVector& expressions) {
+  for (const auto& expr : expressions) {
+    if (!CompileExpression(exec_state, *expr).ok()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status FusedScalarExpressionEvaluator::Open(ExecState* exec_state) {
+  // The builtins that have fused kernels don't have init arguments or state, so there are no
+  // UDF instances to create.
+  for (const auto& expr : expressions_) {
+    PX_ASSIGN_OR_RETURN(compiled_[expr.get()], CompileExpression(exec_state, *expr));
+  }
+  return Status::OK();
+}
+
+Status FusedScalarExpressionEvaluator::Close(ExecState*) {
+  compiled_.clear();
+  return Status::OK();
+}
+
+StatusOr<FusedExpression*> FusedScalarExpressionEvaluator::GetCompiled(
+    const plan::ScalarExpression& expr) {
+  auto it = compiled_.find(&expr);
+  if (it == compiled_.end()) {
+    return error::Internal("Expression $0 was not compiled", expr.DebugString());
+  }
+  return it->second.get();
+}
+
+Status FusedScalarExpressionEvaluator::EvaluateSingleExpression(ExecState* exec_state,
+                                                                const RowBatch& input,
+                                                                const plan::ScalarExpression& expr,
+                                                                RowBatch* output) {
+  PX_ASSIGN_OR_RETURN(auto compiled, GetCompiled(expr));
+  PX_ASSIGN_OR_RETURN(auto result, compiled->Evaluate(exec_state, input));
+  PX_RETURN_IF_ERROR(output->AddColumn(result));
+  return Status::OK();
+}
+
+StatusOr<SelectionVector> FusedScalarExpressionEvaluator::EvaluatePredicate(
+    const RowBatch& input, const plan::ScalarExpression& expr) {
+  PX_ASSIGN_OR_RETURN(auto compiled, GetCompiled(expr));
+  return compiled->Select(input);
+}
+
+ScalarExpressionEvaluatorType ChooseScalarExpressionEvaluator(
+    ExecState* exec_state, const plan::ConstScalarExpressionVector& expressions,
+    ScalarExpressionEvaluatorType fallback) {
+  if (FLAGS_carnot_fused_expression_evaluation &&
+      FusedScalarExpressionEvaluator::CanFuse(exec_state, expressions)) {
+    return ScalarExpressionEvaluatorType::kFused;
+  }
+  return fallback;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/carnot/udf/base.h"
+#include "src/common/base/base.h"
+#include "src/table_store/table_store.h"
+
+DECLARE_bool(carnot_fused_expression_evaluation);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+// An expression compiled into fused kernels. Defined in the .cc file.
+class FusedExpression;
+
+/**
+ * A scalar expression evaluator that compiles expression trees of common builtin functions
+ * (arithmetic, comparisons and logical operators over INT64, FLOAT64, TIME64NS, BOOLEAN and STRING)
+ * into kernels specialized at compile time for the argument types and for whether each argument
+ * is a column, a constant or a nested function.
+ *
+ * The whole tree is evaluated in one pass over the row batch, without materializing a column per
+ * function call. Predicates are evaluated over selection vectors, so the right side of an AND is
+ * only evaluated on the rows where the left side is true (and likewise for OR), and nested
+ * arithmetic only runs on the rows that are still selected.
+ */
+class FusedScalarExpressionEvaluator : public ScalarExpressionEvaluator {
+ public:
+  FusedScalarExpressionEvaluator(const plan::ConstScalarExpressionVector& expressions,
+                                 udf::FunctionContext* function_ctx);
+  ~FusedScalarExpressionEvaluator() override;
+
+  /**
+   * Returns whether all the expressions can be evaluated by this evaluator, ie. whether they only
+   * consist of columns, constants and builtin functions that have a fused kernel.
+   */
+  static bool CanFuse(ExecState* exec_state, const plan::ConstScalarExpressionVector& expressions);
+
+  Status Open(ExecState* exec_state) override;
+  Status Close(ExecState* exec_state) override;
+
+  /**
+   * Evaluates a BOOLEAN expression, and returns the indices of the rows of the input for which it
+   * is true, in increasing order.
+   */
+  StatusOr<table_store::schema::SelectionVector> EvaluatePredicate(
+      const table_store::schema::RowBatch& input, const plan::ScalarExpression& expr);
+
+ protected:
+  Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
+                                  const plan::ScalarExpression& expr,
+                                  table_store::schema::RowBatch* output) override;
+
+ private:
+  StatusOr<FusedExpression*> GetCompiled(const plan::ScalarExpression& expr);
+
+  std::map<const plan::ScalarExpression*, std::unique_ptr<FusedExpression>> compiled_;
+};
+
+/**
+ * Returns kFused if fused evaluation is enabled and the FusedScalarExpressionEvaluator can evaluate
+ * all the expressions, and the fallback type otherwise.
+ */
+ScalarExpressionEvaluatorType ChooseScalarExpressionEvaluator(
+    ExecState* exec_state, const plan::ConstScalarExpressionVector& expressions,
+    ScalarExpressionEvaluatorType fallback);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
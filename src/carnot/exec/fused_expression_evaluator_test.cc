@@ -0,0 +1,281 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/fused_expression_evaluator.h"
+
+#include <arrow/memory_pool.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/funcs/builtins/builtins.h"
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+using table_store::schema::SelectionVector;
+using types::DataType;
+using types::ToArrow;
+
+constexpr int64_t kNumRows = 1000;
+
+class FusedScalarExpressionEvaluatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    builtins::RegisterBuiltinsOrDie(func_registry_.get());
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, MockMetricsStubGenerator,
+                                              MockTraceStubGenerator, sole::uuid4(), nullptr);
+    function_ctx_ = exec_state_->CreateFunctionContext();
+
+    // Columns: a INT64, b FLOAT64, c STRING, d BOOLEAN, e TIME64NS.
+    std::vector<types::Int64Value> a;
+    std::vector<types::Float64Value> b;
+    std::vector<types::StringValue> c;
+    std::vector<types::BoolValue> d;
+    std::vector<types::Time64NSValue> e;
+    for (int64_t i = 0; i < kNumRows; ++i) {
+      a.emplace_back((i * 7919) % 23);
+      b.emplace_back(static_cast<double>((i * 104729) % 31) / 2);
+      c.emplace_back(std::string(1, static_cast<char>('w' + i % 4)));
+      d.emplace_back(i % 3 == 0);
+      e.emplace_back(i * 1000);
+    }
+    RowDescriptor rd({DataType::INT64, DataType::FLOAT64, DataType::STRING, DataType::BOOLEAN,
+                      DataType::TIME64NS});
+    input_rb_ = std::make_unique<RowBatch>(rd, kNumRows);
+    auto* pool = arrow::default_memory_pool();
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(a, pool)));
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(b, pool)));
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(c, pool)));
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(d, pool)));
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(e, pool)));
+  }
+
+  static planpb::ScalarExpression Col(int64_t index) {
+    planpb::ScalarExpression expr;
+    expr.mutable_column()->set_index(index);
+    return expr;
+  }
+
+  static planpb::ScalarExpression Int(int64_t val) {
+    planpb::ScalarExpression expr;
+    expr.mutable_constant()->set_data_type(DataType::INT64);
+    expr.mutable_constant()->set_int64_value(val);
+    return expr;
+  }
+
+  static planpb::ScalarExpression Float(double val) {
+    planpb::ScalarExpression expr;
+    expr.mutable_constant()->set_data_type(DataType::FLOAT64);
+    expr.mutable_constant()->set_float64_value(val);
+    return expr;
+  }
+
+  static planpb::ScalarExpression Str(const std::string& val) {
+    planpb::ScalarExpression expr;
+    expr.mutable_constant()->set_data_type(DataType::STRING);
+    expr.mutable_constant()->set_string_value(val);
+    return expr;
+  }
+
+  // Returns a call to the function, and registers the function with the exec state under a new id.
+  planpb::ScalarExpression Func(const std::string& name,
+                                const std::vector<planpb::ScalarExpression>& args,
+                                const std::vector<DataType>& arg_types) {
+    int64_t id = next_udf_id_++;
+    EXPECT_OK(exec_state_->AddScalarUDF(id, name, arg_types));
+    planpb::ScalarExpression expr;
+    auto* func = expr.mutable_func();
+    func->set_name(name);
+    func->set_id(id);
+    for (const auto& arg : args) {
+      *func->add_args() = arg;
+    }
+    for (auto type : arg_types) {
+      func->add_args_data_types(type);
+    }
+    return expr;
+  }
+
+  static std::shared_ptr<const plan::ScalarExpression> Expr(const planpb::ScalarExpression& pb) {
+    auto s_or_se = plan::ScalarExpression::FromProto(pb);
+    EXPECT_OK(s_or_se);
+    return s_or_se.ConsumeValueOrDie();
+  }
+
+  // Evaluates the expression with the given evaluator type and returns the output column.
+  std::shared_ptr<arrow::Array> Evaluate(ScalarExpressionEvaluatorType type,
+                                         std::shared_ptr<const plan::ScalarExpression> expr,
+                                         DataType output_type) {
+    auto evaluator = ScalarExpressionEvaluator::Create({expr}, type, function_ctx_.get());
+    EXPECT_OK(evaluator->Open(exec_state_.get()));
+    RowBatch output_rb(RowDescriptor({output_type}), input_rb_->num_rows());
+    EXPECT_OK(evaluator->Evaluate(exec_state_.get(), *input_rb_, &output_rb));
+    EXPECT_OK(evaluator->Close(exec_state_.get()));
+    return output_rb.ColumnAt(0);
+  }
+
+  // Checks that the fused evaluator agrees with the vector native evaluator on the expression.
+  void ExpectSameAsVectorNative(const planpb::ScalarExpression& pb, DataType output_type) {
+    auto expr = Expr(pb);
+    ASSERT_TRUE(FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {expr}));
+
+    auto expected = Evaluate(ScalarExpressionEvaluatorType::kVectorNative, expr, output_type);
+    auto actual = Evaluate(ScalarExpressionEvaluatorType::kFused, expr, output_type);
+    EXPECT_TRUE(expected->Equals(actual))
+        << "expected: " << expected->ToString() << "\nactual: " << actual->ToString();
+
+    if (output_type != DataType::BOOLEAN) {
+      return;
+    }
+    SelectionVector expected_selection;
+    const auto& bools = static_cast<const arrow::BooleanArray&>(*expected);
+    for (int64_t i = 0; i < bools.length(); ++i) {
+      if (bools.Value(i)) {
+        expected_selection.push_back(i);
+      }
+    }
+    FusedScalarExpressionEvaluator evaluator({expr}, function_ctx_.get());
+    ASSERT_OK(evaluator.Open(exec_state_.get()));
+    ASSERT_OK_AND_ASSIGN(SelectionVector selection,
+                         evaluator.EvaluatePredicate(*input_rb_, *expr));
+    EXPECT_EQ(expected_selection, selection);
+    ASSERT_OK(evaluator.Close(exec_state_.get()));
+  }
+
+  std::unique_ptr<udf::Registry> func_registry_;
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::FunctionContext> function_ctx_;
+  std::unique_ptr<RowBatch> input_rb_;
+  int64_t next_udf_id_ = 0;
+};
+
+TEST_F(FusedScalarExpressionEvaluatorTest, conjunction_of_comparisons) {
+  // (a > 5) and (b < 10.0) and (c == 'x')
+  auto a_gt = Func("greaterThan", {Col(0), Int(5)}, {DataType::INT64, DataType::INT64});
+  auto b_lt = Func("lessThan", {Col(1), Float(10.0)}, {DataType::FLOAT64, DataType::FLOAT64});
+  auto c_eq = Func("equal", {Col(2), Str("x")}, {DataType::STRING, DataType::STRING});
+  auto lhs = Func("logicalAnd", {a_gt, b_lt}, {DataType::BOOLEAN, DataType::BOOLEAN});
+  ExpectSameAsVectorNative(Func("logicalAnd", {lhs, c_eq}, {DataType::BOOLEAN, DataType::BOOLEAN}),
+                           DataType::BOOLEAN);
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, disjunction_and_negation) {
+  // not(d) or (a * 2 - 3 >= a + 4) or (e != 5000)
+  auto not_d = Func("logicalNot", {Col(3)}, {DataType::BOOLEAN});
+  auto mul = Func("multiply", {Col(0), Int(2)}, {DataType::INT64, DataType::INT64});
+  auto sub = Func("subtract", {mul, Int(3)}, {DataType::INT64, DataType::INT64});
+  auto add = Func("add", {Col(0), Int(4)}, {DataType::INT64, DataType::INT64});
+  auto ge = Func("greaterThanEqual", {sub, add}, {DataType::INT64, DataType::INT64});
+  planpb::ScalarExpression time;
+  time.mutable_constant()->set_data_type(DataType::TIME64NS);
+  time.mutable_constant()->set_time64_ns_value(5000);
+  auto ne = Func("notEqual", {Col(4), time}, {DataType::TIME64NS, DataType::TIME64NS});
+  auto lhs = Func("logicalOr", {not_d, ge}, {DataType::BOOLEAN, DataType::BOOLEAN});
+  ExpectSameAsVectorNative(Func("logicalOr", {lhs, ne}, {DataType::BOOLEAN, DataType::BOOLEAN}),
+                           DataType::BOOLEAN);
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, nested_logical_operators) {
+  // (d == (a < 10)) and not((c != 'w') or (b > 7.5))
+  auto a_lt = Func("lessThan", {Col(0), Int(10)}, {DataType::INT64, DataType::INT64});
+  auto d_eq = Func("equal", {Col(3), a_lt}, {DataType::BOOLEAN, DataType::BOOLEAN});
+  auto c_ne = Func("notEqual", {Col(2), Str("w")}, {DataType::STRING, DataType::STRING});
+  auto b_gt = Func("greaterThan", {Col(1), Float(7.5)}, {DataType::FLOAT64, DataType::FLOAT64});
+  auto either = Func("logicalOr", {c_ne, b_gt}, {DataType::BOOLEAN, DataType::BOOLEAN});
+  auto neither = Func("logicalNot", {either}, {DataType::BOOLEAN});
+  ExpectSameAsVectorNative(
+      Func("logicalAnd", {d_eq, neither}, {DataType::BOOLEAN, DataType::BOOLEAN}),
+      DataType::BOOLEAN);
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, arithmetic) {
+  // (a * a) + (3 - a)
+  auto square = Func("multiply", {Col(0), Col(0)}, {DataType::INT64, DataType::INT64});
+  auto diff = Func("subtract", {Int(3), Col(0)}, {DataType::INT64, DataType::INT64});
+  ExpectSameAsVectorNative(Func("add", {square, diff}, {DataType::INT64, DataType::INT64}),
+                           DataType::INT64);
+
+  // b * 1.5 + b
+  auto scaled = Func("multiply", {Col(1), Float(1.5)}, {DataType::FLOAT64, DataType::FLOAT64});
+  ExpectSameAsVectorNative(Func("add", {scaled, Col(1)}, {DataType::FLOAT64, DataType::FLOAT64}),
+                           DataType::FLOAT64);
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, columns_and_constants) {
+  ExpectSameAsVectorNative(Col(2), DataType::STRING);
+  ExpectSameAsVectorNative(Int(42), DataType::INT64);
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, cannot_fuse) {
+  // Equality of floats is approximate in the builtins.
+  auto float_eq = Func("equal", {Col(1), Float(1.0)}, {DataType::FLOAT64, DataType::FLOAT64});
+  EXPECT_FALSE(FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {Expr(float_eq)}));
+
+  // Mixed argument types.
+  auto mixed_add = Func("add", {Col(1), Col(0)}, {DataType::FLOAT64, DataType::INT64});
+  EXPECT_FALSE(FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {Expr(mixed_add)}));
+
+  // A builtin with no fused kernel, nested in a fusable one.
+  auto pluck = Func("pluck", {Col(2), Str("key")}, {DataType::STRING, DataType::STRING});
+  auto pluck_eq = Func("equal", {pluck, Str("x")}, {DataType::STRING, DataType::STRING});
+  EXPECT_FALSE(FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {Expr(pluck_eq)}));
+
+  // Every expression must be fusable.
+  auto a_gt = Func("greaterThan", {Col(0), Int(5)}, {DataType::INT64, DataType::INT64});
+  EXPECT_TRUE(FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {Expr(a_gt)}));
+  EXPECT_FALSE(
+      FusedScalarExpressionEvaluator::CanFuse(exec_state_.get(), {Expr(a_gt), Expr(float_eq)}));
+}
+
+TEST_F(FusedScalarExpressionEvaluatorTest, choose_evaluator) {
+  auto a_gt = Func("greaterThan", {Col(0), Int(5)}, {DataType::INT64, DataType::INT64});
+  auto float_eq = Func("equal", {Col(1), Float(1.0)}, {DataType::FLOAT64, DataType::FLOAT64});
+  EXPECT_EQ(ScalarExpressionEvaluatorType::kFused,
+            ChooseScalarExpressionEvaluator(exec_state_.get(), {Expr(a_gt)},
+                                            ScalarExpressionEvaluatorType::kArrowNative));
+  EXPECT_EQ(ScalarExpressionEvaluatorType::kArrowNative,
+            ChooseScalarExpressionEvaluator(exec_state_.get(), {Expr(float_eq)},
+                                            ScalarExpressionEvaluatorType::kArrowNative));
+
+  PX_SET_FOR_SCOPE(FLAGS_carnot_fused_expression_evaluation, false);
+  EXPECT_EQ(ScalarExpressionEvaluatorType::kVectorNative,
+            ChooseScalarExpressionEvaluator(exec_state_.get(), {Expr(a_gt)},
+                                            ScalarExpressionEvaluatorType::kVectorNative));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
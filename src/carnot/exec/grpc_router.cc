@@ -29,19 +29,58 @@
 
 #include "src/carnot/exec/grpc_source_node.h"
 #include "src/common/base/base.h"
+#include "src/common/metrics/metrics.h"
 #include "src/common/uuid/uuid.h"
 
+DEFINE_int64(grpc_router_max_queued_batches_per_producer,
+             gflags::Int64FromEnv("PL_GRPC_ROUTER_MAX_QUEUED_BATCHES_PER_PRODUCER", 64),
+             "The maximum number of row batches received on one incoming result stream that may be "
+             "waiting to be consumed. Once reached, the router stops reading from the stream until "
+             "the query catches up, which pushes back on the producer through gRPC flow control. "
+             "0 means no limit.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
+using table_store::schema::RowBatch;
+
+namespace {
+
+prometheus::Histogram::BucketBoundaries LatencyBuckets() {
+  return {1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 0.1, 0.5, 1, 5};
+}
+
+}  // namespace
+
+GRPCRouter::GRPCRouter()
+    : queued_batches_gauge_(
+          prometheus::BuildGauge()
+              .Name("carnot_grpc_router_queued_row_batches")
+              .Help("Number of row batches received by the GRPC router that haven't been consumed")
+              .Register(GetMetricsRegistry())
+              .Add({})),
+      decode_latency_histogram_(
+          prometheus::BuildHistogram()
+              .Name("carnot_grpc_router_decode_latency_seconds")
+              .Help("Time taken to decode a row batch received by the GRPC router")
+              .Register(GetMetricsRegistry())
+              .Add({}, LatencyBuckets())),
+      backpressure_wait_histogram_(
+          prometheus::BuildHistogram()
+              .Name("carnot_grpc_router_backpressure_wait_seconds")
+              .Help("Time an incoming result stream waited for its queued batches to be consumed")
+              .Register(GetMetricsRegistry())
+              .Add({}, LatencyBuckets())) {}
+
 GRPCRouter::SourceNodeTracker* GRPCRouter::GetSourceNodeTracker(QueryTracker* query_tracker,
                                                                 int64_t source_id) {
   absl::base_internal::SpinLockHolder query_lock(&query_tracker->query_lock);
   return &query_tracker->source_node_trackers[source_id];
 }
 
-Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
+Status GRPCRouter::EnqueueRowBatch(const std::shared_ptr<QueryTracker>& query_tracker,
+                                   const std::shared_ptr<ProducerFlow>& producer_flow,
                                    std::unique_ptr<carnotpb::TransferResultChunkRequest> req) {
   if (!req->has_query_result() || !req->query_result().has_row_batch() ||
       req->query_result().destination_case() !=
@@ -51,23 +90,86 @@ Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
         "with a GPRC source ID.");
   }
 
-  auto snt = GetSourceNodeTracker(query_tracker, req->query_result().grpc_source_id());
+  // Decode on this (the sender's) gRPC thread, outside of any locks, so that batches from
+  // different agents are decoded in parallel.
+  int64_t source_id = req->query_result().grpc_source_id();
+  auto decode_start = std::chrono::steady_clock::now();
+  PX_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> rb,
+                      RowBatch::FromProto(req->query_result().row_batch()));
+  decode_latency_histogram_.Observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - decode_start).count());
+  req.reset();
+
+  // Count the batch before handing it over, so that it can't be consumed before it is counted.
+  {
+    absl::MutexLock lock(&producer_flow->lock);
+    ++producer_flow->queued_batches;
+  }
+  ++query_tracker->queued_batches;
+  queued_batches_gauge_.Increment();
+
+  auto snt = GetSourceNodeTracker(query_tracker.get(), source_id);
   {
     absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
     // It's possible that we see row batches before we have gotten information about the query. To
     // solve this race, We store a backlog of all the pending batches.
     if (snt->source_node == nullptr) {
       snt->connection_initiated_by_sink = true;
-      snt->response_backlog.emplace_back(std::move(req));
+      snt->response_backlog.push_back({std::move(rb), producer_flow});
       return Status::OK();
     }
     snt->source_node->set_upstream_initiated_connection();
-    PX_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(req)));
+    auto s = snt->source_node->EnqueueDecodedRowBatch(
+        std::move(rb), RowBatchConsumedCallback(query_tracker, producer_flow));
+    if (!s.ok()) {
+      OnRowBatchConsumed(query_tracker.get(), producer_flow.get());
+      return s;
+    }
   }
   query_tracker->RestartExecution();
   return Status::OK();
 }
 
+std::function<void()> GRPCRouter::RowBatchConsumedCallback(
+    std::shared_ptr<QueryTracker> query_tracker, std::shared_ptr<ProducerFlow> producer_flow) {
+  return [this, query_tracker = std::move(query_tracker),
+          producer_flow = std::move(producer_flow)]() {
+    OnRowBatchConsumed(query_tracker.get(), producer_flow.get());
+  };
+}
+
+void GRPCRouter::OnRowBatchConsumed(QueryTracker* query_tracker, ProducerFlow* producer_flow) {
+  --query_tracker->queued_batches;
+  queued_batches_gauge_.Decrement();
+  absl::MutexLock lock(&producer_flow->lock);
+  --producer_flow->queued_batches;
+}
+
+bool GRPCRouter::HasProducerCapacity(ProducerFlow* producer_flow) {
+  return producer_flow->queued_batches < FLAGS_grpc_router_max_queued_batches_per_producer;
+}
+
+void GRPCRouter::WaitForProducerCapacity(ProducerFlow* producer_flow,
+                                         ::grpc::ServerContext* context) {
+  if (FLAGS_grpc_router_max_queued_batches_per_producer <= 0) {
+    return;
+  }
+  absl::MutexLock lock(&producer_flow->lock);
+  absl::Condition has_capacity(&HasProducerCapacity, producer_flow);
+  if (has_capacity.Eval()) {
+    return;
+  }
+  auto wait_start = std::chrono::steady_clock::now();
+  // Wake up periodically to notice cancelled streams, including those of deleted queries.
+  while (!producer_flow->lock.AwaitWithTimeout(has_capacity, absl::Milliseconds(100))) {
+    if (context->IsCancelled()) {
+      break;
+    }
+  }
+  backpressure_wait_histogram_.Observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count());
+}
+
 void GRPCRouter::MarkResultStreamClosed(QueryTracker* query_tracker, int64_t source_id) {
   auto snt = GetSourceNodeTracker(query_tracker, source_id);
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
@@ -141,7 +243,7 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
   if (req->has_query_result() && req->query_result().has_row_batch()) {
     state->stream_has_query_results = true;
     state->source_node_id = req->query_result().grpc_source_id();
-    auto s = EnqueueRowBatch(state->query_tracker.get(), std::move(req));
+    auto s = EnqueueRowBatch(state->query_tracker, state->producer_flow, std::move(req));
     if (!s.ok()) {
       return ::grpc::Status(grpc::StatusCode::INTERNAL, "failed to enqueue batch");
     }
@@ -179,6 +281,8 @@ std::vector<statuspb::Status> GRPCRouter::GetIncomingWorkerErrors(const sole::uu
     if (!result_status.ok()) {
       break;
     }
+    // Don't read the producer's next message until the query has caught up with its batches.
+    WaitForProducerCapacity(state.producer_flow.get(), context);
     req = std::make_unique<carnotpb::TransferResultChunkRequest>();
   }
 
@@ -228,8 +332,10 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
     source_node->set_upstream_initiated_connection();
   }
   if (snt->response_backlog.size() > 0) {
-    for (auto& rb : snt->response_backlog) {
-      PX_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(rb)));
+    for (auto& backlogged : snt->response_backlog) {
+      PX_RETURN_IF_ERROR(snt->source_node->EnqueueDecodedRowBatch(
+          std::move(backlogged.row_batch),
+          RowBatchConsumedCallback(query_tracker, std::move(backlogged.producer_flow))));
     }
     snt->response_backlog.clear();
   }
@@ -294,6 +400,15 @@ void GRPCRouter::DeleteQuery(sole::uuid query_id) {
     id_to_query_tracker_map_.erase(it);
   }
   absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
+  // Drop the batches that never reached a source node. Those that did are released when their
+  // source node is closed.
+  for (auto& [source_id, snt] : query_tracker->source_node_trackers) {
+    absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+    for (auto& backlogged : snt.response_backlog) {
+      OnRowBatchConsumed(query_tracker.get(), backlogged.producer_flow.get());
+    }
+    snt.response_backlog.clear();
+  }
   query_tracker->ResetRestartExecutionFunc();
   // For any active input streams for this query, mark their context as cancelled.
   for (auto ctx : query_tracker->active_agent_contexts) {
@@ -306,6 +421,19 @@ size_t GRPCRouter::NumQueriesTracking() const {
   return id_to_query_tracker_map_.size();
 }
 
+int64_t GRPCRouter::NumQueuedRowBatches(const sole::uuid& query_id) const {
+  std::shared_ptr<QueryTracker> query_tracker;
+  {
+    absl::base_internal::SpinLockHolder lock(&id_to_query_tracker_map_lock_);
+    auto it = id_to_query_tracker_map_.find(query_id);
+    if (it == id_to_query_tracker_map_.end()) {
+      return 0;
+    }
+    query_tracker = it->second;
+  }
+  return query_tracker->queued_batches;
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -19,7 +19,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,7 +32,10 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/container/node_hash_map.h>
 #include <absl/hash/hash.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
+#include <prometheus/gauge.h>
+#include <prometheus/histogram.h>
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
@@ -38,6 +43,9 @@
 #include "src/common/base/base.h"
 #include "src/common/base/statuspb/status.pb.h"
 #include "src/common/uuid/uuid.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_int64(grpc_router_max_queued_batches_per_producer);
 
 namespace px {
 namespace carnot {
@@ -49,9 +57,19 @@ class GRPCSourceNode;
 /**
  * GRPCRouter tracks incoming Kelvin connections and routes them to the appropriate Carnot source
  * node.
+ *
+ * Row batches are decoded on the gRPC thread serving the sending agent, so that the query thread
+ * only has to consume ready batches. The number of batches received on each incoming result stream
+ * (i.e. from each producer) that haven't been consumed yet is bounded
+ * (--grpc_router_max_queued_batches_per_producer). Once a stream reaches the bound, the router
+ * stops reading from it until the query consumes one of its batches, so the stream's gRPC flow
+ * control window fills up and the producer's sink blocks, rather than the query failing. The bound
+ * is per producer, so a slow input of a join or union only holds back its own producers.
  */
 class GRPCRouter final : public carnotpb::ResultSinkService::Service {
  public:
+  GRPCRouter();
+
   /**
    * TransferResultChunk implements the RPC method.
    */
@@ -103,7 +121,28 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
    */
   size_t NumQueriesTracking() const;
 
+  /**
+   * @brief Number of row batches received for the query that have not been consumed yet, including
+   * those backlogged before their source node was registered.
+   */
+  int64_t NumQueuedRowBatches(const sole::uuid& query_id) const;
+
  private:
+  /**
+   * ProducerFlow tracks the row batches received on one incoming result stream that haven't been
+   * consumed yet, so that the router can stop reading from the stream once it reaches the bound.
+   */
+  struct ProducerFlow {
+    absl::Mutex lock;
+    int64_t queued_batches ABSL_GUARDED_BY(lock) = 0;
+  };
+
+  // A row batch received before its source node was registered.
+  struct BackloggedRowBatch {
+    std::unique_ptr<table_store::schema::RowBatch> row_batch;
+    std::shared_ptr<ProducerFlow> producer_flow;
+  };
+
   /**
    * SourceNodeTracker is responsible for tracking a single source node and the backlog of messages
    * for the source node.
@@ -116,8 +155,7 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     // respectively.
     bool connection_initiated_by_sink GUARDED_BY(node_lock) = false;
     bool connection_closed_by_sink GUARDED_BY(node_lock) = false;
-    std::vector<std::unique_ptr<::px::carnotpb::TransferResultChunkRequest>> response_backlog
-        GUARDED_BY(node_lock);
+    std::vector<BackloggedRowBatch> response_backlog GUARDED_BY(node_lock);
     absl::base_internal::SpinLock node_lock;
   };
 
@@ -139,6 +177,9 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     std::vector<statuspb::Status> upstream_exec_errors GUARDED_BY(query_lock);
     absl::base_internal::SpinLock query_lock;
 
+    // Number of row batches received for this query that haven't been consumed yet.
+    std::atomic<int64_t> queued_batches = 0;
+
     void ResetRestartExecutionFunc() ABSL_EXCLUSIVE_LOCKS_REQUIRED(query_lock) {
       restart_execution_func_ = std::function<void()>();
     }
@@ -156,8 +197,19 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     }
   };
 
-  Status EnqueueRowBatch(QueryTracker* query_tracker,
+  Status EnqueueRowBatch(const std::shared_ptr<QueryTracker>& query_tracker,
+                         const std::shared_ptr<ProducerFlow>& producer_flow,
                          std::unique_ptr<carnotpb::TransferResultChunkRequest> req);
+  // Returns the function a source node calls once it has consumed (or dropped) a row batch from
+  // the given producer.
+  std::function<void()> RowBatchConsumedCallback(std::shared_ptr<QueryTracker> query_tracker,
+                                                 std::shared_ptr<ProducerFlow> producer_flow);
+  void OnRowBatchConsumed(QueryTracker* query_tracker, ProducerFlow* producer_flow);
+  // Blocks until the producer has room for another row batch or the stream is cancelled, which
+  // also happens when the query is deleted.
+  void WaitForProducerCapacity(ProducerFlow* producer_flow, ::grpc::ServerContext* context);
+  static bool HasProducerCapacity(ProducerFlow* producer_flow)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_flow->lock);
 
   struct TransferResultChunkState {
     int64_t source_node_id = 0;
@@ -166,6 +218,7 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     // When true, the particular TransferResultChunk call has initiated the query stream.
     bool stream_has_query_results = false;
     std::shared_ptr<QueryTracker> query_tracker = nullptr;
+    std::shared_ptr<ProducerFlow> producer_flow = std::make_shared<ProducerFlow>();
   };
   ::grpc::Status HandleTransferResultChunkMessage(
       std::unique_ptr<::px::carnotpb::TransferResultChunkRequest> req,
@@ -180,6 +233,10 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
   absl::node_hash_map<sole::uuid, std::shared_ptr<QueryTracker>> id_to_query_tracker_map_
       GUARDED_BY(id_to_query_tracker_map_lock_);
   mutable absl::base_internal::SpinLock id_to_query_tracker_map_lock_;
+
+  prometheus::Gauge& queued_batches_gauge_;
+  prometheus::Histogram& decode_latency_histogram_;
+  prometheus::Histogram& backpressure_wait_histogram_;
 };
 
 }  // namespace exec
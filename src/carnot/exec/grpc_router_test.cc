@@ -20,12 +20,14 @@
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <string>
 #include <thread>
 #include <utility>
 
 #include <absl/strings/substitute.h>
 #include <absl/synchronization/barrier.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/security/credentials.h>
 #include <grpcpp/security/server_credentials.h>
@@ -83,13 +85,35 @@ class GRPCRouterTest : public ::testing::Test {
 
 class FakeGRPCSourceNode : public px::carnot::exec::GRPCSourceNode {
  public:
-  Status EnqueueRowBatch(std::unique_ptr<px::carnotpb::TransferResultChunkRequest> row_batch) {
+  Status EnqueueDecodedRowBatch(std::unique_ptr<table_store::schema::RowBatch> row_batch,
+                                std::function<void()> on_consumed) override {
+    absl::MutexLock lock(&lock_);
     row_batches.emplace_back(std::move(row_batch));
-
+    consumed_callbacks_.emplace_back(std::move(on_consumed));
     return Status::OK();
   }
 
-  std::vector<std::unique_ptr<px::carnotpb::TransferResultChunkRequest>> row_batches;
+  size_t NumRowBatches() {
+    absl::MutexLock lock(&lock_);
+    return row_batches.size();
+  }
+
+  // Marks the oldest unconsumed row batch as consumed.
+  void ConsumeRowBatch() {
+    std::function<void()> on_consumed;
+    {
+      absl::MutexLock lock(&lock_);
+      on_consumed = std::move(consumed_callbacks_.at(num_consumed_++));
+    }
+    on_consumed();
+  }
+
+  std::vector<std::unique_ptr<table_store::schema::RowBatch>> row_batches;
+
+ private:
+  absl::Mutex lock_;
+  std::vector<std::function<void()>> consumed_callbacks_;
+  size_t num_consumed_ = 0;
 };
 
 TEST_F(GRPCRouterTest, no_node_router_test) {
@@ -140,10 +164,10 @@ TEST_F(GRPCRouterTest, no_node_router_test) {
 
   EXPECT_TRUE(source_node.upstream_initiated_connection());
   EXPECT_EQ(2, source_node.row_batches.size());
-  EXPECT_EQ(1,
-            source_node.row_batches.at(0)->query_result().row_batch().cols(0).int64_data().data(0));
-  EXPECT_EQ(4,
-            source_node.row_batches.at(1)->query_result().row_batch().cols(0).int64_data().data(0));
+  EXPECT_EQ(1, types::GetValueFromArrowArray<types::DataType::INT64>(
+                   source_node.row_batches.at(0)->ColumnAt(0).get(), 0));
+  EXPECT_EQ(4, types::GetValueFromArrowArray<types::DataType::INT64>(
+                   source_node.row_batches.at(1)->ColumnAt(0).get(), 0));
   EXPECT_TRUE(source_node.upstream_closed_connection());
 }
 
@@ -210,10 +234,10 @@ TEST_F(GRPCRouterTest, basic_router_test) {
 
   EXPECT_TRUE(source_node.upstream_initiated_connection());
   EXPECT_EQ(2, source_node.row_batches.size());
-  EXPECT_EQ(1,
-            source_node.row_batches.at(0)->query_result().row_batch().cols(0).int64_data().data(0));
-  EXPECT_EQ(4,
-            source_node.row_batches.at(1)->query_result().row_batch().cols(0).int64_data().data(0));
+  EXPECT_EQ(1, types::GetValueFromArrowArray<types::DataType::INT64>(
+                   source_node.row_batches.at(0)->ColumnAt(0).get(), 0));
+  EXPECT_EQ(4, types::GetValueFromArrowArray<types::DataType::INT64>(
+                   source_node.row_batches.at(1)->ColumnAt(0).get(), 0));
   EXPECT_EQ(2, num_continues);
   EXPECT_TRUE(source_node.upstream_closed_connection());
 }
@@ -299,8 +323,8 @@ TEST_F(GRPCRouterTest, router_and_stats_test) {
 
   EXPECT_TRUE(source_node.upstream_initiated_connection());
   EXPECT_EQ(1, source_node.row_batches.size());
-  EXPECT_EQ(1,
-            source_node.row_batches.at(0)->query_result().row_batch().cols(0).int64_data().data(0));
+  EXPECT_EQ(1, types::GetValueFromArrowArray<types::DataType::INT64>(
+                   source_node.row_batches.at(0)->ColumnAt(0).get(), 0));
   EXPECT_EQ(1, num_continues);
   EXPECT_TRUE(source_node.upstream_closed_connection());
 
@@ -436,6 +460,90 @@ TEST_F(GRPCRouterTest, threaded_router_test) {
   read_thread.join();
 }
 
+TEST_F(GRPCRouterTest, full_producer_waits_until_consumed) {
+  PX_SET_FOR_SCOPE(FLAGS_grpc_router_max_queued_batches_per_producer, 2);
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, 1);
+
+  auto make_request = [&](int64_t source_id, int64_t val) {
+    auto rb = RowBatchBuilder(input_rd, /*size*/ 1, /*eow*/ false, /*eos*/ false)
+                  .AddColumn<types::Int64Value>({val})
+                  .get();
+    carnotpb::TransferResultChunkRequest rb_req;
+    EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+    rb_req.mutable_query_result()->set_grpc_source_id(source_id);
+    auto query_id = rb_req.mutable_query_id();
+    query_id->set_high_bits(ab);
+    query_id->set_low_bits(cd);
+    return rb_req;
+  };
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  *initiate_stream_req.mutable_initiate_conn() =
+      carnotpb::TransferResultChunkRequest::InitiateConnection();
+
+  // Sends the given row batches on a new stream, and returns the status the stream finished with.
+  auto send = [&](int64_t source_id, std::vector<int64_t> vals) {
+    px::carnotpb::TransferResultChunkResponse response;
+    grpc::ClientContext context;
+    auto writer = stub_->TransferResultChunk(&context, &response);
+    writer->Write(initiate_stream_req);
+    for (int64_t val : vals) {
+      writer->Write(make_request(source_id, val));
+    }
+    writer->WritesDone();
+    return writer->Finish();
+  };
+  auto wait_for_queued = [&](int64_t num_batches) {
+    for (int i = 0; i < 500 && service_->NumQueuedRowBatches(query_uuid) != num_batches; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return service_->NumQueuedRowBatches(query_uuid);
+  };
+
+  FakeGRPCSourceNode source_node0;
+  ASSERT_OK(source_node0.Init(*plan_node, input_rd, {}));
+  FakeGRPCSourceNode source_node1;
+  ASSERT_OK(source_node1.Init(*plan_node, input_rd, {}));
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, /* source_id */ 0, &source_node0, [] {}));
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, /* source_id */ 1, &source_node1, [] {}));
+
+  // Once a producer has 2 unconsumed batches, the router stops reading from its stream.
+  grpc::Status blocked_status;
+  std::thread blocked_producer([&] { blocked_status = send(/*source_id*/ 0, {0, 1, 2}); });
+  EXPECT_EQ(2, wait_for_queued(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(2, service_->NumQueuedRowBatches(query_uuid));
+  EXPECT_EQ(2, source_node0.NumRowBatches());
+
+  // Other producers, whether for the same or another source, have their own bound.
+  EXPECT_TRUE(send(/*source_id*/ 0, {3}).ok());
+  EXPECT_TRUE(send(/*source_id*/ 1, {0}).ok());
+  EXPECT_EQ(4, service_->NumQueuedRowBatches(query_uuid));
+
+  // Consuming one of the blocked producer's batches lets it send the rest.
+  source_node0.ConsumeRowBatch();
+  blocked_producer.join();
+  EXPECT_TRUE(blocked_status.ok());
+  EXPECT_EQ(4, source_node0.NumRowBatches());
+  EXPECT_EQ(4, service_->NumQueuedRowBatches(query_uuid));
+
+  // Deleting the query cancels producers that are still waiting.
+  std::thread cancelled_producer([&] { blocked_status = send(/*source_id*/ 1, {1, 2, 3}); });
+  EXPECT_EQ(6, wait_for_queued(6));
+  service_->DeleteQuery(query_uuid);
+  cancelled_producer.join();
+  EXPECT_EQ(grpc::StatusCode::CANCELLED, blocked_status.error_code());
+  EXPECT_EQ(0, service_->NumQueuedRowBatches(query_uuid));
+}
+
 TEST_F(GRPCRouterTest, delete_query_router_test) {
   int64_t grpc_source_node_id = 1;
   uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
@@ -18,17 +18,25 @@
 
 #include "src/carnot/exec/grpc_sink_node.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
+#include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
+#include <farmhash.h>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/macros.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/shared/types/arrow_adapter.h"
 #include "src/table_store/table_store.h"
 
 namespace px {
@@ -40,7 +48,11 @@ using table_store::schema::RowDescriptor;
 
 std::string GRPCSinkNode::DebugStringImpl() {
   std::string destination;
-  if (plan_node_->has_table_name()) {
+  if (plan_node_->is_partitioned()) {
+    destination = absl::Substitute("partitions: $0, partition_columns: [$1]",
+                                   plan_node_->num_partitions(),
+                                   absl::StrJoin(plan_node_->partition_columns(), ","));
+  } else if (plan_node_->has_table_name()) {
     destination = absl::Substitute("table_name: $0", plan_node_->table_name());
   } else if (plan_node_->has_grpc_source_id()) {
     destination = absl::Substitute("source_id: $0", plan_node_->grpc_source_id());
@@ -49,16 +61,18 @@ std::string GRPCSinkNode::DebugStringImpl() {
                           plan_node_->address(), destination, input_descriptor_->DebugString());
 }
 
-StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(
-    plan::GRPCSinkOperator* plan_node, ExecState* exec_state) {
+StatusOr<carnotpb::TransferResultChunkRequest> GRPCSinkNode::RequestWithMetadata(
+    const Destination& dest, ExecState* exec_state) const {
   carnotpb::TransferResultChunkRequest req;
   // Set the metadata for the RowBatch (where it should go).
-  req.set_address(plan_node->address());
+  req.set_address(dest.address);
 
-  if (plan_node->has_grpc_source_id()) {
-    req.mutable_query_result()->set_grpc_source_id(plan_node->grpc_source_id());
-  } else if (plan_node->has_table_name()) {
-    req.mutable_query_result()->set_table_name(plan_node->table_name());
+  if (plan_node_->is_partitioned()) {
+    req.mutable_query_result()->set_grpc_source_id(dest.grpc_source_id);
+  } else if (plan_node_->has_grpc_source_id()) {
+    req.mutable_query_result()->set_grpc_source_id(plan_node_->grpc_source_id());
+  } else if (plan_node_->has_table_name()) {
+    req.mutable_query_result()->set_table_name(plan_node_->table_name());
   } else {
     return error::Internal("GRPCSink has neither source ID nor table name set.");
   }
@@ -73,19 +87,24 @@ Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
   }
 
   auto time_now = std::chrono::system_clock::now();
-  auto since_last_flush =
-      std::chrono::duration_cast<std::chrono::milliseconds>(time_now - last_send_time_);
-  bool recheck_connection = since_last_flush > connection_check_timeout_;
-  if (!recheck_connection) {
-    return Status::OK();
-  }
+  for (auto& dest : destinations_) {
+    if (dest.sent_eos) {
+      continue;
+    }
+    auto since_last_flush =
+        std::chrono::duration_cast<std::chrono::milliseconds>(time_now - dest.last_send_time);
+    bool recheck_connection = since_last_flush > connection_check_timeout_;
+    if (!recheck_connection) {
+      continue;
+    }
 
-  PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
-  PX_ASSIGN_OR_RETURN(auto rb,
-                      RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
-  PX_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
+    PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(dest, exec_state));
+    PX_ASSIGN_OR_RETURN(auto rb, RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false,
+                                                        /* eos */ false));
+    PX_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
 
-  PX_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
+    PX_RETURN_IF_ERROR(TryWriteRequest(exec_state, &dest, req));
+  }
   return Status::OK();
 }
 
@@ -99,102 +118,134 @@ Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
   const auto* sink_plan_node = static_cast<const plan::GRPCSinkOperator*>(&plan_node);
   plan_node_ = std::make_unique<plan::GRPCSinkOperator>(*sink_plan_node);
+
+  destinations_.clear();
+  if (!plan_node_->is_partitioned()) {
+    auto& dest = destinations_.emplace_back();
+    dest.address = plan_node_->address();
+    dest.ssl_targetname = plan_node_->ssl_targetname();
+    return Status::OK();
+  }
+
+  if (plan_node_->partition_columns().empty()) {
+    return error::InvalidArgument("Partitioned GRPCSink $0 has no partition columns",
+                                  plan_node_->id());
+  }
+  for (int64_t col_idx : plan_node_->partition_columns()) {
+    if (col_idx < 0 || col_idx >= static_cast<int64_t>(input_descriptor_->size())) {
+      return error::InvalidArgument("GRPCSink $0 partition column $1 is out of range",
+                                    plan_node_->id(), col_idx);
+    }
+  }
+  for (int64_t i = 0; i < plan_node_->num_partitions(); ++i) {
+    const auto& partition = plan_node_->partitioned_destination(i);
+    auto& dest = destinations_.emplace_back();
+    dest.address = partition.address();
+    dest.ssl_targetname = partition.connection_options().ssl_targetname();
+    dest.grpc_source_id = partition.grpc_source_id();
+  }
   return Status::OK();
 }
 
 Status GRPCSinkNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
-Status GRPCSinkNode::StartConnection(ExecState* exec_state) {
-  return StartConnectionWithRetries(exec_state, kGRPCRetries);
+Status GRPCSinkNode::StartConnection(ExecState* exec_state, Destination* dest) {
+  return StartConnectionWithRetries(exec_state, dest, kGRPCRetries);
 }
 
-Status GRPCSinkNode::StartConnectionWithRetries(ExecState* exec_state, size_t n_retries) {
+Status GRPCSinkNode::StartConnectionWithRetries(ExecState* exec_state, Destination* dest,
+                                                size_t n_retries) {
   if (n_retries == 0) {
     cancelled_ = true;
     return error::Cancelled(
         "GRPCSinkNode $0 error: unable to write TransferResultChunkRequest on stream start"
         "to remote address $1 for query $2",
-        plan_node_->id(), plan_node_->address(), exec_state->query_id().str());
+        plan_node_->id(), dest->address, exec_state->query_id().str());
   }
 
-  stub_ = exec_state->ResultSinkServiceStub(plan_node_->address(), plan_node_->ssl_targetname());
+  dest->stub = exec_state->ResultSinkServiceStub(dest->address, dest->ssl_targetname);
 
-  context_ = std::make_unique<grpc::ClientContext>();
+  dest->context = std::make_unique<grpc::ClientContext>();
   // When we are sending the results to an external service, such as the query broker,
   // add authentication to the client context.
-  if (plan_node_->has_table_name()) {
+  if (!plan_node_->is_partitioned() && plan_node_->has_table_name()) {
     // Adding auth to GRPC client.
-    exec_state->AddAuthToGRPCClientContext(context_.get());
+    exec_state->AddAuthToGRPCClientContext(dest->context.get());
   }
 
-  response_.Clear();
-  writer_ = stub_->TransferResultChunk(context_.get(), &response_);
+  dest->response.Clear();
+  dest->writer = dest->stub->TransferResultChunk(dest->context.get(), &dest->response);
 
-  PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
+  PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(*dest, exec_state));
   // If this is not the first connection we've made then we send a 0-row rb instead of an
   // initiate_result_stream request.
   PX_ASSIGN_OR_RETURN(auto rb,
                       RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
   PX_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
 
-  if (!writer_->Write(req)) {
-    return StartConnectionWithRetries(exec_state, n_retries - 1);
+  if (!dest->writer->Write(req)) {
+    return StartConnectionWithRetries(exec_state, dest, n_retries - 1);
   }
 
-  last_send_time_ = std::chrono::system_clock::now();
+  dest->last_send_time = std::chrono::system_clock::now();
   return Status::OK();
 }
 
-Status GRPCSinkNode::CancelledByServer(ExecState* exec_state) {
+Status GRPCSinkNode::CancelledByServer(ExecState* exec_state, const Destination& dest) {
   cancelled_ = true;
   return error::Cancelled(
       "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
       "server",
-      plan_node_->id(), exec_state->query_id().str(), plan_node_->address());
+      plan_node_->id(), exec_state->query_id().str(), dest.address);
 }
 
-Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
+Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state, Destination* dest,
                                      const carnotpb::TransferResultChunkRequest& req) {
-  if (writer_->Write(req)) {
-    last_send_time_ = std::chrono::system_clock::now();
+  if (dest->writer->Write(req)) {
+    dest->last_send_time = std::chrono::system_clock::now();
     return Status::OK();
   }
 
   // We need to determine if the server sent a response (i.e. server closed connection) or if the
   // connection just died.
-  writer_->WritesDone();
-  auto s = writer_->Finish();
+  dest->writer->WritesDone();
+  auto s = dest->writer->Finish();
   // If the Finish call was successful, then the server closed the connection and sent a response,
   // in which case we shouldn't try to reconnect. If there's an error from the server side
   // other than a RST_STREAM, we also shouldn't retry.
   if (s.ok() || s.error_code() != grpc::StatusCode::INTERNAL ||
       !absl::StrContains(s.error_message(), "RST_STREAM")) {
-    return CancelledByServer(exec_state);
+    return CancelledByServer(exec_state, *dest);
   }
   // Otherwise, the connection was probably cancelled due to a timeout or other transient failure,
   // so we can try to restart the connection.
-  PX_RETURN_IF_ERROR(StartConnection(exec_state));
+  PX_RETURN_IF_ERROR(StartConnection(exec_state, dest));
 
   // Try again to write the request on the new connection.
-  if (!writer_->Write(req)) {
-    return CancelledByServer(exec_state);
+  if (!dest->writer->Write(req)) {
+    return CancelledByServer(exec_state, *dest);
   }
-  last_send_time_ = std::chrono::system_clock::now();
+  dest->last_send_time = std::chrono::system_clock::now();
   return Status::OK();
 }
 
-Status GRPCSinkNode::OpenImpl(ExecState* exec_state) { return StartConnection(exec_state); }
+Status GRPCSinkNode::OpenImpl(ExecState* exec_state) {
+  for (auto& dest : destinations_) {
+    PX_RETURN_IF_ERROR(StartConnection(exec_state, &dest));
+  }
+  return Status::OK();
+}
 
-Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
-  if (writer_ == nullptr) {
+Status GRPCSinkNode::CloseWriter(ExecState* exec_state, Destination* dest) {
+  if (dest->writer == nullptr) {
     return Status::OK();
   }
-  writer_->WritesDone();
-  auto s = writer_->Finish();
+  dest->writer->WritesDone();
+  auto s = dest->writer->Finish();
   if (!s.ok()) {
     LOG(ERROR) << absl::Substitute(
-        "GRPCSinkNode $0 in query $1: Error calling Finish on stream, message: $2",
-        plan_node_->id(), exec_state->query_id().str(), s.error_message());
+        "GRPCSinkNode $0 in query $1: Error calling Finish on stream to $2, message: $3",
+        plan_node_->id(), exec_state->query_id().str(), dest->address, s.error_message());
   }
   return Status::OK();
 }
@@ -204,10 +255,14 @@ Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
     return Status::OK();
   }
 
-  if (writer_ != nullptr) {
-    LOG(INFO) << absl::Substitute("Closing GRPCSinkNode $0 in query $1 before receiving EOS",
-                                  plan_node_->id(), exec_state->query_id().str());
-    PX_RETURN_IF_ERROR(CloseWriter(exec_state));
+  for (auto& dest : destinations_) {
+    if (dest.writer == nullptr || dest.sent_eos) {
+      continue;
+    }
+    LOG(INFO) << absl::Substitute(
+        "Closing GRPCSinkNode $0 in query $1 before receiving EOS (destination: $2)",
+        plan_node_->id(), exec_state->query_id().str(), dest.address);
+    PX_RETURN_IF_ERROR(CloseWriter(exec_state, &dest));
   }
 
   return Status::OK();
@@ -273,8 +328,8 @@ std::vector<int64_t> GRPCSinkNode::SplitBatchSizes(bool has_string_col,
   return new_batches_num_rows;
 }
 
-Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb,
-                                       size_t parent_idx) {
+Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, Destination* dest,
+                                       const RowBatch& rb) {
   // Calculate the individual row sizes for all the string columns.
   std::vector<int64_t> string_col_row_sizes(rb.num_rows(), 0);
   // All other columns share the same size across all rows.
@@ -290,7 +345,7 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
   for (size_t idx = 0; idx < new_batches_num_rows.size() - 1; ++idx) {
     auto num_rows = new_batches_num_rows[idx];
     PX_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> output_rb, rb.Slice(batch_idx, num_rows));
-    PX_RETURN_IF_ERROR(ConsumeNextImplNoSplit(exec_state, *output_rb, parent_idx));
+    PX_RETURN_IF_ERROR(SendBatchNoSplit(exec_state, dest, *output_rb));
     batch_idx += num_rows;
   }
 
@@ -299,35 +354,110 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
                       rb.Slice(batch_idx, rb.num_rows() - batch_idx));
   output_rb->set_eos(rb.eos());
   output_rb->set_eow(rb.eow());
-  return ConsumeNextImplNoSplit(exec_state, *output_rb, parent_idx);
+  return SendBatchNoSplit(exec_state, dest, *output_rb);
+}
+
+namespace {
+
+// Mixes the values of `col` into the per row hashes. The hash has to be the same on every Carnot
+// instance, so that rows with equal keys sent by different agents land in the same partition.
+// That rules out absl::Hash, which is seeded per process.
+template <types::DataType DT>
+void HashColumnIntoRows(const arrow::Array* col, std::vector<uint64_t>* row_hashes) {
+  for (int64_t row_idx = 0; row_idx < col->length(); ++row_idx) {
+    uint64_t hash;
+    if constexpr (DT == types::DataType::STRING) {
+      auto val = types::GetStringViewFromArrowArray(col, row_idx);
+      hash = ::util::Hash64(val.data(), val.size());
+    } else if constexpr (DT == types::DataType::FLOAT64) {
+      double val = types::GetValueFromArrowArray<DT>(col, row_idx);
+      // Hash the bits of a canonical value, so that -0.0 lands in the same partition as 0.0, and
+      // all NaNs in the same partition.
+      if (val == 0) {
+        val = 0;
+      } else if (std::isnan(val)) {
+        val = std::numeric_limits<double>::quiet_NaN();
+      }
+      hash = ::util::Hash64(reinterpret_cast<const char*>(&val), sizeof(val));
+    } else {
+      auto val = types::GetValueFromArrowArray<DT>(col, row_idx);
+      hash = ::util::Hash64(reinterpret_cast<const char*>(&val), sizeof(val));
+    }
+    (*row_hashes)[row_idx] = ::px::HashCombine((*row_hashes)[row_idx], hash);
+  }
+}
+
+}  // namespace
+
+Status GRPCSinkNode::PartitionAndSendBatch(ExecState* exec_state, const RowBatch& rb) {
+  std::vector<uint64_t> row_hashes(rb.num_rows(), 0);
+  for (int64_t col_idx : plan_node_->partition_columns()) {
+    auto col = rb.ColumnAt(col_idx);
+#define TYPE_CASE(_dt_) HashColumnIntoRows<_dt_>(col.get(), &row_hashes);
+    PX_SWITCH_FOREACH_DATATYPE(rb.desc().type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  std::vector<table_store::schema::SelectionVector> partition_rows(destinations_.size());
+  for (const auto& [row_idx, hash] : Enumerate(row_hashes)) {
+    partition_rows[hash % destinations_.size()].push_back(row_idx);
+  }
+
+  std::vector<int64_t> all_cols(rb.num_columns());
+  std::iota(all_cols.begin(), all_cols.end(), 0);
+  for (size_t partition = 0; partition < partition_rows.size(); ++partition) {
+    // Every destination has to see the end of the window and of the stream, even if none of the
+    // rows hashed to it.
+    if (partition_rows[partition].empty() && !rb.eow() && !rb.eos()) {
+      continue;
+    }
+    PX_ASSIGN_OR_RETURN(auto partition_rb,
+                        rb.Select(rb.desc(), all_cols, std::move(partition_rows[partition]),
+                                  exec_state->exec_mem_pool()));
+    PX_RETURN_IF_ERROR(partition_rb->Materialize());
+    partition_rb->set_eow(rb.eow());
+    partition_rb->set_eos(rb.eos());
+    PX_RETURN_IF_ERROR(SendBatch(exec_state, &destinations_[partition], *partition_rb));
+  }
+  return Status::OK();
+}
+
+Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  if (plan_node_->is_partitioned()) {
+    return PartitionAndSendBatch(exec_state, rb);
+  }
+  return SendBatch(exec_state, &destinations_[0], rb);
 }
 
-Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
+Status GRPCSinkNode::SendBatch(ExecState* exec_state, Destination* dest, const RowBatch& rb) {
   if (rb.NumBytes() > (max_batch_size_ * batch_size_factor_)) {
-    return SplitAndSendBatch(exec_state, rb, parent_idx);
+    return SplitAndSendBatch(exec_state, dest, rb);
   }
-  return ConsumeNextImplNoSplit(exec_state, rb, parent_idx);
+  return SendBatchNoSplit(exec_state, dest, rb);
 }
 
-Status GRPCSinkNode::ConsumeNextImplNoSplit(ExecState* exec_state, const RowBatch& rb, size_t) {
-  PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
+Status GRPCSinkNode::SendBatchNoSplit(ExecState* exec_state, Destination* dest,
+                                      const RowBatch& rb) {
+  PX_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(*dest, exec_state));
   // Serialize the RowBatch.
   PX_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
 
-  PX_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
+  PX_RETURN_IF_ERROR(TryWriteRequest(exec_state, dest, req));
 
   if (!rb.eos()) {
     return Status::OK();
   }
 
-  PX_RETURN_IF_ERROR(CloseWriter(exec_state));
-  sent_eos_ = true;
+  PX_RETURN_IF_ERROR(CloseWriter(exec_state, dest));
+  dest->sent_eos = true;
+  sent_eos_ = std::all_of(destinations_.begin(), destinations_.end(),
+                          [](const Destination& d) { return d.sent_eos; });
 
-  return response_.success()
+  return dest->response.success()
              ? Status::OK()
              : error::Internal(absl::Substitute(
                    "GRPCSinkNode $0 encountered error sending stream to address $1, message: $2",
-                   plan_node_->id(), plan_node_->address(), response_.message()));
+                   plan_node_->id(), dest->address, dest->response.message()));
 }
 
 }  // namespace exec
@@ -51,6 +51,15 @@ constexpr float kBatchSizeFactor = 0.9f;
 // Number of times to retry connecting to grpc before giving up.
 constexpr size_t kGRPCRetries = 3;
 
+/**
+ * GRPCSinkNode sends its input row batches to a GRPC Source on another Carnot instance, or to the
+ * query broker when the sink produces a result table.
+ *
+ * A sink can also be partitioned across several GRPC Sources: each row is then sent to the
+ * destination picked by the hash of the row's partition columns, so that all rows with the same
+ * key end up on the same Carnot instance. End of window and end of stream are sent to every
+ * destination.
+ */
 class GRPCSinkNode : public SinkNode {
  public:
   GRPCSinkNode(size_t max_batch_size, float batch_size_factor)
@@ -65,7 +74,7 @@ class GRPCSinkNode : public SinkNode {
     connection_check_timeout_ = timeout;
   }
   const std::chrono::time_point<std::chrono::system_clock>& testing_last_send_time() const {
-    return last_send_time_;
+    return destinations_[0].last_send_time;
   }
 
  protected:
@@ -76,34 +85,51 @@ class GRPCSinkNode : public SinkNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
-  Status ConsumeNextImplNoSplit(ExecState* exec_state, const table_store::schema::RowBatch& rb,
-                                size_t parent_index);
-  Status SplitAndSendBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb,
-                           size_t parent_index);
   std::vector<int64_t> SplitBatchSizes(bool has_string_col,
                                        const std::vector<int64_t>& string_col_row_sizes,
                                        int64_t other_col_row_size) const;
 
  private:
-  Status CloseWriter(ExecState* exec_state);
-  Status StartConnection(ExecState* exec_state);
-  Status StartConnectionWithRetries(ExecState* exec_state, size_t n_retries);
-  Status CancelledByServer(ExecState* exec_state);
-  Status TryWriteRequest(ExecState* exec_state, const carnotpb::TransferResultChunkRequest& req);
+  // The stream to one of the sink's destinations. Unpartitioned sinks have a single destination.
+  struct Destination {
+    std::string address;
+    std::string ssl_targetname;
+    // Only used by partitioned sinks, the others read the destination off the plan node.
+    int64_t grpc_source_id = 0;
+
+    std::unique_ptr<grpc::ClientContext> context;
+    carnotpb::TransferResultChunkResponse response;
+    carnotpb::ResultSinkService::StubInterface* stub = nullptr;
+    std::unique_ptr<grpc::ClientWriterInterface<carnotpb::TransferResultChunkRequest>> writer;
+    std::chrono::time_point<std::chrono::system_clock> last_send_time;
+    bool sent_eos = false;
+  };
+
+  StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(const Destination& dest,
+                                                                     ExecState* exec_state) const;
+  Status SendBatch(ExecState* exec_state, Destination* dest,
+                   const table_store::schema::RowBatch& rb);
+  Status SendBatchNoSplit(ExecState* exec_state, Destination* dest,
+                          const table_store::schema::RowBatch& rb);
+  Status SplitAndSendBatch(ExecState* exec_state, Destination* dest,
+                           const table_store::schema::RowBatch& rb);
+  Status PartitionAndSendBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+
+  Status CloseWriter(ExecState* exec_state, Destination* dest);
+  Status StartConnection(ExecState* exec_state, Destination* dest);
+  Status StartConnectionWithRetries(ExecState* exec_state, Destination* dest, size_t n_retries);
+  Status CancelledByServer(ExecState* exec_state, const Destination& dest);
+  Status TryWriteRequest(ExecState* exec_state, Destination* dest,
+                         const carnotpb::TransferResultChunkRequest& req);
 
   bool cancelled_ = false;
 
-  std::unique_ptr<grpc::ClientContext> context_;
-  carnotpb::TransferResultChunkResponse response_;
-
-  carnotpb::ResultSinkService::StubInterface* stub_;
-  std::unique_ptr<grpc::ClientWriterInterface<carnotpb::TransferResultChunkRequest>> writer_;
+  std::vector<Destination> destinations_;
 
   std::unique_ptr<plan::GRPCSinkOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
 
   std::chrono::milliseconds connection_check_timeout_ = kDefaultConnectionCheckTimeoutMS;
-  std::chrono::time_point<std::chrono::system_clock> last_send_time_;
 
   size_t max_batch_size_;
   float batch_size_factor_;
@@ -18,9 +18,12 @@
 
 #include "src/carnot/exec/grpc_sink_node.h"
 
+#include <cmath>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <google/protobuf/text_format.h>
 #include <grpcpp/test/mock_stream.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -763,6 +766,132 @@ TEST_F(GRPCSinkNodeTest, check_connection_after_eos) {
   tester.Close();
 }
 
+constexpr char kPartitionedGRPCSink[] = R"proto(
+partition_columns: 0
+partitioned_destinations {
+  address: "localhost:1234"
+  grpc_source_id: 1
+}
+partitioned_destinations {
+  address: "localhost:1234"
+  grpc_source_id: 2
+}
+)proto";
+
+TEST_F(GRPCSinkNodeTest, partitioned_result) {
+  planpb::GRPCSinkOperator op_proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kPartitionedGRPCSink, &op_proto));
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  ASSERT_OK(plan_node->Init(op_proto));
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  // The requests received by each partition, keyed by GRPC source ID.
+  absl::flat_hash_map<int64_t, std::vector<TransferResultChunkRequest>> received;
+  auto save_request = [&received](const TransferResultChunkRequest& req, grpc::WriteOptions) {
+    received[req.query_result().grpc_source_id()].push_back(req);
+    return true;
+  };
+
+  auto writer1 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  auto writer2 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  for (auto writer : {writer1, writer2}) {
+    EXPECT_CALL(*writer, Write(_, _)).WillRepeatedly(Invoke(save_request));
+    EXPECT_CALL(*writer, WritesDone());
+    EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  }
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer1)))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer2)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  auto rb1 = RowBatchBuilder(output_rd, 8, /*eow*/ false, /*eos*/ false)
+                 .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6, 1, 2})
+                 .AddColumn<types::Int64Value>({0, 1, 2, 3, 4, 5, 6, 7})
+                 .get();
+  tester.ConsumeNext(rb1, 5, 0);
+  auto rb2 = RowBatchBuilder(output_rd, 4, /*eow*/ true, /*eos*/ true)
+                 .AddColumn<types::Int64Value>({3, 4, 5, 6})
+                 .AddColumn<types::Int64Value>({8, 9, 10, 11})
+                 .get();
+  tester.ConsumeNext(rb2, 5, 0);
+  tester.Close();
+
+  ASSERT_EQ(2, received.size());
+  // Each key is sent to exactly one partition, and every row is sent once.
+  absl::flat_hash_map<int64_t, int64_t> key_to_source_id;
+  int64_t num_rows = 0;
+  for (const auto& [source_id, reqs] : received) {
+    for (const auto& req : reqs) {
+      EXPECT_EQ("localhost:1234", req.address());
+      const auto& rb = req.query_result().row_batch();
+      num_rows += rb.num_rows();
+      for (auto key : rb.cols(0).int64_data().data()) {
+        auto [it, inserted] = key_to_source_id.emplace(key, source_id);
+        EXPECT_EQ(source_id, it->second) << absl::Substitute("key $0 sent to two partitions", key);
+      }
+    }
+    // Both partitions receive the end of stream.
+    EXPECT_TRUE(reqs.back().query_result().row_batch().eow());
+    EXPECT_TRUE(reqs.back().query_result().row_batch().eos());
+  }
+  EXPECT_EQ(12, num_rows);
+  EXPECT_EQ(6, key_to_source_id.size());
+}
+
+TEST_F(GRPCSinkNodeTest, partitioned_float_keys) {
+  planpb::GRPCSinkOperator op_proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kPartitionedGRPCSink, &op_proto));
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  ASSERT_OK(plan_node->Init(op_proto));
+  RowDescriptor input_rd({types::DataType::FLOAT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::FLOAT64, types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  // The partition that received each row, keyed by the row's value in the second column.
+  absl::flat_hash_map<int64_t, int64_t> row_to_source_id;
+  auto save_request = [&row_to_source_id](const TransferResultChunkRequest& req,
+                                          grpc::WriteOptions) {
+    for (auto row : req.query_result().row_batch().cols(1).int64_data().data()) {
+      row_to_source_id[row] = req.query_result().grpc_source_id();
+    }
+    return true;
+  };
+
+  auto writer1 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  auto writer2 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  for (auto writer : {writer1, writer2}) {
+    EXPECT_CALL(*writer, Write(_, _)).WillRepeatedly(Invoke(save_request));
+    EXPECT_CALL(*writer, WritesDone());
+    EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  }
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer1)))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer2)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  auto rb = RowBatchBuilder(output_rd, 4, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Float64Value>({0.0, -0.0, std::nan(""), -std::nan("")})
+                .AddColumn<types::Int64Value>({0, 1, 2, 3})
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  tester.Close();
+
+  ASSERT_EQ(4, row_to_source_id.size());
+  // Keys that compare equal as groups land in the same partition, whatever their bits.
+  EXPECT_EQ(row_to_source_id[0], row_to_source_id[1]);
+  EXPECT_EQ(row_to_source_id[2], row_to_source_id[3]);
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -47,7 +47,16 @@ Status GRPCSourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
 Status GRPCSourceNode::OpenImpl(ExecState*) { return Status::OK(); }
 
-Status GRPCSourceNode::CloseImpl(ExecState*) { return Status::OK(); }
+Status GRPCSourceNode::CloseImpl(ExecState*) {
+  // Release the batches that will never be consumed.
+  QueuedRowBatch queued;
+  while (row_batch_queue_.try_dequeue(queued)) {
+    if (queued.on_consumed) {
+      queued.on_consumed();
+    }
+  }
+  return Status::OK();
+}
 
 Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
   PX_RETURN_IF_ERROR(PopRowBatch());
@@ -57,7 +66,18 @@ Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
 
 Status GRPCSourceNode::EnqueueRowBatch(
     std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
-  if (!row_batch_queue_.enqueue(std::move(row_batch))) {
+  if (!row_batch->has_query_result() || !row_batch->query_result().has_row_batch()) {
+    return error::Internal(
+        "GRPCSourceNode::EnqueueRowBatch expected TransferResultChunkRequest to have RowBatch "
+        "message.");
+  }
+  PX_ASSIGN_OR_RETURN(auto rb, RowBatch::FromProto(row_batch->query_result().row_batch()));
+  return EnqueueDecodedRowBatch(std::move(rb), std::function<void()>());
+}
+
+Status GRPCSourceNode::EnqueueDecodedRowBatch(std::unique_ptr<RowBatch> row_batch,
+                                              std::function<void()> on_consumed) {
+  if (!row_batch_queue_.enqueue(QueuedRowBatch{std::move(row_batch), std::move(on_consumed)})) {
     return error::Internal("Failed to enqueue RowBatch");
   }
   return Status::OK();
@@ -65,20 +85,17 @@ Status GRPCSourceNode::EnqueueRowBatch(
 
 Status GRPCSourceNode::PopRowBatch() {
   DCHECK(NextBatchReady());
-  std::unique_ptr<carnotpb::TransferResultChunkRequest> rb_request;
-  bool got_one = row_batch_queue_.try_dequeue(rb_request);
+  QueuedRowBatch queued;
+  bool got_one = row_batch_queue_.try_dequeue(queued);
   if (!got_one) {
     return error::Internal(
         "Called GRPCSourceNode::OptionallyPopRowBatch but there was no available row batch in the "
         "queue.");
   }
-  if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
-    return error::Internal(
-        "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
-        "message.");
+  rb_ = std::move(queued.row_batch);
+  if (queued.on_consumed) {
+    queued.on_consumed();
   }
-
-  PX_ASSIGN_OR_RETURN(rb_, RowBatch::FromProto(rb_request->query_result().row_batch()));
   return Status::OK();
 }
 
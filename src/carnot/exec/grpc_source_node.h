@@ -19,8 +19,10 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
@@ -42,7 +44,13 @@ class GRPCSourceNode : public SourceNode {
   virtual ~GRPCSourceNode() = default;
 
   bool NextBatchReady() override;
+  // Decodes the row batch in the request and enqueues it.
   virtual Status EnqueueRowBatch(std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch);
+  // Enqueues a row batch that was already decoded, e.g. by the GRPCRouter on a gRPC thread.
+  // on_consumed, if set, is called once the node has consumed the row batch, or dropped it when
+  // closed. Used by the GRPCRouter for flow control.
+  virtual Status EnqueueDecodedRowBatch(std::unique_ptr<table_store::schema::RowBatch> row_batch,
+                                        std::function<void()> on_consumed);
 
   // Tracks whether the upstream sink node has successfully initiated the connection to
   // this remote source. Used by the exec graph to determine whether or not any sources have
@@ -67,9 +75,13 @@ class GRPCSourceNode : public SourceNode {
  private:
   Status PopRowBatch();
 
+  struct QueuedRowBatch {
+    std::unique_ptr<table_store::schema::RowBatch> row_batch;
+    std::function<void()> on_consumed;
+  };
+
   std::unique_ptr<table_store::schema::RowBatch> rb_;
-  moodycamel::BlockingConcurrentQueue<std::unique_ptr<carnotpb::TransferResultChunkRequest>>
-      row_batch_queue_;
+  moodycamel::BlockingConcurrentQueue<QueuedRowBatch> row_batch_queue_;
 
   std::unique_ptr<plan::GRPCSourceOperator> plan_node_;
   bool upstream_initiated_connection_ = false;
@@ -65,28 +65,23 @@ Status LimitNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, siz
     return Status::OK();
   }
 
+  // Projecting and slicing keep columns that a preceding filter left unmaterialized that way, so
+  // only the rows within the limit are ever gathered.
+  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
+  PX_ASSIGN_OR_RETURN(auto projected_rb,
+                      rb.Project(*output_descriptor_, plan_node_->selected_cols()));
+
   // Check if the entire row batch will fit.
   if (remainder_records > rb.num_rows()) {
-    RowBatch output_rb(*output_descriptor_, rb.num_rows());
-    DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
-    // If so we just need to convert to output descriptor and transfer it.
-    for (int64_t input_col_idx : plan_node_->selected_cols()) {
-      PX_RETURN_IF_ERROR(output_rb.AddColumn(rb.ColumnAt(input_col_idx)));
-    }
     records_processed_ += rb.num_rows();
-    output_rb.set_eos(rb.eos());
-    output_rb.set_eow(rb.eow());
-    return SendRowBatchToChildren(exec_state, output_rb);
+    projected_rb->set_eos(rb.eos());
+    projected_rb->set_eow(rb.eow());
+    return SendRowBatchToChildren(exec_state, *projected_rb);
   }
 
-  RowBatch output_rb(*output_descriptor_, remainder_records);
-  DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
-  for (int64_t input_col_idx : plan_node_->selected_cols()) {
-    auto col = rb.ColumnAt(input_col_idx);
-    PX_RETURN_IF_ERROR(output_rb.AddColumn(col->Slice(0, remainder_records)));
-  }
-  output_rb.set_eow(true);
-  output_rb.set_eos(true);
+  PX_ASSIGN_OR_RETURN(auto output_rb, projected_rb->Slice(0, remainder_records));
+  output_rb->set_eow(true);
+  output_rb->set_eos(true);
   records_processed_ += remainder_records;
   limit_reached_ = true;
 
@@ -95,7 +90,7 @@ Status LimitNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, siz
     exec_state->StopSource(src_id);
   }
 
-  return SendRowBatchToChildren(exec_state, output_rb);
+  return SendRowBatchToChildren(exec_state, *output_rb);
 }
 
 }  // namespace exec
@@ -48,8 +48,11 @@ class LimitNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  // Limit only projects and slices its input, so a preceding filter's selection stays lazy.
+  const std::vector<int64_t>* InputColumnsRead(size_t) const override { return &columns_read_; }
 
  private:
+  const std::vector<int64_t> columns_read_;
   size_t records_processed_ = 0;
   bool limit_reached_ = false;
   std::unique_ptr<plan::LimitOperator> plan_node_;
@@ -25,6 +25,7 @@
 #include <gtest/gtest.h>
 #include <sole.hpp>
 
+#include "src/carnot/exec/query_memory_pool.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/planpb/test_proto.h"
 #include "src/carnot/udf/base.h"
@@ -281,6 +282,54 @@ TEST_F(LimitNodeTest, drop_input_columns_fewer_than_limit) {
       .Close();
 }
 
+TEST_F(LimitNodeTest, selected_input_from_filter) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  // A filter emits its rows as a selection vector over the input columns.
+  auto input_rb = RowBatchBuilder(input_rd, 14, /*eow*/ false, /*eos*/ false)
+                      .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14})
+                      .AddColumn<types::Int64Value>({1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0})
+                      .get();
+  ASSERT_OK_AND_ASSIGN(auto selected_rb,
+                       input_rb.Select(input_rd, {0, 1}, {0, 1, 2, 4, 6, 7, 8, 9, 10, 11, 12, 13},
+                                       arrow::default_memory_pool()));
+  selected_rb->set_eow(true);
+  selected_rb->set_eos(true);
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*plan_node_, output_rd,
+                                                                     {input_rd}, exec_state_.get());
+  tester.ConsumeNext(*selected_rb, 0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 10, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 5, 7, 8, 9, 10, 11, 12})
+                          .AddColumn<types::Int64Value>({1, 0, 1, 1, 1, 0, 1, 0, 1, 0})
+                          .get())
+      .Close();
+}
+
+TEST_F(LimitNodeTest, selected_input_materialization_fails) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  // Gathering the selected rows exceeds the query's memory limit.
+  auto* pool = QueryMemoryPool::Create(arrow::default_memory_pool(), /*memory_limit_bytes*/ 1);
+  auto input_rb = RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                      .AddColumn<types::Int64Value>({1, 2, 3})
+                      .AddColumn<types::Int64Value>({4, 5, 6})
+                      .get();
+  ASSERT_OK_AND_ASSIGN(auto selected_rb, input_rb.Select(input_rd, {0, 1}, {0, 2}, pool));
+  selected_rb->set_eow(true);
+  selected_rb->set_eos(true);
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*plan_node_, output_rd,
+                                                                     {input_rd}, exec_state_.get());
+  // The failure surfaces as a status when the limit's child materializes the batch.
+  EXPECT_NOT_OK(tester.node()->ConsumeNext(exec_state_.get(), *selected_rb, 0));
+  tester.Close();
+  selected_rb.reset();
+  pool->Release();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
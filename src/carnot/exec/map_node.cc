@@ -18,11 +18,14 @@
 
 #include "src/carnot/exec/map_node.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/fused_expression_evaluator.h"
+#include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
@@ -42,12 +45,25 @@ Status MapNode::InitImpl(const plan::Operator& plan_node) {
   const auto* map_plan_node = static_cast<const plan::MapOperator*>(&plan_node);
   // copy the plan node to local object;
   plan_node_ = std::make_unique<plan::MapOperator>(*map_plan_node);
+
+  std::set<int64_t> cols;
+  auto walker = plan::ExpressionWalker<int>().OnColumn([&cols](const auto& col, const auto&) {
+    cols.insert(col.Index());
+    return 0;
+  });
+  for (const auto& expr : plan_node_->expressions()) {
+    // The walk only fails for expressions the evaluators reject anyway.
+    PX_UNUSED(walker.Walk(*expr));
+  }
+  columns_read_.assign(cols.begin(), cols.end());
   return Status::OK();
 }
 Status MapNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
-  evaluator_ = ScalarExpressionEvaluator::Create(
-      plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative, function_ctx_.get());
+  auto evaluator_type = ChooseScalarExpressionEvaluator(
+      exec_state, plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative);
+  evaluator_ = ScalarExpressionEvaluator::Create(plan_node_->expressions(), evaluator_type,
+                                                 function_ctx_.get());
   return Status::OK();
 }
 
@@ -49,8 +49,11 @@ class MapNode : public ProcessingNode {
   Status CloseImpl(ExecState* exec_state) override;
   Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                          size_t parent_index) override;
+  const std::vector<int64_t>* InputColumnsRead(size_t) const override { return &columns_read_; }
 
  private:
+  // The input columns referenced by the expressions, in increasing order.
+  std::vector<int64_t> columns_read_;
   std::unique_ptr<ExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::MapOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
@@ -131,6 +131,30 @@ TEST_F(MapNodeTest, zero_row_row_batch) {
       .Close();
 }
 
+TEST_F(MapNodeTest, selected_input_gathers_read_columns) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto input_rb = RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                      .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                      .AddColumn<types::Int64Value>({1, 3, 6, 9})
+                      .AddColumn<types::Int64Value>({7, 7, 7, 7})
+                      .get();
+  ASSERT_OK_AND_ASSIGN(auto selected_rb,
+                       input_rb.Select(input_rd, {0, 1, 2}, {1, 3}, arrow::default_memory_pool()));
+  selected_rb->set_eow(true);
+  selected_rb->set_eos(true);
+
+  auto tester = exec::ExecNodeTester<MapNode, plan::MapOperator>(*plan_node_, output_rd, {},
+                                                                 exec_state_.get());
+  tester.ConsumeNext(*selected_rb, 0)
+      .ExpectRowBatch(
+          RowBatchBuilder(output_rd, 2, true, true).AddColumn<types::Int64Value>({5, 13}).get())
+      .Close();
+  // The map only reads columns 0 and 1, so column 2 is never gathered.
+  EXPECT_FALSE(selected_rb->is_materialized());
+}
+
 TEST_F(MapNodeTest, child_fail) {
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
   RowDescriptor output_rd({types::DataType::INT64});
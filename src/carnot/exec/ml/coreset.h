@@ -22,8 +22,12 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -37,9 +41,41 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
+// Helpers for the binary serialization of coresets. Values are written in host byte order, since
+// the serialized coresets are only exchanged between agents running the same build.
+template <typename T>
+void AppendBinary(T val, std::string* out) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+inline void AppendFloats(const float* vals, size_t n, std::string* out) {
+  out->append(reinterpret_cast<const char*>(vals), n * sizeof(float));
+}
+
+template <typename T>
+Status ReadBinary(std::string_view* in, T* val) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (in->size() < sizeof(T)) {
+    return error::InvalidArgument("Truncated binary coreset.");
+  }
+  std::memcpy(val, in->data(), sizeof(T));
+  in->remove_prefix(sizeof(T));
+  return Status::OK();
+}
+
+inline Status ReadFloats(std::string_view* in, float* vals, size_t n) {
+  if (in->size() < n * sizeof(float)) {
+    return error::InvalidArgument("Truncated binary coreset.");
+  }
+  std::memcpy(vals, in->data(), n * sizeof(float));
+  in->remove_prefix(n * sizeof(float));
+  return Status::OK();
+}
+
 class WeightedPointSet {
  public:
-  WeightedPointSet() : size_(0) {}
+  WeightedPointSet() : size_(0), point_size_(0) {}
   WeightedPointSet(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
     DCHECK_EQ(points.rows(), weights.rows());
     size_ = points.rows();
@@ -125,6 +161,47 @@ class WeightedPointSet {
     return set;
   }
 
+  /**
+   * Appends the binary representation of the set: the size and point size, followed by the
+   * column-major points and the weights.
+   */
+  void ToBinary(std::string* out) const {
+    AppendBinary<int32_t>(size_, out);
+    AppendBinary<int32_t>(point_size_, out);
+    AppendFloats(points_.data(), points_.size(), out);
+    AppendFloats(weights_.data(), weights_.size(), out);
+  }
+
+  /**
+   * Reads a set written by ToBinary() from the front of in, and removes it from in.
+   */
+  Status FromBinary(std::string_view* in) {
+    int32_t size;
+    int32_t point_size;
+    PX_RETURN_IF_ERROR(ReadBinary(in, &size));
+    PX_RETURN_IF_ERROR(ReadBinary(in, &point_size));
+    // Check the dimensions against the remaining data before allocating for them.
+    const uint64_t num_floats =
+        static_cast<uint64_t>(size) * (static_cast<uint64_t>(point_size) + 1);
+    if (size < 0 || point_size < 0 || num_floats * sizeof(float) > in->size()) {
+      return error::InvalidArgument("Invalid binary coreset of $0 points of size $1.", size,
+                                    point_size);
+    }
+    size_ = size;
+    point_size_ = point_size;
+    points_.resize(size_, point_size_);
+    weights_.resize(size_);
+    PX_RETURN_IF_ERROR(ReadFloats(in, points_.data(), points_.size()));
+    PX_RETURN_IF_ERROR(ReadFloats(in, weights_.data(), weights_.size()));
+    return Status::OK();
+  }
+
+  static StatusOr<std::shared_ptr<WeightedPointSet>> CreateFromBinary(std::string_view* in) {
+    auto set = std::make_shared<WeightedPointSet>();
+    PX_RETURN_IF_ERROR(set->FromBinary(in));
+    return set;
+  }
+
   const Eigen::MatrixXf& points() const { return points_; }
   const Eigen::VectorXf& weights() const { return weights_; }
   int point_size() const { return point_size_; }
@@ -243,6 +320,40 @@ class CoresetTree {
     writer->EndObject();
   }
 
+  void ToBinary(std::string* out) const {
+    AppendBinary<uint64_t>(coreset_size_, out);
+    AppendBinary<uint64_t>(r_, out);
+    AppendBinary<uint32_t>(levels_.size(), out);
+    for (const auto& level : levels_) {
+      AppendBinary<uint32_t>(level.size(), out);
+      for (const auto& set : level) {
+        set->ToBinary(out);
+      }
+    }
+  }
+
+  Status FromBinary(std::string_view* in) {
+    uint64_t coreset_size;
+    uint64_t r;
+    uint32_t num_levels;
+    PX_RETURN_IF_ERROR(ReadBinary(in, &coreset_size));
+    PX_RETURN_IF_ERROR(ReadBinary(in, &r));
+    PX_RETURN_IF_ERROR(ReadBinary(in, &num_levels));
+    std::vector<Level> levels(num_levels);
+    for (auto& level : levels) {
+      uint32_t num_sets;
+      PX_RETURN_IF_ERROR(ReadBinary(in, &num_sets));
+      for (uint32_t i = 0; i < num_sets; ++i) {
+        PX_ASSIGN_OR_RETURN(auto set, WeightedPointSet::CreateFromBinary(in));
+        level.push_back(std::move(set));
+      }
+    }
+    coreset_size_ = coreset_size;
+    r_ = r;
+    levels_ = std::move(levels);
+    return Status::OK();
+  }
+
   void FromJSON(const rapidjson::Document::ValueType& doc) {
     DCHECK(doc.IsObject());
     DCHECK(doc.HasMember("coreset_size"));
@@ -296,6 +407,26 @@ class CoresetDriver {
     }
   }
 
+  /**
+   * Adds each row of points as a point with weight 1. Equivalent to calling Update() on each row,
+   * but copies the rows into the base bucket a block at a time.
+   */
+  void UpdateBatch(const Eigen::MatrixXf& points) {
+    DCHECK_EQ(points.cols(), d_);
+    int offset = 0;
+    while (offset < points.rows()) {
+      int n = std::min<int>(m_ - size_, points.rows() - offset);
+      points_.middleRows(size_, n) = points.middleRows(offset, n);
+      weights_.segment(size_, n).setOnes();
+      size_ += n;
+      offset += n;
+      if (size_ == m_) {
+        coreset_data_.Update(std::make_shared<WeightedPointSet>(points_, weights_));
+        size_ = 0;
+      }
+    }
+  }
+
   std::shared_ptr<WeightedPointSet> Query() {
     auto coreset = coreset_data_.Coreset();
     if (size_ == 0) {
@@ -331,6 +462,31 @@ class CoresetDriver {
     return sb.GetString();
   }
 
+  /**
+   * Returns the binary representation of the driver's state, which is smaller and faster to
+   * produce and parse than ToJSON().
+   */
+  std::string ToBinary() const {
+    std::string out;
+    CurrentSet()->ToBinary(&out);
+    coreset_data_.ToBinary(&out);
+    return out;
+  }
+
+  Status FromBinary(std::string_view data) {
+    PX_ASSIGN_OR_RETURN(auto set, WeightedPointSet::CreateFromBinary(&data));
+    if (set->size() > m_ || (set->size() > 0 && set->point_size() != d_)) {
+      return error::InvalidArgument("Invalid base set of $0 points of size $1.", set->size(),
+                                    set->point_size());
+    }
+    PX_RETURN_IF_ERROR(coreset_data_.FromBinary(&data));
+    if (!data.empty()) {
+      return error::InvalidArgument("Unexpected trailing bytes in binary coreset.");
+    }
+    GatherPointsFromSet(set);
+    return Status::OK();
+  }
+
   void FromJSON(std::string data) {
     rapidjson::Document doc;
     doc.Parse(data.data());
@@ -18,6 +18,8 @@
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
+
 #include "src/carnot/exec/ml/coreset.h"
 #include "src/common/perf/perf.h"
 
@@ -92,6 +94,7 @@ static void BM_CoresetSerialize(benchmark::State& state) {
   for (auto _ : state) {
     benchmark::DoNotOptimize(driver.ToJSON());
   }
+  state.counters["bytes"] = driver.ToJSON().size();
 }
 
 // NOLINTNEXTLINE : runtime/references.
@@ -111,9 +114,80 @@ static void BM_CoresetDeserialize(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetTreeUpdateLarge(benchmark::State& state) {
+  int d = 64;
+  int n = state.range(0);
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(n, d);
+
+  for (auto _ : state) {
+    CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+    for (int i = 0; i < n; i++) {
+      driver.Update(points.row(i).transpose());
+    }
+    benchmark::DoNotOptimize(driver);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetTreeUpdateBatch(benchmark::State& state) {
+  int d = 64;
+  int n = state.range(0);
+  int batch_size = state.range(1);
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(n, d);
+
+  for (auto _ : state) {
+    CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+    for (int offset = 0; offset < n; offset += batch_size) {
+      driver.UpdateBatch(points.middleRows(offset, std::min(batch_size, n - offset)));
+    }
+    benchmark::DoNotOptimize(driver);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetSerializeBinary(benchmark::State& state) {
+  int d = 64;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+  Eigen::VectorXf point = Eigen::VectorXf::Random(d);
+  for (int i = 0; i < 10000; i++) {
+    driver.Update(point);
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(driver.ToBinary());
+  }
+  state.counters["bytes"] = driver.ToBinary().size();
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetDeserializeBinary(benchmark::State& state) {
+  int d = 64;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+  Eigen::VectorXf point = Eigen::VectorXf::Random(d);
+  for (int i = 0; i < 10000; i++) {
+    driver.Update(point);
+  }
+  auto serialized = driver.ToBinary();
+
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver2(64, d, 4, 64);
+
+  for (auto _ : state) {
+    PX_CHECK_OK(driver2.FromBinary(serialized));
+  }
+}
+
 BENCHMARK(BM_CoresetTreeUpdate);
+BENCHMARK(BM_CoresetTreeUpdateLarge)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CoresetTreeUpdateBatch)
+    ->ArgsProduct({{100000, 1000000}, {1024}})
+    ->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_CoresetFromWeightedPointSet);
 BENCHMARK(BM_CoresetTreeQuery);
 BENCHMARK(BM_CoresetTreeMerge);
 BENCHMARK(BM_CoresetSerialize);
 BENCHMARK(BM_CoresetDeserialize);
+BENCHMARK(BM_CoresetSerializeBinary);
+BENCHMARK(BM_CoresetDeserializeBinary);
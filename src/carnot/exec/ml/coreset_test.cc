@@ -19,7 +19,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
+
 #include "src/carnot/exec/ml/coreset.h"
+#include "src/common/testing/testing.h"
 
 namespace px {
 namespace carnot {
@@ -105,6 +109,44 @@ TEST(CoresetDriver, serialization) {
   EXPECT_EQ(256, point_set->size());
 }
 
+TEST(CoresetDriver, update_batch) {
+  int d = 8;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+  CoresetDriver<CoresetTree<KMeansCoreset>> batch_driver(64, d, 4, 64);
+  // Not a multiple of the base bucket size, so the last bucket is partially filled.
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(64 * 5 + 10, d);
+  for (int i = 0; i < points.rows(); i++) {
+    driver.Update(points.row(i).transpose());
+  }
+  // Split the points into batches that don't line up with the buckets.
+  batch_driver.UpdateBatch(points.topRows(100));
+  batch_driver.UpdateBatch(points.bottomRows(points.rows() - 100));
+
+  EXPECT_EQ(driver.Query()->size(), batch_driver.Query()->size());
+  EXPECT_EQ(driver.ToBinary().size(), batch_driver.ToBinary().size());
+}
+
+TEST(CoresetDriver, binary_serialization) {
+  int d = 64;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver(64, d, 4, 64);
+  Eigen::VectorXf point = Eigen::VectorXf::Random(d);
+  // Insert 10 buckets and a partial bucket worth of points.
+  for (int i = 0; i < 64 * 10 + 5; i++) {
+    driver.Update(point);
+  }
+  auto serialized = driver.ToBinary();
+
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver2(64, d, 4, 64);
+  ASSERT_OK(driver2.FromBinary(serialized));
+  EXPECT_EQ(serialized, driver2.ToBinary());
+  // 4 buckets in the tree, plus the partial bucket.
+  EXPECT_EQ(256 + 5, driver2.Query()->size());
+
+  // Truncated data is rejected rather than read past.
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver3(64, d, 4, 64);
+  EXPECT_NOT_OK(driver3.FromBinary(std::string_view(serialized).substr(0, serialized.size() - 1)));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -17,22 +17,58 @@
  */
 
 #include "src/carnot/exec/ml/kmeans.h"
+
+#include <algorithm>
+#include <limits>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include "src/carnot/exec/ml/sampling.h"
 
+DEFINE_int32(carnot_kmeans_num_threads, gflags::Int32FromEnv("PL_CARNOT_KMEANS_NUM_THREADS", 4),
+             "The number of threads used to fit the model of the KMeans UDA.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
+namespace {
+
+// Below this many points per thread, the cost of starting the threads outweighs the speedup.
+constexpr int kMinPointsPerShard = 1024;
+
+int NumShards(int num_points, int num_threads) {
+  return std::clamp(num_points / kMinPointsPerShard, 1, std::max(num_threads, 1));
+}
+
+// Splits [0, num_points) into num_shards contiguous ranges, and calls fn(shard, begin, end) for
+// each of them, one per thread.
+template <typename TFn>
+void ParallelFor(int num_points, int num_shards, const TFn& fn) {
+  const int shard_size = (num_points + num_shards - 1) / num_shards;
+  std::vector<std::thread> threads;
+  for (int shard = 1; shard < num_shards; ++shard) {
+    int begin = std::min(num_points, shard * shard_size);
+    int end = std::min(num_points, begin + shard_size);
+    threads.emplace_back([&fn, shard, begin, end]() { fn(shard, begin, end); });
+  }
+  fn(0, 0, std::min(num_points, shard_size));
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
 void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
   if (set->size() < 2) {
     LOG(ERROR) << "Fitting KMeans on less than 2 points is currently unsupported.";
     return;
   }
-  auto points = set->points();
-  auto weights = set->weights();
+  const auto& points = set->points();
+  const auto& weights = set->weights();
 
   centroids_.resize(k_, points.cols());
   switch (init_type_) {
@@ -49,18 +85,37 @@ void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
 }
 
 bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
-  Eigen::MatrixXf new_centroids = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
-  Eigen::ArrayXf centroid_weights = Eigen::ArrayXf::Zero(centroids_.rows());
-
-  for (int i = 0; i < points.rows(); i++) {
-    Eigen::VectorXf::Index closest_centroid;
-    (centroids_.rowwise() - points(i, Eigen::indexing::all))
-        .rowwise()
-        .squaredNorm()
-        .minCoeff(&closest_centroid);
-    new_centroids(closest_centroid, Eigen::indexing::all) +=
-        weights(i) * points(i, Eigen::indexing::all);
-    centroid_weights(closest_centroid) += weights(i);
+  const int num_shards = NumShards(points.rows(), num_threads_);
+  const Eigen::RowVectorXf centroid_norms = centroids_.rowwise().squaredNorm().transpose();
+
+  // Each shard accumulates the weighted sums of its points per centroid, which are added up after.
+  std::vector<Eigen::MatrixXf> shard_sums(
+      num_shards, Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols()));
+  std::vector<Eigen::ArrayXf> shard_weights(num_shards, Eigen::ArrayXf::Zero(centroids_.rows()));
+
+  ParallelFor(points.rows(), num_shards, [&](int shard, int begin, int end) {
+    if (begin == end) {
+      return;
+    }
+    auto block = points.middleRows(begin, end - begin);
+    // ||p - c||^2 = ||p||^2 - 2 p.c + ||c||^2, of which ||p||^2 does not change the closest
+    // centroid. This computes the distances of the whole block with one matrix multiply.
+    Eigen::MatrixXf dists = block * centroids_.transpose();
+    dists *= -2.0f;
+    dists.rowwise() += centroid_norms;
+    for (int i = 0; i < dists.rows(); i++) {
+      Eigen::Index closest_centroid;
+      dists.row(i).minCoeff(&closest_centroid);
+      shard_sums[shard].row(closest_centroid) += weights(begin + i) * block.row(i);
+      shard_weights[shard](closest_centroid) += weights(begin + i);
+    }
+  });
+
+  Eigen::MatrixXf new_centroids = shard_sums[0];
+  Eigen::ArrayXf centroid_weights = shard_weights[0];
+  for (int shard = 1; shard < num_shards; ++shard) {
+    new_centroids += shard_sums[shard];
+    centroid_weights += shard_weights[shard];
   }
 
   for (int i = 0; i < k_; i++) {
@@ -80,22 +135,30 @@ bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorX
 
 void KMeans::KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
   std::uniform_int_distribution<> dist(0, points.rows() - 1);
-  auto firstCentroid = dist(random_gen_);
-  centroids_(0, Eigen::indexing::all) = points(firstCentroid, Eigen::indexing::all);
+  auto first_centroid = dist(random_gen_);
+  centroids_(0, Eigen::indexing::all) = points(first_centroid, Eigen::indexing::all);
 
-  Eigen::VectorXf probDist(points.rows());
+  const int num_shards = NumShards(points.rows(), num_threads_);
+
+  // The distance from each point to its closest centroid so far. It is updated with only the
+  // newest centroid on each step, instead of recomputed against all the chosen centroids.
+  Eigen::VectorXf min_dists =
+      Eigen::VectorXf::Constant(points.rows(), std::numeric_limits<float>::max());
+  Eigen::VectorXf prob_dist(points.rows());
   for (auto i = 1; i < k_; i++) {
-    for (auto j = 0; j < probDist.rows(); j++) {
-      auto point = points(j, Eigen::indexing::all);
-      Eigen::VectorXf::Index closestCentroid;
-      auto dist = (centroids_(Eigen::seq(0, i - 1), Eigen::indexing::all).rowwise() - point)
-                      .rowwise()
-                      .squaredNorm()
-                      .minCoeff(&closestCentroid);
-      probDist(j) = weights(j) * dist;
-    }
-    std::discrete_distribution<> pointDist(probDist.begin(), probDist.end());
-    auto ind = pointDist(random_gen_);
+    const Eigen::RowVectorXf last_centroid = centroids_(i - 1, Eigen::indexing::all);
+    ParallelFor(points.rows(), num_shards, [&](int, int begin, int end) {
+      const int n = end - begin;
+      if (n == 0) {
+        return;
+      }
+      min_dists.segment(begin, n) = min_dists.segment(begin, n).cwiseMin(
+          (points.middleRows(begin, n).rowwise() - last_centroid).rowwise().squaredNorm());
+      prob_dist.segment(begin, n) =
+          weights.segment(begin, n).cwiseProduct(min_dists.segment(begin, n));
+    });
+    std::discrete_distribution<> point_dist(prob_dist.begin(), prob_dist.end());
+    auto ind = point_dist(random_gen_);
     centroids_(i, Eigen::indexing::all) = points(ind, Eigen::indexing::all);
   }
 }
@@ -18,12 +18,16 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
+
 #include <memory>
 #include <random>
 #include <string>
 
 #include "src/carnot/exec/ml/coreset.h"
 
+DECLARE_int32(carnot_kmeans_num_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -35,14 +39,19 @@ class KMeans {
     kKMeansPlusPlus = 0,
   };
   explicit KMeans(int k, int max_iters = 10, KMeansInitType init_type = kKMeansPlusPlus,
-                  unsigned int seed = 42)
-      : k_(k), max_iters_(max_iters), init_type_(init_type), random_gen_(seed) {}
+                  unsigned int seed = 42, int num_threads = 1)
+      : k_(k),
+        max_iters_(max_iters),
+        init_type_(init_type),
+        num_threads_(num_threads),
+        random_gen_(seed) {}
 
   /**
    * Run kmeans on a weighted set of points.
    * Updates centroids_ based on running kmeans on this set.
    * Note that only the last call to Fit matters, eg. Fit(set1); Fit(set2); is equivalent to
    * Fit(set2).
+   * The points are split across up to num_threads threads for the seeding and each iteration.
    **/
   void Fit(std::shared_ptr<WeightedPointSet> set);
 
@@ -63,6 +72,7 @@ class KMeans {
   int k_;
   int max_iters_;
   KMeansInitType init_type_;
+  int num_threads_;
   Eigen::MatrixXf centroids_;
   std::mt19937 random_gen_;
 };
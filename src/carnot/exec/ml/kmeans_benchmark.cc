@@ -58,5 +58,27 @@ static void BM_KMeansTransform(benchmark::State& state) {
   }
 }
 
+// Fits a model on a large set of points, on state.range(1) threads.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_KMeansFitLarge(benchmark::State& state) {
+  int k = 10;
+  int d = 64;
+  int n = state.range(0);
+  int num_threads = state.range(1);
+
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(n, d);
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(n);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  for (auto _ : state) {
+    KMeans kmeans(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42, num_threads);
+    kmeans.Fit(set);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
 BENCHMARK(BM_KMeansFit);
+BENCHMARK(BM_KMeansFitLarge)
+    ->ArgsProduct({{100000, 1000000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_KMeansTransform);
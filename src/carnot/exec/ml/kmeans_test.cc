@@ -97,6 +97,21 @@ TEST(KMeans, trimodal_normal_dist) {
   }
 }
 
+TEST(KMeans, multi_threaded_fit) {
+  int k = 3;
+  // Repeat the data so that it is split across all the threads.
+  int repeats = 100;
+  Eigen::MatrixXf points = kmeans_test_data().replicate(repeats, 1);
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(60 * repeats);
+
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  KMeans kmeans(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42, /*num_threads*/ 4);
+  kmeans.Fit(set);
+
+  EXPECT_THAT(kmeans.centroids(), UnorderedRowsAre(kmeans_expected_centroids(), 0.15));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -18,14 +18,23 @@
 
 #include "src/carnot/exec/ml/transformer_executor.h"
 
+#include <algorithm>
+
+DEFINE_int32(carnot_transformer_batch_size,
+             gflags::Int32FromEnv("PL_CARNOT_TRANSFORMER_BATCH_SIZE", 32),
+             "The number of documents the transformer model embeds per inference.");
+DEFINE_int32(carnot_transformer_num_threads,
+             gflags::Int32FromEnv("PL_CARNOT_TRANSFORMER_NUM_THREADS", 1),
+             "The number of threads used by each inference of the transformer model.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
-static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
+static int load_ints_from_json(std::string_view in, int32_t* arr, int max_num) {
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(in.data());
+  rapidjson::ParseResult ok = d.Parse(in.data(), in.size());
   // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
   if (ok == nullptr) {
     return 0;
@@ -49,18 +58,40 @@ static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
   return count;
 }
 
+bool TransformerExecutor::ResizeBatch(int batch_size) {
+  tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {batch_size, max_length_});
+  if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    batch_size_ = 0;
+    return false;
+  }
+  batch_size_ = batch_size;
+  return true;
+}
+
+int TransformerExecutor::LoadTokens(std::string_view doc, int32_t* row) {
+  auto count = load_ints_from_json(doc, row, max_length_);
+  if (count == 0) {
+    return 0;
+  }
+
+  // Add 1 to each token to account for pad token.
+  for (int i = 0; i < count; i++) {
+    row[i] = row[i] + 1;
+  }
+
+  for (int i = count; i < max_length_; i++) {
+    row[i] = 0;
+  }
+  return count;
+}
+
 void TransformerExecutor::Execute(std::string doc, std::string* out) {
-  // LOG(INFO) << "inputs: " << tf_interpreter_->inputs().size() << "\n";
-  // LOG(INFO) << "input(0) name: " << tf_interpreter_->GetInputName(0) << "\n";
-
-  // int t_size = tf_interpreter_->tensors_size();
-  // for (int i = 0; i < t_size; i++) {
-  //   if (tf_interpreter_->tensor(i)->name) {
-  //     LOG(INFO) << i << ": " << tf_interpreter_->tensor(i)->name << ", "
-  //               << tf_interpreter_->tensor(i)->bytes << ", "
-  //               << tf_interpreter_->tensor(i)->type;
-  //   }
-  // }
+  if (batch_size_ != 1 && !ResizeBatch(1)) {
+    LOG(INFO) << "Failed to allocate tensors";
+    *out = "";
+    return;
+  }
+
   auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
   if (input == nullptr) {
     LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
@@ -68,25 +99,13 @@ void TransformerExecutor::Execute(std::string doc, std::string* out) {
     return;
   }
 
-  auto count = load_ints_from_json(doc, input, max_length_);
-  if (count == 0) {
+  if (LoadTokens(doc, input) == 0) {
     // Either input array was empty or there was an error parsing the json, either way don't
     // continue.
     *out = "";
     return;
   }
 
-  // Add 1 to each token to account for pad token.
-  for (int i = 0; i < count; i++) {
-    input[i] = input[i] + 1;
-  }
-
-  for (int i = count; i < max_length_; i++) {
-    input[i] = 0;
-  }
-
-  const int embedding_size = 256;
-
   tf_interpreter_->Invoke();
 
   auto output = tf_interpreter_->typed_output_tensor<float>(0);
@@ -95,13 +114,64 @@ void TransformerExecutor::Execute(std::string doc, std::string* out) {
   rapidjson::StringBuffer sb;
   rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
   writer.StartArray();
-  for (int i = 0; i < embedding_size; i++) {
+  for (int i = 0; i < kEmbeddingSize; i++) {
     writer.Double(output[i]);
   }
   writer.EndArray();
   *out = sb.GetString();
 }
 
+void TransformerExecutor::ExecuteBatch(const std::vector<std::string_view>& docs,
+                                       std::vector<std::vector<float>>* out) {
+  out->clear();
+  out->resize(docs.size());
+
+  // The interpreter is kept at a fixed batch size, and the last batch is padded, so that the
+  // tensors are only reallocated when the batch size changes.
+  const int batch_size = std::max(1, FLAGS_carnot_transformer_batch_size);
+  if (batch_size_ != batch_size && !ResizeBatch(batch_size)) {
+    LOG(INFO) << "Failed to allocate tensors for batch size " << batch_size;
+    return;
+  }
+
+  auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
+  if (input == nullptr) {
+    LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
+    return;
+  }
+
+  for (size_t start = 0; start < docs.size(); start += batch_size) {
+    const size_t end = std::min(docs.size(), start + batch_size);
+
+    bool has_tokens = false;
+    for (size_t i = start; i < end; ++i) {
+      if (LoadTokens(docs[i], input + (i - start) * max_length_) > 0) {
+        (*out)[i].resize(kEmbeddingSize);
+        has_tokens = true;
+      }
+    }
+    if (!has_tokens) {
+      continue;
+    }
+    // Rows without tokens, including the padding of the last batch, are run as all padding and
+    // their output is ignored.
+    for (size_t i = start; i < start + batch_size; ++i) {
+      if (i >= end || (*out)[i].empty()) {
+        std::fill_n(input + (i - start) * max_length_, max_length_, 0);
+      }
+    }
+
+    tf_interpreter_->Invoke();
+
+    const float* output = tf_interpreter_->typed_output_tensor<float>(0);
+    for (size_t i = start; i < end; ++i) {
+      if (!(*out)[i].empty()) {
+        std::copy_n(output + (i - start) * kEmbeddingSize, kEmbeddingSize, (*out)[i].begin());
+      }
+    }
+  }
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
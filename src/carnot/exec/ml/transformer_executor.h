@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <gflags/gflags.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -26,9 +27,15 @@
 #include <tensorflow/lite/model.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+
 #include "src/carnot/udf/model_executor.h"
 #include "src/common/base/utils.h"
 
+DECLARE_int32(carnot_transformer_batch_size);
+DECLARE_int32(carnot_transformer_num_threads);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -36,6 +43,9 @@ namespace ml {
 
 class TransformerExecutor : public udf::ModelExecutor {
  public:
+  // The number of floats in the embedding of a document.
+  static constexpr int kEmbeddingSize = 256;
+
   TransformerExecutor() : TransformerExecutor("/embedding.proto") {}
   explicit TransformerExecutor(std::string model_proto_path) { Init(model_proto_path); }
 
@@ -45,8 +55,8 @@ class TransformerExecutor : public udf::ModelExecutor {
     model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
     tflite::ops::builtin::BuiltinOpResolver resolver;
     tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
-    tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {1, max_length_});
-    if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    tf_interpreter_->SetNumThreads(FLAGS_carnot_transformer_num_threads);
+    if (!ResizeBatch(1)) {
       LOG(INFO) << "Failed to allocate tensors";
     } else {
       LOG(INFO) << "Init Transformer model";
@@ -55,10 +65,27 @@ class TransformerExecutor : public udf::ModelExecutor {
 
   void Execute(std::string doc, std::string* out);
 
+  /**
+   * Computes the embeddings of a batch of documents, each a JSON array of SentencePiece token IDs.
+   * The documents are run through the model FLAGS_carnot_transformer_batch_size at a time. Sets
+   * (*out)[i] to the kEmbeddingSize floats of docs[i], or to an empty vector if docs[i] has no
+   * valid tokens.
+   */
+  void ExecuteBatch(const std::vector<std::string_view>& docs,
+                    std::vector<std::vector<float>>* out);
+
  private:
+  // Resizes the input tensor to hold batch_size documents. Returns false if the tensors could not
+  // be allocated.
+  bool ResizeBatch(int batch_size);
+
+  // Loads the tokens of doc into the input tensor row. Returns the number of tokens.
+  int LoadTokens(std::string_view doc, int32_t* row);
+
   std::unique_ptr<tflite::Interpreter> tf_interpreter_;
   std::unique_ptr<tflite::FlatBufferModel> model_;
   int max_length_ = 64;
+  int batch_size_ = 0;
 };
 
 }  // namespace ml
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/funcs/builtins/builtins.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/datagen/datagen.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table/table_store.h"
+
+using px::Status;
+using px::carnot::exec::AggNode;
+using px::carnot::exec::ExecState;
+using px::carnot::exec::FakePlanNode;
+using px::carnot::exec::MockMetricsStubGenerator;
+using px::carnot::exec::MockResultSinkStubGenerator;
+using px::carnot::exec::MockTraceStubGenerator;
+using px::carnot::exec::RowBatchBuilder;
+using px::carnot::exec::SinkNode;
+using px::table_store::schema::RowBatch;
+using px::table_store::schema::RowDescriptor;
+using px::types::DataType;
+
+namespace {
+
+// Agg of px.mean over the value column, grouped by the group column.
+constexpr char kMeanAggOperator[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  values {
+    name: "mean"
+    args {
+      column {
+        node: 0
+        index: 1
+      }
+    }
+  }
+  groups {
+    node: 0
+    index: 0
+  }
+  group_names: "group"
+  value_names: "mean"
+  partial_agg: $0
+  finalize_results: $1
+})";
+
+constexpr int64_t kNumPEMs = 4;
+constexpr int64_t kBatchSize = 1024;
+
+// Holds on to the row batches sent to it, standing in for the GRPCSink between a PEM and Kelvin.
+class RowBatchCollector : public SinkNode {
+ public:
+  std::vector<std::unique_ptr<RowBatch>>& batches() { return batches_; }
+
+ protected:
+  std::string DebugStringImpl() override { return "RowBatchCollector"; }
+  Status InitImpl(const px::carnot::plan::Operator&) override { return Status::OK(); }
+  Status PrepareImpl(ExecState*) override { return Status::OK(); }
+  Status OpenImpl(ExecState*) override { return Status::OK(); }
+  Status CloseImpl(ExecState*) override { return Status::OK(); }
+  Status ConsumeNextImpl(ExecState*, const RowBatch& rb, size_t) override {
+    batches_.push_back(std::make_unique<RowBatch>(rb));
+    return Status::OK();
+  }
+
+ private:
+  std::vector<std::unique_ptr<RowBatch>> batches_;
+};
+
+std::unique_ptr<px::carnot::plan::Operator> MeanAggOperator(bool partial_agg,
+                                                            bool finalize_results) {
+  px::carnot::planpb::Operator op_pb;
+  CHECK(google::protobuf::TextFormat::MergeFromString(
+      absl::Substitute(kMeanAggOperator, partial_agg, finalize_results), &op_pb));
+  return px::carnot::plan::AggregateOperator::FromProto(op_pb, 1);
+}
+
+// Runs the agg over the input batches, marking the last batch as the end of the stream.
+std::vector<std::unique_ptr<RowBatch>> RunAgg(ExecState* exec_state,
+                                              const px::carnot::plan::Operator& op,
+                                              const RowDescriptor& input_rd,
+                                              const RowDescriptor& output_rd,
+                                              const std::vector<std::unique_ptr<RowBatch>>& input) {
+  AggNode node;
+  RowBatchCollector collector;
+  node.AddChild(&collector, 0);
+  PX_CHECK_OK(node.Init(op, output_rd, {input_rd}));
+  PX_CHECK_OK(node.Prepare(exec_state));
+  PX_CHECK_OK(node.Open(exec_state));
+  FakePlanNode fake_plan(2);
+  PX_CHECK_OK(collector.Init(fake_plan, RowDescriptor({}), {output_rd}));
+  PX_CHECK_OK(collector.Prepare(exec_state));
+  PX_CHECK_OK(collector.Open(exec_state));
+
+  for (const auto& [i, rb] : px::Enumerate(input)) {
+    bool last = i + 1 == input.size();
+    rb->set_eow(last);
+    rb->set_eos(last);
+    PX_CHECK_OK(node.ConsumeNext(exec_state, *rb, 0));
+  }
+  PX_CHECK_OK(node.Close(exec_state));
+  PX_CHECK_OK(collector.Close(exec_state));
+  return std::move(collector.batches());
+}
+
+int64_t TotalBytes(const std::vector<std::unique_ptr<RowBatch>>& batches) {
+  int64_t bytes = 0;
+  for (const auto& rb : batches) {
+    bytes += rb->NumBytes();
+  }
+  return bytes;
+}
+
+}  // namespace
+
+// Measures the cost on Kelvin of a groupby mean over the data of kNumPEMs PEMs, with and without
+// partial aggregation on the PEMs. Reports the bytes the PEMs ship to Kelvin as a counter.
+// NOLINTNEXTLINE : runtime/references.
+void BM_KelvinMeanAgg(benchmark::State& state, bool partial_agg) {
+  int64_t rows_per_pem = state.range(0);
+  int64_t num_groups = state.range(1);
+
+  auto func_registry = std::make_unique<px::carnot::udf::Registry>("test_registry");
+  px::carnot::builtins::RegisterBuiltinsOrDie(func_registry.get());
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, MockMetricsStubGenerator,
+      MockTraceStubGenerator, sole::uuid4(), nullptr);
+  PX_CHECK_OK(exec_state->AddUDA(0, "mean", {DataType::FLOAT64}));
+
+  RowDescriptor input_rd({DataType::INT64, DataType::FLOAT64});
+  RowDescriptor partial_rd({DataType::INT64, DataType::STRING});
+  RowDescriptor output_rd({DataType::INT64, DataType::FLOAT64});
+
+  // Build the batches that each PEM sends to Kelvin.
+  std::vector<std::unique_ptr<RowBatch>> shipped;
+  std::chrono::nanoseconds pem_time{0};
+  auto partial_op = MeanAggOperator(/*partial_agg*/ true, /*finalize_results*/ false);
+  for (int64_t pem = 0; pem < kNumPEMs; ++pem) {
+    std::vector<std::unique_ptr<RowBatch>> pem_batches;
+    for (int64_t offset = 0; offset < rows_per_pem; offset += kBatchSize) {
+      int64_t num_rows = std::min(kBatchSize, rows_per_pem - offset);
+      RowBatchBuilder builder(input_rd, num_rows, /*eow*/ false, /*eos*/ false);
+      builder.AddColumn<px::types::Int64Value>(
+          px::datagen::CreateLargeData<px::types::Int64Value>(num_rows, 0, num_groups - 1));
+      builder.AddColumn<px::types::Float64Value>(
+          px::datagen::CreateLargeData<px::types::Float64Value>(num_rows, 0, 1000));
+      pem_batches.push_back(std::make_unique<RowBatch>(builder.get()));
+    }
+    if (!partial_agg) {
+      for (auto& rb : pem_batches) {
+        shipped.push_back(std::move(rb));
+      }
+      continue;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto partials = RunAgg(exec_state.get(), *partial_op, input_rd, partial_rd, pem_batches);
+    pem_time += std::chrono::steady_clock::now() - start;
+    for (auto& rb : partials) {
+      shipped.push_back(std::move(rb));
+    }
+  }
+
+  auto kelvin_op = partial_agg ? MeanAggOperator(/*partial_agg*/ false, /*finalize_results*/ true)
+                               : MeanAggOperator(/*partial_agg*/ true, /*finalize_results*/ true);
+  const RowDescriptor& kelvin_input_rd = partial_agg ? partial_rd : input_rd;
+
+  for (auto _ : state) {
+    auto out = RunAgg(exec_state.get(), *kelvin_op, kelvin_input_rd, output_rd, shipped);
+    benchmark::DoNotOptimize(out);
+  }
+
+  state.counters["bytes_shipped"] = TotalBytes(shipped);
+  state.counters["pem_partial_agg_ms"] =
+      std::chrono::duration<double, std::milli>(pem_time).count() / kNumPEMs;
+  state.SetItemsProcessed(state.iterations() * rows_per_pem * kNumPEMs);
+}
+
+BENCHMARK_CAPTURE(BM_KelvinMeanAgg, full_agg_on_kelvin, /*partial_agg*/ false)
+    ->RangeMultiplier(8)
+    ->Ranges({{1 << 14, 1 << 20}, {16, 16384}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_KelvinMeanAgg, partial_agg_on_pems, /*partial_agg*/ true)
+    ->RangeMultiplier(8)
+    ->Ranges({{1 << 14, 1 << 20}, {16, 16384}})
+    ->Unit(benchmark::kMillisecond);
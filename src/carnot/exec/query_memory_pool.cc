@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/query_memory_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/strings/substitute.h>
+
+DEFINE_int64(carnot_query_memory_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_LIMIT_BYTES", 0),
+             "The maximum number of bytes a single query may allocate for its row batches. "
+             "0 means no limit.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+int QueryMemoryPool::SizeClass(int64_t size) {
+  if (size <= kMinSizeClassBytes) {
+    return 0;
+  }
+  if (size > kMaxSizeClassBytes) {
+    return -1;
+  }
+  // ceil(log2(size)) - log2(kMinSizeClassBytes).
+  int log2_ceil = 64 - __builtin_clzll(static_cast<uint64_t>(size - 1));
+  return log2_ceil - 6;
+}
+
+int64_t QueryMemoryPool::AllocationBytes(int64_t size) {
+  int size_class = SizeClass(size);
+  return size_class >= 0 ? SizeClassBytes(size_class) : size;
+}
+
+QueryMemoryPool::~QueryMemoryPool() {
+  absl::base_internal::SpinLockHolder lock(&lock_);
+  ReleaseCachedBlocks();
+}
+
+arrow::Status QueryMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  if (size < 0) {
+    return arrow::Status::Invalid("negative malloc size");
+  }
+  int size_class = SizeClass(size);
+  int64_t alloc_bytes = AllocationBytes(size);
+  {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    DCHECK(!released_) << "Allocating from a released QueryMemoryPool";
+    if (memory_limit_bytes_ > 0 && bytes_allocated_ + alloc_bytes > memory_limit_bytes_) {
+      return arrow::Status::OutOfMemory(absl::Substitute(
+          "Query exceeded its memory limit of $0 bytes (allocated: $1, requested: $2)",
+          memory_limit_bytes_, bytes_allocated_, alloc_bytes));
+    }
+    bytes_allocated_ += alloc_bytes;
+    peak_bytes_ = std::max(peak_bytes_, bytes_allocated_);
+
+    if (size_class >= 0 && !free_lists_[size_class].empty()) {
+      *out = free_lists_[size_class].back();
+      free_lists_[size_class].pop_back();
+      cached_bytes_ -= alloc_bytes;
+      return arrow::Status::OK();
+    }
+  }
+
+  auto s = parent_->Allocate(alloc_bytes, out);
+  if (!s.ok()) {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    bytes_allocated_ -= alloc_bytes;
+  }
+  return s;
+}
+
+arrow::Status QueryMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (new_size < 0) {
+    return arrow::Status::Invalid("negative realloc size");
+  }
+  // Both sizes fit in the same block, so there is nothing to do.
+  if (AllocationBytes(old_size) == AllocationBytes(new_size)) {
+    return arrow::Status::OK();
+  }
+  uint8_t* new_ptr;
+  ARROW_RETURN_NOT_OK(Allocate(new_size, &new_ptr));
+  std::memcpy(new_ptr, *ptr, std::min(old_size, new_size));
+  Free(*ptr, old_size);
+  *ptr = new_ptr;
+  return arrow::Status::OK();
+}
+
+void QueryMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  int size_class = SizeClass(size);
+  int64_t alloc_bytes = AllocationBytes(size);
+  bool delete_self = false;
+  {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    bytes_allocated_ -= alloc_bytes;
+    if (!released_ && size_class >= 0 && cached_bytes_ + alloc_bytes <= max_cached_bytes_) {
+      free_lists_[size_class].push_back(buffer);
+      cached_bytes_ += alloc_bytes;
+      return;
+    }
+    delete_self = released_ && bytes_allocated_ == 0;
+  }
+  parent_->Free(buffer, alloc_bytes);
+  if (delete_self) {
+    delete this;
+  }
+}
+
+int64_t QueryMemoryPool::bytes_allocated() const {
+  absl::base_internal::SpinLockHolder lock(&lock_);
+  return bytes_allocated_;
+}
+
+int64_t QueryMemoryPool::max_memory() const {
+  absl::base_internal::SpinLockHolder lock(&lock_);
+  return peak_bytes_;
+}
+
+int64_t QueryMemoryPool::cached_bytes() const {
+  absl::base_internal::SpinLockHolder lock(&lock_);
+  return cached_bytes_;
+}
+
+void QueryMemoryPool::ReleaseCachedBlocks() {
+  for (const auto& [size_class, free_list] : Enumerate(free_lists_)) {
+    for (uint8_t* block : free_list) {
+      parent_->Free(block, SizeClassBytes(size_class));
+    }
+    free_list.clear();
+  }
+  cached_bytes_ = 0;
+}
+
+void QueryMemoryPool::Release() {
+  bool delete_self = false;
+  {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    released_ = true;
+    ReleaseCachedBlocks();
+    delete_self = bytes_allocated_ == 0;
+  }
+  if (delete_self) {
+    delete this;
+  }
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <absl/base/internal/spinlock.h>
+#include <absl/base/thread_annotations.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * QueryMemoryPool is an arrow::MemoryPool used for the allocations of a single query.
+ *
+ * Allocations are rounded up to power-of-two size classes. Freed blocks are kept on per size class
+ * free lists and handed out again on the next allocation of the same class, so the builders of
+ * successive row batches reuse the same memory instead of going back to the parent allocator.
+ * Allocations larger than the largest size class go directly to the parent pool.
+ *
+ * The pool optionally enforces a memory limit: allocations that would push the bytes held by the
+ * query above the limit fail with an OutOfMemory status.
+ *
+ * Arrow buffers keep a raw pointer to the pool that allocated them, and some of them (e.g. batches
+ * written to a MemorySink table) outlive the query. So the pool is not deleted directly; instead
+ * the owning query calls Release() at teardown. Release returns all cached blocks to the parent,
+ * and the pool deletes itself once the last outstanding allocation is freed.
+ */
+class QueryMemoryPool : public arrow::MemoryPool {
+ public:
+  static constexpr int64_t kMinSizeClassBytes = 64;
+  static constexpr int64_t kMaxSizeClassBytes = 4 * 1024 * 1024;
+  static constexpr int kNumSizeClasses = 17;  // 64B .. 4MB.
+  // Maximum number of bytes kept on the free lists. Frees beyond this go to the parent pool.
+  static constexpr int64_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+  /**
+   * Creates a new pool. The returned pool must be released with Release(), not deleted.
+   * @param parent the pool that backs this pool's allocations.
+   * @param memory_limit_bytes the maximum number of bytes the query may hold, or 0 for no limit.
+   */
+  static QueryMemoryPool* Create(arrow::MemoryPool* parent, int64_t memory_limit_bytes = 0,
+                                 int64_t max_cached_bytes = kDefaultMaxCachedBytes) {
+    return new QueryMemoryPool(parent, memory_limit_bytes, max_cached_bytes);
+  }
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  // Number of bytes currently held by the query (rounded up to size classes).
+  int64_t bytes_allocated() const override;
+  // Peak number of bytes held by the query.
+  int64_t max_memory() const override;
+
+  // Number of bytes sitting on the free lists, ready for reuse.
+  int64_t cached_bytes() const;
+
+  /**
+   * Returns all cached blocks to the parent pool and marks the pool as released. The pool deletes
+   * itself immediately if there are no outstanding allocations, or otherwise on the final Free.
+   * The pool must not be used for new allocations after this call.
+   */
+  void Release();
+
+ private:
+  QueryMemoryPool(arrow::MemoryPool* parent, int64_t memory_limit_bytes, int64_t max_cached_bytes)
+      : parent_(parent),
+        memory_limit_bytes_(memory_limit_bytes),
+        max_cached_bytes_(max_cached_bytes) {}
+  ~QueryMemoryPool() override;
+
+  // Returns the size class for the given size, or -1 if the size is too large for a class.
+  static int SizeClass(int64_t size);
+  static int64_t SizeClassBytes(int size_class) { return kMinSizeClassBytes << size_class; }
+  // Returns the number of bytes actually reserved for an allocation of the given size.
+  static int64_t AllocationBytes(int64_t size);
+
+  void ReleaseCachedBlocks() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  arrow::MemoryPool* parent_;
+  const int64_t memory_limit_bytes_;
+  const int64_t max_cached_bytes_;
+
+  mutable absl::base_internal::SpinLock lock_;
+  std::array<std::vector<uint8_t*>, kNumSizeClasses> free_lists_ ABSL_GUARDED_BY(lock_);
+  int64_t bytes_allocated_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t peak_bytes_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t cached_bytes_ ABSL_GUARDED_BY(lock_) = 0;
+  bool released_ ABSL_GUARDED_BY(lock_) = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
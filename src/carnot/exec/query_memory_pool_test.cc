@@ -0,0 +1,136 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/builder.h>
+#include <arrow/memory_pool.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/carnot/exec/query_memory_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+class QueryMemoryPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override { parent_bytes_ = parent_->bytes_allocated(); }
+  // Bytes allocated from the parent pool since the start of the test.
+  int64_t parent_bytes() { return parent_->bytes_allocated() - parent_bytes_; }
+
+  arrow::MemoryPool* parent_ = arrow::default_memory_pool();
+  int64_t parent_bytes_ = 0;
+};
+
+TEST_F(QueryMemoryPoolTest, rounds_up_to_size_class) {
+  auto* pool = QueryMemoryPool::Create(parent_);
+  uint8_t* buf;
+  ASSERT_TRUE(pool->Allocate(100, &buf).ok());
+  EXPECT_EQ(128, pool->bytes_allocated());
+  EXPECT_EQ(128, parent_bytes());
+  pool->Free(buf, 100);
+  EXPECT_EQ(0, pool->bytes_allocated());
+  pool->Release();
+  EXPECT_EQ(0, parent_bytes());
+}
+
+TEST_F(QueryMemoryPoolTest, reuses_freed_blocks) {
+  auto* pool = QueryMemoryPool::Create(parent_);
+  uint8_t* buf1;
+  ASSERT_TRUE(pool->Allocate(1000, &buf1).ok());
+  pool->Free(buf1, 1000);
+  EXPECT_EQ(1024, pool->cached_bytes());
+
+  // Same size class, so the cached block is handed out again.
+  uint8_t* buf2;
+  ASSERT_TRUE(pool->Allocate(600, &buf2).ok());
+  EXPECT_EQ(buf1, buf2);
+  EXPECT_EQ(0, pool->cached_bytes());
+  EXPECT_EQ(1024, parent_bytes());
+  pool->Free(buf2, 600);
+  pool->Release();
+  EXPECT_EQ(0, parent_bytes());
+}
+
+TEST_F(QueryMemoryPoolTest, enforces_memory_limit) {
+  auto* pool = QueryMemoryPool::Create(parent_, /*memory_limit_bytes*/ 4096);
+  uint8_t* buf1;
+  uint8_t* buf2;
+  ASSERT_TRUE(pool->Allocate(4000, &buf1).ok());
+  auto s = pool->Allocate(100, &buf2);
+  EXPECT_TRUE(s.IsOutOfMemory());
+  EXPECT_EQ(4096, pool->bytes_allocated());
+  pool->Free(buf1, 4000);
+  EXPECT_TRUE(pool->Allocate(100, &buf2).ok());
+  pool->Free(buf2, 100);
+  pool->Release();
+}
+
+TEST_F(QueryMemoryPoolTest, tracks_peak_memory) {
+  auto* pool = QueryMemoryPool::Create(parent_);
+  uint8_t* buf1;
+  uint8_t* buf2;
+  ASSERT_TRUE(pool->Allocate(64, &buf1).ok());
+  ASSERT_TRUE(pool->Allocate(10 * 1024 * 1024, &buf2).ok());
+  pool->Free(buf2, 10 * 1024 * 1024);
+  EXPECT_EQ(64, pool->bytes_allocated());
+  EXPECT_EQ(64 + 10 * 1024 * 1024, pool->max_memory());
+  // Blocks larger than the largest size class are not cached.
+  EXPECT_EQ(0, pool->cached_bytes());
+  pool->Free(buf1, 64);
+  pool->Release();
+}
+
+TEST_F(QueryMemoryPoolTest, reallocate_preserves_contents) {
+  auto* pool = QueryMemoryPool::Create(parent_);
+  uint8_t* buf;
+  ASSERT_TRUE(pool->Allocate(64, &buf).ok());
+  for (int i = 0; i < 64; ++i) {
+    buf[i] = static_cast<uint8_t>(i);
+  }
+  ASSERT_TRUE(pool->Reallocate(64, 200, &buf).ok());
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(i, buf[i]);
+  }
+  EXPECT_EQ(256, pool->bytes_allocated());
+  pool->Free(buf, 200);
+  pool->Release();
+}
+
+TEST_F(QueryMemoryPoolTest, buffers_outlive_release) {
+  auto* pool = QueryMemoryPool::Create(parent_);
+  std::shared_ptr<arrow::Array> arr;
+  {
+    arrow::Int64Builder builder(pool);
+    ASSERT_TRUE(builder.AppendValues({1, 2, 3}).ok());
+    ASSERT_TRUE(builder.Finish(&arr).ok());
+  }
+  // The query ends, but the array is still referenced (e.g. by a MemorySink table).
+  pool->Release();
+  EXPECT_GT(parent_bytes(), 0);
+  EXPECT_EQ(3, arr->length());
+  // Dropping the last reference frees the memory and the pool itself.
+  arr.reset();
+  EXPECT_EQ(0, parent_bytes());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
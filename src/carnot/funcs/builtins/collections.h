@@ -88,8 +88,13 @@ class AnyUDA : public udf::UDA {
     }
   }
 
-  void Merge(FunctionContext*, const AnyUDA&) {
-    // Does nothing.
+  void Merge(FunctionContext*, const AnyUDA& other) {
+    // Keep our value if we have one, otherwise take the other's. The finalizing UDA of a partial
+    // agg only sees merges, so it must pick up a value here.
+    if (!picked && other.picked) {
+      val_ = other.val_;
+      picked = true;
+    }
   }
 
   TArg Finalize(FunctionContext*) { return val_; }
@@ -102,6 +107,7 @@ class AnyUDA : public udf::UDA {
 
   Status Deserialize(FunctionContext*, const StringValue& data) {
     val_ = DeserializeScalar<TArg>(data);
+    picked = true;
     return Status::OK();
   }
 
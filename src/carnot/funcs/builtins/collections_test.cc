@@ -41,6 +41,17 @@ TEST(CollectionsTest, AnyUDA) {
   EXPECT_THAT(vals, ::testing::Contains(uda_tester.Result()));
 }
 
+TEST(CollectionsTest, AnyUDA_partial_agg) {
+  auto uda_tester = udf::UDATester<AnyUDA<types::StringValue>>();
+  std::vector<types::StringValue> vals = {"a", "b", "c"};
+
+  for (const auto& val : vals) {
+    uda_tester.ForInput(val);
+  }
+
+  EXPECT_THAT(vals, ::testing::Contains(uda_tester.PartialAggResult()));
+}
+
 TEST(CollectionsTest, CanSerializeDeserialize_Float64) {
   auto uda_tester = udf::UDATester<AnyUDA<types::Float64Value>>();
   std::vector<types::Float64Value> vals = {
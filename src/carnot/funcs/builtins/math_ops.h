@@ -686,7 +686,7 @@ class MaxUDA : public udf::UDA {
   Status Deserialize(FunctionContext*, const StringValue& data) { return max_.Deserialize(data); }
 
  protected:
-  TArg max_ = std::numeric_limits<typename types::ValueTypeTraits<TArg>::native_type>::min();
+  TArg max_ = std::numeric_limits<typename types::ValueTypeTraits<TArg>::native_type>::lowest();
 };
 
 template <typename TArg>
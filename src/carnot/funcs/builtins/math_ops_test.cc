@@ -571,6 +571,12 @@ TEST(MathOps, basic_int64_max_uda_test) {
   uda_tester.ForInput(5).ForInput(2).ForInput(7).ForInput(1).Expect(7);
 }
 
+TEST(MathOps, basic_float64_max_uda_test) {
+  // All inputs are negative, so the result must not be the initial value of the UDA.
+  auto uda_tester = udf::UDATester<MaxUDA<types::Float64Value>>();
+  uda_tester.ForInput(-4.64).ForInput(-1.5).ForInput(-2.25).Expect(-1.5);
+}
+
 TEST(MathOps, merge_max_test) {
   auto uda_tester = udf::UDATester<MaxUDA<types::Int64Value>>();
   uda_tester.ForInput(3).ForInput(6).ForInput(10).ForInput(5).ForInput(2);
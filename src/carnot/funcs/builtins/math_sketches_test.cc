@@ -73,6 +73,22 @@ TEST(MathSketches, quantiles_int64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6);
 }
 
+TEST(MathSketches, quantiles_partial_agg) {
+  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  auto res = uda_tester.ForInput(1.234)
+                 .ForInput(2.442)
+                 .ForInput(1.04)
+                 .ForInput(5.322)
+                 .ForInput(6.333)
+                 .PartialAggResult();
+
+  rapidjson::Document d;
+  d.Parse(res.data());
+  EXPECT_DOUBLE_EQ(d["p01"].GetDouble(), 1.04);
+  EXPECT_DOUBLE_EQ(d["p50"].GetDouble(), 2.442);
+  EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6.333);
+}
+
 TEST(MathSketches, quantiles_serialize) {
   auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
   auto serialized = uda_tester.ForInput(1).Serialize();
@@ -39,9 +39,9 @@ void RegisterMLOpsOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<ReservoirSampleUDA<types::StringValue>>("sample");
 }
 
-int load_floats_from_json(std::string in, Eigen::VectorXf* out, int max_num) {
+int load_floats_from_json(std::string_view in, Eigen::VectorXf* out, int max_num) {
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(in.data());
+  rapidjson::ParseResult ok = d.Parse(in.data(), in.size());
   // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
   if (ok == nullptr) {
     return 0;
@@ -77,6 +77,17 @@ std::string write_ints_to_json(int* arr, int num) {
   return sb.GetString();
 }
 
+std::string write_floats_to_json(const float* arr, int num) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartArray();
+  for (int i = 0; i < num; i++) {
+    writer.Double(arr[i]);
+  }
+  writer.EndArray();
+  return sb.GetString();
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
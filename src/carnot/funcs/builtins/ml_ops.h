@@ -26,6 +26,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "src/carnot/exec/ml/coreset.h"
@@ -46,8 +47,9 @@ using exec::ml::CoresetTree;
 using exec::ml::KMeans;
 using exec::ml::KMeansCoreset;
 
-int load_floats_from_json(std::string in, Eigen::VectorXf* out, int max_num);
+int load_floats_from_json(std::string_view in, Eigen::VectorXf* out, int max_num);
 std::string write_ints_to_json(int* arr, int num);
+std::string write_floats_to_json(const float* arr, int num);
 
 class TransformerUDF : public udf::ScalarUDF {
  public:
@@ -61,6 +63,22 @@ class TransformerUDF : public udf::ScalarUDF {
     return output;
   }
 
+  // Embeds the whole batch with one borrowed executor, which runs the model on many documents
+  // per inference.
+  Status ExecBatch(FunctionContext* ctx, size_t count, StringValue* out, const StringValue* docs) {
+    auto executor =
+        ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
+    std::vector<std::string_view> doc_views(docs, docs + count);
+    std::vector<std::vector<float>> embeddings;
+    executor->ExecuteBatch(doc_views, &embeddings);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = embeddings[i].empty()
+                   ? std::string()
+                   : write_floats_to_json(embeddings[i].data(), embeddings[i].size());
+    }
+    return Status::OK();
+  }
+
  private:
   std::string model_proto_path_;
 };
@@ -81,6 +99,16 @@ class SentencePieceUDF : public udf::ScalarUDF {
     return write_ints_to_json(ids.data(), ids.size());
   }
 
+  Status ExecBatch(FunctionContext*, size_t count, StringValue* out, const StringValue* in) {
+    // Reuses the token buffer across the rows of the batch.
+    std::vector<int> ids;
+    for (size_t i = 0; i < count; ++i) {
+      processor_.Encode(in[i], &ids);
+      out[i] = write_ints_to_json(ids.data(), ids.size());
+    }
+    return Status::OK();
+  }
+
  private:
   sentencepiece::SentencePieceProcessor processor_;
 };
@@ -99,17 +127,84 @@ class KMeansUDA : public udf::UDA {
     DCHECK_EQ(d_, d);
     coreset_.Update(point);
   }
-  void Merge(FunctionContext*, const KMeansUDA& other) { coreset_.Merge(other.coreset_); }
+  // Parses the whole batch into one matrix, which the coreset copies in blocks.
+  void UpdateBatch(FunctionContext*, size_t count, const StringValue* in, const Int64Value* k) {
+    if (count == 0) {
+      return;
+    }
+    if (k_ == -1) {
+      k_ = k[0].val;
+    }
+    Eigen::MatrixXf points(count, d_);
+    Eigen::VectorXf point(d_);
+    for (size_t i = 0; i < count; ++i) {
+      int d = load_floats_from_json(in[i], &point, d_);
+      DCHECK_EQ(d_, d);
+      points.row(i) = point;
+    }
+    coreset_.UpdateBatch(points);
+  }
+  void Merge(FunctionContext*, const KMeansUDA& other) {
+    // The finalizing UDA never sees an Update call, so it learns k from the partials it merges.
+    if (k_ == -1) {
+      k_ = other.k_;
+    }
+    coreset_.Merge(other.coreset_);
+  }
   StringValue Finalize(FunctionContext*) {
     auto point_set = coreset_.Query();
-    KMeans kmeans(k_);
+    KMeans kmeans(k_, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42,
+                  FLAGS_carnot_kmeans_num_threads);
+    // k is only unknown if every input was a legacy JSON partial, which doesn't carry it.
+    if (k_ < 1) {
+      LOG_FIRST_N(ERROR, 1) << "KMeans UDA finalized without knowing k, skipping the fit.";
+      return kmeans.ToJSON();
+    }
     kmeans.Fit(point_set);
     return kmeans.ToJSON();
   }
 
-  StringValue Serialize(FunctionContext*) { return coreset_.ToJSON(); }
+  // The partial aggregate is serialized in binary, as a version byte, k and the coreset.
+  StringValue Serialize(FunctionContext*) {
+    std::string out;
+    exec::ml::AppendBinary<uint8_t>(kSerializationVersion, &out);
+    exec::ml::AppendBinary<int32_t>(k_, &out);
+    out.append(coreset_.ToBinary());
+    return out;
+  }
 
   Status Deserialize(FunctionContext*, const StringValue& data) {
+    // Partials from agents that still serialize to JSON.
+    if (!data.empty() && data[0] == '{') {
+      return DeserializeJSON(data);
+    }
+    std::string_view in(data);
+    uint8_t version;
+    int32_t k;
+    PX_RETURN_IF_ERROR(exec::ml::ReadBinary(&in, &version));
+    if (version != kSerializationVersion) {
+      return error::InvalidArgument("Unsupported serialized KMeans UDA version $0", version);
+    }
+    PX_RETURN_IF_ERROR(exec::ml::ReadBinary(&in, &k));
+    PX_RETURN_IF_ERROR(coreset_.FromBinary(in));
+    k_ = k;
+    return Status::OK();
+  }
+
+ private:
+  static constexpr uint8_t kSerializationVersion = 1;
+
+  // Partials serialized before k was carried through serialization are the bare coreset. For
+  // those, k comes from the Update arguments or from the other partials merged into this UDA.
+  Status DeserializeJSON(const StringValue& data) {
+    rapidjson::Document doc;
+    doc.Parse(data.data(), data.size());
+    if (doc.HasParseError() || !doc.IsObject()) {
+      return error::InvalidArgument("Invalid serialized KMeans UDA");
+    }
+    if (doc.HasMember("k")) {
+      k_ = doc["k"].GetInt();
+    }
     coreset_.FromJSON(data);
     return Status::OK();
   }
@@ -71,6 +71,33 @@ static void BM_TransformerModel(benchmark::State& state) {
   for (auto _ : state) {
     benchmark::DoNotOptimize(udf.Exec(&ctx, json));
   }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Embeds a column of documents through the batch path, which the query engine uses.
+// Reports rows/sec, for comparison with BM_TransformerModel.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TransformerModelBatch(benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  FLAGS_carnot_transformer_batch_size = state.range(1);
+  FLAGS_carnot_transformer_num_threads = state.range(2);
+
+  px::carnot::builtins::TransformerUDF udf(FLAGS_embedding_dir);
+  std::vector<px::types::StringValue> docs;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    auto ints = random_ints(64);
+    docs.push_back(px::carnot::builtins::write_ints_to_json(ints.data(), 64));
+  }
+  std::vector<px::types::StringValue> out(num_rows);
+
+  auto model_pool = px::carnot::udf::ModelPool::Create();
+  auto ctx = px::carnot::udf::FunctionContext(nullptr, model_pool.get());
+
+  for (auto _ : state) {
+    PX_CHECK_OK(udf.ExecBatch(&ctx, num_rows, out.data(), docs.data()));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * num_rows);
 }
 
 // NOLINTNEXTLINE : runtime/references.
@@ -81,7 +108,30 @@ static void BM_SentencePiece(benchmark::State& state) {
   for (auto _ : state) {
     benchmark::DoNotOptimize(udf.Exec(nullptr, text));
   }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_SentencePieceBatch(benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  auto udf = px::carnot::builtins::SentencePieceUDF(FLAGS_sentencepiece_dir);
+  std::vector<px::types::StringValue> texts;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    texts.push_back(random_string(1024));
+  }
+  std::vector<px::types::StringValue> out(num_rows);
+
+  for (auto _ : state) {
+    PX_CHECK_OK(udf.ExecBatch(nullptr, num_rows, out.data(), texts.data()));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * num_rows);
 }
 
 BENCHMARK(BM_SentencePiece)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SentencePieceBatch)->Arg(1024)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_TransformerModel)->Unit(benchmark::kMillisecond);
+// Args are the number of rows, the batch size and the number of interpreter threads.
+BENCHMARK(BM_TransformerModelBatch)
+    ->ArgsProduct({{1024, 10000}, {1, 32}, {1, 4}})
+    ->Unit(benchmark::kMillisecond);
@@ -71,6 +71,73 @@ TEST(KMeans, basic) {
   EXPECT_THAT(kmeans.centroids(), UnorderedRowsAre(expected_centroids, 0.1));
 }
 
+TEST(KMeans, partial_agg) {
+  int k = 3;
+  int d = 2;
+
+  Eigen::MatrixXf expected_centroids = kmeans_expected_centroids();
+  Eigen::MatrixXf points = kmeans_test_data();
+
+  // Split the points across two partial aggregates, and merge their serialized state into a fresh
+  // UDA, as the finalize agg on Kelvin does.
+  KMeansUDA partials[2] = {KMeansUDA(d), KMeansUDA(d)};
+  for (int i = 0; i < points.rows(); i++) {
+    auto inp = write_vector_to_json(points(i, Eigen::indexing::all).transpose());
+    partials[i % 2].Update(nullptr, inp, k);
+  }
+
+  KMeansUDA merged(d);
+  for (auto& partial : partials) {
+    KMeansUDA deserialized(d);
+    ASSERT_OK(deserialized.Deserialize(nullptr, partial.Serialize(nullptr)));
+    merged.Merge(nullptr, deserialized);
+  }
+
+  px::carnot::exec::ml::KMeans kmeans(k);
+  kmeans.FromJSON(merged.Finalize(nullptr));
+  EXPECT_THAT(kmeans.centroids(), UnorderedRowsAre(expected_centroids, 0.1));
+}
+
+// Serializes the partial aggregate as the bare coreset JSON, as agents did before k was carried
+// through serialization.
+class LegacyKMeansUDA : public KMeansUDA {
+ public:
+  using KMeansUDA::KMeansUDA;
+  std::string SerializeLegacyJSON() { return coreset_.ToJSON(); }
+};
+
+TEST(KMeans, partial_agg_from_legacy_json) {
+  int k = 3;
+  int d = 2;
+
+  Eigen::MatrixXf expected_centroids = kmeans_expected_centroids();
+  Eigen::MatrixXf points = kmeans_test_data();
+
+  // One partial comes from an older agent, the other carries k.
+  LegacyKMeansUDA legacy(d);
+  KMeansUDA current(d);
+  for (int i = 0; i < points.rows(); i++) {
+    auto inp = write_vector_to_json(points(i, Eigen::indexing::all).transpose());
+    if (i % 2 == 0) {
+      legacy.Update(nullptr, inp, k);
+    } else {
+      current.Update(nullptr, inp, k);
+    }
+  }
+
+  KMeansUDA merged(d);
+  KMeansUDA legacy_deserialized(d);
+  ASSERT_OK(legacy_deserialized.Deserialize(nullptr, legacy.SerializeLegacyJSON()));
+  merged.Merge(nullptr, legacy_deserialized);
+  KMeansUDA current_deserialized(d);
+  ASSERT_OK(current_deserialized.Deserialize(nullptr, current.Serialize(nullptr)));
+  merged.Merge(nullptr, current_deserialized);
+
+  px::carnot::exec::ml::KMeans kmeans(k);
+  kmeans.FromJSON(merged.Finalize(nullptr));
+  EXPECT_THAT(kmeans.centroids(), UnorderedRowsAre(expected_centroids, 0.1));
+}
+
 TEST(SentencePiece, basic) {
   auto udf_tester = udf::UDFTester<SentencePieceUDF>(FLAGS_sentencepiece_dir);
   udf_tester.ForInput("Test 123!");
@@ -102,6 +169,39 @@ TEST(Transformer, basic) {
   }
 }
 
+TEST(Transformer, batch_matches_per_row) {
+  auto pool = udf::ModelPool::Create();
+  FunctionContext ctx(nullptr, pool.get());
+  TransformerUDF udf(FLAGS_embedding_dir);
+
+  // More documents than fit in one batch, with an invalid document in the middle.
+  std::vector<types::StringValue> docs;
+  for (int i = 0; i < FLAGS_carnot_transformer_batch_size + 3; ++i) {
+    docs.push_back(absl::Substitute("[4,197,$0,195,16,5001]", 100 + i));
+  }
+  docs[5] = "not json";
+
+  std::vector<types::StringValue> batch_out(docs.size());
+  ASSERT_OK(udf.ExecBatch(&ctx, docs.size(), batch_out.data(), docs.data()));
+
+  for (const auto& [i, doc] : Enumerate(docs)) {
+    SCOPED_TRACE(i);
+    types::StringValue expected = udf.Exec(&ctx, doc);
+    if (expected.empty()) {
+      EXPECT_THAT(batch_out[i], ::testing::IsEmpty());
+      continue;
+    }
+    rapidjson::Document expected_doc;
+    rapidjson::Document actual_doc;
+    ASSERT_NE(expected_doc.Parse(expected.data()), nullptr);
+    ASSERT_NE(actual_doc.Parse(batch_out[i].data()), nullptr);
+    ASSERT_EQ(expected_doc.Size(), actual_doc.Size());
+    for (rapidjson::SizeType j = 0; j < expected_doc.Size(); ++j) {
+      EXPECT_NEAR(expected_doc[j].GetFloat(), actual_doc[j].GetFloat(), 0.0001);
+    }
+  }
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
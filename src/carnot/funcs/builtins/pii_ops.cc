@@ -17,6 +17,7 @@
  */
 #include <algorithm>
 #include <map>
+#include <numeric>
 #include <vector>
 
 #include <absl/strings/numbers.h>
@@ -167,11 +168,24 @@ struct TagTypeTraits<Tag::Type::MAC_ADDR> {
   static bool Filter(std::string_view) { return true; }
 };
 
-static inline bool CheckLuhn(std::string digits) {
+static inline bool IsDelim(char c) { return c == '-' || c == ' '; }
+
+// Checks the Luhn check digit of a number, ignoring any delimiters in it.
+static inline bool CheckLuhn(std::string_view number) {
   int sum = 0;
-  int ndigits = digits.length();
-  for (int idx = 0; idx < ndigits - 1; ++idx) {
-    int val = digits[(ndigits - 2) - idx] - '0';
+  int check_digit = -1;
+  // Walk the digits from the right. Every second digit, starting with the one left of the check
+  // digit, is doubled.
+  int idx = 0;
+  for (auto it = number.rbegin(); it != number.rend(); ++it) {
+    if (IsDelim(*it)) {
+      continue;
+    }
+    int val = *it - '0';
+    if (check_digit == -1) {
+      check_digit = val;
+      continue;
+    }
     if (idx % 2 == 0) {
       val *= 2;
     }
@@ -181,9 +195,10 @@ static inline bool CheckLuhn(std::string digits) {
       val -= 9;
     }
     sum += val;
+    ++idx;
   }
   auto checksum = (10 - (sum % 10)) % 10;
-  return (digits[ndigits - 1] - '0') == checksum;
+  return check_digit == checksum;
 }
 
 template <>
@@ -194,13 +209,7 @@ struct TagTypeTraits<Tag::Type::CC_NUMBER> {
     return "((?:[0-9][ -]*){12,18}[0-9])";
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_CC_NUMBER>"; }
-  static bool Filter(std::string_view match) {
-    std::string match_no_delims(match);
-    match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(),
-                                         [](char c) { return c == '-' || c == ' '; }),
-                          match_no_delims.end());
-    return CheckLuhn(match_no_delims);
-  }
+  static bool Filter(std::string_view match) { return CheckLuhn(match); }
 };
 
 template <>
@@ -209,13 +218,7 @@ struct TagTypeTraits<Tag::Type::IMEI> {
     return "([0-9]{2}-[0-9]{6}-[0-9]{6}-[0-9])";
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_IMEI>"; }
-  static bool Filter(std::string_view match) {
-    std::string match_no_delims(match);
-    match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(),
-                                         [](char c) { return c == '-' || c == ' '; }),
-                          match_no_delims.end());
-    return CheckLuhn(match_no_delims);
-  }
+  static bool Filter(std::string_view match) { return CheckLuhn(match); }
 };
 
 template <>
@@ -241,15 +244,14 @@ struct TagTypeTraits<Tag::Type::IBAN> {
   static bool Filter(std::string_view match) {
     // A International Bank Account Number (IBAN) begins with a two char country code and a two
     // digit checksum
-    std::string m(match);
-    std::string country_code = m.substr(0, 2);
-    std::transform(country_code.begin(), country_code.end(), country_code.begin(), ::toupper);
+    std::string country_code{static_cast<char>(::toupper(match[0])),
+                             static_cast<char>(::toupper(match[1]))};
     // are the first two letters a valid country code?
-    if (country_codes.find(country_code) == country_codes.end()) return false;
-    m.erase(std::remove_if(m.begin(), m.end(), [](char c) { return c == '-' || c == ' '; }),
-            m.end());
+    auto country_it = country_codes.find(country_code);
+    if (country_it == country_codes.end()) return false;
     // is the string long enough to be an IBAN for the specified country code?
-    if (m.length() < country_codes.at(country_code)) return false;
+    auto length = std::count_if(match.begin(), match.end(), [](char c) { return !IsDelim(c); });
+    if (static_cast<uint32_t>(length) < country_it->second) return false;
     // validate IBAN by converting to an int and performing mod-97
     // 1. move country code and checksum to end of string (first four characters)
     // 2. replace each letter with two digits (interpreting char as int)
@@ -258,24 +260,20 @@ struct TagTypeTraits<Tag::Type::IBAN> {
     // Rearrange: WEST 1234 5698 7654 32GB 82
     // Convert to integer: 3214282912345698765432161182
     // Compute remainder: 3214282912345698765432161182 mod 97 == 1
-    std::rotate(m.begin(), m.begin() + 4, m.end());
-    std::string nums;
-    for (const auto& c : m) {
-      if (std::isdigit(c)) nums += c;
-      if (std::isupper(c)) nums += std::to_string(static_cast<int>(c) - 55);
-    }
-    uint64_t start = 0, step = 9, number = 0;
-    std::string prepended;
-    while (start < nums.length() - step) {
-      number = std::stol(prepended + nums.substr(start, step));
-      int remainder = number % 97;
-      prepended = std::to_string(remainder);
-      if (remainder < 10) prepended = "0" + prepended;
-      start += step;
-      step = 7;
+    // The remainder is computed one digit at a time, so the number is never materialized.
+    int remainder = 0;
+    auto add_char = [&remainder](char c) {
+      if (std::isdigit(c)) remainder = (remainder * 10 + (c - '0')) % 97;
+      if (std::isupper(c)) remainder = (remainder * 100 + (c - 55)) % 97;
+    };
+    // The first four characters, skipping any delimiters between them.
+    size_t rest_idx = 0;
+    for (int n = 0; n < 4; ++rest_idx) {
+      if (!IsDelim(match[rest_idx])) ++n;
     }
-    number = std::stol(prepended + nums.substr(start));
-    return (number % 97 == 1);
+    std::for_each(match.begin() + rest_idx, match.end(), add_char);
+    std::for_each(match.begin(), match.begin() + rest_idx, add_char);
+    return remainder == 1;
   }
 };
 
@@ -292,8 +290,7 @@ struct TagTypeTraits<Tag::Type::SSN> {
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_SSN>"; }
   static bool Filter(std::string_view match) {
     std::string match_no_delims(match);
-    match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(),
-                                         [](char c) { return c == '-' || c == ' '; }),
+    match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(), IsDelim),
                           match_no_delims.end());
     std::string_view area = std::string_view(match_no_delims).substr(0, 3);
     std::string_view group = std::string_view(match_no_delims).substr(3, 2);
@@ -334,46 +331,52 @@ Status RedactPIIUDF::Init(FunctionContext*) {
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::IMEISV>>());
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::CC_NUMBER>>());
   taggers_.push_back(std::make_unique<RegexTagger<Tag::Type::SSN>>());
+
+  prefilter_ = std::make_unique<re2::RE2::Set>(RE2::DefaultOptions, RE2::UNANCHORED);
+  for (const auto& tagger : taggers_) {
+    std::string error;
+    if (prefilter_->Add(tagger->pattern(), &error) == -1) {
+      return error::Internal("Failed to add PII pattern to the prefilter: $0", error);
+    }
+  }
+  if (!prefilter_->Compile()) {
+    return error::Internal("Failed to compile the PII prefilter.");
+  }
   return Status::OK();
 }
 
 // Replace all tagged sequences in the string with the corresponding substitution string. For
 // overlapping tags, we take the longest tag.
-static inline std::string ReplaceTagsWithSubs(std::string input, std::vector<Tag>* tags) {
-  // Sort the tags chronologically.
-  std::sort(tags->begin(), tags->end(), [](Tag a, Tag b) { return a.start_idx < b.start_idx; });
+static inline std::string ReplaceTagsWithSubs(const std::string& input, std::vector<Tag>* tags) {
+  // Sort the tags chronologically. Tags that start at the same index stay in the order of the
+  // taggers that found them.
+  std::stable_sort(tags->begin(), tags->end(),
+                   [](const Tag& a, const Tag& b) { return a.start_idx < b.start_idx; });
 
   // Remove overlapping tags by only keeping the biggest tag for each group of overlapping tags.
   std::vector<Tag> non_overlapping_tags;
-  for (auto it = tags->begin(); it < tags->end();) {
-    if (it->size == 0) {
-      it++;
+  size_t new_string_size = input.size();
+  int prev_end_idx = 0;
+  for (size_t i = 0; i < tags->size();) {
+    const Tag& first_tag = (*tags)[i];
+    // Skip empty tags, and tags that overlap the tag kept for the previous group.
+    if (first_tag.size == 0 || first_tag.start_idx < prev_end_idx) {
+      ++i;
       continue;
     }
-    std::vector<Tag> overlapping_tags;
-    auto sub_it = it;
-    while (sub_it != tags->end() &&
-           sub_it->start_idx < (it->start_idx + static_cast<int>(it->size))) {
-      overlapping_tags.push_back(*sub_it);
-      sub_it++;
-    }
-    Tag max_size_tag;
-    size_t max_size = 0;
-    for (const auto& tag : overlapping_tags) {
-      if (tag.size > max_size) {
-        max_size_tag = tag;
-        max_size = tag.size;
+    const Tag* max_size_tag = &first_tag;
+    auto end_idx = first_tag.start_idx + static_cast<int>(first_tag.size);
+    for (++i; i < tags->size() && (*tags)[i].start_idx < end_idx; ++i) {
+      if ((*tags)[i].size > max_size_tag->size) {
+        max_size_tag = &(*tags)[i];
       }
     }
-    non_overlapping_tags.push_back(max_size_tag);
-    it = tags->erase(it, it + overlapping_tags.size());
+    non_overlapping_tags.push_back(*max_size_tag);
+    prev_end_idx = max_size_tag->start_idx + static_cast<int>(max_size_tag->size);
+    new_string_size =
+        new_string_size + type_to_sub_str_[max_size_tag->tag_type].size() - max_size_tag->size;
   }
 
-  // Calculate new string size.
-  size_t new_string_size = input.size();
-  for (auto tag : non_overlapping_tags) {
-    new_string_size = new_string_size + type_to_sub_str_[tag.tag_type].size() - tag.size;
-  }
   // Build new string from old string and non overlapping tags.
   std::string output(new_string_size, 0);
   int input_idx = 0;
@@ -393,13 +396,30 @@ static inline std::string ReplaceTagsWithSubs(std::string input, std::vector<Tag
 }
 
 StringValue RedactPIIUDF::Exec(FunctionContext*, StringValue input) {
+  matched_taggers_.clear();
+  re2::RE2::Set::ErrorInfo error_info;
+  if (!prefilter_->Match(input, &matched_taggers_, &error_info)) {
+    if (error_info.kind == re2::RE2::Set::kNoError) {
+      // No tagger's pattern occurs in the input.
+      return input;
+    }
+    // The DFA can run out of memory on large inputs, in which case every tagger has to run.
+    matched_taggers_.resize(taggers_.size());
+    std::iota(matched_taggers_.begin(), matched_taggers_.end(), 0);
+  }
+  // Run the matching taggers in their original order.
+  std::sort(matched_taggers_.begin(), matched_taggers_.end());
+
   std::vector<Tag> tags;
-  for (const auto& tagger : taggers_) {
-    auto s = tagger->AddTags(&input, &tags);
+  for (auto tagger_idx : matched_taggers_) {
+    auto s = taggers_[tagger_idx]->AddTags(&input, &tags);
     if (!s.ok()) {
       return "Invalid regex: " + s.msg();
     }
   }
+  if (tags.empty()) {
+    return input;
+  }
   return ReplaceTagsWithSubs(input, &tags);
 }
 
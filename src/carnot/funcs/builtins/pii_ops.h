@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "re2/re2.h"
+#include "re2/set.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -70,6 +71,8 @@ class Tagger {
  public:
   virtual ~Tagger() = default;
   virtual Status AddTags(std::string* input, std::vector<Tag>* tags) = 0;
+  // The pattern matching the candidates for this tagger's tags.
+  virtual const std::string& pattern() const = 0;
 };
 
 class RedactPIIUDF : public udf::ScalarUDF {
@@ -94,6 +97,11 @@ class RedactPIIUDF : public udf::ScalarUDF {
 
  private:
   std::vector<std::unique_ptr<Tagger>> taggers_;
+  // Matches the patterns of all the taggers in a single pass over the input, so that only the
+  // taggers whose pattern occurs in the input have to search it for their tags. The index of each
+  // pattern in the set is the index of its tagger in taggers_.
+  std::unique_ptr<re2::RE2::Set> prefilter_;
+  std::vector<int> matched_taggers_;
 };
 
 void RegisterPIIOpsOrDie(udf::Registry* registry);
@@ -132,6 +140,8 @@ class RegexTagger : public Tagger {
     return Status::OK();
   }
 
+  const std::string& pattern() const override { return regex_.pattern(); }
+
  private:
   re2::RE2 regex_;
 };
@@ -267,6 +267,23 @@ INSTANTIATE_TEST_SUITE_P(TemplatedRedactionTest, RedactionTest,
                                                           EmailGen(), CCGen(), IMEIGen(), SSNGen(),
                                                           NegativeExampleGen()})));
 
+TEST(RedactPII, overlapping_tags) {
+  udf::UDFTester<RedactPIIUDF> udf_tester;
+  udf_tester.Init();
+  // The email "x@0" overlaps the IPv6 address, which contains the IPv4 address 10.1.2.3.
+  udf_tester.ForInput("x@0:1:2:3::10.1.2.3:").Expect("x@<REDACTED_IPV6>:");
+}
+
+TEST(RedactPII, no_pii) {
+  udf::UDFTester<RedactPIIUDF> udf_tester;
+  udf_tester.Init();
+  udf_tester.ForInput("").Expect("");
+  udf_tester.ForInput(R"({"name": "value", "count": 3})")
+      .Expect(R"({"name": "value", "count": 3})");
+  // Looks like the start of an IBAN with a lowercase country code, but is too short.
+  udf_tester.ForInput("name 42 value user items").Expect("name 42 value user items");
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
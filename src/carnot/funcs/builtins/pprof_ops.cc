@@ -29,6 +29,7 @@ void RegisterPProfOpsOrDie(udf::Registry* registry) {
   CHECK(registry != nullptr);
 
   registry->RegisterOrDie<CreatePProfRowAggregate>("pprof");
+  registry->RegisterOrDie<CreatePProfFromIDsRowAggregate>("pprof");
 }
 
 }  // namespace builtins
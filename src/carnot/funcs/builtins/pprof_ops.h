@@ -21,6 +21,7 @@
 #include <absl/container/flat_hash_map.h>
 
 #include <string>
+#include <utility>
 
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf.h"
@@ -32,7 +33,60 @@ namespace builtins {
 
 using px::shared::PProfProfile;
 
-class CreatePProfRowAggregate : public udf::UDA {
+// Shared state of the pprof UDAs: the histogram of stack trace strings and the sampling period.
+class PProfRowAggregateBase : public udf::UDA {
+ protected:
+  void UpdateOrCheckSamplingPeriod(const int32_t profiler_period_ms) {
+    // Initialize profiler_period_ms_ if needed.
+    if (profiler_period_ms_ == -1) {
+      profiler_period_ms_ = profiler_period_ms;
+    }
+
+    // If any inconsistent profiler period is observed, set the error flag.
+    if (profiler_period_ms_ != profiler_period_ms) {
+      multiple_profiler_periods_found_ = true;
+    }
+  }
+
+  StringValue SerializePProf() const {
+    if (multiple_profiler_periods_found_) {
+      return "Protobuf `SerializeToString` failed, multiple profiling periods found.";
+    }
+
+    const auto pprof = px::shared::CreatePProfProfile(profiler_period_ms_, histo_);
+    std::string output;
+    const bool ok = pprof.SerializeToString(&output);
+    if (!ok) {
+      return "Protobuf `SerializeToString` failed.";
+    }
+    return output;
+  }
+
+  Status DeserializePProf(const StringValue& pprof_str) {
+    // Parse serialized input a pprof proto object.
+    PProfProfile pprof;
+    if (!pprof.ParseFromString(pprof_str)) {
+      return error::Internal("Could not parse input string into a pprof proto.");
+    }
+
+    UpdateOrCheckSamplingPeriod(pprof.period() / 1000 / 1000);
+
+    // Deserialize into a map from stack_trace string to count.
+    const auto merge_histo = ::px::shared::DeserializePProfProfile(pprof);
+
+    // Incorporate the deserialized result into our histo_.
+    for (const auto& [stack_trace, count] : merge_histo) {
+      histo_[stack_trace] += count;
+    }
+    return Status::OK();
+  }
+
+  absl::flat_hash_map<std::string, uint64_t> histo_;
+  int32_t profiler_period_ms_ = -1;
+  bool multiple_profiler_periods_found_ = false;
+};
+
+class CreatePProfRowAggregate : public PProfRowAggregateBase {
  public:
   static udf::UDADocBuilder Doc() {
     return udf::UDADocBuilder("Convert perf profiling data to pprof format.")
@@ -41,8 +95,14 @@ class CreatePProfRowAggregate : public udf::UDA {
             R"doc(
         | # Get the stack traces, the underlying data we want; populate an ASID column
         | # to join with profiler sampling period (see next).
+        | # The stack trace strings are looked up by ID in the stack trace dictionary.
         | stack_traces = px.DataFrame(table='stack_traces.beta', start_time='-1m')
-        | stack_traces.asid = px.asid()
+        | stack_traces = stack_traces.drop('stack_trace')
+        | strs = px.DataFrame(table='stack_trace_dict.beta')
+        | strs = strs.groupby(['upid', 'stack_trace_id']).agg(stack_trace=('stack_trace', px.any))
+        | stack_traces = stack_traces.merge(strs, how='inner', left_on=['upid', 'stack_trace_id'],
+        |                                   right_on=['upid', 'stack_trace_id'], suffixes=['', '_x'])
+        | stack_traces.asid = px.upid_to_asid(stack_traces.upid)
         |
         | # Get the profiler sampling period for all deployed PEMs, then merge to stack traces on ASID.
         | sample_period = px.GetProfilerSamplingPeriodMS()
@@ -73,57 +133,104 @@ class CreatePProfRowAggregate : public udf::UDA {
     }
   }
 
-  StringValue Serialize(FunctionContext*) {
-    if (multiple_profiler_periods_found_) {
-      return "Protobuf `SerializeToString` failed, multiple profiling periods found.";
-    }
+  StringValue Serialize(FunctionContext*) { return SerializePProf(); }
 
-    const auto pprof = px::shared::CreatePProfProfile(profiler_period_ms_, histo_);
-    std::string output;
-    const bool ok = pprof.SerializeToString(&output);
-    if (!ok) {
-      return "Protobuf `SerializeToString` failed.";
-    }
-    return output;
+  Status Deserialize(FunctionContext*, const StringValue& pprof_str) {
+    return DeserializePProf(pprof_str);
   }
 
-  Status Deserialize(FunctionContext*, const StringValue& pprof_str) {
-    // Parse serialized input a pprof proto object.
-    PProfProfile pprof;
-    if (!pprof.ParseFromString(pprof_str)) {
-      return error::Internal("Could not parse input string into a pprof proto.");
-    }
+  StringValue Finalize(FunctionContext* ctx) { return Serialize(ctx); }
+};
 
-    UpdateOrCheckSamplingPeriod(pprof.period() / 1000 / 1000);
+/**
+ * CreatePProfFromIDsRowAggregate builds pprof from stack trace IDs, rather than stack trace
+ * strings. The samples are aggregated by (upid, stack_trace_id), so each row hashes two integers
+ * instead of a multi-KB stack trace string, and each string is stored once per ID. Identical
+ * strings from different processes are only combined when the pprof is built.
+ */
+class CreatePProfFromIDsRowAggregate : public PProfRowAggregateBase {
+ public:
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Convert perf profiling data to pprof format, by stack trace ID.")
+        .Details(
+            "Converts perf profiling stack traces into pprof format. The samples are aggregated "
+            "by stack trace ID, which is cheaper than aggregating by stack trace string.")
+        .Example(
+            R"doc(
+        | stack_traces = px.DataFrame(table='stack_traces.beta', start_time='-1m')
+        | stack_traces = stack_traces.drop('stack_trace')
+        | strs = px.DataFrame(table='stack_trace_dict.beta')
+        | strs = strs.groupby(['upid', 'stack_trace_id']).agg(stack_trace=('stack_trace', px.any))
+        | stack_traces = stack_traces.merge(strs, how='inner', left_on=['upid', 'stack_trace_id'],
+        |                                   right_on=['upid', 'stack_trace_id'], suffixes=['', '_x'])
+        | stack_traces.asid = px.upid_to_asid(stack_traces.upid)
+        | sample_period = px.GetProfilerSamplingPeriodMS()
+        | df = stack_traces.merge(sample_period, how='inner', left_on=['asid'], right_on=['asid'])
+        | df = df.groupby(['profiler_sampling_period_ms']).agg(
+        |     pprof=('upid', 'stack_trace_id', 'stack_trace', 'count', 'profiler_sampling_period_ms', px.pprof))
+        )doc")
+        .Arg("upid", "The UPID of the sampled process.")
+        .Arg("stack_trace_id", "The ID of the stack trace within the process.")
+        .Arg("stack_trace", "Stack trace string.")
+        .Arg("count", "Count of the stack trace.")
+        .Arg("profiler_period_ms", "Profiler stack trace sampling period in ms.")
+        .Returns("A single row that aggregates all the stack traces and counts into pprof format.");
+  }
 
-    // Deserialize into a map from stack_trace string to count.
-    const auto merge_histo = ::px::shared::DeserializePProfProfile(pprof);
+  void Update(FunctionContext*, const UInt128Value upid, const Int64Value stack_trace_id,
+              const StringValue stack_trace, const Int64Value count,
+              const Int64Value profiler_period_ms) {
+    UpdateOrCheckSamplingPeriod(profiler_period_ms.val);
 
-    // Incorporate the deserialized result into our histo_.
-    for (const auto& [stack_trace, count] : merge_histo) {
-      histo_[stack_trace] += count;
+    auto [it, inserted] = id_histo_.try_emplace(IDKey{upid.val, stack_trace_id.val});
+    if (inserted) {
+      it->second.stack_trace = stack_trace;
     }
-    return Status::OK();
+    it->second.count += count.val;
   }
 
-  StringValue Finalize(FunctionContext* ctx) { return Serialize(ctx); }
+  void Merge(FunctionContext*, const CreatePProfFromIDsRowAggregate& other) {
+    UpdateOrCheckSamplingPeriod(other.profiler_period_ms_);
 
- protected:
-  void UpdateOrCheckSamplingPeriod(const int32_t profiler_period_ms) {
-    // Initialize profiler_period_ms_ if needed.
-    if (profiler_period_ms_ == -1) {
-      profiler_period_ms_ = profiler_period_ms;
+    for (const auto& [key, entry] : other.id_histo_) {
+      auto [it, inserted] = id_histo_.try_emplace(key);
+      if (inserted) {
+        it->second.stack_trace = entry.stack_trace;
+      }
+      it->second.count += entry.count;
     }
+    for (const auto& [stack_trace, count] : other.histo_) {
+      histo_[stack_trace] += count;
+    }
+  }
 
-    // If any inconsistent profiler period is observed, set the error flag.
-    if (profiler_period_ms_ != profiler_period_ms) {
-      multiple_profiler_periods_found_ = true;
+  StringValue Serialize(FunctionContext*) {
+    FoldIDsIntoHisto();
+    return SerializePProf();
+  }
+
+  Status Deserialize(FunctionContext*, const StringValue& pprof_str) {
+    return DeserializePProf(pprof_str);
+  }
+
+  StringValue Finalize(FunctionContext* ctx) { return Serialize(ctx); }
+
+ private:
+  using IDKey = std::pair<absl::uint128, int64_t>;
+  struct IDEntry {
+    std::string stack_trace;
+    uint64_t count = 0;
+  };
+
+  // Moves the per-ID counts into the histogram of stack trace strings.
+  void FoldIDsIntoHisto() {
+    for (auto& [key, entry] : id_histo_) {
+      histo_[std::move(entry.stack_trace)] += entry.count;
     }
+    id_histo_.clear();
   }
 
-  absl::flat_hash_map<std::string, uint64_t> histo_;
-  int32_t profiler_period_ms_ = -1;
-  bool multiple_profiler_periods_found_ = false;
+  absl::flat_hash_map<IDKey, IDEntry> id_histo_;
 };
 
 void RegisterPProfOpsOrDie(udf::Registry* registry);
@@ -137,6 +137,31 @@ TEST(PProf, pprof_merge_test) {
   EXPECT_EQ(actual, expected);
 }
 
+TEST(PProf, pprof_from_ids_test) {
+  const types::UInt128Value upid_a(1, 100);
+  const types::UInt128Value upid_b(2, 100);
+
+  auto pprof_uda_tester = udf::UDATester<CreatePProfFromIDsRowAggregate>();
+
+  // The same stack trace ID in different processes refers to different stack traces,
+  // and the same stack trace in different processes is combined in the pprof.
+  pprof_uda_tester.ForInput(upid_a, 1, "foo;bar;baz", 1, profiler_period_ms);
+  pprof_uda_tester.ForInput(upid_a, 1, "foo;bar;baz", 2, profiler_period_ms);
+  pprof_uda_tester.ForInput(upid_a, 2, "main;compute", 3, profiler_period_ms);
+  pprof_uda_tester.ForInput(upid_b, 1, "main;compute", 4, profiler_period_ms);
+  pprof_uda_tester.ForInput(upid_b, 2, "foo;bar;qux", 5, profiler_period_ms);
+
+  const absl::flat_hash_map<std::string, uint64_t> expected = {
+      {"foo;bar;baz", 1 + 2},
+      {"main;compute", 3 + 4},
+      {"foo;bar;qux", 5},
+  };
+
+  PProfProfile pprof;
+  EXPECT_TRUE(pprof.ParseFromString(pprof_uda_tester.Result()));
+  EXPECT_EQ(DeserializePProfProfile(pprof), expected);
+}
+
 TEST(PProf, uda_fails_with_multiple_sample_periods) {
   // Create our UDA tester.
   auto pprof_uda_tester = udf::UDATester<CreatePProfRowAggregate>();
@@ -17,7 +17,10 @@
  */
 
 #include "src/carnot/funcs/builtins/request_path_ops.h"
+#include <algorithm>
+#include <cstring>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
@@ -26,6 +29,83 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+namespace {
+
+class Encoder {
+ public:
+  template <typename T>
+  void Write(T val) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    buf_.append(reinterpret_cast<const char*>(&val), sizeof(T));
+  }
+
+  void WriteString(std::string_view s) {
+    Write<uint32_t>(s.size());
+    buf_.append(s);
+  }
+
+  void WritePath(const RequestPath& path) {
+    Write<uint32_t>(path.depth());
+    for (const auto& component : path.path_components()) {
+      WriteString(component);
+    }
+  }
+
+  std::string Consume() { return std::move(buf_); }
+
+ private:
+  std::string buf_;
+};
+
+class Decoder {
+ public:
+  explicit Decoder(std::string_view buf) : buf_(buf) {}
+
+  template <typename T>
+  StatusOr<T> Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (buf_.size() < sizeof(T)) {
+      return error::InvalidArgument("RequestPathClustering::FromBinary: truncated data");
+    }
+    T val;
+    std::memcpy(&val, buf_.data(), sizeof(T));
+    buf_.remove_prefix(sizeof(T));
+    return val;
+  }
+
+  StatusOr<std::string> ReadString() {
+    PX_ASSIGN_OR_RETURN(uint32_t size, Read<uint32_t>());
+    if (buf_.size() < size) {
+      return error::InvalidArgument("RequestPathClustering::FromBinary: truncated data");
+    }
+    std::string s(buf_.substr(0, size));
+    buf_.remove_prefix(size);
+    return s;
+  }
+
+  StatusOr<RequestPath> ReadPath() {
+    PX_ASSIGN_OR_RETURN(uint32_t depth, Read<uint32_t>());
+    // Each path component takes at least the 4 bytes of its size.
+    if (buf_.size() / sizeof(uint32_t) < depth) {
+      return error::InvalidArgument("RequestPathClustering::FromBinary: truncated data");
+    }
+    std::vector<std::string> components;
+    components.reserve(depth);
+    for (uint32_t i = 0; i < depth; ++i) {
+      PX_ASSIGN_OR_RETURN(std::string component, ReadString());
+      components.push_back(std::move(component));
+    }
+    return RequestPath(std::move(components));
+  }
+
+  bool eof() const { return buf_.empty(); }
+
+ private:
+  std::string_view buf_;
+};
+
+}  // namespace
+
 void RegisterRequestPathOpsOrDie(udf::Registry* registry) {
   CHECK(registry != nullptr);
   /*****************************************
@@ -211,34 +291,98 @@ void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writ
 
 double RequestPathClustering::MaxSimilarity(const RequestPath& request_path,
                                             int64_t* max_index) const {
-  auto it = depth_to_centroid_indices_.find(request_path.depth());
+  auto it = depth_to_position_indices_.find(request_path.depth());
   *max_index = -1;
-  if (it == depth_to_centroid_indices_.end()) {
+  if (it == depth_to_position_indices_.end()) {
     return 0.0;
   }
+
+  // Only the clusters that share a path component with the request path can be similar to it, so
+  // the candidates are the clusters in the index entries of its path components.
+  const auto& position_indices = it->second;
+  candidate_lists_.clear();
+  for (const auto& [i, path_component] : Enumerate(request_path.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto cluster_indices_it = position_indices[i].find(path_component);
+    if (cluster_indices_it != position_indices[i].end()) {
+      candidate_lists_.push_back(&cluster_indices_it->second);
+    }
+  }
+  // Visit the rarest path components first. Path components shared by many clusters (eg. "api")
+  // are usually never visited, because the clusters that haven't been seen by then can only share
+  // the remaining path components, which isn't enough to beat the best cluster found so far.
+  std::sort(candidate_lists_.begin(), candidate_lists_.end(),
+            [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+  seen_.resize(clusters_.size());
+  seen_clusters_.clear();
   auto max_similarity = 0.0;
-  for (auto index : it->second) {
-    auto similarity = clusters_[index].Similarity(request_path);
-    if (similarity > max_similarity) {
-      *max_index = index;
-      max_similarity = similarity;
+  auto num_lists = static_cast<int64_t>(candidate_lists_.size());
+  for (int64_t k = 0; k < num_lists; ++k) {
+    if (max_similarity > static_cast<double>(num_lists - k) / request_path.depth()) {
+      break;
     }
+    for (auto index : *candidate_lists_[k]) {
+      if (seen_[index]) {
+        continue;
+      }
+      seen_[index] = true;
+      seen_clusters_.push_back(index);
+      // Ties go to the first cluster, as in a linear scan of the clusters.
+      auto similarity = clusters_[index].Similarity(request_path);
+      if (similarity > max_similarity || (similarity == max_similarity && index < *max_index)) {
+        *max_index = index;
+        max_similarity = similarity;
+      }
+    }
+  }
+  for (auto index : seen_clusters_) {
+    seen_[index] = false;
   }
   return max_similarity;
 }
 
 void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
-  auto centroid = cluster.centroid();
-  if (depth_to_centroid_indices_.find(centroid.depth()) == depth_to_centroid_indices_.end()) {
-    depth_to_centroid_indices_.emplace(centroid.depth(), std::vector<int64_t>());
-  }
-  depth_to_centroid_indices_[centroid.depth()].push_back(clusters_.size());
   clusters_.push_back(cluster);
+  IndexCluster(clusters_.size() - 1);
+}
+
+void RequestPathClustering::IndexCluster(int64_t cluster_index) {
+  const auto& centroid = clusters_[cluster_index].centroid();
+  auto& position_indices = depth_to_position_indices_[centroid.depth()];
+  position_indices.resize(centroid.depth());
+  for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    position_indices[i][path_component].push_back(cluster_index);
+  }
 }
 
 void RequestPathClustering::MergeCluster(int64_t cluster_index,
                                          const RequestPathCluster& other_cluster) {
+  RequestPath old_centroid = clusters_[cluster_index].centroid();
   clusters_[cluster_index].Merge(other_cluster);
+
+  // Merging can only replace path components of the centroid with kAnyToken, which are not
+  // indexed.
+  const auto& centroid = clusters_[cluster_index].centroid();
+  auto& position_indices = depth_to_position_indices_[centroid.depth()];
+  for (const auto& [i, path_component] : Enumerate(old_centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken ||
+        path_component == centroid.path_components()[i]) {
+      continue;
+    }
+    auto it = position_indices[i].find(path_component);
+    DCHECK(it != position_indices[i].end());
+    auto& cluster_indices = it->second;
+    cluster_indices.erase(std::find(cluster_indices.begin(), cluster_indices.end(), cluster_index));
+    if (cluster_indices.empty()) {
+      position_indices[i].erase(it);
+    }
+  }
 }
 
 StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::string& json) {
@@ -264,13 +408,62 @@ std::string RequestPathClustering::ToJSON() const {
   rapidjson::StringBuffer sb;
   rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
   writer.StartArray();
-  for (auto cluster : clusters_) {
+  for (const auto& cluster : clusters_) {
     cluster.ToJSON(&writer);
   }
   writer.EndArray();
   return sb.GetString();
 }
 
+StatusOr<RequestPathClustering> RequestPathClustering::FromBinary(std::string_view data) {
+  Decoder dec(data);
+  PX_ASSIGN_OR_RETURN(std::string header, dec.ReadString());
+  if (header != kBinaryHeader) {
+    return error::InvalidArgument("RequestPathClustering::FromBinary: unexpected header");
+  }
+
+  RequestPathClustering clustering;
+  PX_ASSIGN_OR_RETURN(uint32_t num_clusters, dec.Read<uint32_t>());
+  for (uint32_t i = 0; i < num_clusters; ++i) {
+    RequestPathCluster cluster;
+    PX_ASSIGN_OR_RETURN(cluster.centroid_, dec.ReadPath());
+    PX_ASSIGN_OR_RETURN(uint32_t num_members, dec.Read<uint32_t>());
+    for (uint32_t j = 0; j < num_members; ++j) {
+      PX_ASSIGN_OR_RETURN(auto member, dec.ReadPath());
+      cluster.members_.insert(std::move(member));
+    }
+    clustering.AddNewCluster(cluster);
+  }
+
+  if (!dec.eof()) {
+    return error::InvalidArgument("RequestPathClustering::FromBinary: unexpected trailing bytes");
+  }
+  return clustering;
+}
+
+std::string RequestPathClustering::ToBinary() const {
+  Encoder enc;
+  enc.WriteString(kBinaryHeader);
+  enc.Write<uint32_t>(clusters_.size());
+  for (const auto& cluster : clusters_) {
+    enc.WritePath(cluster.centroid());
+    enc.Write<uint32_t>(cluster.members().size());
+    for (const auto& member : cluster.members()) {
+      enc.WritePath(member);
+    }
+  }
+  return enc.Consume();
+}
+
+StatusOr<RequestPathClustering> RequestPathClustering::Deserialize(std::string_view data) {
+  // The binary encoding starts with the size of its header, which can't start a JSON document.
+  if (data.size() >= sizeof(uint32_t) + sizeof(kBinaryHeader) - 1 &&
+      data.substr(sizeof(uint32_t), sizeof(kBinaryHeader) - 1) == kBinaryHeader) {
+    return FromBinary(data);
+  }
+  return FromJSON(std::string(data));
+}
+
 const RequestPath& RequestPathClustering::Predict(const RequestPath& request_path) {
   int64_t closest_cluster_index;
   MaxSimilarity(request_path, &closest_cluster_index);
@@ -295,33 +488,30 @@ void RequestPathClustering::Update(const RequestPathCluster& new_cluster) {
 void RequestPathClustering::Merge(const RequestPathClustering& other_clustering) {
   std::vector<RequestPathCluster> new_clusters;
   std::vector<RequestPathCluster> singleton_clusters;
-  for (const auto& cluster : clusters_) {
+  for (auto& cluster : clusters_) {
     if (cluster.members().size() == 0) {
-      new_clusters.push_back(cluster);
+      new_clusters.push_back(std::move(cluster));
     } else {
-      for (auto request_path : cluster.members()) {
-        singleton_clusters.push_back(RequestPathCluster(request_path));
+      for (const auto& request_path : cluster.members()) {
+        singleton_clusters.emplace_back(request_path);
       }
     }
   }
 
-  clusters_ = new_clusters;
-  // Rebuild depth_to_cluster_indices mapping.
-  depth_to_centroid_indices_.clear();
-  for (const auto& [cluster_idx, cluster] : Enumerate(clusters_)) {
-    auto depth = cluster.centroid().depth();
-    if (depth_to_centroid_indices_.find(depth) == depth_to_centroid_indices_.end()) {
-      depth_to_centroid_indices_.emplace(depth, std::vector<int64_t>());
-    }
-    depth_to_centroid_indices_[depth].push_back(cluster_idx);
+  clusters_ = std::move(new_clusters);
+  // Rebuild the index of the formed clusters.
+  depth_to_position_indices_.clear();
+  for (int64_t cluster_idx = 0; cluster_idx < static_cast<int64_t>(clusters_.size());
+       ++cluster_idx) {
+    IndexCluster(cluster_idx);
   }
 
   for (const auto& cluster : other_clustering.clusters_) {
     if (cluster.members().size() == 0) {
       Update(cluster);
     } else {
-      for (auto request_path : cluster.members()) {
-        singleton_clusters.push_back(RequestPathCluster(request_path));
+      for (const auto& request_path : cluster.members()) {
+        singleton_clusters.emplace_back(request_path);
       }
     }
   }
@@ -45,6 +45,8 @@ class RequestPath {
    */
  public:
   explicit RequestPath(std::string request_path);
+  explicit RequestPath(std::vector<std::string> path_components)
+      : path_components_(std::move(path_components)) {}
   RequestPath() = default;
   /**
    * Get the similarity of this request path to another one. The similarity metric used is the
@@ -164,6 +166,8 @@ class RequestPathCluster {
   const absl::flat_hash_set<RequestPath>& members() const { return members_; }
 
  private:
+  friend class RequestPathClustering;
+
   void MergeCentroids(const RequestPath& other_centroid);
   void MergeMembers(const absl::flat_hash_set<RequestPath>& other_members);
 
@@ -174,12 +178,36 @@ class RequestPathCluster {
   absl::flat_hash_set<RequestPath> members_;
 };
 
+/**
+ * A set of request path clusters.
+ *
+ * The clusters are indexed by depth, and within a depth by the (non kAnyToken) path component
+ * at each position of their centroid. Finding the closest cluster to a request path only visits
+ * clusters that share its rarest path components, instead of every cluster of the same depth. The
+ * closest cluster is the same as the one found by a linear scan: the one with the highest
+ * similarity, and the first one in clusters() on ties.
+ *
+ * The index keeps scratch state that is written by the const lookups, so a clustering can't be
+ * used from multiple threads at once, even for predictions.
+ */
 class RequestPathClustering {
  public:
   static StatusOr<RequestPathClustering> FromJSON(const std::string& json);
 
   std::string ToJSON() const;
 
+  /**
+   * Binary encoding of the clustering, which is more compact and much faster to decode than the
+   * JSON encoding. Used to pass partial aggregates between agents.
+   */
+  static StatusOr<RequestPathClustering> FromBinary(std::string_view data);
+  std::string ToBinary() const;
+
+  /**
+   * Decodes either encoding of the clustering, based on the header of the binary encoding.
+   */
+  static StatusOr<RequestPathClustering> Deserialize(std::string_view data);
+
   /**
    * @param request_path request path to get prediction for.
    * @return the centroid of the cluster closest to the given request path.
@@ -198,13 +226,26 @@ class RequestPathClustering {
   const std::vector<RequestPathCluster>& clusters() const { return clusters_; }
 
  private:
+  // For each position of a path of a given depth, maps the path components to the indices of the
+  // clusters whose centroid has that component at that position.
+  using PositionIndex = absl::flat_hash_map<std::string, std::vector<int64_t>>;
+
+  inline static constexpr char kBinaryHeader[] = "px_request_path_clustering_v1";
+
   double MaxSimilarity(const RequestPath& request_path, int64_t* max_index) const;
   void AddNewCluster(const RequestPathCluster& cluster);
+  void IndexCluster(int64_t cluster_index);
   void MergeCluster(int64_t cluster_index, const RequestPathCluster& other_cluster);
   // We currently only allow request path's with the same depth to be clustered together.
-  absl::flat_hash_map<int64_t, std::vector<int64_t>> depth_to_centroid_indices_;
+  absl::flat_hash_map<int64_t, std::vector<PositionIndex>> depth_to_position_indices_;
   std::vector<RequestPathCluster> clusters_;
   double thresh_ = 0.5;
+
+  // Scratch space for MaxSimilarity(). seen_ has an entry per cluster, and is all false between
+  // calls.
+  mutable std::vector<const std::vector<int64_t>*> candidate_lists_;
+  mutable std::vector<bool> seen_;
+  mutable std::vector<int64_t> seen_clusters_;
 };
 
 class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
@@ -212,7 +253,7 @@ class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
   StringValue Exec(FunctionContext*, StringValue request_path_str,
                    StringValue serialized_clustering) {
     if (!clustering_init_) {
-      auto clustering_or_s = RequestPathClustering::FromJSON(serialized_clustering);
+      auto clustering_or_s = RequestPathClustering::Deserialize(serialized_clustering);
       if (!clustering_or_s.ok()) {
         return clustering_or_s.msg();
       }
@@ -238,10 +279,10 @@ class RequestPathClusteringFitUDA : public udf::UDA {
   }
   StringValue Finalize(FunctionContext*) { return clustering_.ToJSON(); }
 
-  StringValue Serialize(FunctionContext*) { return clustering_.ToJSON(); }
+  StringValue Serialize(FunctionContext*) { return clustering_.ToBinary(); }
 
   Status Deserialize(FunctionContext*, const StringValue& data) {
-    PX_ASSIGN_OR_RETURN(clustering_, RequestPathClustering::FromJSON(data));
+    PX_ASSIGN_OR_RETURN(clustering_, RequestPathClustering::Deserialize(data));
     return Status::OK();
   }
 
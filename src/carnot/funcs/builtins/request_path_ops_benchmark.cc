@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/request_path_ops.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+// Generates request paths for the given number of services, each of which has a handful of
+// endpoints with an ID path component. All the paths share the "/api/v1" prefix, and each service
+// ends up in its own cluster.
+static std::vector<std::string> GenerateRequestPaths(int num_services) {
+  std::vector<std::string> paths;
+  for (int svc = 0; svc < num_services; ++svc) {
+    for (int endpoint = 0; endpoint < 4; ++endpoint) {
+      for (int id = 0; id < 8; ++id) {
+        paths.push_back(absl::Substitute("/api/v1/service$0/service$0_endpoint$1/$2", svc,
+                                         endpoint, id));
+      }
+    }
+  }
+  return paths;
+}
+
+static RequestPathClustering FitClustering(const std::vector<std::string>& paths) {
+  RequestPathClustering clustering;
+  for (const auto& path : paths) {
+    clustering.Update(RequestPathCluster(RequestPath(path)));
+  }
+  return clustering;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RequestPathClusteringPredict(benchmark::State& state) {
+  auto paths = GenerateRequestPaths(state.range(0));
+  auto serialized_clustering = FitClustering(paths).ToJSON();
+
+  RequestPathClusteringPredictUDF udf;
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(udf.Exec(nullptr, path, serialized_clustering));
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(paths.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RequestPathClusteringFit(benchmark::State& state) {
+  auto paths = GenerateRequestPaths(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FitClustering(paths));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(paths.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+// Fits two halves of the paths separately, and merges them after a round trip through the
+// partial aggregate encoding, like the fit UDA does across agents.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RequestPathClusteringPartialAggMerge(benchmark::State& state) {
+  auto paths = GenerateRequestPaths(state.range(0));
+  std::vector<std::string> half1(paths.begin(), paths.begin() + paths.size() / 2);
+  std::vector<std::string> half2(paths.begin() + paths.size() / 2, paths.end());
+  auto clustering1 = FitClustering(half1);
+  auto clustering2 = FitClustering(half2);
+
+  for (auto _ : state) {
+    auto merged = RequestPathClustering::Deserialize(clustering1.ToBinary()).ConsumeValueOrDie();
+    merged.Merge(RequestPathClustering::Deserialize(clustering2.ToBinary()).ConsumeValueOrDie());
+    benchmark::DoNotOptimize(merged);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RequestPathClusteringDeserialize(benchmark::State& state) {
+  auto clustering = FitClustering(GenerateRequestPaths(state.range(0)));
+  auto serialized_clustering = state.range(1) ? clustering.ToBinary() : clustering.ToJSON();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RequestPathClustering::Deserialize(serialized_clustering));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(serialized_clustering.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_RequestPathClusteringPredict)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK(BM_RequestPathClusteringFit)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK(BM_RequestPathClusteringPartialAggMerge)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK(BM_RequestPathClusteringDeserialize)
+    ->ArgNames({"services", "binary"})
+    ->ArgsProduct({{16, 1024}, {0, 1}});
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -57,6 +57,23 @@ TEST(RequestPathClusteringFit, basic) {
   EXPECT_EQ("/a/b/*", clustering.clusters()[0].Predict(RequestPath("/a/b/c")).ToString());
 }
 
+TEST(RequestPathClusteringFit, partial_agg) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+
+  auto serialized_clustering = uda_tester.ForInput("/a/b/c")
+                                   .ForInput("/a/b/d")
+                                   .ForInput("a/b/a")
+                                   .ForInput("/a/b/b")
+                                   .ForInput("/a/b/e")
+                                   .ForInput("a/b/f")
+                                   .PartialAggResult();
+  auto clustering_or_s = RequestPathClustering::FromJSON(serialized_clustering);
+  ASSERT_OK(clustering_or_s);
+  auto clustering = clustering_or_s.ConsumeValueOrDie();
+  ASSERT_EQ(1, clustering.clusters().size());
+  EXPECT_EQ("/a/b/*", clustering.clusters()[0].centroid().ToString());
+}
+
 TEST(RequestPathClusteringFit, basic_low_cardinality) {
   auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
 
@@ -192,6 +209,62 @@ TEST(RequestPathClusteringFit, merging_clusters_complicated) {
   } while (std::next_permutation(permutation_indices.begin(), permutation_indices.end()));
 }
 
+TEST(RequestPathClustering, binary_serialization) {
+  RequestPathClustering clustering;
+  for (const auto& path : {"/a/b/a", "/a/b/b", "/a/b/c", "/a/b/d", "/a/b/e", "/a/b/f", "/c/d",
+                           "/c/e", "/x"}) {
+    clustering.Update(RequestPathCluster(RequestPath(path)));
+  }
+  std::vector<std::string> centroids({"/a/b/*", "/c/d", "/c/e", "/x"});
+  ASSERT_THAT(clustering, HasCentroids(centroids));
+
+  auto binary = clustering.ToBinary();
+  ASSERT_OK_AND_ASSIGN(auto from_binary, RequestPathClustering::FromBinary(binary));
+  EXPECT_THAT(from_binary, HasCentroids(centroids));
+  EXPECT_EQ("/a/b/*", from_binary.Predict(RequestPath("/a/b/z")).ToString());
+  EXPECT_EQ("/c/e", from_binary.Predict(RequestPath("/c/e")).ToString());
+
+  // Deserialize accepts both encodings.
+  ASSERT_OK_AND_ASSIGN(auto deserialized_binary, RequestPathClustering::Deserialize(binary));
+  EXPECT_THAT(deserialized_binary, HasCentroids(centroids));
+  ASSERT_OK_AND_ASSIGN(auto deserialized_json,
+                       RequestPathClustering::Deserialize(clustering.ToJSON()));
+  EXPECT_THAT(deserialized_json, HasCentroids(centroids));
+
+  EXPECT_NOT_OK(RequestPathClustering::FromBinary(binary.substr(0, binary.size() - 1)));
+  EXPECT_NOT_OK(RequestPathClustering::FromBinary(binary + "a"));
+}
+
+// The index must pick the same cluster as a linear scan over all the clusters, including on ties.
+TEST(RequestPathClustering, predict_matches_linear_scan) {
+  RequestPathClustering clustering;
+  std::vector<RequestPath> paths;
+  for (int i = 0; i < 200; ++i) {
+    paths.emplace_back(absl::Substitute("/svc$0/v$1/item/$2", i % 7, i % 3, i));
+    paths.emplace_back(absl::Substitute("/svc$0/$1", i % 5, i % 11));
+  }
+  for (const auto& path : paths) {
+    clustering.Update(RequestPathCluster(path));
+  }
+
+  for (const auto& path : paths) {
+    const RequestPathCluster* expected = nullptr;
+    double max_similarity = 0.0;
+    for (const auto& cluster : clustering.clusters()) {
+      if (cluster.centroid().depth() != path.depth()) {
+        continue;
+      }
+      auto similarity = cluster.Similarity(path);
+      if (similarity > max_similarity) {
+        expected = &cluster;
+        max_similarity = similarity;
+      }
+    }
+    ASSERT_NE(nullptr, expected);
+    EXPECT_EQ(expected->Predict(path).ToString(), clustering.Predict(path).ToString());
+  }
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,708 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/sql_parsing/fast_normalization.h"
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <initializer_list>
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+namespace {
+
+enum class Dialect { kPostgres, kMySQL };
+
+enum class TokenKind {
+  kEnd,
+  kWord,
+  kQuotedIdentifier,
+  kNumber,
+  kString,
+  kParam,
+  kVariable,
+  kOperator,
+  kLeftParen,
+  kRightParen,
+  kComma,
+  kSemicolon,
+  kDot,
+  kDoubleColon,
+};
+
+struct Token {
+  TokenKind kind = TokenKind::kEnd;
+  // Points into the query, so tokens never allocate.
+  std::string_view text;
+};
+
+bool IsOneOf(std::string_view word, std::initializer_list<std::string_view> keywords) {
+  for (std::string_view keyword : keywords) {
+    if (absl::EqualsIgnoreCase(word, keyword)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsWordChar(char c) { return absl::ascii_isalnum(c) || c == '_'; }
+
+/**
+ * Splits a query into tokens. Next() returns false when it reaches something the fast path doesn't
+ * handle, in which case the query must go through the ANTLR parser.
+ */
+class Lexer {
+ public:
+  Lexer(std::string_view sql, Dialect dialect) : sql_(sql), dialect_(dialect) {}
+
+  bool Next(Token* token) {
+    if (!SkipWhitespaceAndComments()) {
+      return false;
+    }
+    size_t start = pos_;
+    if (pos_ == sql_.size()) {
+      *token = Token{TokenKind::kEnd, sql_.substr(start, 0)};
+      return true;
+    }
+
+    char c = sql_[pos_];
+    TokenKind kind;
+    if (absl::ascii_isdigit(c)) {
+      if (!LexNumber()) {
+        return false;
+      }
+      kind = TokenKind::kNumber;
+    } else if (absl::ascii_isalpha(c) || c == '_') {
+      // Prefixed string literals: E'' escape strings in Postgres and X'' hex strings in MySQL.
+      if (Peek(1) == '\'') {
+        if (dialect_ == Dialect::kPostgres && (c == 'e' || c == 'E')) {
+          ++pos_;
+          if (!LexString(/* backslash_escapes */ true)) {
+            return false;
+          }
+        } else if (dialect_ == Dialect::kMySQL && (c == 'x' || c == 'X')) {
+          ++pos_;
+          if (!LexHexString()) {
+            return false;
+          }
+        } else {
+          return false;
+        }
+        kind = TokenKind::kString;
+      } else {
+        while (pos_ < sql_.size() && IsWordChar(sql_[pos_])) {
+          ++pos_;
+        }
+        // '$' is valid in identifiers of both dialects, but it's too rare to be worth handling.
+        if (Peek(0) == '$') {
+          return false;
+        }
+        kind = TokenKind::kWord;
+      }
+    } else {
+      switch (c) {
+        case '\'': {
+          // Backslashes are escapes in MySQL strings but not in standard Postgres strings.
+          bool backslash_escapes = dialect_ == Dialect::kMySQL;
+          if (!LexString(backslash_escapes)) {
+            return false;
+          }
+          if (!backslash_escapes && sql_.substr(start, pos_ - start).find('\\') !=
+                                        std::string_view::npos) {
+            return false;
+          }
+          kind = TokenKind::kString;
+          break;
+        }
+        case '"':
+          // Quoted identifiers in Postgres. In MySQL they can also be strings.
+          if (dialect_ != Dialect::kPostgres || !LexQuotedIdentifier()) {
+            return false;
+          }
+          kind = TokenKind::kQuotedIdentifier;
+          break;
+        case '$':
+          // Dollar params. Dollar quoted strings aren't handled.
+          if (dialect_ != Dialect::kPostgres || !absl::ascii_isdigit(Peek(1))) {
+            return false;
+          }
+          ++pos_;
+          while (pos_ < sql_.size() && absl::ascii_isdigit(sql_[pos_])) {
+            ++pos_;
+          }
+          if (IsWordChar(Peek(0)) || Peek(0) == '$') {
+            return false;
+          }
+          kind = TokenKind::kParam;
+          break;
+        case '?':
+          if (dialect_ != Dialect::kMySQL) {
+            return false;
+          }
+          ++pos_;
+          kind = TokenKind::kParam;
+          break;
+        case '@':
+          // User and system variables in MySQL.
+          if (dialect_ != Dialect::kMySQL) {
+            return false;
+          }
+          ++pos_;
+          if (Peek(0) == '@') {
+            ++pos_;
+          }
+          if (!IsWordChar(Peek(0))) {
+            return false;
+          }
+          while (pos_ < sql_.size() && (IsWordChar(sql_[pos_]) || sql_[pos_] == '.')) {
+            ++pos_;
+          }
+          kind = TokenKind::kVariable;
+          break;
+        case '(':
+          ++pos_;
+          kind = TokenKind::kLeftParen;
+          break;
+        case ')':
+          ++pos_;
+          kind = TokenKind::kRightParen;
+          break;
+        case ',':
+          ++pos_;
+          kind = TokenKind::kComma;
+          break;
+        case ';':
+          ++pos_;
+          kind = TokenKind::kSemicolon;
+          break;
+        case '.':
+          // Numbers starting with a dot aren't handled.
+          if (absl::ascii_isdigit(Peek(1))) {
+            return false;
+          }
+          ++pos_;
+          kind = TokenKind::kDot;
+          break;
+        case ':':
+          if (dialect_ != Dialect::kPostgres || Peek(1) != ':') {
+            return false;
+          }
+          pos_ += 2;
+          kind = TokenKind::kDoubleColon;
+          break;
+        default:
+          if (!LexOperator()) {
+            return false;
+          }
+          kind = TokenKind::kOperator;
+          break;
+      }
+    }
+    *token = Token{kind, sql_.substr(start, pos_ - start)};
+    return true;
+  }
+
+ private:
+  char Peek(size_t offset) const {
+    return pos_ + offset < sql_.size() ? sql_[pos_ + offset] : '\0';
+  }
+
+  bool SkipWhitespaceAndComments() {
+    while (pos_ < sql_.size()) {
+      char c = sql_[pos_];
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        ++pos_;
+      } else if (c == '-' && Peek(1) == '-') {
+        // MySQL only treats '--' as a comment when it's followed by a space or a line break.
+        if (dialect_ == Dialect::kMySQL && Peek(2) != ' ' && Peek(2) != '\n' &&
+            Peek(2) != '\r' && Peek(2) != '\0') {
+          return false;
+        }
+        SkipLine();
+      } else if (c == '#' && dialect_ == Dialect::kMySQL) {
+        SkipLine();
+      } else if (c == '/' && Peek(1) == '*') {
+        // Postgres block comments nest, and MySQL executes the contents of /*! */ comments.
+        if (dialect_ == Dialect::kMySQL && Peek(2) == '!') {
+          return false;
+        }
+        size_t end = sql_.find("*/", pos_ + 2);
+        if (end == std::string_view::npos) {
+          return false;
+        }
+        if (dialect_ == Dialect::kPostgres &&
+            sql_.substr(pos_ + 2, end - pos_ - 2).find("/*") != std::string_view::npos) {
+          return false;
+        }
+        pos_ = end + 2;
+      } else if (absl::ascii_iscntrl(c)) {
+        return false;
+      } else {
+        return true;
+      }
+    }
+    return true;
+  }
+
+  void SkipLine() {
+    while (pos_ < sql_.size() && sql_[pos_] != '\n') {
+      ++pos_;
+    }
+  }
+
+  bool LexNumber() {
+    while (absl::ascii_isdigit(Peek(0))) {
+      ++pos_;
+    }
+    if (Peek(0) == '.') {
+      if (!absl::ascii_isdigit(Peek(1))) {
+        return false;
+      }
+      ++pos_;
+      while (absl::ascii_isdigit(Peek(0))) {
+        ++pos_;
+      }
+    }
+    // Exponents, identifiers starting with digits and the like aren't handled.
+    return !IsWordChar(Peek(0)) && Peek(0) != '.' && Peek(0) != '$';
+  }
+
+  // Lexes a single quoted string starting at pos_. Quotes are escaped by doubling them.
+  bool LexString(bool backslash_escapes) {
+    ++pos_;
+    while (pos_ < sql_.size()) {
+      char c = sql_[pos_];
+      if (backslash_escapes && c == '\\') {
+        pos_ += 2;
+      } else if (c == '\'') {
+        if (Peek(1) != '\'') {
+          ++pos_;
+          return true;
+        }
+        pos_ += 2;
+      } else {
+        ++pos_;
+      }
+    }
+    return false;
+  }
+
+  // Lexes X'..' hex strings, which need a non-zero, even number of hex digits.
+  bool LexHexString() {
+    size_t digits_start = ++pos_;
+    while (absl::ascii_isxdigit(Peek(0))) {
+      ++pos_;
+    }
+    size_t num_digits = pos_ - digits_start;
+    if (Peek(0) != '\'' || num_digits == 0 || num_digits % 2 != 0) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  bool LexQuotedIdentifier() {
+    ++pos_;
+    while (pos_ < sql_.size()) {
+      if (sql_[pos_] == '"') {
+        if (Peek(1) != '"') {
+          ++pos_;
+          return true;
+        }
+        ++pos_;
+      }
+      ++pos_;
+    }
+    return false;
+  }
+
+  bool LexOperator() {
+    size_t start = pos_;
+    while (pos_ < sql_.size()) {
+      char c = sql_[pos_];
+      if (c != '+' && c != '-' && c != '*' && c != '/' && c != '%' && c != '=' && c != '<' &&
+          c != '>' && c != '!' && c != '|') {
+        break;
+      }
+      // Stop at the start of a comment.
+      if ((c == '-' && Peek(1) == '-') || (c == '/' && Peek(1) == '*')) {
+        break;
+      }
+      ++pos_;
+    }
+    // How other runs of operator characters are split into tokens differs between the lexers.
+    return IsOneOf(sql_.substr(start, pos_ - start),
+                   {"=", "<>", "!=", "<", ">", "<=", ">=", "+", "-", "*", "/", "%", "||"});
+  }
+
+  std::string_view sql_;
+  Dialect dialect_;
+  size_t pos_ = 0;
+};
+
+/**
+ * Replaces the constants and parameter placeholders of a query in a single pass over its tokens.
+ */
+class FastNormalizer {
+ public:
+  FastNormalizer(std::string_view sql, Dialect dialect,
+                 const std::vector<std::string>& param_values)
+      : sql_(sql), dialect_(dialect), param_values_(param_values), lexer_(sql, dialect) {}
+
+  std::optional<NormalizeResult> Normalize() {
+    // The ANTLR path finds constants by their position in code points, so queries with anything
+    // but ASCII are left to it to produce the same output. It also validates the UTF-8.
+    for (char c : sql_) {
+      if (static_cast<unsigned char>(c) >= 0x80) {
+        return std::nullopt;
+      }
+    }
+    result_.normalized_query.reserve(sql_.size());
+
+    bool at_statement_start = true;
+    bool saw_statement = false;
+    int depth = 0;
+    // Set after a '::', and after the type name that follows it.
+    int cast_state = 0;
+    // Whether the last +/- sign was a prefix of the operand after it.
+    bool last_sign_is_prefix = false;
+    // Whether we're in a MySQL LIMIT clause, whose numbers aren't constants in the grammar.
+    bool in_limit = false;
+    // Whether the previous token was a '*' selecting all columns, rather than a multiplication.
+    bool prev_is_star = false;
+
+    Token token;
+    while (true) {
+      if (!lexer_.Next(&token)) {
+        return std::nullopt;
+      }
+      if (token.kind == TokenKind::kEnd) {
+        break;
+      }
+      bool is_star = false;
+
+      if (at_statement_start) {
+        if (token.kind != TokenKind::kWord || !IsStatementKeyword(token.text)) {
+          return std::nullopt;
+        }
+        at_statement_start = false;
+        saw_statement = true;
+      }
+
+      if (cast_state == 1) {
+        // A '::' must be followed by a type name.
+        if (token.kind != TokenKind::kWord) {
+          return std::nullopt;
+        }
+        cast_state = 2;
+        prev_is_star = false;
+        Advance(token);
+        continue;
+      }
+      if (cast_state == 2) {
+        // Type modifiers like varchar(20) aren't constants.
+        if (token.kind == TokenKind::kLeftParen) {
+          return std::nullopt;
+        }
+        cast_state = 0;
+      }
+
+      switch (token.kind) {
+        case TokenKind::kNumber:
+          if (in_limit) {
+            if (!AfterLimitKeywordOrComma()) {
+              return std::nullopt;
+            }
+            break;
+          }
+          // MySQL has signed numeric constants, so it's ambiguous whether a sign is part of them.
+          if (dialect_ == Dialect::kMySQL && prev_.kind == TokenKind::kOperator &&
+              (prev_.text == "-" || prev_.text == "+") && last_sign_is_prefix) {
+            return std::nullopt;
+          }
+          if (!ReplaceConstant(token)) {
+            return std::nullopt;
+          }
+          break;
+        case TokenKind::kString:
+          if (in_limit || !ReplaceConstant(token)) {
+            return std::nullopt;
+          }
+          break;
+        case TokenKind::kParam:
+          // Placeholders are replaced in LIMIT clauses too, where they follow LIMIT, OFFSET or ','.
+          if (in_limit ? !AfterLimitKeywordOrComma() : !ValueAllowed()) {
+            return std::nullopt;
+          }
+          if (!ReplaceParam(token)) {
+            return std::nullopt;
+          }
+          break;
+        case TokenKind::kWord:
+          // Keywords that continue a clause must follow an operand, not a ',' or an operator.
+          if ((prev_.kind == TokenKind::kComma ||
+               (prev_.kind == TokenKind::kOperator && !prev_is_star)) &&
+              IsInfixKeyword(token.text)) {
+            return std::nullopt;
+          }
+          if (IsOneOf(token.text, {"TRUE", "FALSE"})) {
+            if (in_limit || !ReplaceConstant(token)) {
+              return std::nullopt;
+            }
+            break;
+          }
+          // Whether NULL is a constant depends on the dialect and on where it appears, and the
+          // others have literals in the grammar that aren't constants.
+          if (IsOneOf(token.text, {"NULL", "CAST", "CONVERT", "INTERVAL", "COLLATE", "EXTRACT",
+                                   "SUBSTRING", "TRIM", "POSITION", "OVERLAY"})) {
+            return std::nullopt;
+          }
+          // ON is a boolean constant in Postgres when it's used as a value.
+          if (dialect_ == Dialect::kPostgres && absl::EqualsIgnoreCase(token.text, "ON") &&
+              ValueAllowed()) {
+            return std::nullopt;
+          }
+          if (dialect_ == Dialect::kMySQL && absl::EqualsIgnoreCase(token.text, "LIMIT")) {
+            in_limit = true;
+          } else if (!(in_limit && absl::EqualsIgnoreCase(token.text, "OFFSET"))) {
+            in_limit = false;
+          }
+          break;
+        case TokenKind::kOperator:
+          if (token.text == "-" || token.text == "+") {
+            last_sign_is_prefix = ValueAllowed();
+          }
+          // Binary operators must follow an operand. Signs can also prefix one, and a '*' after
+          // SELECT, '(', ',' or '.' selects all columns.
+          is_star = token.text == "*" && !EndsOperand(prev_) && StarAllowed();
+          if (!EndsOperand(prev_) && !is_star &&
+              !((token.text == "-" || token.text == "+") && last_sign_is_prefix)) {
+            return std::nullopt;
+          }
+          // COUNT(*) and the like go through the slow path in MySQL.
+          if (dialect_ == Dialect::kMySQL && token.text == "*" &&
+              prev_.kind == TokenKind::kLeftParen) {
+            return std::nullopt;
+          }
+          in_limit = false;
+          break;
+        case TokenKind::kLeftParen:
+          ++depth;
+          in_limit = false;
+          break;
+        case TokenKind::kRightParen:
+          if (--depth < 0) {
+            return std::nullopt;
+          }
+          in_limit = false;
+          break;
+        case TokenKind::kComma:
+          in_limit =
+              in_limit && (prev_.kind == TokenKind::kNumber || prev_.kind == TokenKind::kParam);
+          break;
+        case TokenKind::kSemicolon:
+          if (depth != 0 || !EndsOperand(prev_)) {
+            return std::nullopt;
+          }
+          at_statement_start = true;
+          in_limit = false;
+          break;
+        case TokenKind::kDoubleColon:
+          cast_state = 1;
+          in_limit = false;
+          break;
+        default:
+          in_limit = false;
+          break;
+      }
+      prev_is_star = is_star;
+      Advance(token);
+    }
+
+    // Queries cut off mid-statement (eg. after an operator, AND, a ',' or a clause keyword) are
+    // invalid, and the ANTLR path reports the error.
+    bool ends_statement = prev_.kind == TokenKind::kSemicolon || EndsOperand(prev_);
+    if (!saw_statement || depth != 0 || cast_state == 1 || !ends_statement) {
+      return std::nullopt;
+    }
+    result_.normalized_query.append(sql_.substr(copied_until_));
+    return std::move(result_);
+  }
+
+ private:
+  bool IsStatementKeyword(std::string_view word) const {
+    if (IsOneOf(word, {"SELECT", "INSERT", "UPDATE", "DELETE", "BEGIN", "COMMIT", "ROLLBACK"})) {
+      return true;
+    }
+    return dialect_ == Dialect::kPostgres && absl::EqualsIgnoreCase(word, "WITH");
+  }
+
+  // Returns whether a literal after the current previous token is a constant in the grammar.
+  // This is only the case when the literal is an operand of an expression: after an operator,
+  // an opening parenthesis, a comma or one of a few keywords. Anything else, like a literal after
+  // a type name or after IS, is left to the ANTLR parser.
+  bool ValueAllowed() const {
+    switch (prev_.kind) {
+      case TokenKind::kOperator:
+      case TokenKind::kLeftParen:
+      case TokenKind::kComma:
+        return true;
+      case TokenKind::kWord:
+        if (absl::EqualsIgnoreCase(prev_.text, "NOT") && prev2_.kind == TokenKind::kWord &&
+            absl::EqualsIgnoreCase(prev2_.text, "IS")) {
+          return false;
+        }
+        if (dialect_ == Dialect::kPostgres && absl::EqualsIgnoreCase(prev_.text, "ILIKE")) {
+          return true;
+        }
+        return IsOneOf(prev_.text, {"SELECT", "WHERE", "AND", "OR", "NOT", "LIKE", "BETWEEN",
+                                    "CASE", "WHEN", "THEN", "ELSE", "HAVING", "ON", "BY",
+                                    "DISTINCT"});
+      default:
+        return false;
+    }
+  }
+
+  // Keywords that can only follow an operand, because they continue the expression or clause before
+  // them.
+  static bool IsInfixKeyword(std::string_view word) {
+    return IsOneOf(word, {"FROM", "WHERE", "GROUP", "ORDER", "BY", "HAVING", "LIMIT", "OFFSET",
+                          "AND", "OR", "THEN", "ELSE", "END", "ON", "SET", "VALUES", "INTO", "AS",
+                          "UNION", "EXCEPT", "INTERSECT", "JOIN", "IN", "IS", "LIKE", "ILIKE",
+                          "BETWEEN"});
+  }
+
+  // Returns whether a statement can end after the token, and a binary operator can follow it. This
+  // is the case after an operand, but not after keywords that expect an operand or a clause.
+  static bool EndsOperand(const Token& token) {
+    switch (token.kind) {
+      case TokenKind::kNumber:
+      case TokenKind::kString:
+      case TokenKind::kParam:
+      case TokenKind::kVariable:
+      case TokenKind::kQuotedIdentifier:
+      case TokenKind::kRightParen:
+        return true;
+      case TokenKind::kWord:
+        return !(IsInfixKeyword(token.text) && !absl::EqualsIgnoreCase(token.text, "END")) &&
+               !IsOneOf(token.text, {"SELECT", "NOT", "CASE", "WHEN", "DISTINCT", "ALL", "ANY",
+                                     "SOME", "EXISTS", "UPDATE", "DELETE", "INSERT", "WITH",
+                                     "LEFT", "RIGHT", "INNER", "OUTER", "CROSS", "FULL"});
+      default:
+        return false;
+    }
+  }
+
+  // Returns whether a '*' after the previous token selects all columns.
+  bool StarAllowed() const {
+    switch (prev_.kind) {
+      case TokenKind::kLeftParen:
+      case TokenKind::kComma:
+      case TokenKind::kDot:
+        return true;
+      case TokenKind::kWord:
+        return IsOneOf(prev_.text, {"SELECT", "DISTINCT", "ALL"});
+      default:
+        return false;
+    }
+  }
+
+  bool AfterLimitKeywordOrComma() const {
+    return prev_.kind == TokenKind::kComma ||
+           (prev_.kind == TokenKind::kWord && IsOneOf(prev_.text, {"LIMIT", "OFFSET"}));
+  }
+
+  bool ReplaceConstant(const Token& token) {
+    if (!ValueAllowed()) {
+      return false;
+    }
+    Replace(token);
+    result_.params.emplace_back(token.text);
+    return true;
+  }
+
+  bool ReplaceParam(const Token& token) {
+    size_t index;
+    if (dialect_ == Dialect::kMySQL) {
+      index = num_generic_params_++;
+    } else {
+      int param_num;
+      if (!absl::SimpleAtoi(token.text.substr(1), &param_num) || param_num < 1) {
+        return false;
+      }
+      index = param_num - 1;
+    }
+    // The ANTLR path returns the error for missing param values.
+    if (index >= param_values_.size()) {
+      return false;
+    }
+    Replace(token);
+    result_.params.push_back(param_values_[index]);
+    return true;
+  }
+
+  void Replace(const Token& token) {
+    size_t offset = token.text.data() - sql_.data();
+    result_.normalized_query.append(sql_.substr(copied_until_, offset - copied_until_));
+    if (dialect_ == Dialect::kPostgres) {
+      absl::StrAppend(&result_.normalized_query, "$", ++num_placeholders_);
+    } else {
+      result_.normalized_query.push_back('?');
+    }
+    copied_until_ = offset + token.text.size();
+  }
+
+  void Advance(const Token& token) {
+    prev2_ = prev_;
+    prev_ = token;
+  }
+
+  std::string_view sql_;
+  Dialect dialect_;
+  const std::vector<std::string>& param_values_;
+  Lexer lexer_;
+
+  NormalizeResult result_;
+  size_t copied_until_ = 0;
+  int num_placeholders_ = 0;
+  size_t num_generic_params_ = 0;
+  Token prev_;
+  Token prev2_;
+};
+
+}  // namespace
+
+std::optional<NormalizeResult> fast_normalize_pgsql(std::string_view sql,
+                                                    const std::vector<std::string>& param_values) {
+  return FastNormalizer(sql, Dialect::kPostgres, param_values).Normalize();
+}
+
+std::optional<NormalizeResult> fast_normalize_mysql(std::string_view sql,
+                                                    const std::vector<std::string>& param_values) {
+  return FastNormalizer(sql, Dialect::kMySQL, param_values).Normalize();
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+/**
+ * Normalizes a query the same way normalize_sql() does, using only a hand-written tokenizer
+ * instead of building an ANTLR parse tree.
+ *
+ * The tokenizer only understands the common subset of the grammar (DML statements with string,
+ * numeric and boolean literals, IN-lists, parameter placeholders and comments). Whether a literal
+ * is a constant in the ANTLR grammar is decided from the token before it, and any query where that
+ * isn't clear-cut (eg. typed literals like DATE '2020-01-01', casts, NULL, non-ASCII text) returns
+ * std::nullopt, in which case the caller must fall back to the ANTLR parser. When a result is
+ * returned, it is identical to the one normalize_sql() returns.
+ */
+std::optional<NormalizeResult> fast_normalize_pgsql(std::string_view sql,
+                                                    const std::vector<std::string>& param_values);
+
+std::optional<NormalizeResult> fast_normalize_mysql(std::string_view sql,
+                                                    const std::vector<std::string>& param_values);
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
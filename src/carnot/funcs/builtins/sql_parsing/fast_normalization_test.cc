@@ -0,0 +1,202 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mysql_parser/MySQLLexer.h"
+#include "mysql_parser/MySQLParser.h"
+#include "pgsql_parser/PostgresSQLLexer.h"
+#include "pgsql_parser/PostgresSQLParser.h"
+#include "src/carnot/funcs/builtins/sql_parsing/antlr_parse.h"
+#include "src/carnot/funcs/builtins/sql_parsing/fast_normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+struct FastNormSQLTestCase {
+  std::string input_sql_str;
+  std::vector<std::string> input_params;
+  // Whether the fast path is expected to handle the query, rather than leave it to ANTLR.
+  bool fast_path;
+};
+
+void ExpectSameAsANTLR(const std::optional<NormalizeResult>& fast_result,
+                       const StatusOr<NormalizeResult>& antlr_result) {
+  ASSERT_TRUE(fast_result.has_value());
+  ASSERT_OK(antlr_result);
+  EXPECT_EQ(fast_result->normalized_query, antlr_result.ValueOrDie().normalized_query);
+  EXPECT_EQ(fast_result->params, antlr_result.ValueOrDie().params);
+  EXPECT_EQ(fast_result->error, antlr_result.ValueOrDie().error);
+}
+
+class FastNormPGSQLTest : public ::testing::TestWithParam<FastNormSQLTestCase> {};
+
+TEST_P(FastNormPGSQLTest, same_as_antlr) {
+  auto test_case = GetParam();
+
+  auto fast_result = fast_normalize_pgsql(test_case.input_sql_str, test_case.input_params);
+  ASSERT_EQ(fast_result.has_value(), test_case.fast_path);
+  if (!test_case.fast_path) {
+    return;
+  }
+  ExpectSameAsANTLR(
+      fast_result, normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(
+                       test_case.input_sql_str, test_case.input_params));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FastNormPGSQLVariants, FastNormPGSQLTest,
+    ::testing::Values(
+        FastNormSQLTestCase{"SELECT 1", {}, true},
+        FastNormSQLTestCase{"BEGIN;", {}, true},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE prop=1234 AND prop2='abcd'", {}, true},
+        FastNormSQLTestCase{"UPDATE test SET age=10 where name='abcd'", {}, true},
+        FastNormSQLTestCase{"SELECT * from test where abcd >= 11", {}, true},
+        FastNormSQLTestCase{
+            "SELECT 'abcd' as col1, 1234 as col2, 1.2345 as col3 into my_new_table", {}, true},
+        FastNormSQLTestCase{"SELECT length(abcd) + 1 from test", {}, true},
+        FastNormSQLTestCase{
+            "SELECT * from test WHERE name=$1 AND tag=1234 AND property=$2", {"'abcd'", "1.23"},
+            true},
+        FastNormSQLTestCase{
+            "SELECT * from test WHERE name=$1 AND tag=1234 AND property=$1", {"'abcd'"}, true},
+        FastNormSQLTestCase{
+            R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, E'\\xDEADBEEF'))",
+            {},
+            true},
+        // IN-lists, comments, escaped quotes and multiple lines.
+        FastNormSQLTestCase{"SELECT a FROM test -- where b = 1\nWHERE id IN (1, 2, 3)\n"
+                            "  AND name = 'it''s' /* or 4 */ OR id = -5",
+                            {},
+                            true},
+        FastNormSQLTestCase{"SELECT name, count(id) FROM test WHERE tag ILIKE 'a%' "
+                            "GROUP BY name HAVING count(id) > 10 ORDER BY 2 DESC",
+                            {},
+                            true},
+        FastNormSQLTestCase{"SELECT \"Name\", 'x'::text FROM test t JOIN other o ON t.id = o.id "
+                            "WHERE t.a BETWEEN 1 AND 2 AND CASE WHEN t.b THEN 3 ELSE 4 END = 5",
+                            {},
+                            true},
+        FastNormSQLTestCase{"WITH q AS (SELECT 1) SELECT * FROM q; COMMIT;", {}, true},
+        FastNormSQLTestCase{"DELETE FROM test WHERE id = $1 AND flag = false", {"7"}, true},
+        // Queries that are left to ANTLR.
+        FastNormSQLTestCase{
+            "CREATE TABLE test (name varchar(20), address text, foo int, bar text)", {}, false},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE a IS NULL", {}, false},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE a IS NOT TRUE", {}, false},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE d > DATE '2020-01-01'", {}, false},
+        FastNormSQLTestCase{"SELECT * FROM test LIMIT 10", {}, false},
+        FastNormSQLTestCase{"SELECT $1::varchar(20)", {"'a'"}, false},
+        FastNormSQLTestCase{"SELECT $$abc$$", {}, false},
+        FastNormSQLTestCase{"SELECT 'abc\\'", {}, false},
+        FastNormSQLTestCase{"SELECT 1e10", {}, false},
+        FastNormSQLTestCase{"SELECT 'é'", {}, false},
+        FastNormSQLTestCase{"SELECT $2", {"1"}, false},
+        FastNormSQLTestCase{"SELECT (1", {}, false},
+        FastNormSQLTestCase{"SELECT 1 /* nested /* comment */ */", {}, false}));
+
+// Invalid queries must be left to ANTLR, which reports the error, rather than be normalized.
+TEST(FastNormPGSQLInvalidTest, left_to_antlr) {
+  for (const auto& sql : {"SELECT a FROM t WHERE b = 1 AND", "SELECT = 1", "SELECT a FROM t WHERE",
+                          "SELECT a, FROM t", "SELECT 1 +", "SELECT a FROM t WHERE b = 1 OR;",
+                          "UPDATE t SET", "SELECT f(1,", "SELECT a FROM t WHERE b IN"}) {
+    SCOPED_TRACE(sql);
+    EXPECT_FALSE(fast_normalize_pgsql(sql, {}).has_value());
+    EXPECT_NOT_OK(
+        (normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(sql, {})));
+  }
+}
+
+class FastNormMySQLTest : public ::testing::TestWithParam<FastNormSQLTestCase> {};
+
+TEST_P(FastNormMySQLTest, same_as_antlr) {
+  auto test_case = GetParam();
+
+  auto fast_result = fast_normalize_mysql(test_case.input_sql_str, test_case.input_params);
+  ASSERT_EQ(fast_result.has_value(), test_case.fast_path);
+  if (!test_case.fast_path) {
+    return;
+  }
+  ExpectSameAsANTLR(
+      fast_result,
+      normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
+          test_case.input_sql_str, test_case.input_params));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    FastNormMySQLVariants, FastNormMySQLTest,
+    ::testing::Values(
+        FastNormSQLTestCase{"SELECT 1", {}, true},
+        FastNormSQLTestCase{"BEGIN;", {}, true},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE prop=1234 AND prop2='abcd'", {}, true},
+        FastNormSQLTestCase{"UPDATE test SET age=10 where name='abcd'", {}, true},
+        FastNormSQLTestCase{"SELECT * from test where abcd >= 11", {}, true},
+        FastNormSQLTestCase{
+            "INSERT INTO my_new_table SELECT 'abcd' as col1, 1234 as col2, 1.2345 as col3", {},
+            true},
+        FastNormSQLTestCase{"SELECT length(abcd) + 1 from test", {}, true},
+        FastNormSQLTestCase{
+            "SELECT * from test WHERE name=? AND tag=1234 AND property=?", {"'abcd'", "1.23"},
+            true},
+        FastNormSQLTestCase{
+            R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, X'DEADBEEF'))",
+            {},
+            true},
+        // IN-lists, comments, escaped quotes, variables and LIMIT clauses.
+        FastNormSQLTestCase{"SELECT a FROM test # where b = 1\nWHERE id IN (1, 2, 3)\n"
+                            "  AND name = 'it\\'s' /* or 4 */ AND c - 5 > @min LIMIT 10, 20",
+                            {},
+                            true},
+        FastNormSQLTestCase{"SELECT a FROM test WHERE id = ? LIMIT ? OFFSET ?", {"1", "2", "3"},
+                            true},
+        FastNormSQLTestCase{"DELETE FROM test WHERE id = 1 -- trailing comment", {}, true},
+        // Queries that are left to ANTLR.
+        FastNormSQLTestCase{
+            "CREATE TABLE test (name text, address text, foo int, bar text)", {}, false},
+        FastNormSQLTestCase{"SELECT * FROM test WHERE a IS NOT NULL", {}, false},
+        FastNormSQLTestCase{"SELECT -1", {}, false},
+        FastNormSQLTestCase{"SELECT `a` FROM test", {}, false},
+        FastNormSQLTestCase{"SELECT \"a\" FROM test", {}, false},
+        FastNormSQLTestCase{"SELECT _utf8'a'", {}, false},
+        FastNormSQLTestCase{"SELECT count(*) FROM test", {}, false},
+        FastNormSQLTestCase{"SELECT /*! STRAIGHT_JOIN */ a FROM test", {}, false},
+        FastNormSQLTestCase{"SET autocommit=1", {}, false},
+        FastNormSQLTestCase{"SELECT ?", {}, false}));
+
+TEST(FastNormMySQLInvalidTest, left_to_antlr) {
+  for (const auto& sql : {"SELECT a FROM t WHERE b = 1 AND", "SELECT = 1", "SELECT a FROM t WHERE",
+                          "SELECT a, FROM t", "SELECT 1 +", "SELECT a FROM t WHERE b = 1 OR;",
+                          "UPDATE t SET", "SELECT f(1,", "SELECT a FROM t WHERE b IN"}) {
+    SCOPED_TRACE(sql);
+    EXPECT_FALSE(fast_normalize_mysql(sql, {}).has_value());
+    EXPECT_NOT_OK(
+        (normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
+            sql, {})));
+  }
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
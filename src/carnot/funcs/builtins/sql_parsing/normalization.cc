@@ -16,12 +16,15 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <optional>
 #include <string>
+#include <utility>
 
 #include "mysql_parser/MySQLLexer.h"
 #include "mysql_parser/MySQLParser.h"
 #include "pgsql_parser/PostgresSQLLexer.h"
 #include "pgsql_parser/PostgresSQLParser.h"
+#include "src/carnot/funcs/builtins/sql_parsing/fast_normalization.h"
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
 #include "src/common/base/logging.h"
 #include "src/common/base/statusor.h"
@@ -126,12 +129,20 @@ void SQLFragmentHandler::ReplaceFragmentWithPlaceholder(const SQLFragment& fragm
 
 StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
                                           const std::vector<std::string>& param_values) {
+  std::optional<NormalizeResult> result = fast_normalize_pgsql(sql, param_values);
+  if (result.has_value()) {
+    return std::move(result.value());
+  }
   return normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(
       sql, param_values);
 }
 
 StatusOr<NormalizeResult> normalize_mysql(std::string sql,
                                           const std::vector<std::string>& param_values) {
+  std::optional<NormalizeResult> result = fast_normalize_mysql(sql, param_values);
+  if (result.has_value()) {
+    return std::move(result.value());
+  }
   return normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
       sql, param_values);
 }
@@ -266,6 +266,10 @@ StatusOr<NormalizeResult> normalize_sql(std::string sql,
   return result;
 }
 
+/**
+ * normalize_pgsql and normalize_mysql normalize the query with the lexer-only fast path when it
+ * handles the query, and with normalize_sql() otherwise. The results are the same either way.
+ */
 StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
                                           const std::vector<std::string>& param_values);
 
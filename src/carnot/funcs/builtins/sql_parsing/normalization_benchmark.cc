@@ -19,6 +19,7 @@
 #include <gflags/gflags.h>
 
 #include <benchmark/benchmark.h>
+#include "src/carnot/funcs/builtins/sql_parsing/antlr_parse.h"
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
 #include "src/common/perf/perf.h"
 
@@ -36,6 +37,32 @@ static void BM_NormalizeMySQL(benchmark::State& state, std::string query) {
   }
 }
 
+// The ANTLR normalization that normalize_pgsql() and normalize_mysql() fall back to when the
+// lexer-only fast path doesn't handle a query.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizePgSQLAntlr(benchmark::State& state, std::string query) {
+  using px::carnot::builtins::sql_parsing::normalize_sql;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(query, {}));
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizeMySQLAntlr(benchmark::State& state, std::string query) {
+  using px::carnot::builtins::sql_parsing::normalize_sql;
+  using px::carnot::builtins::sql_parsing::UpperCaseCharStream;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
+            query, {}));
+  }
+}
+
+constexpr char kInListQuery[] =
+    "SELECT id, name, price FROM product WHERE category = 'shoes' AND id IN (101, 102, 103, 104, "
+    "105, 106, 107, 108, 109, 110) AND price > 10.5 ORDER BY price";
+
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select,
                   "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select_1, "SELECT 1");
@@ -72,3 +99,22 @@ BENCHMARK_CAPTURE(BM_NormalizeMySQL, sock_shop,
                   "JOIN sock_tag ON sock.sock_id=sock_tag.sock_id JOIN tag ON "
                   "sock_tag.tag_id=tag.tag_id "
                   "WHERE sock.sock_id =abcde GROUP BY sock.sock_id;");
+
+BENCHMARK_CAPTURE(BM_NormalizePgSQL, in_list, kInListQuery);
+BENCHMARK_CAPTURE(BM_NormalizeMySQL, in_list, kInListQuery);
+
+BENCHMARK_CAPTURE(BM_NormalizePgSQLAntlr, select,
+                  "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
+BENCHMARK_CAPTURE(BM_NormalizePgSQLAntlr, update, "UPDATE test SET age=10 where name='abcd'");
+BENCHMARK_CAPTURE(
+    BM_NormalizePgSQLAntlr, insert_into,
+    R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, E'\\xDEADBEEF'))");
+BENCHMARK_CAPTURE(BM_NormalizePgSQLAntlr, in_list, kInListQuery);
+
+BENCHMARK_CAPTURE(BM_NormalizeMySQLAntlr, select,
+                  "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
+BENCHMARK_CAPTURE(BM_NormalizeMySQLAntlr, update, "UPDATE test SET age=10 where name='abcd'");
+BENCHMARK_CAPTURE(
+    BM_NormalizeMySQLAntlr, insert_into,
+    R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, X'DEADBEEF'))");
+BENCHMARK_CAPTURE(BM_NormalizeMySQLAntlr, in_list, kInListQuery);
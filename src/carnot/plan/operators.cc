@@ -110,6 +110,20 @@ Status MemorySourceOperator::Init(const planpb::MemorySourceOperator& pb) {
   return Status::OK();
 }
 
+void MemorySourceOperator::SetTimeBounds(const planpb::MemorySourceOperator& pb) {
+  DCHECK(is_initialized_) << "Not initialized";
+  if (pb.has_start_time()) {
+    *pb_.mutable_start_time() = pb.start_time();
+  } else {
+    pb_.clear_start_time();
+  }
+  if (pb.has_stop_time()) {
+    *pb_.mutable_stop_time() = pb.stop_time();
+  } else {
+    pb_.clear_stop_time();
+  }
+}
+
 StatusOr<table_store::schema::Relation> MemorySourceOperator::OutputRelation(
     const table_store::schema::Schema&, const PlanState&,
     const std::vector<int64_t>& input_ids) const {
@@ -320,7 +334,10 @@ StatusOr<table_store::schema::Relation> GRPCSourceOperator::OutputRelation(
 
 std::string GRPCSinkOperator::DebugString() const {
   std::string destination;
-  if (has_table_name()) {
+  if (is_partitioned()) {
+    destination = absl::Substitute("partitions=$0, partition_cols=[$1]", num_partitions(),
+                                   absl::StrJoin(partition_columns(), ","));
+  } else if (has_table_name()) {
     destination = absl::Substitute("table_name=$0", table_name());
   } else if (has_grpc_source_id()) {
     destination = absl::Substitute("source_id=$0", grpc_source_id());
@@ -98,6 +98,12 @@ class MemorySourceOperator : public Operator {
   const types::TabletID& Tablet() const { return pb_.tablet(); }
   bool streaming() const { return pb_.streaming(); }
 
+  /**
+   * Replaces the start and stop times with the ones in the given operator, which must otherwise
+   * be the same as the one this operator was initialized with.
+   */
+  void SetTimeBounds(const planpb::MemorySourceOperator& pb);
+
  private:
   planpb::MemorySourceOperator pb_;
   std::vector<int64_t> column_idxs_;
@@ -145,6 +151,7 @@ class AggregateOperator : public Operator {
   const std::vector<std::shared_ptr<AggregateExpression>>& values() const { return values_; }
   bool windowed() const { return pb_.windowed(); }
   bool partial_agg() const { return pb_.partial_agg(); }
+  bool cumulative() const { return pb_.cumulative(); }
   bool finalize_results() const { return pb_.finalize_results(); }
 
  private:
@@ -217,6 +224,17 @@ class GRPCSinkOperator : public Operator {
   }
   std::string table_name() const { return pb_.output_table().table_name(); }
 
+  // Whether the sink hash-partitions its rows across several GRPC Sources.
+  bool is_partitioned() const { return pb_.partitioned_destinations_size() > 0; }
+  std::vector<int64_t> partition_columns() const {
+    return std::vector<int64_t>(pb_.partition_columns().begin(), pb_.partition_columns().end());
+  }
+  int64_t num_partitions() const { return pb_.partitioned_destinations_size(); }
+  const planpb::GRPCSinkOperator::PartitionedDestination& partitioned_destination(
+      int64_t i) const {
+    return pb_.partitioned_destinations(i);
+  }
+
  private:
   planpb::GRPCSinkOperator pb_;
 };
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/plan_cache.h"
+
+#include <farmhash.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <utility>
+#include <vector>
+
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/plan/plan_fragment.h"
+#include "src/carnot/plan/scalar_expression.h"
+
+DEFINE_int32(carnot_plan_cache_size, gflags::Int32FromEnv("PL_CARNOT_PLAN_CACHE_SIZE", 64),
+             "The number of prepared plans Carnot keeps for reuse by later queries with the same "
+             "plan. 0 disables the cache.");
+
+namespace px {
+namespace carnot {
+
+StatusOr<std::unique_ptr<PreparedPlan>> PreparedPlan::Create(const planpb::Plan& pb,
+                                                             const udf::Registry* func_registry) {
+  std::unique_ptr<PreparedPlan> prepared(new PreparedPlan());
+  PX_RETURN_IF_ERROR(prepared->plan_.Init(pb));
+  PX_RETURN_IF_ERROR(prepared->ResolveFuncs(func_registry));
+  return prepared;
+}
+
+/**
+ * Finds all of the UDF/UDA definitions used by the plan and tracks them with the ids provided by
+ * the logical plan.
+ *
+ * This assumes that the logical plan has valid ids for each udf/uda and that ids
+ * aren't shared by non-matching RegistryKeys.
+ */
+Status PreparedPlan::ResolveFuncs(const udf::Registry* func_registry) {
+  auto no_op = [&](const auto&) { return Status::OK(); };
+  return plan::PlanWalker()
+      .OnPlanFragment([&](plan::PlanFragment* pf) {
+        return plan::PlanFragmentWalker()
+            .OnMap([&](const plan::MapOperator& map) {
+              for (const auto& expr : map.expressions()) {
+                PX_RETURN_IF_ERROR(ResolveFuncs(func_registry, *expr));
+              }
+              return Status::OK();
+            })
+            .OnAggregate([&](const plan::AggregateOperator& agg) {
+              for (const auto& expr : agg.values()) {
+                PX_RETURN_IF_ERROR(ResolveFuncs(func_registry, *expr));
+              }
+              return Status::OK();
+            })
+            .OnFilter([&](const plan::FilterOperator& filter) {
+              return ResolveFuncs(func_registry, *filter.expression());
+            })
+            .OnLimit(no_op)
+            .OnMemorySink(no_op)
+            .OnMemorySource(no_op)
+            .OnUnion(no_op)
+            .OnJoin(no_op)
+            .OnGRPCSource(no_op)
+            .OnGRPCSink(no_op)
+            .OnUDTFSource(no_op)
+            .OnEmptySource(no_op)
+            .OnOTelSink(no_op)
+            .Walk(pf);
+      })
+      .Walk(&plan_);
+}
+
+Status PreparedPlan::ResolveFuncs(const udf::Registry* func_registry,
+                                  const plan::ScalarExpression& expr) {
+  Status status;
+  StatusOr<bool> walk_result =
+      plan::ExpressionWalker<bool>()
+          .OnAggregateExpression([&](const plan::AggregateExpression& func, std::vector<bool>) {
+            CHECK_EQ(func.registry_arg_types().size(),
+                     func.init_arguments().size() + func.arg_deps().size());
+            auto def = func_registry->GetUDADefinition(func.name(), func.registry_arg_types());
+            if (!def.ok()) {
+              status = def.status();
+              return false;
+            }
+            udas_[func.uda_id()] = def.ConsumeValueOrDie();
+            return true;
+          })
+          .OnColumn([&](const auto&, std::vector<bool>) { return true; })
+          .OnScalarFunc([&](const plan::ScalarFunc& func, std::vector<bool>) {
+            CHECK_EQ(func.registry_arg_types().size(),
+                     func.init_arguments().size() + func.arg_deps().size());
+            auto def =
+                func_registry->GetScalarUDFDefinition(func.name(), func.registry_arg_types());
+            if (!def.ok()) {
+              status = def.status();
+              return false;
+            }
+            scalar_udfs_[func.udf_id()] = def.ConsumeValueOrDie();
+            return true;
+          })
+          .OnScalarValue([&](const auto&, std::vector<bool>) { return true; })
+          .Walk(expr);
+  PX_RETURN_IF_ERROR(status);
+  if (!walk_result.ok() || !walk_result.ConsumeValueOrDie()) {
+    return error::Internal("Error walking expression.");
+  }
+  return Status::OK();
+}
+
+Status PreparedPlan::RebindTimeBounds(const planpb::Plan& pb) {
+  for (const auto& pf_pb : pb.nodes()) {
+    auto pf = plan_.nodes().find(pf_pb.id());
+    if (pf == plan_.nodes().end()) {
+      return error::NotFound("Could not find plan fragment $0 in prepared plan.", pf_pb.id());
+    }
+    for (const auto& node_pb : pf_pb.nodes()) {
+      if (node_pb.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto node = pf->second->nodes().find(node_pb.id());
+      if (node == pf->second->nodes().end() ||
+          node->second->op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        return error::NotFound("Could not find memory source $0 in prepared plan fragment $1.",
+                               node_pb.id(), pf_pb.id());
+      }
+      static_cast<plan::MemorySourceOperator*>(node->second.get())
+          ->SetTimeBounds(node_pb.op().mem_source_op());
+    }
+  }
+  return Status::OK();
+}
+
+void PreparedPlan::RegisterFuncs(exec::ExecState* exec_state) const {
+  for (const auto& [id, def] : scalar_udfs_) {
+    exec_state->AddScalarUDF(id, def);
+  }
+  for (const auto& [id, def] : udas_) {
+    exec_state->AddUDA(id, def);
+  }
+}
+
+std::string PlanCache::Key(const planpb::Plan& pb) {
+  planpb::Plan key_pb = pb;
+  for (auto& pf : *key_pb.mutable_nodes()) {
+    for (auto& node : *pf.mutable_nodes()) {
+      if (node.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto* mem_source = node.mutable_op()->mutable_mem_source_op();
+      if (mem_source->has_start_time()) {
+        mem_source->mutable_start_time()->set_value(0);
+      }
+      if (mem_source->has_stop_time()) {
+        mem_source->mutable_stop_time()->set_value(0);
+      }
+    }
+  }
+
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream sos(&key);
+    google::protobuf::io::CodedOutputStream cos(&sos);
+    cos.SetSerializationDeterministic(true);
+    key_pb.SerializeToCodedStream(&cos);
+  }
+  return key;
+}
+
+std::unique_ptr<PreparedPlan> PlanCache::Acquire(const std::string& key) {
+  uint64_t fingerprint = ::util::Fingerprint64(key);
+  absl::MutexLock lock(&mu_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->fingerprint == fingerprint && it->key == key) {
+      std::unique_ptr<PreparedPlan> prepared = std::move(it->prepared);
+      entries_.erase(it);
+      return prepared;
+    }
+  }
+  return nullptr;
+}
+
+void PlanCache::Release(std::string key, std::unique_ptr<PreparedPlan> prepared) {
+  if (capacity_ == 0) {
+    return;
+  }
+  uint64_t fingerprint = ::util::Fingerprint64(key);
+  absl::MutexLock lock(&mu_);
+  entries_.push_front(Entry{fingerprint, std::move(key), std::move(prepared)});
+  while (entries_.size() > capacity_) {
+    entries_.pop_back();
+  }
+}
+
+size_t PlanCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/plan.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_plan_cache_size);
+
+namespace px {
+namespace carnot {
+
+/**
+ * PreparedPlan is a plan::Plan that has been initialized from its proto, along with the UDF and
+ * UDA definitions its expressions refer to.
+ *
+ * Preparing a plan is independent of the query that runs it, so a PreparedPlan can be reused by
+ * later queries with the same plan, which only need to rebind the time bounds of the memory
+ * sources. A PreparedPlan must only be used by one query at a time.
+ */
+class PreparedPlan : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<PreparedPlan>> Create(const planpb::Plan& pb,
+                                                        const udf::Registry* func_registry);
+
+  plan::Plan* plan() { return &plan_; }
+
+  /**
+   * Sets the time bounds of the memory sources to the ones in the given plan, which must have the
+   * same PlanCache::Key() as the plan this was created from.
+   */
+  Status RebindTimeBounds(const planpb::Plan& pb);
+
+  /**
+   * Registers the UDF and UDA definitions used by the plan with the query's exec state.
+   */
+  void RegisterFuncs(exec::ExecState* exec_state) const;
+
+ private:
+  PreparedPlan() = default;
+
+  Status ResolveFuncs(const udf::Registry* func_registry);
+  Status ResolveFuncs(const udf::Registry* func_registry, const plan::ScalarExpression& expr);
+
+  plan::Plan plan_;
+  std::map<int64_t, udf::ScalarUDFDefinition*> scalar_udfs_;
+  std::map<int64_t, udf::UDADefinition*> udas_;
+};
+
+/**
+ * PlanCache keeps the most recently used PreparedPlans, so that plans that are executed
+ * repeatedly (eg. the plan fragments of a dashboard that is refreshed every few seconds) don't
+ * have to be prepared for every query.
+ *
+ * Only the plan is cached. Each query still builds its own ExecutionGraphs, because ExecNodes keep
+ * per-query state (row counts, aggregate and join hash tables, received row batches) that they have
+ * no way to reset, and a graph registers its GRPC source nodes with the router under the id of the
+ * query that built it. Reusing graphs would need a reset path on every ExecNode.
+ *
+ * A query checks a prepared plan out of the cache with Acquire(), and returns it with Release()
+ * once it is done with it. Concurrent queries with the same plan each get their own copy, and the
+ * cache may hold several copies of the same plan.
+ */
+class PlanCache : public NotCopyable {
+ public:
+  explicit PlanCache(size_t capacity) : capacity_(capacity) {}
+
+  /**
+   * Returns the cache key of a plan, which is its deterministic serialization with the time bounds
+   * of the memory sources zeroed out. Their presence is kept, since it changes how the sources
+   * are read.
+   */
+  static std::string Key(const planpb::Plan& pb);
+
+  /**
+   * Removes and returns a prepared plan with the given key, or nullptr if there is none.
+   */
+  std::unique_ptr<PreparedPlan> Acquire(const std::string& key);
+
+  /**
+   * Adds a prepared plan to the cache, evicting the least recently released plan if the cache is
+   * full.
+   */
+  void Release(std::string key, std::unique_ptr<PreparedPlan> prepared);
+
+  size_t capacity() const { return capacity_; }
+  size_t size() const;
+
+ private:
+  struct Entry {
+    uint64_t fingerprint;
+    std::string key;
+    std::unique_ptr<PreparedPlan> prepared;
+  };
+
+  const size_t capacity_;
+
+  mutable absl::Mutex mu_;
+  // Ordered from the most to the least recently released.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/plan_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+
+constexpr char kPlanTmpl[] = R"proto(
+  dag {
+    nodes {
+      id: 1
+    }
+  }
+  nodes {
+    id: 1
+    dag {
+      nodes {
+        id: 1
+        sorted_children: 2
+      }
+      nodes {
+        id: 2
+        sorted_children: 3
+        sorted_parents: 1
+      }
+      nodes {
+        id: 3
+        sorted_parents: 2
+      }
+    }
+    nodes {
+      id: 1
+      op {
+        op_type: MEMORY_SOURCE_OPERATOR
+        mem_source_op {
+          name: "numbers"
+          column_idxs: 0
+          column_types: INT64
+          column_names: "a"
+          column_idxs: 1
+          column_types: INT64
+          column_names: "b"
+          start_time {
+            value: $0
+          }
+          stop_time {
+            value: $1
+          }
+        }
+      }
+    }
+    nodes {
+      id: 2
+      op {
+        op_type: MAP_OPERATOR
+        map_op {
+          expressions {
+            func {
+              name: "add"
+              id: 7
+              args {
+                column {
+                  node: 1
+                  index: 0
+                }
+              }
+              args {
+                column {
+                  node: 1
+                  index: $2
+                }
+              }
+              args_data_types: INT64
+              args_data_types: INT64
+            }
+          }
+          column_names: "sum"
+        }
+      }
+    }
+    nodes {
+      id: 3
+      op {
+        op_type: MEMORY_SINK_OPERATOR
+        mem_sink_op {
+          name: "out"
+          column_types: INT64
+          column_names: "sum"
+        }
+      }
+    }
+  }
+)proto";
+
+class AddUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(udf::FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+};
+
+planpb::Plan MakePlan(int64_t start_time, int64_t stop_time, int64_t second_arg_idx = 1) {
+  planpb::Plan pb;
+  CHECK(google::protobuf::TextFormat::MergeFromString(
+      absl::Substitute(kPlanTmpl, start_time, stop_time, second_arg_idx), &pb));
+  return pb;
+}
+
+const plan::MemorySourceOperator& MemSource(PreparedPlan* prepared) {
+  return *static_cast<plan::MemorySourceOperator*>(
+      prepared->plan()->nodes().at(1)->nodes().at(1).get());
+}
+
+class PreparedPlanTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    ASSERT_OK(func_registry_->Register<AddUDF>("add"));
+  }
+
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(PreparedPlanTest, RegistersFuncs) {
+  ASSERT_OK_AND_ASSIGN(auto prepared, PreparedPlan::Create(MakePlan(10, 20), func_registry_.get()));
+
+  exec::ExecState exec_state(func_registry_.get(), std::make_shared<table_store::TableStore>(),
+                             exec::MockResultSinkStubGenerator, exec::MockMetricsStubGenerator,
+                             exec::MockTraceStubGenerator, sole::uuid4(), nullptr);
+  prepared->RegisterFuncs(&exec_state);
+  ASSERT_OK_AND_ASSIGN(auto expected, func_registry_->GetScalarUDFDefinition(
+                                          "add", {types::DataType::INT64, types::DataType::INT64}));
+  EXPECT_EQ(expected, exec_state.GetScalarUDFDefinition(7));
+}
+
+TEST_F(PreparedPlanTest, MissingFunc) {
+  udf::Registry empty_registry("empty_registry");
+  EXPECT_NOT_OK(PreparedPlan::Create(MakePlan(10, 20), &empty_registry));
+}
+
+TEST_F(PreparedPlanTest, RebindTimeBounds) {
+  ASSERT_OK_AND_ASSIGN(auto prepared, PreparedPlan::Create(MakePlan(10, 20), func_registry_.get()));
+  EXPECT_EQ(10, MemSource(prepared.get()).start_time());
+  EXPECT_EQ(20, MemSource(prepared.get()).stop_time());
+
+  ASSERT_OK(prepared->RebindTimeBounds(MakePlan(30, 40)));
+  EXPECT_EQ(30, MemSource(prepared.get()).start_time());
+  EXPECT_EQ(40, MemSource(prepared.get()).stop_time());
+}
+
+TEST(PlanCacheTest, KeyIgnoresTimeBounds) {
+  EXPECT_EQ(PlanCache::Key(MakePlan(10, 20)), PlanCache::Key(MakePlan(30, 40)));
+  EXPECT_NE(PlanCache::Key(MakePlan(10, 20)),
+            PlanCache::Key(MakePlan(10, 20, /* second_arg_idx */ 0)));
+
+  planpb::Plan no_stop_time = MakePlan(10, 20);
+  auto* op = no_stop_time.mutable_nodes(0)->mutable_nodes(0)->mutable_op();
+  op->mutable_mem_source_op()->clear_stop_time();
+  EXPECT_NE(PlanCache::Key(MakePlan(10, 20)), PlanCache::Key(no_stop_time));
+}
+
+TEST_F(PreparedPlanTest, CacheAcquireRelease) {
+  PlanCache cache(2);
+  std::string key = PlanCache::Key(MakePlan(10, 20));
+  EXPECT_EQ(nullptr, cache.Acquire(key));
+
+  ASSERT_OK_AND_ASSIGN(auto prepared, PreparedPlan::Create(MakePlan(10, 20), func_registry_.get()));
+  PreparedPlan* prepared_ptr = prepared.get();
+  cache.Release(key, std::move(prepared));
+  EXPECT_EQ(1, cache.size());
+
+  // A prepared plan is only handed out to one query at a time.
+  auto acquired = cache.Acquire(key);
+  EXPECT_EQ(prepared_ptr, acquired.get());
+  EXPECT_EQ(nullptr, cache.Acquire(key));
+  EXPECT_EQ(0, cache.size());
+  cache.Release(key, std::move(acquired));
+
+  // Fill the cache with other plans, which evicts the least recently released one.
+  for (int64_t i = 0; i < 2; ++i) {
+    planpb::Plan other = MakePlan(10, 20, /* second_arg_idx */ 0);
+    other.mutable_nodes(0)->mutable_nodes(2)->mutable_op()->mutable_mem_sink_op()->set_name(
+        absl::StrCat("out", i));
+    ASSERT_OK_AND_ASSIGN(auto other_prepared, PreparedPlan::Create(other, func_registry_.get()));
+    cache.Release(PlanCache::Key(other), std::move(other_prepared));
+  }
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(nullptr, cache.Acquire(key));
+}
+
+TEST_F(PreparedPlanTest, CacheDisabled) {
+  PlanCache cache(0);
+  std::string key = PlanCache::Key(MakePlan(10, 20));
+  ASSERT_OK_AND_ASSIGN(auto prepared, PreparedPlan::Create(MakePlan(10, 20), func_registry_.get()));
+  cache.Release(key, std::move(prepared));
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.Acquire(key));
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -172,6 +172,14 @@ class CompilerState : public NotCopyable {
   const RedactionOptions& redaction_options() { return redaction_options_; }
   void set_redaction_options(const RedactionOptions& options) { redaction_options_ = options; }
 
+  // Whether the distributed planner may split aggregates into a partial aggregate on the agents
+  // and a finalize aggregate on Kelvin. Aggregates that use UDAs without partial support always
+  // run in full on Kelvin, regardless of this setting.
+  bool support_partial_agg() const { return support_partial_agg_; }
+  void set_support_partial_agg(bool support_partial_agg) {
+    support_partial_agg_ = support_partial_agg;
+  }
+
   planpb::OTelEndpointConfig* endpoint_config() { return endpoint_config_.get(); }
   PluginConfig* plugin_config() { return plugin_config_.get(); }
   const DebugInfo& debug_info() { return debug_info_; }
@@ -188,6 +196,7 @@ class CompilerState : public NotCopyable {
   const std::string result_address_;
   const std::string result_ssl_targetname_;
   RedactionOptions redaction_options_;
+  bool support_partial_agg_ = true;
   std::unique_ptr<planpb::OTelEndpointConfig> endpoint_config_ = nullptr;
   std::unique_ptr<PluginConfig> plugin_config_ = nullptr;
   DebugInfo debug_info_;
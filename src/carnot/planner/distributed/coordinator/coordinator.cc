@@ -177,16 +177,224 @@ StatusOr<SchemaToAgentsMap> LoadSchemaMap(
   return agent_schema_map;
 }
 
+/**
+ * A blocking operator on Kelvin that can be split across several Kelvins by hash-partitioning its
+ * input on its key columns: an aggregate with groups, or a join. Each of its parents must be a
+ * GRPCSourceGroup that only feeds this operator, so that the PEMs can shuffle the rows themselves.
+ */
+struct PartitionCandidate {
+  OperatorIR* op;
+  // The source group of each of the op's inputs and the indices of the key columns in it.
+  std::vector<std::pair<GRPCSourceGroupIR*, std::vector<int64_t>>> inputs;
+};
+
+GRPCSourceGroupIR* ExclusiveSourceGroup(OperatorIR* parent) {
+  if (!Match(parent, GRPCSourceGroup()) || parent->Children().size() != 1) {
+    return nullptr;
+  }
+  return static_cast<GRPCSourceGroupIR*>(parent);
+}
+
+// Returns the indices of the key columns in the output of the group, or an empty vector if any
+// of them is missing.
+std::vector<int64_t> KeyColumnIndices(GRPCSourceGroupIR* group,
+                                      const std::vector<ColumnIR*>& keys) {
+  const auto& col_names = group->resolved_table_type()->ColumnNames();
+  std::vector<int64_t> indices;
+  for (ColumnIR* key : keys) {
+    auto it = std::find(col_names.begin(), col_names.end(), key->col_name());
+    if (it == col_names.end()) {
+      return {};
+    }
+    indices.push_back(std::distance(col_names.begin(), it));
+  }
+  return indices;
+}
+
+std::vector<PartitionCandidate> FindPartitionCandidates(IR* kelvin_plan) {
+  // Only the PEM plans are rewritten to shuffle their rows, so a source group fed by a sink in the
+  // Kelvin plan itself would never receive the rows of the other partitions. Leave those whole.
+  absl::flat_hash_set<int64_t> kelvin_bridge_ids;
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+    kelvin_bridge_ids.insert(static_cast<GRPCSinkIR*>(node)->destination_id());
+  }
+  auto exclusive_pem_source_group = [&kelvin_bridge_ids](OperatorIR* parent) {
+    GRPCSourceGroupIR* group = ExclusiveSourceGroup(parent);
+    if (group == nullptr || kelvin_bridge_ids.contains(group->source_id())) {
+      return static_cast<GRPCSourceGroupIR*>(nullptr);
+    }
+    return group;
+  };
+
+  std::vector<PartitionCandidate> candidates;
+  for (IRNode* node : kelvin_plan->FindNodesThatMatch(BlockingAgg())) {
+    auto agg = static_cast<BlockingAggIR*>(node);
+    if (agg->group_by_all()) {
+      continue;
+    }
+    GRPCSourceGroupIR* group = exclusive_pem_source_group(agg->parents()[0]);
+    if (group == nullptr) {
+      continue;
+    }
+    auto indices = KeyColumnIndices(group, agg->groups());
+    if (indices.empty()) {
+      continue;
+    }
+    candidates.push_back({agg, {{group, std::move(indices)}}});
+  }
+
+  for (IRNode* node : kelvin_plan->FindNodesThatMatch(Join())) {
+    auto join = static_cast<JoinIR*>(node);
+    if (join->parents().size() != 2 || join->parents()[0] == join->parents()[1]) {
+      continue;
+    }
+    // Split the key columns by the parent they refer to, keeping the left/right pairs aligned.
+    std::vector<std::vector<ColumnIR*>> parent_keys(2);
+    for (ColumnIR* col : join->left_on_columns()) {
+      parent_keys[col->container_op_parent_idx()].push_back(col);
+    }
+    for (ColumnIR* col : join->right_on_columns()) {
+      parent_keys[col->container_op_parent_idx()].push_back(col);
+    }
+    PartitionCandidate candidate{join, {}};
+    for (const auto& [i, parent] : Enumerate(join->parents())) {
+      GRPCSourceGroupIR* group = exclusive_pem_source_group(parent);
+      if (group == nullptr || parent_keys[i].size() != join->left_on_columns().size()) {
+        break;
+      }
+      auto indices = KeyColumnIndices(group, parent_keys[i]);
+      if (indices.empty()) {
+        break;
+      }
+      candidate.inputs.emplace_back(group, std::move(indices));
+    }
+    if (candidate.inputs.size() == 2) {
+      candidates.push_back(std::move(candidate));
+    }
+  }
+  return candidates;
+}
+
+// Moves the children of op behind a new GRPC bridge, so that the partitions of op that run on
+// other Kelvins can send their results back to the Kelvin that runs the rest of the plan.
+StatusOr<GRPCSinkIR*> AddGatherBridge(OperatorIR* op, int64_t bridge_id) {
+  DCHECK(op->is_type_resolved()) << op->DebugString();
+  IR* graph = op->graph();
+  std::vector<OperatorIR*> children = op->Children();
+  PX_ASSIGN_OR_RETURN(GRPCSinkIR * grpc_sink,
+                      graph->CreateNode<GRPCSinkIR>(op->ast(), op, bridge_id));
+  PX_RETURN_IF_ERROR(grpc_sink->SetResolvedType(op->resolved_type()));
+  PX_ASSIGN_OR_RETURN(GRPCSourceGroupIR * grpc_source_group,
+                      graph->CreateNode<GRPCSourceGroupIR>(op->ast(), bridge_id,
+                                                           op->resolved_type()));
+  for (OperatorIR* child : children) {
+    PX_RETURN_IF_ERROR(child->ReplaceParent(op, grpc_source_group));
+  }
+  return grpc_sink;
+}
+
+int64_t NextBridgeID(const IR* plan) {
+  int64_t max_id = -1;
+  for (IRNode* node : plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+    max_id = std::max(max_id, static_cast<GRPCSinkIR*>(node)->destination_id());
+  }
+  for (IRNode* node : plan->FindNodesOfType(IRNodeType::kGRPCSourceGroup)) {
+    max_id = std::max(max_id, static_cast<GRPCSourceGroupIR*>(node)->source_id());
+  }
+  return max_id + 1;
+}
+
+/**
+ * Splits the blocking operators of the Kelvin plan that are fed directly by the PEMs across all of
+ * the Kelvins. The PEMs hash-partition the rows they send on the operators' keys, each Kelvin runs
+ * the operators on its own partition, and the partitions are gathered back on the main Kelvin,
+ * which runs the first partition and the rest of the plan. `partition_kelvin_infos` are the
+ * Kelvins that run the other partitions; none of them may already be in the distributed plan.
+ */
+Status PartitionAcrossKelvins(const std::vector<distributedpb::CarnotInfo>& partition_kelvin_infos,
+                              int64_t next_bridge_id, DistributedPlan* distributed_plan) {
+  CarnotInstance* kelvin = distributed_plan->kelvin();
+  IR* kelvin_plan = kelvin->plan();
+  auto candidates = FindPartitionCandidates(kelvin_plan);
+  if (partition_kelvin_infos.empty() || candidates.empty()) {
+    return Status::OK();
+  }
+
+  absl::flat_hash_set<int64_t> partition_op_ids;
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> bridge_id_to_partition_columns;
+  for (const auto& candidate : candidates) {
+    PX_ASSIGN_OR_RETURN(GRPCSinkIR * gather_sink, AddGatherBridge(candidate.op, next_bridge_id));
+    ++next_bridge_id;
+    partition_op_ids.insert({candidate.op->id(), gather_sink->id()});
+    for (const auto& [group, partition_columns] : candidate.inputs) {
+      partition_op_ids.insert(group->id());
+      bridge_id_to_partition_columns[group->source_id()] = partition_columns;
+    }
+  }
+
+  // Each of the other Kelvins runs a copy of the partitioned operators on its own partition. The
+  // main Kelvin runs partition 0.
+  for (const auto& [i, kelvin_info] : Enumerate(partition_kelvin_infos)) {
+    PX_ASSIGN_OR_RETURN(int64_t partition_kelvin_id, distributed_plan->AddCarnot(kelvin_info));
+    PX_ASSIGN_OR_RETURN(std::unique_ptr<IR> partition_plan_uptr, kelvin_plan->Clone());
+    IR* partition_plan = partition_plan_uptr.get();
+    std::vector<int64_t> op_ids;
+    for (IRNode* node : partition_plan->FindNodesThatMatch(Operator())) {
+      op_ids.push_back(node->id());
+    }
+    for (int64_t op_id : op_ids) {
+      // Operators are deleted along with their subtree, so some may already be gone.
+      if (partition_op_ids.contains(op_id) || !partition_plan->HasNode(op_id)) {
+        continue;
+      }
+      PX_RETURN_IF_ERROR(partition_plan->DeleteSubtree(op_id));
+    }
+    for (IRNode* node : partition_plan->FindNodesOfType(IRNodeType::kGRPCSourceGroup)) {
+      static_cast<GRPCSourceGroupIR*>(node)->SetPartitionIndex(i + 1);
+    }
+
+    CarnotInstance* partition_kelvin = distributed_plan->Get(partition_kelvin_id);
+    partition_kelvin->AddPlan(partition_plan);
+    distributed_plan->AddPlan(std::move(partition_plan_uptr));
+    distributed_plan->AddPartitionKelvin(partition_kelvin);
+    distributed_plan->AddEdge(partition_kelvin, kelvin);
+  }
+
+  // The PEMs shuffle the input of the partitioned operators across all of the Kelvins.
+  for (const auto& [pem_plan, agents] : distributed_plan->plan_to_agent_map()) {
+    bool sends_partitions = false;
+    for (IRNode* node : pem_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+      auto grpc_sink = static_cast<GRPCSinkIR*>(node);
+      auto it = bridge_id_to_partition_columns.find(grpc_sink->destination_id());
+      if (it == bridge_id_to_partition_columns.end()) {
+        continue;
+      }
+      grpc_sink->SetPartitionColumns(it->second);
+      sends_partitions = true;
+    }
+    if (!sends_partitions) {
+      continue;
+    }
+    for (int64_t agent : agents) {
+      for (CarnotInstance* partition_kelvin : distributed_plan->partition_kelvins()) {
+        distributed_plan->AddEdge(agent, partition_kelvin->id());
+      }
+    }
+  }
+  return Status::OK();
+}
+
 StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const IR* logical_plan) {
-  // TODO(zasgar) set support_partial_agg to true to enable partial aggs.
+  // Aggregates are split into a partial agg on the PEMs and a finalize agg on Kelvin, so that
+  // the PEMs ship serialized UDA state rather than raw rows. Aggregates with any UDA that doesn't
+  // support partial aggregation are left whole and run on Kelvin.
   PX_ASSIGN_OR_RETURN(std::unique_ptr<Splitter> splitter,
-                      Splitter::Create(compiler_state_, /* support_partial_agg */ false));
+                      Splitter::Create(compiler_state_, compiler_state_->support_partial_agg()));
   PX_ASSIGN_OR_RETURN(std::unique_ptr<BlockingSplitPlan> split_plan,
                       splitter->SplitKelvinAndAgents(logical_plan));
   auto distributed_plan = std::make_unique<DistributedPlan>();
   PX_ASSIGN_OR_RETURN(int64_t remote_node_id, distributed_plan->AddCarnot(GetRemoteProcessor()));
   // TODO(philkuz) Need to update the Blocking Split Plan to better represent what we expect.
-  // TODO(philkuz) (PL-1469) Future support for grabbing data from multiple Kelvin nodes.
 
   PX_ASSIGN_OR_RETURN(std::unique_ptr<IR> remote_plan_uptr, split_plan->original_plan->Clone());
   CarnotInstance* remote_carnot = distributed_plan->Get(remote_node_id);
@@ -229,6 +437,19 @@ StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const
   distributed_plan->SetKelvin(remote_carnot);
   distributed_plan->AddPlanToAgentMap(std::move(agent_to_plan_map.plan_to_agents));
 
+  // Any remote processor other than the main Kelvin can run a partition, unless it is also a data
+  // store, in which case it already runs a PEM plan.
+  std::vector<distributedpb::CarnotInfo> partition_kelvin_infos;
+  for (const auto& info : remote_processor_nodes_) {
+    if (info.agent_id() == GetRemoteProcessor().agent_id() || info.has_data_store()) {
+      continue;
+    }
+    partition_kelvin_infos.push_back(info);
+  }
+  PX_RETURN_IF_ERROR(PartitionAcrossKelvins(partition_kelvin_infos,
+                                            NextBridgeID(split_plan->original_plan.get()),
+                                            distributed_plan.get()));
+
   return distributed_plan;
 }
 
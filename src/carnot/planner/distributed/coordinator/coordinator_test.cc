@@ -639,6 +639,193 @@ TEST_F(CoordinatorTest, delete_dependent_nodes) {
   EXPECT_TRUE(plan_by_qb_addr.contains("pem1"));
 }
 
+constexpr char kPartialAggQuery[] = R"pxl(
+import px
+
+df = px.DataFrame(table='http_events', start_time='-120s')
+df = df.groupby('upid').agg(latency=('resp_latency_ns', px.mean),
+                            count=('resp_latency_ns', px.count))
+px.display(df, 'out')
+)pxl";
+
+TEST_F(CoordinatorTest, partial_agg_on_pems) {
+  auto physical_plan = ThreeAgentOneKelvinCoordinateQuery(kPartialAggQuery);
+
+  for (int64_t carnot_id : physical_plan->dag().nodes()) {
+    auto carnot = physical_plan->Get(carnot_id);
+    SCOPED_TRACE(carnot->QueryBrokerAddress());
+    if (carnot->QueryBrokerAddress() == "kelvin") {
+      EXPECT_EQ(1, carnot->plan()->FindNodesThatMatch(FinalizeAgg()).size());
+      EXPECT_EQ(0, carnot->plan()->FindNodesThatMatch(PartialAgg()).size());
+      continue;
+    }
+    auto partial_aggs = carnot->plan()->FindNodesThatMatch(PartialAgg());
+    ASSERT_EQ(1, partial_aggs.size());
+    auto partial_agg = static_cast<BlockingAggIR*>(partial_aggs[0]);
+    ASSERT_EQ(1, partial_agg->Children().size());
+    EXPECT_MATCH(partial_agg->Children()[0], GRPCSink());
+  }
+}
+
+TEST_F(CoordinatorTest, partial_agg_disabled) {
+  compiler_state_->set_support_partial_agg(false);
+  auto physical_plan = ThreeAgentOneKelvinCoordinateQuery(kPartialAggQuery);
+
+  for (int64_t carnot_id : physical_plan->dag().nodes()) {
+    auto carnot = physical_plan->Get(carnot_id);
+    SCOPED_TRACE(carnot->QueryBrokerAddress());
+    EXPECT_EQ(0, carnot->plan()->FindNodesThatMatch(PartialAgg()).size());
+    EXPECT_EQ(0, carnot->plan()->FindNodesThatMatch(FinalizeAgg()).size());
+    if (carnot->QueryBrokerAddress() == "kelvin") {
+      EXPECT_EQ(1, carnot->plan()->FindNodesThatMatch(BlockingAgg()).size());
+    }
+  }
+}
+
+constexpr char kNonPartialAggQuery[] = R"pxl(
+import px
+
+df = px.DataFrame(table='http_events', start_time='-120s')
+df = df.groupby('upid').agg(latency=('resp_latency_ns', px.mean),
+                            path=('req_path', px.sample))
+px.display(df, 'out')
+)pxl";
+
+TEST_F(CoordinatorTest, non_partial_uda_falls_back_to_kelvin_agg) {
+  // px.sample doesn't support partial aggregation, so the whole agg must run on Kelvin.
+  auto physical_plan = ThreeAgentOneKelvinCoordinateQuery(kNonPartialAggQuery);
+
+  for (int64_t carnot_id : physical_plan->dag().nodes()) {
+    auto carnot = physical_plan->Get(carnot_id);
+    SCOPED_TRACE(carnot->QueryBrokerAddress());
+    if (carnot->QueryBrokerAddress() == "kelvin") {
+      auto aggs = carnot->plan()->FindNodesThatMatch(BlockingAgg());
+      ASSERT_EQ(1, aggs.size());
+      auto agg = static_cast<BlockingAggIR*>(aggs[0]);
+      EXPECT_TRUE(agg->partial_agg());
+      EXPECT_TRUE(agg->finalize_results());
+      continue;
+    }
+    EXPECT_EQ(0, carnot->plan()->FindNodesThatMatch(BlockingAgg()).size());
+  }
+}
+
+constexpr char kExtraKelvins[] = R"carnotinfo(
+carnot_info {
+  query_broker_address: "kelvin2"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000006
+  }
+  grpc_address: "1112"
+  has_grpc_server: true
+  has_data_store: false
+  processes_data: true
+  accepts_remote_sources: true
+  asid: 457
+  ssl_targetname: "kelvin.pl.svc"
+}
+carnot_info {
+  query_broker_address: "kelvin3"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000007
+  }
+  grpc_address: "1113"
+  has_grpc_server: true
+  has_data_store: false
+  processes_data: true
+  accepts_remote_sources: true
+  asid: 458
+  ssl_targetname: "kelvin.pl.svc"
+}
+)carnotinfo";
+
+TEST_F(CoordinatorTest, agg_partitioned_across_kelvins) {
+  auto ps = ThreeAgentOneKelvinStateWithMetadataInfo();
+  EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(kExtraKelvins, &ps));
+
+  auto coordinator = Coordinator::Create(compiler_state_.get(), ps).ConsumeValueOrDie();
+  compiler::Compiler compiler;
+  auto graph =
+      compiler.CompileToIR(kPartialAggQuery, compiler_state_.get()).ConsumeValueOrDie();
+  auto physical_plan = coordinator->Coordinate(graph.get()).ConsumeValueOrDie();
+
+  ASSERT_EQ(2, physical_plan->partition_kelvins().size());
+  for (CarnotInstance* partition_kelvin : physical_plan->partition_kelvins()) {
+    SCOPED_TRACE(partition_kelvin->QueryBrokerAddress());
+    EXPECT_THAT(partition_kelvin->QueryBrokerAddress(), ContainsRegex("kelvin[23]"));
+    EXPECT_THAT(physical_plan->dag().DependenciesOf(partition_kelvin->id()),
+                ElementsAre(physical_plan->kelvin()->id()));
+
+    // The partition Kelvins only run the finalize agg and send its output back.
+    IR* plan = partition_kelvin->plan();
+    EXPECT_EQ(3, plan->FindNodesThatMatch(Operator()).size());
+    auto aggs = plan->FindNodesThatMatch(FinalizeAgg());
+    ASSERT_EQ(1, aggs.size());
+    auto agg = static_cast<BlockingAggIR*>(aggs[0]);
+    EXPECT_MATCH(agg->parents()[0], GRPCSourceGroup());
+    ASSERT_EQ(1, agg->Children().size());
+    EXPECT_MATCH(agg->Children()[0], GRPCSink());
+  }
+
+  // The main Kelvin runs the first partition and gathers the others before the output sink.
+  IR* kelvin_plan = physical_plan->kelvin()->plan();
+  auto aggs = kelvin_plan->FindNodesThatMatch(FinalizeAgg());
+  ASSERT_EQ(1, aggs.size());
+  auto agg = static_cast<BlockingAggIR*>(aggs[0]);
+  ASSERT_EQ(1, agg->Children().size());
+  EXPECT_MATCH(agg->Children()[0], GRPCSink());
+  EXPECT_EQ(2, kelvin_plan->FindNodesThatMatch(GRPCSourceGroup()).size());
+
+  for (const auto& [pem_plan, agents] : physical_plan->plan_to_agent_map()) {
+    auto sinks = pem_plan->FindNodesThatMatch(GRPCSink());
+    ASSERT_EQ(1, sinks.size());
+    auto sink = static_cast<GRPCSinkIR*>(sinks[0]);
+    ASSERT_TRUE(sink->is_partitioned());
+    // The partial agg outputs the group column first.
+    EXPECT_THAT(sink->partition_columns(), ElementsAre(0));
+    for (int64_t agent : agents) {
+      EXPECT_EQ(3, physical_plan->dag().DependenciesOf(agent).size());
+    }
+  }
+}
+
+constexpr char kDataStoreKelvin[] = R"carnotinfo(
+carnot_info {
+  query_broker_address: "kelvin4"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000008
+  }
+  grpc_address: "1114"
+  has_grpc_server: true
+  has_data_store: true
+  processes_data: true
+  accepts_remote_sources: true
+  asid: 459
+  ssl_targetname: "kelvin.pl.svc"
+}
+)carnotinfo";
+
+TEST_F(CoordinatorTest, partition_kelvins_skip_data_stores) {
+  auto ps = ThreeAgentOneKelvinStateWithMetadataInfo();
+  EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(kExtraKelvins, &ps));
+  EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(kDataStoreKelvin, &ps));
+
+  auto coordinator = Coordinator::Create(compiler_state_.get(), ps).ConsumeValueOrDie();
+  compiler::Compiler compiler;
+  auto graph =
+      compiler.CompileToIR(kPartialAggQuery, compiler_state_.get()).ConsumeValueOrDie();
+  auto physical_plan = coordinator->Coordinate(graph.get()).ConsumeValueOrDie();
+
+  // The Kelvin that is also a data store already runs a PEM plan, so it doesn't get a partition.
+  ASSERT_EQ(2, physical_plan->partition_kelvins().size());
+  for (CarnotInstance* partition_kelvin : physical_plan->partition_kelvins()) {
+    EXPECT_THAT(partition_kelvin->QueryBrokerAddress(), ContainsRegex("kelvin[23]"));
+  }
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -49,23 +49,41 @@ Status StitchPlan(DistributedPlan* distributed_plan) {
   IR* remote_plan = remote_carnot->plan();
   DCHECK(remote_plan);
 
+  std::vector<CarnotInstance*> kelvins{remote_carnot};
+  const auto& partition_kelvins = distributed_plan->partition_kelvins();
+  kelvins.insert(kelvins.end(), partition_kelvins.begin(), partition_kelvins.end());
+
   DistributedSetSourceGroupGRPCAddressRule set_grpc_address_rule;
-  PX_RETURN_IF_ERROR(set_grpc_address_rule.Apply(remote_carnot));
+  for (CarnotInstance* kelvin : kelvins) {
+    PX_RETURN_IF_ERROR(set_grpc_address_rule.Apply(kelvin));
+  }
 
   // Connect the plans.
   for (const auto& [plan, agents] : distributed_plan->plan_to_agent_map()) {
-    PX_ASSIGN_OR_RETURN(auto did_connect_plan, AssociateDistributedPlanEdgesRule::ConnectGraphs(
-                                                   plan, agents, remote_plan));
+    bool did_connect_plan = false;
+    for (CarnotInstance* kelvin : kelvins) {
+      PX_ASSIGN_OR_RETURN(auto did_connect_kelvin, AssociateDistributedPlanEdgesRule::ConnectGraphs(
+                                                       plan, agents, kelvin->plan()));
+      did_connect_plan |= did_connect_kelvin;
+    }
     DCHECK(did_connect_plan);
   }
 
+  // The partition Kelvins send their results back to the Kelvin that runs the rest of the plan.
+  for (CarnotInstance* kelvin : partition_kelvins) {
+    PX_RETURN_IF_ERROR(AssociateDistributedPlanEdgesRule::ConnectGraphs(
+        kelvin->plan(), {kelvin->id()}, remote_plan));
+  }
+
   // TODO(philkuz) make this connect to self without a grpc bridge.
   PX_RETURN_IF_ERROR(
       AssociateDistributedPlanEdgesRule::ConnectGraphs(remote_plan, {remote_node_id}, remote_plan));
 
-  // Expand GRPCSourceGroups in the remote_plan.
+  // Expand GRPCSourceGroups in the Kelvin plans.
   GRPCSourceGroupConversionRule conversion_rule;
-  PX_RETURN_IF_ERROR(conversion_rule.Execute(remote_plan));
+  for (CarnotInstance* kelvin : kelvins) {
+    PX_RETURN_IF_ERROR(conversion_rule.Execute(kelvin->plan()));
+  }
   return MergeSameNodeGRPCBridgeRule(remote_node_id).Execute(remote_plan).status();
 }
 
@@ -20,9 +20,11 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/strings/match.h>
 #include <pypa/parser/parser.hh>
 
 #include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
@@ -398,6 +400,85 @@ TEST_F(DistributedRulesTest, init_args) {
   EXPECT_OK(distributed_plan_or_s);
 }
 
+constexpr char kGroupByQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-120s')
+df = df.groupby('upid').agg(latency=('resp_latency_ns', px.mean))
+px.display(df, 'out')
+)pxl";
+
+constexpr char kPartitionKelvins[] = R"proto(
+carnot_info {
+  query_broker_address: "kelvin2"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000006
+  }
+  grpc_address: "1112"
+  has_grpc_server: true
+  has_data_store: false
+  processes_data: true
+  accepts_remote_sources: true
+  ssl_targetname: "kelvin.pl.svc"
+}
+carnot_info {
+  query_broker_address: "kelvin3"
+  agent_id {
+    high_bits: 0x0000000100000000
+    low_bits: 0x0000000000000007
+  }
+  grpc_address: "1113"
+  has_grpc_server: true
+  has_data_store: false
+  processes_data: true
+  accepts_remote_sources: true
+  ssl_targetname: "kelvin.pl.svc"
+}
+)proto";
+
+TEST_F(DistributedRulesTest, agg_shuffled_across_kelvins) {
+  auto ps = ThreeAgentOneKelvinStateWithMetadataInfo();
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kPartitionKelvins, &ps));
+
+  compiler::Compiler compiler;
+  auto single_node_plan =
+      compiler.CompileToIR(kGroupByQuery, compiler_state_.get()).ConsumeValueOrDie();
+  auto distributed_planner = distributed::DistributedPlanner::Create().ConsumeValueOrDie();
+  auto distributed_plan =
+      distributed_planner->Plan(ps, compiler_state_.get(), single_node_plan.get())
+          .ConsumeValueOrDie();
+  auto plan_pb = distributed_plan->ToProto().ConsumeValueOrDie();
+
+  for (const auto& [qb_address, agent_plan] : plan_pb.qb_address_to_plan()) {
+    SCOPED_TRACE(qb_address);
+    std::vector<planpb::GRPCSinkOperator> internal_sinks;
+    for (const auto& op : agent_plan.nodes(0).nodes()) {
+      if (op.op().op_type() == planpb::GRPC_SINK_OPERATOR &&
+          !op.op().grpc_sink_op().has_output_table()) {
+        internal_sinks.push_back(op.op().grpc_sink_op());
+      }
+    }
+    if (qb_address == "kelvin") {
+      // The first partition is merged into the main Kelvin plan without a GRPC bridge.
+      EXPECT_EQ(0, internal_sinks.size());
+      continue;
+    }
+    ASSERT_EQ(1, internal_sinks.size());
+    if (absl::StartsWith(qb_address, "kelvin")) {
+      EXPECT_EQ("1111", internal_sinks[0].address());
+      EXPECT_EQ(0, internal_sinks[0].partitioned_destinations_size());
+      continue;
+    }
+    // Each PEM splits its partial aggregates between the three Kelvins.
+    EXPECT_THAT(internal_sinks[0].partition_columns(), ElementsAre(0));
+    std::vector<std::string> addresses;
+    for (const auto& dest : internal_sinks[0].partitioned_destinations()) {
+      addresses.push_back(dest.address());
+    }
+    EXPECT_THAT(addresses, ElementsAre("1111", "1112", "1113"));
+  }
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -31,9 +31,26 @@ Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
   destination_ssl_targetname_ = grpc_sink->destination_ssl_targetname_;
   name_ = grpc_sink->name_;
   out_columns_ = grpc_sink->out_columns_;
+  partition_columns_ = grpc_sink->partition_columns_;
   return Status::OK();
 }
 
+void GRPCSinkIR::SetPartitionDestination(int64_t partition, const std::string& address,
+                                         std::string_view ssl_targetname) {
+  DCHECK_GE(partition, 0);
+  if (partition >= num_partitions()) {
+    partition_destinations_.resize(partition + 1);
+  }
+  partition_destinations_[partition].address = address;
+  partition_destinations_[partition].ssl_targetname = ssl_targetname;
+}
+
+void GRPCSinkIR::AddPartitionDestinationIDMap(int64_t partition, int64_t destination_id,
+                                              int64_t agent_id) {
+  DCHECK_LT(partition, num_partitions());
+  partition_destinations_[partition].agent_id_to_destination_id[agent_id] = destination_id;
+}
+
 Status GRPCSinkIR::ToProto(planpb::Operator* op) const {
   CHECK(has_output_table());
   auto pb = op->mutable_grpc_sink_op();
@@ -56,6 +73,22 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op) const {
 Status GRPCSinkIR::ToProto(planpb::Operator* op, int64_t agent_id) const {
   auto pb = op->mutable_grpc_sink_op();
   op->set_op_type(planpb::GRPC_SINK_OPERATOR);
+  if (is_partitioned()) {
+    for (int64_t col : partition_columns_) {
+      pb->add_partition_columns(col);
+    }
+    for (const auto& [i, partition] : Enumerate(partition_destinations_)) {
+      if (!partition.agent_id_to_destination_id.contains(agent_id)) {
+        return CreateIRNodeError("No agent ID '$0' found for partition $1 of grpc sink '$2'",
+                                 agent_id, i, DebugString());
+      }
+      auto dest = pb->add_partitioned_destinations();
+      dest->set_address(partition.address);
+      dest->set_grpc_source_id(partition.agent_id_to_destination_id.find(agent_id)->second);
+      dest->mutable_connection_options()->set_ssl_targetname(partition.ssl_targetname);
+    }
+    return Status::OK();
+  }
   pb->set_address(destination_address());
   pb->mutable_connection_options()->set_ssl_targetname(destination_ssl_targetname());
   if (!agent_id_to_destination_id_.contains(agent_id)) {
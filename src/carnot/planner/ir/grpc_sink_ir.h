@@ -42,6 +42,9 @@ namespace planner {
  * 0. Init(int destination_id): Set the destination id.
  * 1. SetDistributedID(string): Set the name of the node same as the query broker.
  * 2. SetDestinationAddress(string): the GRPC address where batches should be sent.
+ *
+ * A partitioned sink instead has one destination per partition, set with
+ * SetPartitionDestination(), and splits its batches between them on the partition columns.
  */
 class GRPCSinkIR : public OperatorIR {
  public:
@@ -138,6 +141,21 @@ class GRPCSinkIR : public OperatorIR {
     return agent_id_to_destination_id_;
   }
 
+  /**
+   * @brief Partitioned sinks hash each row on the partition columns and send it to one of several
+   * GRPC Sources, one per partition, instead of sending everything to a single destination.
+   */
+  void SetPartitionColumns(const std::vector<int64_t>& partition_columns) {
+    partition_columns_ = partition_columns;
+  }
+  bool is_partitioned() const { return !partition_columns_.empty(); }
+  const std::vector<int64_t>& partition_columns() const { return partition_columns_; }
+  int64_t num_partitions() const { return partition_destinations_.size(); }
+
+  void SetPartitionDestination(int64_t partition, const std::string& address,
+                               std::string_view ssl_targetname);
+  void AddPartitionDestinationIDMap(int64_t partition, int64_t destination_id, int64_t agent_id);
+
  protected:
   Status CopyFromNodeImpl(const IRNode* node,
                           absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
@@ -156,6 +174,15 @@ class GRPCSinkIR : public OperatorIR {
   std::string name_;
   std::vector<std::string> out_columns_;
   absl::flat_hash_map<int64_t, int64_t> agent_id_to_destination_id_;
+
+  struct PartitionDestination {
+    std::string address;
+    std::string ssl_targetname;
+    absl::flat_hash_map<int64_t, int64_t> agent_id_to_destination_id;
+  };
+  // Used when the sink is partitioned, in place of the single destination above.
+  std::vector<int64_t> partition_columns_;
+  std::vector<PartitionDestination> partition_destinations_;
 };
 
 }  // namespace planner
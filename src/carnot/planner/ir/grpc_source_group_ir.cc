@@ -27,6 +27,7 @@ Status GRPCSourceGroupIR::CopyFromNodeImpl(const IRNode* node,
   const GRPCSourceGroupIR* grpc_source_group = static_cast<const GRPCSourceGroupIR*>(node);
   source_id_ = grpc_source_group->source_id_;
   grpc_address_ = grpc_source_group->grpc_address_;
+  partition_index_ = grpc_source_group->partition_index_;
   if (grpc_source_group->dependent_sinks_.size()) {
     return error::Unimplemented("Cannot clone GRPCSourceGroupIR with dependent_sinks_");
   }
@@ -58,8 +59,12 @@ Status GRPCSourceGroupIR::AddGRPCSink(GRPCSinkIR* sink_op,
     return DExitOrIRNodeError("$0 doesn't have a physical agent associated with it.",
                               DebugString());
   }
-  sink_op->SetDestinationAddress(grpc_address_);
-  sink_op->SetDestinationSSLTargetName(ssl_targetname_);
+  if (sink_op->is_partitioned()) {
+    sink_op->SetPartitionDestination(partition_index_, grpc_address_, ssl_targetname_);
+  } else {
+    sink_op->SetDestinationAddress(grpc_address_);
+    sink_op->SetDestinationSSLTargetName(ssl_targetname_);
+  }
   dependent_sinks_.emplace_back(sink_op, agents);
   return Status::OK();
 }
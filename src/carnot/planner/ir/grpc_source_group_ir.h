@@ -74,6 +74,11 @@ class GRPCSourceGroupIR : public OperatorIR {
   bool GRPCAddressSet() const { return grpc_address_ != ""; }
   const std::string& grpc_address() const { return grpc_address_; }
   int64_t source_id() const { return source_id_; }
+
+  // The partition of a partitioned GRPCSink that this group receives. Only meaningful when the
+  // sinks feeding this group are partitioned.
+  void SetPartitionIndex(int64_t partition_index) { partition_index_ = partition_index; }
+  int64_t partition_index() const { return partition_index_; }
   const std::vector<std::pair<GRPCSinkIR*, absl::flat_hash_set<int64_t>>>& dependent_sinks() {
     return dependent_sinks_;
   }
@@ -99,6 +104,7 @@ class GRPCSourceGroupIR : public OperatorIR {
   int64_t source_id_ = -1;
   std::string grpc_address_ = "";
   std::string ssl_targetname_ = "";
+  int64_t partition_index_ = 0;
   std::vector<std::pair<GRPCSinkIR*, absl::flat_hash_set<int64_t>>> dependent_sinks_;
 };
 }  // namespace planner
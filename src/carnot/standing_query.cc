@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/standing_query.h"
+
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/dag/dag.h"
+#include "src/carnot/plan/plan.h"
+
+namespace px {
+namespace carnot {
+
+namespace {
+
+// Rewrites the plan so that it runs across periods: the memory sources stream from the plan's
+// start time on, and each aggregate either keeps its state across periods or starts over every
+// period. Operators whose results depend on seeing the whole input at once, or that would end the
+// query after the first period, are rejected rather than silently changing the query's results.
+//
+// Every node outputs either the rows of the current period, or the cumulative results of an
+// aggregate, which it re-emits every period. A blocking aggregate over the rows of each period
+// keeps its state across periods, so that every period it emits the results the one-shot query
+// would compute over all of the data since the start time. An aggregate over cumulative results
+// sees all of its input again every period, so it starts over every period instead.
+Status ToStandingPlan(planpb::Plan* plan) {
+  for (auto& pf : *plan->mutable_nodes()) {
+    absl::flat_hash_map<int64_t, planpb::PlanNode*> nodes;
+    for (auto& node : *pf.mutable_nodes()) {
+      nodes[node.id()] = &node;
+    }
+    dag::DAG dag;
+    dag.Init(pf.dag());
+    // Whether each node outputs cumulative results rather than the rows of the current period.
+    absl::flat_hash_map<int64_t, bool> cumulative_output;
+    for (int64_t id : dag.TopologicalSort()) {
+      auto it = nodes.find(id);
+      if (it == nodes.end()) {
+        return error::Internal("Node $0 of plan fragment $1 is missing from its nodes.", id,
+                               pf.id());
+      }
+      auto* op = it->second->mutable_op();
+      std::vector<int64_t> parents = dag.ParentsOf(id);
+      bool cumulative = !parents.empty() && cumulative_output[parents[0]];
+      for (int64_t parent : parents) {
+        if (cumulative_output[parent] != cumulative) {
+          return error::InvalidArgument(
+              "Standing queries can't combine the cumulative results of an aggregate with the rows "
+              "of each period, but node $0 of plan fragment $1 takes both as inputs.",
+              id, pf.id());
+        }
+      }
+
+      switch (op->op_type()) {
+        case planpb::MEMORY_SOURCE_OPERATOR:
+          // A stop time would end the source's stream after the period that reaches it.
+          if (op->mem_source_op().has_stop_time()) {
+            return error::InvalidArgument(
+                "Standing queries don't support bounded sources, but memory source $0 of plan "
+                "fragment $1 has a stop time.",
+                id, pf.id());
+          }
+          op->mutable_mem_source_op()->set_streaming(true);
+          break;
+        case planpb::AGGREGATE_OPERATOR:
+          if (cumulative) {
+            op->mutable_agg_op()->set_windowed(true);
+          } else if (!op->agg_op().windowed()) {
+            op->mutable_agg_op()->set_cumulative(true);
+            cumulative = true;
+          }
+          break;
+        case planpb::JOIN_OPERATOR:
+          return error::InvalidArgument(
+              "Standing queries don't support joins, which would buffer their inputs across "
+              "periods, but node $0 of plan fragment $1 is a join.",
+              id, pf.id());
+        case planpb::LIMIT_OPERATOR:
+          return error::InvalidArgument(
+              "Standing queries don't support limits, which would end the query after the first "
+              "period, but node $0 of plan fragment $1 is a limit.",
+              id, pf.id());
+        case planpb::GRPC_SOURCE_OPERATOR:
+        case planpb::UDTF_SOURCE_OPERATOR:
+        case planpb::EMPTY_SOURCE_OPERATOR:
+          return error::InvalidArgument(
+              "Standing queries only support memory sources, but node $0 of plan fragment $1 is a "
+              "$2.",
+              id, pf.id(), planpb::OperatorType_Name(op->op_type()));
+        default:
+          break;
+      }
+      cumulative_output[id] = cumulative;
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<StandingQuery>> StandingQuery::Create(
+    const planpb::Plan& plan, const sole::uuid& query_id, EngineState* engine_state,
+    std::shared_ptr<const md::AgentMetadataState> metadata_state) {
+  planpb::Plan standing_plan = plan;
+  PX_RETURN_IF_ERROR(ToStandingPlan(&standing_plan));
+
+  std::unique_ptr<StandingQuery> query(new StandingQuery());
+  PX_ASSIGN_OR_RETURN(query->prepared_,
+                      PreparedPlan::Create(standing_plan, engine_state->func_registry()));
+  query->exec_state_ = engine_state->CreateExecState(query_id);
+  if (metadata_state != nullptr) {
+    query->exec_state_->set_metadata_state(metadata_state);
+  }
+  query->prepared_->RegisterFuncs(query->exec_state_.get());
+  query->plan_state_ = engine_state->CreatePlanState();
+  query->schema_ = std::make_unique<table_store::schema::Schema>();
+
+  PX_RETURN_IF_ERROR(plan::PlanWalker()
+                         .OnPlanFragment([&](plan::PlanFragment* pf) {
+                           auto exec_graph = std::make_unique<exec::ExecutionGraph>();
+                           PX_RETURN_IF_ERROR(exec_graph->Init(
+                               query->schema_.get(), query->plan_state_.get(),
+                               query->exec_state_.get(), pf, /* collect_exec_node_stats */ false));
+                           PX_RETURN_IF_ERROR(exec_graph->Open());
+                           query->exec_graphs_.push_back(std::move(exec_graph));
+                           return Status::OK();
+                         })
+                         .Walk(query->prepared_->plan()));
+  return query;
+}
+
+StandingQuery::~StandingQuery() {
+  if (closed_) {
+    return;
+  }
+  auto s = Close();
+  if (!s.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to close standing query $0: $1",
+                                   exec_state_->query_id().str(), s.msg());
+  }
+}
+
+Status StandingQuery::ExecutePeriod() {
+  if (closed_) {
+    return error::FailedPrecondition("Standing query $0 is closed.", query_id().str());
+  }
+  for (const auto& exec_graph : exec_graphs_) {
+    PX_RETURN_IF_ERROR(exec_graph->ExecutePeriod());
+  }
+  return Status::OK();
+}
+
+Status StandingQuery::Close() {
+  if (closed_) {
+    return Status::OK();
+  }
+  closed_ = true;
+  Status status = Status::OK();
+  for (const auto& exec_graph : exec_graphs_) {
+    auto s = exec_graph->Close();
+    if (!s.ok()) {
+      status = s;
+    }
+  }
+  return status;
+}
+
+exec::ExecutionStats StandingQuery::GetStats() const {
+  exec::ExecutionStats stats{0, 0};
+  for (const auto& exec_graph : exec_graphs_) {
+    auto graph_stats = exec_graph->GetStats();
+    stats.bytes_processed += graph_stats.bytes_processed;
+    stats.rows_processed += graph_stats.rows_processed;
+  }
+  return stats;
+}
+
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <sole.hpp>
+
+#include "src/carnot/engine_state.h"
+#include "src/carnot/exec/exec_graph.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/plan_state.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/plan_cache.h"
+#include "src/common/base/base.h"
+#include "src/shared/metadata/metadata_state.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+
+/**
+ * StandingQuery is a query that is executed once per period over the data that was appended to
+ * its source tables since the previous period, instead of re-running the whole plan over its time
+ * window every period.
+ *
+ * The execution graphs, and the table cursors of their memory sources, stay open for the lifetime
+ * of the query. The memory sources stream from the plan's start time on, and every period ends
+ * with an end of window. Windowed aggregates emit their results for the period and then start
+ * over. Blocking aggregates keep their state across periods and emit their results so far at the
+ * end of every period, which match what the one-shot query would return for all of the data since
+ * the start time. Each period therefore costs time proportional to the new data, rather than to
+ * the window.
+ *
+ * Only plans that can run period by period are accepted: their sources must all be unbounded
+ * memory sources (no stop time), and they can't contain joins or limits, nor combine the
+ * cumulative results of an aggregate with the rows of each period.
+ */
+class StandingQuery : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<StandingQuery>> Create(
+      const planpb::Plan& plan, const sole::uuid& query_id, EngineState* engine_state,
+      std::shared_ptr<const md::AgentMetadataState> metadata_state);
+
+  ~StandingQuery();
+
+  /**
+   * Runs the batches appended to the source tables since the last period through the plan, and
+   * flushes the period's results to the sinks. If this fails, the query should be closed.
+   */
+  Status ExecutePeriod();
+
+  /**
+   * Ends the streams of the sources and closes the execution graphs. Called by the destructor if
+   * it wasn't called before.
+   */
+  Status Close();
+
+  const sole::uuid& query_id() const { return exec_state_->query_id(); }
+
+  /**
+   * Returns the bytes and rows read by the query's sources over all of the periods so far.
+   */
+  exec::ExecutionStats GetStats() const;
+
+ private:
+  StandingQuery() = default;
+
+  std::unique_ptr<PreparedPlan> prepared_;
+  std::unique_ptr<exec::ExecState> exec_state_;
+  std::unique_ptr<plan::PlanState> plan_state_;
+  std::unique_ptr<table_store::schema::Schema> schema_;
+  // The execution graphs of the plan fragments, in topological order. They reference the state
+  // above, so they are declared last to be destroyed first.
+  std::vector<std::unique_ptr<exec::ExecutionGraph>> exec_graphs_;
+  bool closed_ = false;
+};
+
+}  // namespace carnot
+}  // namespace px
@@ -157,8 +157,12 @@ class UDATester {
     if constexpr (UDATraits<TUDA>::SupportsPartial()) {
       // Verify the serialization/deserialization works.
       TUDA other;
-      auto s = (other.Deserialize(/*ctx*/ nullptr, uda_.Serialize(/*ctx*/ nullptr)));
+      EXPECT_OK(other.Deserialize(/*ctx*/ nullptr, uda_.Serialize(/*ctx*/ nullptr)));
       internal::ExpectEquality(other.Finalize(nullptr), arg);
+
+      if (test_merge_) {
+        internal::ExpectEquality(PartialAggResult(), arg);
+      }
     }
 
     if (test_merge_) {
@@ -182,6 +186,25 @@ class UDATester {
     return uda_.Finalize(nullptr);
   }
 
+  /**
+   * Returns the result of running the inputs through the distributed partial aggregation path:
+   * each input's UDA is serialized, deserialized and merged into a fresh UDA, the way the finalize
+   * agg on Kelvin merges the partial aggregates sent by the PEMs. Cannot be called after Expect,
+   * or on a UDATester created with init args.
+   * @return the result value.
+   */
+  typename types::DataTypeTraits<uda_data_type>::value_type PartialAggResult() {
+    static_assert(UDATraits<TUDA>::SupportsPartial(), "UDA does not support partial aggregation");
+    EXPECT_TRUE(test_merge_) << "Partial aggregation can't be tested for UDAs with init args";
+    TUDA merged;
+    for (const auto& partial : merge_udas_) {
+      TUDA deserialized;
+      EXPECT_OK(deserialized.Deserialize(/*ctx*/ nullptr, partial->Serialize(/*ctx*/ nullptr)));
+      merged.Merge(nullptr, deserialized);
+    }
+    return merged.Finalize(nullptr);
+  }
+
   /*
    * Merge the UDA from the given UDATester with this UDA.
    */
@@ -74,6 +74,12 @@ class AnyUDA : public BaseFunc {
  *      Status Init(FunctionContext *ctx, UDFValue... init_args) {}
  *  This function is called once during initialization of each instance (many instances
  *  may exists in a given query). The arguments are as provided by the query.
+ *
+ * UDFs with a large fixed cost per call (ie. model inference) can _optionally_ implement:
+ *      Status ExecBatch(FunctionContext *ctx, size_t count, UDFValue* out,
+ *                       const UDFValue*... values) {}
+ *  When present, it is called instead of Exec with all the records of a row batch. The argument
+ *  and return types must match those of Exec, which is still used to infer the UDF's signature.
  */
 class ScalarUDF : public AnyUDF {
  public:
@@ -94,6 +100,8 @@ class ScalarUDF : public AnyUDF {
  *
  * It may optionally implement:
  *     Status Init(FunctionContext *ctx, InitArgs...) {}
+ *     void UpdateBatch(FunctionContext *ctx, size_t count, const Args*...) {}
+ * When present, UpdateBatch is called instead of Update with all the records of a row batch.
  *
  * To support partial aggregation to UDAs must also implement:
  *     StringValue Serialize(FunctionContext*) {}
@@ -167,6 +175,13 @@ struct has_udf_executor_fn<T, std::void_t<decltype(&T::Executor)>> : std::true_t
       "If an executor function exists, it must have the form: UDFSourceExecutor Executor()");
 };
 
+// SFINAE test for ExecBatch fn.
+template <typename T, typename = void>
+struct has_udf_exec_batch_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_batch_fn<T, std::void_t<decltype(&T::ExecBatch)>> : std::true_type {};
+
 template <typename T, typename = void>
 struct check_executor_fn {};
 
@@ -228,6 +243,12 @@ class ScalarUDFTraits {
    */
   static constexpr bool HasExecutor() { return has_udf_executor_fn<T>::value; }
 
+  /**
+   * Checks if the UDF has an ExecBatch function, which is used instead of Exec.
+   * @return true if it has an ExecBatch function.
+   */
+  static constexpr bool HasExecBatch() { return has_udf_exec_batch_fn<T>::value; }
+
   template <typename Q = T, std::enable_if_t<ScalarUDFTraits<Q>::HasInit(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return GetArgumentTypesHelper(&Q::Init);
@@ -343,6 +364,13 @@ struct has_uda_deserialize_fn<T, std::void_t<decltype(&T::Deserialize)>> : std::
                 "Deserialize(FunctionContext*, const StringValue&)");
 };
 
+// SFINAE test for update batch fn.
+template <typename T, typename = void>
+struct has_uda_update_batch_fn : std::false_type {};
+
+template <typename T>
+struct has_uda_update_batch_fn<T, std::void_t<decltype(&T::UpdateBatch)>> : std::true_type {};
+
 /**
  * ScalarUDFTraits allows access to compile time traits of a given UDA.
  * @tparam T A class that derives from UDA.
@@ -359,6 +387,12 @@ class UDATraits {
    */
   static constexpr bool HasInit() { return has_udf_init_fn<T>::value; }
 
+  /**
+   * Checks if the UDA has an UpdateBatch function, which is used instead of Update.
+   * @return true if it has an UpdateBatch function.
+   */
+  static constexpr bool HasUpdateBatch() { return has_uda_update_batch_fn<T>::value; }
+
   /**
    * @brief Whether this UDA supports a partial aggregate representation
    * @return true
@@ -68,6 +68,24 @@ class InitArgUDF : public ScalarUDF {
   int64_t i_;
 };
 
+// Concatenates its arguments, and counts the batches it was called with.
+class BatchConcatUDF : public ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue str, types::Int64Value i) {
+    return absl::StrCat(str, i.val);
+  }
+  Status ExecBatch(FunctionContext*, size_t count, types::StringValue* out,
+                   const types::StringValue* strs, const types::Int64Value* ints) {
+    ++num_batches;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = absl::StrCat(strs[i], ints[i].val);
+    }
+    return Status::OK();
+  }
+
+  int num_batches = 0;
+};
+
 TEST(UDFDefinition, no_args) {
   auto ctx = FunctionContext(nullptr, nullptr);
   ScalarUDFDefinition def("noargudf");
@@ -162,6 +180,46 @@ TEST(UDFDefinition, init_args) {
   EXPECT_EQ("init_arg, 10, hello", out[2]);
 }
 
+TEST(UDFDefinition, exec_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("batch_concat");
+  EXPECT_OK(def.Init<BatchConcatUDF>());
+  EXPECT_THAT(def.exec_arguments(), ElementsAre(types::STRING, types::INT64));
+
+  types::StringValueColumnWrapper v1({"a", "b", "c"});
+  types::Int64ValueColumnWrapper v2({1, 2, 3});
+
+  types::StringValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1, &v2}, &out, v1.Size()));
+  EXPECT_EQ("a1", out[0]);
+  EXPECT_EQ("b2", out[1]);
+  EXPECT_EQ("c3", out[2]);
+  EXPECT_EQ(1, static_cast<BatchConcatUDF*>(u.get())->num_batches);
+}
+
+TEST(UDFDefinition, exec_batch_arrow) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  std::vector<types::StringValue> v1 = {"a", "b", "c"};
+  std::vector<types::Int64Value> v2 = {1, 2, 3};
+
+  auto v1a = ToArrow(v1, arrow::default_memory_pool());
+  auto v2a = ToArrow(v2, arrow::default_memory_pool());
+
+  auto output_builder = std::make_shared<arrow::StringBuilder>();
+  auto u = std::make_shared<BatchConcatUDF>();
+  EXPECT_OK(ScalarUDFWrapper<BatchConcatUDF>::ExecBatchArrow(
+      u.get(), &ctx, {v1a.get(), v2a.get()}, output_builder.get(), 3));
+  EXPECT_EQ(1, u->num_batches);
+
+  std::shared_ptr<arrow::Array> res;
+  EXPECT_TRUE(output_builder->Finish(&res).ok());
+  auto* res_arr = static_cast<arrow::StringArray*>(res.get());
+  EXPECT_EQ("a1", res_arr->GetString(0));
+  EXPECT_EQ("b2", res_arr->GetString(1));
+  EXPECT_EQ("c3", res_arr->GetString(2));
+}
+
 // Test UDA, takes the min of two arguments and then sums them.
 class MinSumUDA : public udf::UDA {
  public:
@@ -175,6 +233,23 @@ class MinSumUDA : public udf::UDA {
   types::Int64Value sum_ = 0;
 };
 
+// MinSumUDA, with a batch update that counts the batches it was called with.
+class BatchMinSumUDA : public MinSumUDA {
+ public:
+  void UpdateBatch(udf::FunctionContext* ctx, size_t count, const types::Int64Value* arg1,
+                   const types::Int64Value* arg2) {
+    ++num_batches;
+    for (size_t i = 0; i < count; ++i) {
+      Update(ctx, arg1[i], arg2[i]);
+    }
+  }
+  void Merge(udf::FunctionContext* ctx, const BatchMinSumUDA& other) {
+    MinSumUDA::Merge(ctx, other);
+  }
+
+  int num_batches = 0;
+};
+
 class InitArgUDA : public udf::UDA {
  public:
   Status Init(udf::FunctionContext*, types::Int64Value i, types::StringValue str,
@@ -232,6 +307,29 @@ TEST(UDADefinition, without_merge) {
   EXPECT_EQ(5, out.val);
 }
 
+TEST(UDADefinition, update_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  UDADefinition def("minsum");
+  EXPECT_OK(def.Init<BatchMinSumUDA>());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3});
+  types::Int64ValueColumnWrapper v2({5, 1, 3});
+
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatchUpdate(u.get(), &ctx, {&v1, &v2}));
+
+  std::vector<types::Int64Value> a1 = {4, 5};
+  std::vector<types::Int64Value> a2 = {6, 1};
+  auto a1a = ToArrow(a1, arrow::default_memory_pool());
+  auto a2a = ToArrow(a2, arrow::default_memory_pool());
+  EXPECT_OK(def.ExecBatchUpdateArrow(u.get(), &ctx, {a1a.get(), a2a.get()}));
+
+  types::Int64Value out;
+  EXPECT_OK(def.FinalizeValue(u.get(), &ctx, &out));
+  EXPECT_EQ(10, out.val);
+  EXPECT_EQ(2, static_cast<BatchMinSumUDA*>(u.get())->num_batches);
+}
+
 TEST(UDADefinition, with_merge) {
   auto ctx = FunctionContext(nullptr, nullptr);
   UDADefinition def("minsum");
@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "src/carnot/udf/udf.h"
@@ -63,6 +64,9 @@ Status ExecWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
                    const std::vector<const types::BaseValueType*>& args,
                    std::index_sequence<I...>) {
   [[maybe_unused]] constexpr auto exec_argument_types = ScalarUDFTraits<TUDF>::ExecArguments();
+  if constexpr (ScalarUDFTraits<TUDF>::HasExecBatch()) {
+    return udf->ExecBatch(ctx, count, out, CastToUDFValueType<exec_argument_types[I]>(args[I])...);
+  }
   for (size_t idx = 0; idx < count; ++idx) {
     out[idx] = udf->Exec(ctx, CastToUDFValueType<exec_argument_types[I]>(args[I])[idx]...);
   }
@@ -96,6 +100,37 @@ inline auto UnWrap<types::StringValue>(const types::StringValue& s) {
   return s;
 }
 
+/**
+ * This is the inner wrapper for the arrow type, for UDFs that implement ExecBatch.
+ * The inputs are copied into arrays of UDF values, which ExecBatch takes, and the results are
+ * appended to the output builder.
+ */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecBatchWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                             const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  constexpr types::DataType return_type = ScalarUDFTraits<TUDF>::ReturnType();
+
+  std::tuple<std::vector<typename types::DataTypeTraits<exec_argument_types[I]>::value_type>...>
+      inputs;
+  (std::get<I>(inputs).reserve(count), ...);
+  for (size_t idx = 0; idx < count; ++idx) {
+    (std::get<I>(inputs).emplace_back(
+         types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], idx)),
+     ...);
+  }
+
+  std::vector<typename types::DataTypeTraits<return_type>::value_type> results(count);
+  PX_RETURN_IF_ERROR(udf->ExecBatch(ctx, count, results.data(), std::get<I>(inputs).data()...));
+
+  PX_RETURN_IF_ERROR(out->Reserve(count));
+  for (const auto& res : results) {
+    PX_RETURN_IF_ERROR(out->Append(UnWrap(res)));
+  }
+  return Status::OK();
+}
+
 /**
  * This is the inner wrapper for the arrow type.
  * This performs type casting and storing the data in the output builder.
@@ -105,6 +140,9 @@ Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput*
                         const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
   [[maybe_unused]] static constexpr auto exec_argument_types =
       ScalarUDFTraits<TUDF>::ExecArguments();
+  if constexpr (ScalarUDFTraits<TUDF>::HasExecBatch()) {
+    return ExecBatchWrapperArrow<TUDF>(udf, ctx, count, out, args, std::index_sequence<I...>{});
+  }
   CHECK(out->Reserve(count).ok());
   size_t reserved = count * kStringAssumedSizeHeuristic;
   size_t total_size = 0;
@@ -290,6 +328,10 @@ Status UpdateWrapper(TUDA* uda, FunctionContext* ctx, size_t count,
                      const std::vector<const types::BaseValueType*>& args,
                      std::index_sequence<I...>) {
   constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  if constexpr (UDATraits<TUDA>::HasUpdateBatch()) {
+    uda->UpdateBatch(ctx, count, CastToUDFValueType<update_argument_types[I]>(args[I])...);
+    return Status::OK();
+  }
   for (size_t idx = 0; idx < count; ++idx) {
     uda->Update(ctx, CastToUDFValueType<update_argument_types[I]>(args[I])[idx]...);
   }
@@ -304,6 +346,20 @@ template <typename TUDA, std::size_t... I>
 Status UpdateWrapperArrow(TUDA* uda, FunctionContext* ctx, size_t count,
                           const std::vector<const arrow::Array*>& args, std::index_sequence<I...>) {
   constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  if constexpr (UDATraits<TUDA>::HasUpdateBatch()) {
+    // UpdateBatch takes arrays of UDF values, so the inputs are copied into them first.
+    std::tuple<
+        std::vector<typename types::DataTypeTraits<update_argument_types[I]>::value_type>...>
+        inputs;
+    (std::get<I>(inputs).reserve(count), ...);
+    for (size_t idx = 0; idx < count; ++idx) {
+      (std::get<I>(inputs).emplace_back(
+           types::GetValueFromArrowArray<update_argument_types[I]>(args[I], idx)),
+       ...);
+    }
+    uda->UpdateBatch(ctx, count, std::get<I>(inputs).data()...);
+    return Status::OK();
+  }
   for (size_t idx = 0; idx < count; ++idx) {
     uda->Update(ctx, types::GetValueFromArrowArray<update_argument_types[I]>(args[I], idx)...);
   }
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/experimental/standalone_pem/cron_script_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <sole.hpp>
+
+#include "src/carnot/planner/compiler/compiler.h"
+#include "src/carnot/planpb/plan.pb.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+CronScriptRunner::CronScriptRunner(px::event::Dispatcher* dispatcher, carnot::Carnot* carnot,
+                                   std::chrono::seconds frequency)
+    : dispatcher_(dispatcher), carnot_(carnot), frequency_(frequency) {}
+
+CronScriptRunner::~CronScriptRunner() { Stop(); }
+
+Status CronScriptRunner::Start(const std::filesystem::path& scripts_dir) {
+  std::error_code ec;
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(scripts_dir, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".pxl") {
+      paths.push_back(entry.path());
+    }
+  }
+  if (ec) {
+    return error::InvalidArgument("Failed to list cron scripts in $0: $1", scripts_dir.string(),
+                                  ec.message());
+  }
+  std::sort(paths.begin(), paths.end());
+
+  for (const auto& path : paths) {
+    PX_ASSIGN_OR_RETURN(std::string query_str, ReadFileToString(path.string()));
+    auto query_or_s = CreateQuery(query_str);
+    if (!query_or_s.ok()) {
+      return error::InvalidArgument("Cron script $0 can't run as a standing query: $1",
+                                    path.string(), query_or_s.status().msg());
+    }
+    LOG(INFO) << absl::Substitute("Running cron script $0 every $1 s", path.filename().string(),
+                                  frequency_.count());
+    scripts_.push_back(CronScript{path.filename().string(), query_or_s.ConsumeValueOrDie()});
+  }
+
+  if (!scripts_.empty()) {
+    period_timer_ = dispatcher_->CreateTimer(std::bind(&CronScriptRunner::RunPeriod, this));
+    period_timer_->EnableTimer(frequency_);
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<carnot::StandingQuery>> CronScriptRunner::CreateQuery(
+    const std::string& query_str) {
+  // Relative start times in the script are resolved against the time the script starts at.
+  auto compiler_state =
+      carnot_->GetEngineState()->CreateLocalExecutionCompilerState(CurrentTimeNS());
+  PX_ASSIGN_OR_RETURN(carnot::planpb::Plan plan,
+                      carnot::planner::compiler::Compiler().Compile(query_str,
+                                                                    compiler_state.get()));
+  for (const auto& pf : plan.nodes()) {
+    for (const auto& node : pf.nodes()) {
+      if (node.op().op_type() == carnot::planpb::GRPC_SINK_OPERATOR) {
+        return error::InvalidArgument(
+            "Cron scripts have no client to display their results to, so they must export them "
+            "instead, e.g. with px.export.");
+      }
+    }
+  }
+  return carnot_->CreateStandingQuery(plan, sole::uuid4());
+}
+
+void CronScriptRunner::RunPeriod() {
+  for (auto& script : scripts_) {
+    if (script.query == nullptr) {
+      continue;
+    }
+    auto s = script.query->ExecutePeriod();
+    if (!s.ok()) {
+      LOG(ERROR) << absl::Substitute("Cron script $0 failed, and won't run again: $1", script.name,
+                                     s.msg());
+      script.query.reset();
+    }
+  }
+  period_timer_->EnableTimer(frequency_);
+}
+
+void CronScriptRunner::Stop() {
+  if (period_timer_ != nullptr) {
+    period_timer_->DisableTimer();
+  }
+  // Resetting the queries closes them.
+  for (auto& script : scripts_) {
+    script.query.reset();
+  }
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/standing_query.h"
+#include "src/common/base/base.h"
+#include "src/common/event/event.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * CronScriptRunner runs the PxL scripts of a directory as standing queries, executing a period of
+ * each of them at a fixed frequency.
+ *
+ * Every period only reads the data that was written since the previous one. Blocking aggregates
+ * keep their state across periods, so every period exports the aggregates of all of the data since
+ * the script started, which is what cumulative metrics expect. There's no client to display the
+ * results to, so the scripts must export them, e.g. with px.export.
+ */
+class CronScriptRunner {
+ public:
+  CronScriptRunner() = delete;
+  CronScriptRunner(px::event::Dispatcher* dispatcher, carnot::Carnot* carnot,
+                   std::chrono::seconds frequency);
+  ~CronScriptRunner();
+
+  /**
+   * Compiles the *.pxl scripts in the directory and starts running them. Fails if any of the
+   * scripts can't run as a standing query.
+   */
+  Status Start(const std::filesystem::path& scripts_dir);
+
+  /**
+   * Closes the standing queries of the scripts. Must not race with the dispatcher running them.
+   */
+  void Stop();
+
+ private:
+  struct CronScript {
+    std::string name;
+    // Reset once the query fails or is stopped.
+    std::unique_ptr<carnot::StandingQuery> query;
+  };
+
+  StatusOr<std::unique_ptr<carnot::StandingQuery>> CreateQuery(const std::string& query_str);
+  void RunPeriod();
+
+  px::event::Dispatcher* dispatcher_;
+  carnot::Carnot* carnot_;
+  const std::chrono::seconds frequency_;
+
+  event::TimerUPtr period_timer_;
+  std::vector<CronScript> scripts_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
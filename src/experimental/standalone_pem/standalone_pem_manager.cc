@@ -49,6 +49,13 @@ DEFINE_int32(table_store_proc_exit_events_limit_bytes,
              gflags::Int32FromEnv("PL_TABLE_STORE_PROC_EXIT_EVENTS_LIMIT_BYTES", 10 * 1024 * 1024),
              "The maximum amount of data to store in the proc_exit_events table.");
 
+DEFINE_string(cron_scripts_dir, gflags::StringFromEnv("PL_CRON_SCRIPTS_DIR", ""),
+              "The directory of PxL scripts (*.pxl) to run periodically as standing queries. The "
+              "scripts must export their results, e.g. with px.export. Empty disables them.");
+
+DEFINE_int32(cron_script_frequency_s, gflags::Int32FromEnv("PL_CRON_SCRIPT_FREQUENCY_S", 10),
+             "The period, in seconds, at which the cron scripts process their new data.");
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -150,6 +157,12 @@ Status StandalonePEMManager::Init() {
       std::make_unique<VizierGRPCServer>(port_, carnot_.get(), results_sink_server_.get(),
                                          carnot_->GetEngineState(), tracepoint_manager_.get());
 
+  cron_script_runner_ = std::make_unique<CronScriptRunner>(
+      dispatcher_.get(), carnot_.get(), std::chrono::seconds(FLAGS_cron_script_frequency_s));
+  if (!FLAGS_cron_scripts_dir.empty()) {
+    PX_RETURN_IF_ERROR(cron_script_runner_->Start(FLAGS_cron_scripts_dir));
+  }
+
   return Status::OK();
 }
 
@@ -213,6 +226,8 @@ Status StandalonePEMManager::Stop(std::chrono::milliseconds timeout) {
   }
 
   vizier_grpc_server_->Stop();
+  // The dispatcher no longer runs the cron scripts, so their queries can be closed.
+  cron_script_runner_->Stop();
   return s;
 }
 
@@ -23,6 +23,7 @@
 
 #include "src/carnot/carnot.h"
 #include "src/common/event/event.h"
+#include "src/experimental/standalone_pem/cron_script_runner.h"
 #include "src/experimental/standalone_pem/sink_server.h"
 #include "src/experimental/standalone_pem/tracepoint_manager.h"
 #include "src/experimental/standalone_pem/vizier_server.h"
@@ -87,6 +88,9 @@ class StandalonePEMManager : public BaseManager {
 
   // Tracepoints
   std::unique_ptr<TracepointManager> tracepoint_manager_;
+
+  // Runs the cron scripts as standing queries on the dispatcher.
+  std::unique_ptr<CronScriptRunner> cron_script_runner_;
 };
 
 }  // namespace agent
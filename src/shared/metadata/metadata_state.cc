@@ -16,9 +16,11 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_set.h>
 
@@ -42,6 +44,28 @@ const K8sMetadataObject* K8sMetadataState::K8sMetadataObjectByID(UIDView id,
   return it->second.get();
 }
 
+K8sMetadataObject* K8sMetadataState::MutableK8sMetadataObject(UIDView id) {
+  K8sMetadataObjectSPtr* obj = k8s_objects_by_id_.Mutable(id);
+  if (obj == nullptr) {
+    return nullptr;
+  }
+  if (obj->use_count() > 1) {
+    *obj = (*obj)->Clone();
+  }
+  return obj->get();
+}
+
+ContainerInfo* K8sMetadataState::MutableContainerInfo(CIDView id) {
+  ContainerInfoSPtr* container = containers_by_id_.Mutable(id);
+  if (container == nullptr) {
+    return nullptr;
+  }
+  if (container->use_count() > 1) {
+    *container = (*container)->Clone();
+  }
+  return container->get();
+}
+
 const PodInfo* K8sMetadataState::PodInfoByID(UIDView pod_id) const {
   auto type = K8sObjectType::kPod;
   return static_cast<const PodInfo*>(K8sMetadataObjectByID(pod_id, type));
@@ -165,16 +189,8 @@ std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
   other->pod_cidrs_ = pod_cidrs_;
   other->service_cidr_ = service_cidr_;
 
-  other->k8s_objects_by_id_.reserve(k8s_objects_by_id_.size());
-  for (const auto& [k, v] : k8s_objects_by_id_) {
-    other->k8s_objects_by_id_[k] = v->Clone();
-  }
-
-  other->containers_by_id_.reserve(containers_by_id_.size());
-  for (const auto& [k, v] : containers_by_id_) {
-    other->containers_by_id_[k] = v->Clone();
-  }
-
+  other->k8s_objects_by_id_ = k8s_objects_by_id_;
+  other->containers_by_id_ = containers_by_id_;
   other->pods_by_name_ = pods_by_name_;
   other->services_by_name_ = services_by_name_;
   other->namespaces_by_name_ = namespaces_by_name_;
@@ -251,13 +267,12 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(object_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto pod = std::make_unique<PodInfo>(update);
+  if (!k8s_objects_by_id_.contains(object_uid)) {
+    auto pod = std::make_shared<PodInfo>(update);
     VLOG(1) << "Adding Pod: " << pod->DebugString();
-    it = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
+    k8s_objects_by_id_[object_uid] = std::move(pod);
   }
-  auto pod_info = static_cast<PodInfo*>(it->second.get());
+  auto pod_info = static_cast<PodInfo*>(MutableK8sMetadataObject(object_uid));
 
   // We always just add to the container set even if the container is stopped.
   // We expect all cleanup to happen periodically to allow stale objects to be queried for some
@@ -266,7 +281,8 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
   // state might be periodically inconsistent.
 
   for (const auto& cid : update.container_ids()) {
-    if (containers_by_id_.find(cid) == containers_by_id_.end()) {
+    ContainerInfo* container_info = MutableContainerInfo(cid);
+    if (container_info == nullptr) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
@@ -275,7 +291,7 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     }
 
     pod_info->AddContainer(cid);
-    containers_by_id_[cid]->set_pod_id(object_uid);
+    container_info->set_pod_id(object_uid);
   }
 
   for (const auto& owner_ref : update.owner_references()) {
@@ -308,15 +324,14 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
 Status K8sMetadataState::HandleContainerUpdate(const ContainerUpdate& update) {
   const CID& cid = update.cid();
 
-  auto it = containers_by_id_.find(cid);
-  if (it == containers_by_id_.end()) {
-    auto container = std::make_unique<ContainerInfo>(update);
+  if (!containers_by_id_.contains(cid)) {
+    auto container = std::make_shared<ContainerInfo>(update);
     VLOG(1) << "Adding Container: " << container->DebugString();
-    it = containers_by_id_.try_emplace(cid, std::move(container)).first;
+    containers_by_id_[cid] = std::move(container);
   }
   VLOG(1) << "container update: " << update.name();
 
-  auto* container_info = it->second.get();
+  auto* container_info = MutableContainerInfo(cid);
   container_info->set_stop_time_ns(update.stop_timestamp_ns());
   container_info->set_state(ConvertToContainerState(update.container_state()));
   container_info->set_state_message(update.message());
@@ -332,25 +347,29 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(service_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto service = std::make_unique<ServiceInfo>(service_uid, ns, name);
+  if (!k8s_objects_by_id_.contains(service_uid)) {
+    auto service = std::make_shared<ServiceInfo>(service_uid, ns, name);
     VLOG(1) << "Adding Service: " << service->DebugString();
-    it = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
+    k8s_objects_by_id_[service_uid] = std::move(service);
   }
-  auto service_info = static_cast<ServiceInfo*>(it->second.get());
+  auto service_info = static_cast<ServiceInfo*>(MutableK8sMetadataObject(service_uid));
 
   for (const auto& uid : update.pod_ids()) {
-    if (k8s_objects_by_id_.find(uid) == k8s_objects_by_id_.end()) {
+    auto pod_it = k8s_objects_by_id_.find(uid);
+    if (pod_it == k8s_objects_by_id_.end()) {
       // We should be resilient to the case where we happened to miss a pod update
       // in the stream of events. If we did miss a pod update, just skip adding the
       // pod to this particular service to avoid dangling references.
       LOG(INFO) << absl::Substitute("Didn't find pod UID $0 for service $1/$2", uid, ns, name);
       continue;
     }
-    ECHECK(k8s_objects_by_id_[uid]->type() == K8sObjectType::kPod);
+    ECHECK(pod_it->second->type() == K8sObjectType::kPod);
     // We add the service uid to the pod. Lifetime of service still handled by the service object.
-    PodInfo* pod_info = static_cast<PodInfo*>(k8s_objects_by_id_[uid].get());
+    if (static_cast<const PodInfo*>(pod_it->second.get())->services().contains(service_uid)) {
+      // Avoid copying a pod that is shared with an older state when nothing changes.
+      continue;
+    }
+    PodInfo* pod_info = static_cast<PodInfo*>(MutableK8sMetadataObject(uid));
     pod_info->AddService(service_uid);
   }
   if (update.start_timestamp_ns() != 0) {
@@ -379,13 +398,12 @@ Status K8sMetadataState::HandleNamespaceUpdate(const NamespaceUpdate& update) {
   const std::string& name = update.name();
   const std::string& ns = update.name();
 
-  auto it = k8s_objects_by_id_.find(namespace_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto ns_obj = std::make_unique<NamespaceInfo>(namespace_uid, ns, name);
+  if (!k8s_objects_by_id_.contains(namespace_uid)) {
+    auto ns_obj = std::make_shared<NamespaceInfo>(namespace_uid, ns, name);
     VLOG(1) << "Adding Namespace: " << ns_obj->DebugString();
-    it = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
+    k8s_objects_by_id_[namespace_uid] = std::move(ns_obj);
   }
-  auto ns_info = static_cast<NamespaceInfo*>(it->second.get());
+  auto ns_info = static_cast<NamespaceInfo*>(MutableK8sMetadataObject(namespace_uid));
 
   ns_info->set_start_time_ns(update.start_timestamp_ns());
   ns_info->set_stop_time_ns(update.stop_timestamp_ns());
@@ -408,13 +426,12 @@ Status K8sMetadataState::HandleReplicaSetUpdate(const ReplicaSetUpdate& update)
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(replica_set_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto replica_set = std::make_unique<ReplicaSetInfo>(update);
+  if (!k8s_objects_by_id_.contains(replica_set_uid)) {
+    auto replica_set = std::make_shared<ReplicaSetInfo>(update);
     VLOG(1) << "Adding ReplicaSet: " << replica_set->DebugString();
-    it = k8s_objects_by_id_.try_emplace(replica_set_uid, std::move(replica_set)).first;
+    k8s_objects_by_id_[replica_set_uid] = std::move(replica_set);
   }
-  auto replica_set_info = static_cast<ReplicaSetInfo*>(it->second.get());
+  auto replica_set_info = static_cast<ReplicaSetInfo*>(MutableK8sMetadataObject(replica_set_uid));
 
   for (const auto& owner_ref : update.owner_references()) {
     replica_set_info->AddOwnerReference(owner_ref.uid(), owner_ref.name(), owner_ref.kind());
@@ -441,13 +458,12 @@ Status K8sMetadataState::HandleDeploymentUpdate(const DeploymentUpdate& update)
   const std::string& name = update.name();
   const std::string& ns = update.namespace_();
 
-  auto it = k8s_objects_by_id_.find(deployment_uid);
-  if (it == k8s_objects_by_id_.end()) {
-    auto deployment = std::make_unique<DeploymentInfo>(update);
+  if (!k8s_objects_by_id_.contains(deployment_uid)) {
+    auto deployment = std::make_shared<DeploymentInfo>(update);
     VLOG(1) << "Adding Deployment: " << deployment->DebugString();
-    it = k8s_objects_by_id_.try_emplace(deployment_uid, std::move(deployment)).first;
+    k8s_objects_by_id_[deployment_uid] = std::move(deployment);
   }
-  auto deployment_info = static_cast<DeploymentInfo*>(it->second.get());
+  auto deployment_info = static_cast<DeploymentInfo*>(MutableK8sMetadataObject(deployment_uid));
 
   deployment_info->set_start_time_ns(update.start_timestamp_ns());
   deployment_info->set_stop_time_ns(update.stop_timestamp_ns());
@@ -478,21 +494,23 @@ bool IsExpired(const T& obj, int64_t retention_time, int64_t now) {
 }
 
 Status K8sMetadataState::CleanupExpiredMetadata(int64_t now, int64_t retention_time_ns) {
-  for (auto iter = k8s_objects_by_id_.begin(); iter != k8s_objects_by_id_.end();) {
-    const auto& k8s_object = iter->second;
-
-    if (!IsExpired(*k8s_object, retention_time_ns, now)) {
-      ++iter;
-      continue;
+  // The maps can't be modified while they are being iterated, so collect the expired entries
+  // first. Holding on to the objects keeps them alive after they are erased from the map.
+  std::vector<K8sMetadataObjectSPtr> expired_objects;
+  for (const auto& [uid, k8s_object] : k8s_objects_by_id_) {
+    if (IsExpired(*k8s_object, retention_time_ns, now)) {
+      expired_objects.push_back(k8s_object);
     }
+  }
 
+  for (const auto& k8s_object : expired_objects) {
+    K8sNameIdentView name_ident(k8s_object->ns(), k8s_object->name());
     switch (k8s_object->type()) {
       case K8sObjectType::kPod: {
-        if (PodIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
-            k8s_object->uid()) {
-          pods_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+        if (PodIDByName(name_ident) == k8s_object->uid()) {
+          pods_by_name_.erase(name_ident);
         }
-        auto pod_ip = static_cast<PodInfo*>(k8s_object.get())->pod_ip();
+        auto pod_ip = static_cast<const PodInfo*>(k8s_object.get())->pod_ip();
         // There could be a new pod assigned to the podIP now, we should only
         // delete the IP from the map if it belongs to the terminated pod.
         if (PodIDByIP(pod_ip) == k8s_object->uid()) {
@@ -501,7 +519,7 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t now, int64_t retention_t
 
         auto it = pods_by_ip_and_start_time_.find(pod_ip);
         if (it != pods_by_ip_and_start_time_.end()) {
-          auto& pod_set = it->second;
+          const auto& pod_set = it->second;
           auto erase_end = pod_set.upper_bound({"", now - retention_time_ns});
 
           if (erase_end != pod_set.begin()) {
@@ -510,26 +528,29 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t now, int64_t retention_t
             // before the expiration time, leave it alone.
             auto prev_obj = k8s_objects_by_id_.find(std::prev(erase_end)->first);
             if (prev_obj != k8s_objects_by_id_.end()) {
-              auto prev_pod = static_cast<PodInfo*>(prev_obj->second.get());
+              auto prev_pod = static_cast<const PodInfo*>(prev_obj->second.get());
               if (prev_pod->phase() == PodPhase::kRunning || prev_pod->stop_time_ns() == 0) {
                 --erase_end;
               }
             }
           }
-          pod_set.erase(pod_set.begin(), erase_end);
+          if (erase_end != pod_set.begin()) {
+            size_t num_erased = std::distance(pod_set.begin(), erase_end);
+            auto* mutable_pod_set = pods_by_ip_and_start_time_.Mutable(pod_ip);
+            mutable_pod_set->erase(mutable_pod_set->begin(),
+                                   std::next(mutable_pod_set->begin(), num_erased));
+          }
         }
         break;
       }
       case K8sObjectType::kNamespace:
-        if (NamespaceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
-            k8s_object->uid()) {
-          namespaces_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+        if (NamespaceIDByName(name_ident) == k8s_object->uid()) {
+          namespaces_by_name_.erase(name_ident);
         }
         break;
       case K8sObjectType::kService:
-        if (ServiceIDByName(std::make_pair(k8s_object->ns(), k8s_object->name())) ==
-            k8s_object->uid()) {
-          services_by_name_.erase({k8s_object->ns(), k8s_object->name()});
+        if (ServiceIDByName(name_ident) == k8s_object->uid()) {
+          services_by_name_.erase(name_ident);
         }
         break;
       default:
@@ -537,19 +558,18 @@ Status K8sMetadataState::CleanupExpiredMetadata(int64_t now, int64_t retention_t
                                         static_cast<int>(k8s_object->type()));
     }
 
-    k8s_objects_by_id_.erase(iter++);
+    k8s_objects_by_id_.erase(k8s_object->uid());
   }
 
-  for (auto iter = containers_by_id_.begin(); iter != containers_by_id_.end();) {
-    const auto& cinfo = iter->second;
-
-    if (!IsExpired(*cinfo, retention_time_ns, now)) {
-      ++iter;
-      continue;
+  std::vector<ContainerInfoSPtr> expired_containers;
+  for (const auto& [cid, cinfo] : containers_by_id_) {
+    if (IsExpired(*cinfo, retention_time_ns, now)) {
+      expired_containers.push_back(cinfo);
     }
-
+  }
+  for (const auto& cinfo : expired_containers) {
     containers_by_name_.erase(cinfo->name());
-    containers_by_id_.erase(iter++);
+    containers_by_id_.erase(cinfo->cid());
   }
 
   return Status::OK();
@@ -562,10 +582,8 @@ std::shared_ptr<AgentMetadataState> AgentMetadataState::CloneToShared() const {
   state->last_update_ts_ns_ = last_update_ts_ns_;
   state->epoch_id_ = epoch_id_;
   state->k8s_metadata_state_ = k8s_metadata_state_->Clone();
-  state->pids_by_upid_.reserve(pids_by_upid_.size());
-  for (const auto& [k, v] : pids_by_upid_) {
-    state->pids_by_upid_[k] = v->Clone();
-  }
+  // The PIDInfos are shared with the copy, and copied by MarkUPIDAsStopped if they change.
+  state->pids_by_upid_ = pids_by_upid_;
   state->upids_ = upids_;
   return state;
 }
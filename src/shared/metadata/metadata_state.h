@@ -35,14 +35,18 @@
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
 #include "src/shared/metadata/k8s_objects.h"
 #include "src/shared/metadata/pids.h"
+#include "src/shared/metadata/sharded_cow_map.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
 namespace md {
 
-using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
-using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
-using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+// The metadata objects are shared between snapshots of the metadata state, and are only copied
+// when a snapshot that shares them is updated.
+using K8sMetadataObjectSPtr = std::shared_ptr<K8sMetadataObject>;
+using ContainerInfoSPtr = std::shared_ptr<ContainerInfo>;
+using PIDInfoSPtr = std::shared_ptr<PIDInfo>;
+using PIDInfoMap = ShardedCOWMap<absl::flat_hash_map<UPID, PIDInfoSPtr>>;
 using AgentID = sole::uuid;
 
 using UIDAndStart = std::pair<UID, int64_t>;
@@ -54,6 +58,10 @@ struct SortByStart {
 
 /**
  * This class contains all kubernetes relate metadata.
+ *
+ * All of the maps are ShardedCOWMaps and all of the objects are shared_ptrs, so Clone() shares
+ * the contents of the state with the copy. Updates to either copy only copy the map shards and
+ * objects that they touch.
  */
 class K8sMetadataState : NotCopyable {
  public:
@@ -105,18 +113,21 @@ class K8sMetadataState : NotCopyable {
       }
     };
   };
-  using K8sEntityByNameMap =
-      absl::flat_hash_map<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>;
+  using K8sEntityByNameMap = ShardedCOWMap<
+      absl::flat_hash_map<K8sNameIdent, UID, K8sIdentHashEq::Hash, K8sIdentHashEq::Eq>>;
 
   using PodsByNameMap = K8sEntityByNameMap;
   using ServicesByNameMap = K8sEntityByNameMap;
   using ReplicaSetByNameMap = K8sEntityByNameMap;
   using DeploymentByNameMap = K8sEntityByNameMap;
   using NamespacesByNameMap = K8sEntityByNameMap;
-  using ContainersByNameMap = absl::flat_hash_map<std::string, CID>;
-  using PodsByPodIPMap = absl::flat_hash_map<std::string, UID>;
-  using PodsByIPAndStartTime = absl::flat_hash_map<std::string, std::set<UIDAndStart, SortByStart>>;
-  using ServicesByServiceIpMap = absl::flat_hash_map<std::string, UID>;
+  using ContainersByNameMap = ShardedCOWMap<absl::flat_hash_map<std::string, CID>>;
+  using PodsByPodIPMap = ShardedCOWMap<absl::flat_hash_map<std::string, UID>>;
+  using PodsByIPAndStartTime =
+      ShardedCOWMap<absl::flat_hash_map<std::string, std::set<UIDAndStart, SortByStart>>>;
+  using ServicesByServiceIpMap = ShardedCOWMap<absl::flat_hash_map<std::string, UID>>;
+  using K8sObjectsByIDMap = ShardedCOWMap<absl::flat_hash_map<UID, K8sMetadataObjectSPtr>>;
+  using ContainersByIDMap = ShardedCOWMap<absl::flat_hash_map<CID, ContainerInfoSPtr>>;
 
   void set_service_cidr(CIDRBlock cidr) {
     if (!service_cidr_.has_value() || service_cidr_.value() != cidr) {
@@ -261,6 +272,9 @@ class K8sMetadataState : NotCopyable {
    */
   const DeploymentInfo* OwnerDeploymentInfo(const K8sMetadataObject* obj_info) const;
 
+  /**
+   * Clone returns a copy of the state that shares all of its maps and objects with this state.
+   */
   std::unique_ptr<K8sMetadataState> Clone() const;
 
   Status HandlePodUpdate(const PodUpdate& update);
@@ -273,11 +287,22 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t now, int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  const ContainersByIDMap& containers_by_id() const { return containers_by_id_; }
+
+  /**
+   * MutableContainerInfo returns a pointer to the container that may be updated, first copying
+   * the container if it is shared with another copy of the state.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* MutableContainerInfo(CIDView id);
+
   std::string DebugString(int indent_level = 0) const;
 
  private:
   const K8sMetadataObject* K8sMetadataObjectByID(UIDView id, K8sObjectType type) const;
+  // Returns the object with the given ID, copied first if it is shared with another state.
+  K8sMetadataObject* MutableK8sMetadataObject(UIDView id);
 
   // The CIDR block used for services inside the cluster.
   std::optional<CIDRBlock> service_cidr_;
@@ -286,10 +311,10 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  K8sObjectsByIDMap k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  ContainersByIDMap containers_by_id_;
 
   /**
    * Mapping of pods by name.
@@ -377,7 +402,7 @@ class AgentMetadataState : NotCopyable {
 
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
-  PIDInfo* GetPIDByUPID(UPID upid) const {
+  const PIDInfo* GetPIDByUPID(UPID upid) const {
     auto it = pids_by_upid_.find(upid);
     if (it != pids_by_upid_.end()) {
       return it->second.get();
@@ -394,16 +419,19 @@ class AgentMetadataState : NotCopyable {
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
+    PIDInfoSPtr* pid_info = pids_by_upid_.Mutable(upid);
     if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
+      if (pid_info->use_count() > 1) {
+        *pid_info = (*pid_info)->Clone();
+      }
+      (*pid_info)->set_stop_time_ns(ts);
       upids_.erase(upid);
     } else {
       DCHECK(!upids_.contains(upid));
     }
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const PIDInfoMap& pids_by_upid() const { return pids_by_upid_; }
 
   const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
 
@@ -446,7 +474,7 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  PIDInfoMap pids_by_upid_;
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+#include <absl/strings/substitute.h>
+
+#include "src/common/benchmark/benchmark.h"
+#include "src/shared/metadata/metadata_state.h"
+
+using px::md::K8sMetadataState;
+
+namespace {
+
+// Number of pods updated between snapshots of the metadata state.
+constexpr int kNumUpdatedPods = 10;
+
+K8sMetadataState::ContainerUpdate ContainerUpdate(int i) {
+  K8sMetadataState::ContainerUpdate update;
+  update.set_cid(absl::Substitute("container$0_uid", i));
+  update.set_name(absl::Substitute("container$0", i));
+  update.set_start_timestamp_ns(100);
+  update.set_pod_id(absl::Substitute("pod$0_uid", i));
+  update.set_pod_name(absl::Substitute("pod$0", i));
+  update.set_namespace_("ns0");
+  return update;
+}
+
+K8sMetadataState::PodUpdate PodUpdate(int i) {
+  K8sMetadataState::PodUpdate update;
+  update.set_uid(absl::Substitute("pod$0_uid", i));
+  update.set_name(absl::Substitute("pod$0", i));
+  update.set_namespace_("ns0");
+  update.set_start_timestamp_ns(100);
+  update.add_container_ids(absl::Substitute("container$0_uid", i));
+  update.add_container_names(absl::Substitute("container$0", i));
+  update.set_pod_ip(absl::Substitute("10.$0.$1.$2", i >> 16, (i >> 8) & 0xff, i & 0xff));
+  update.set_host_ip("1.1.1.1");
+  update.set_node_name("node0");
+  return update;
+}
+
+std::unique_ptr<K8sMetadataState> CreateState(int num_pods) {
+  auto state = std::make_unique<K8sMetadataState>();
+  for (int i = 0; i < num_pods; ++i) {
+    PX_CHECK_OK(state->HandleContainerUpdate(ContainerUpdate(i)));
+    PX_CHECK_OK(state->HandlePodUpdate(PodUpdate(i)));
+  }
+  return state;
+}
+
+}  // namespace
+
+// Measures taking a snapshot of the metadata state.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_K8sMetadataStateClone(benchmark::State& state) {
+  auto md_state = CreateState(state.range(0));
+  for (auto _ : state) {
+    auto snapshot = md_state->Clone();
+    benchmark::DoNotOptimize(snapshot);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Measures a metadata update cycle: a snapshot of the state followed by a handful of pod updates
+// applied to the snapshot, as the state manager does for every batch of updates.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_K8sMetadataStateCloneAndUpdate(benchmark::State& state) {
+  int num_pods = state.range(0);
+  auto md_state = CreateState(num_pods);
+  int next_pod = 0;
+  for (auto _ : state) {
+    auto snapshot = md_state->Clone();
+    for (int i = 0; i < kNumUpdatedPods; ++i) {
+      auto update = PodUpdate(next_pod);
+      update.set_stop_timestamp_ns(200);
+      PX_CHECK_OK(snapshot->HandlePodUpdate(update));
+      next_pod = (next_pod + 1) % num_pods;
+    }
+    md_state = std::move(snapshot);
+  }
+  state.SetItemsProcessed(state.iterations() * num_pods);
+}
+
+BENCHMARK(BM_K8sMetadataStateClone)->Arg(10000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_K8sMetadataStateCloneAndUpdate)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace px {
+namespace md {
+
+/**
+ * ShardedCOWMap is a hash map whose copies share their contents.
+ *
+ * The entries are split by hash across a fixed number of shards, each of which is a TMap held by a
+ * shared_ptr. Copying the map only copies the shard pointers, and the first write to a shard that
+ * is shared with another copy copies just that shard. This makes snapshots of large maps cheap,
+ * and a snapshot followed by a few updates only copies the shards that were updated.
+ *
+ * Like the shared_ptr it is built on, a ShardedCOWMap may be read concurrently with reads and
+ * writes to its copies, but writes to the same ShardedCOWMap must be synchronized by the caller.
+ *
+ * TMap is the flat_hash_map type for a single shard. Lookups accept any key type that the shard's
+ * hasher and key_equal accept.
+ */
+template <typename TMap>
+class ShardedCOWMap {
+ public:
+  using key_type = typename TMap::key_type;
+  using mapped_type = typename TMap::mapped_type;
+  using value_type = typename TMap::value_type;
+  using hasher = typename TMap::hasher;
+  using size_type = size_t;
+
+  static constexpr int kShardBits = 6;
+  static constexpr size_t kNumShards = 1 << kShardBits;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename TMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return *it_; }
+    pointer operator->() const { return &*it_; }
+
+    const_iterator& operator++() {
+      ++it_;
+      SkipEmptyShards();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.shard_ == b.shard_ && (a.shard_ == kNumShards || a.it_ == b.it_);
+    }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) { return !(a == b); }
+
+   private:
+    friend class ShardedCOWMap;
+
+    const_iterator(const ShardedCOWMap* map, size_t shard, typename TMap::const_iterator it)
+        : map_(map), shard_(shard), it_(it) {}
+
+    void SkipEmptyShards() {
+      while (it_ == map_->shards_[shard_]->end()) {
+        if (++shard_ == kNumShards) {
+          return;
+        }
+        it_ = map_->shards_[shard_]->begin();
+      }
+    }
+
+    const ShardedCOWMap* map_ = nullptr;
+    size_t shard_ = kNumShards;
+    typename TMap::const_iterator it_;
+  };
+
+  ShardedCOWMap() { shards_.fill(EmptyShard()); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const {
+    const_iterator it(this, 0, shards_[0]->begin());
+    it.SkipEmptyShards();
+    return it;
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  template <typename K>
+  const_iterator find(const K& key) const {
+    size_t shard = ShardIndex(key);
+    auto it = shards_[shard]->find(key);
+    if (it == shards_[shard]->end()) {
+      return end();
+    }
+    return const_iterator(this, shard, it);
+  }
+
+  template <typename K>
+  bool contains(const K& key) const {
+    return shards_[ShardIndex(key)]->contains(key);
+  }
+
+  /**
+   * Returns a mutable pointer to the value for the key, or nullptr if there is none. The shard
+   * holding the key is copied first if it is shared with another copy of the map.
+   */
+  template <typename K>
+  mapped_type* Mutable(const K& key) {
+    size_t shard = ShardIndex(key);
+    if (!shards_[shard]->contains(key)) {
+      return nullptr;
+    }
+    return &MutableShard(shard)->find(key)->second;
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    auto [it, inserted] = MutableShard(ShardIndex(key))->try_emplace(key);
+    size_ += inserted;
+    return it->second;
+  }
+
+  template <typename K>
+  size_t erase(const K& key) {
+    size_t shard = ShardIndex(key);
+    if (!shards_[shard]->contains(key)) {
+      return 0;
+    }
+    size_t erased = MutableShard(shard)->erase(key);
+    size_ -= erased;
+    return erased;
+  }
+
+  void clear() {
+    shards_.fill(EmptyShard());
+    size_ = 0;
+  }
+
+ private:
+  template <typename K>
+  static size_t ShardIndex(const K& key) {
+    // The shard is picked from the top bits of the hash, because the shard's own table uses the
+    // low bits to place the entry.
+    return hasher{}(key) >> (std::numeric_limits<size_t>::digits - kShardBits);
+  }
+
+  static const std::shared_ptr<TMap>& EmptyShard() {
+    static const auto* kEmpty = new std::shared_ptr<TMap>(std::make_shared<TMap>());
+    return *kEmpty;
+  }
+
+  TMap* MutableShard(size_t shard) {
+    // Only this map can hand out new references to its shards, so a use count of one can't go up
+    // concurrently. The empty shard is always shared, so it is never written to.
+    if (shards_[shard].use_count() > 1) {
+      shards_[shard] = std::make_shared<TMap>(*shards_[shard]);
+    }
+    return shards_[shard].get();
+  }
+
+  std::array<std::shared_ptr<TMap>, kNumShards> shards_;
+  size_t size_ = 0;
+};
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/metadata/sharded_cow_map.h"
+
+namespace px {
+namespace md {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+using StringIntMap = ShardedCOWMap<absl::flat_hash_map<std::string, int>>;
+
+TEST(ShardedCOWMapTest, InsertFindErase) {
+  StringIntMap map;
+  EXPECT_TRUE(map.empty());
+
+  map["a"] = 1;
+  map["b"] = 2;
+  map["a"] = 3;
+  EXPECT_EQ(2, map.size());
+
+  auto it = map.find(std::string_view("a"));
+  ASSERT_NE(it, map.end());
+  EXPECT_EQ(3, it->second);
+  EXPECT_TRUE(map.contains("b"));
+  EXPECT_EQ(map.find("c"), map.end());
+  EXPECT_EQ(nullptr, map.Mutable("c"));
+
+  EXPECT_EQ(1, map.erase("a"));
+  EXPECT_EQ(0, map.erase("a"));
+  EXPECT_EQ(1, map.size());
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("b", 2)));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(ShardedCOWMapTest, IteratesAllShards) {
+  StringIntMap map;
+  constexpr int kNumEntries = 1000;
+  for (int i = 0; i < kNumEntries; ++i) {
+    map[std::to_string(i)] = i;
+  }
+
+  int count = 0;
+  int64_t sum = 0;
+  for (const auto& [k, v] : map) {
+    EXPECT_EQ(std::to_string(v), k);
+    ++count;
+    sum += v;
+  }
+  EXPECT_EQ(kNumEntries, count);
+  EXPECT_EQ(kNumEntries * (kNumEntries - 1) / 2, sum);
+}
+
+TEST(ShardedCOWMapTest, CopiesAreIndependent) {
+  StringIntMap map;
+  for (int i = 0; i < 100; ++i) {
+    map[std::to_string(i)] = i;
+  }
+
+  StringIntMap copy = map;
+  // The copy shares its entries with the original until one of them is written to.
+  EXPECT_EQ(&map.find("1")->second, &copy.find("1")->second);
+
+  *copy.Mutable("1") = -1;
+  copy["new"] = 100;
+  copy.erase("2");
+
+  EXPECT_EQ(1, map.find("1")->second);
+  EXPECT_FALSE(map.contains("new"));
+  EXPECT_TRUE(map.contains("2"));
+  EXPECT_EQ(100, map.size());
+
+  EXPECT_EQ(-1, copy.find("1")->second);
+  EXPECT_EQ(100, copy.find("new")->second);
+  EXPECT_FALSE(copy.contains("2"));
+  EXPECT_EQ(100, copy.size());
+
+  // Entries in shards that were not written to are still shared.
+  int num_shared = 0;
+  for (const auto& [k, v] : copy) {
+    auto it = map.find(k);
+    num_shared += it != map.end() && &it->second == &v;
+  }
+  EXPECT_GT(num_shared, 90);
+}
+
+}  // namespace md
+}  // namespace px
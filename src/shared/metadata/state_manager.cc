@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -235,9 +236,17 @@ Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     CGroupMetadataReader* md_reader,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
-  const auto& k8s_md_state = md->k8s_metadata_state();
+  K8sMetadataState* k8s_md_state = md->k8s_metadata_state();
 
+  // Updating a container may copy the map shard that holds it, so collect the containers first.
+  std::vector<CID> cids;
+  cids.reserve(k8s_md_state->containers_by_id().size());
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
+    cids.push_back(cid);
+  }
+
+  for (const auto& cid : cids) {
+    const ContainerInfo* cinfo = k8s_md_state->ContainerInfoByID(cid);
     if (cinfo->stop_time_ns() != 0) {
       // Ignore dead containers.
       // TODO(zasgar): Come up with a cleaner way of doing this. Probably by using active/inactive
@@ -263,7 +272,7 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->MutableContainerInfo(cid)->set_stop_time_ns(pod_info->stop_time_ns());
       continue;
     }
 
@@ -281,16 +290,28 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        ContainerInfo* mutable_cinfo = k8s_md_state->MutableContainerInfo(cid);
+        mutable_cinfo->set_stop_time_ns(ts);
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
+    // Most containers keep the same PIDs between updates. Leave those alone, so that they stay
+    // shared with older snapshots of the metadata state.
+    const auto& active_upids = cinfo->active_upids();
+    if (active_upids.size() == cgroups_active_pids.size() &&
+        std::all_of(active_upids.begin(), active_upids.end(), [&](const UPID& upid) {
+          return cgroups_active_pids.contains(upid.pid());
+        })) {
+      continue;
+    }
+
+    ProcessContainerPIDUpdates(cid, ts, proc_parser, md,
+                               k8s_md_state->MutableContainerInfo(cid)->mutable_active_upids(),
                                &cgroups_active_pids, pid_updates);
   }
 
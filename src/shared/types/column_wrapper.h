@@ -22,6 +22,7 @@
 #include <arrow/buffer.h>
 #include <arrow/builder.h>
 
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -94,6 +95,11 @@ class ColumnWrapper {
   template <class TValueType>
   void AppendFromVector(const std::vector<TValueType>& value_vector);
 
+  // Moves the values in, without copying them. If the column is empty, the vector's buffer is
+  // taken over as is.
+  template <class TValueType>
+  void AppendFromVector(std::vector<TValueType>&& value_vector);
+
   // Return a new SharedColumnWrapper with values according to the spec:
   //    { data[idx[0]], data[idx[1]], data[idx[2]], ... }
   // CopyIndexes leaves the original untouched, while MoveIndexes destroys the moved indexes.
@@ -129,7 +135,7 @@ class ColumnWrapperTmpl : public ColumnWrapper {
 
   T& operator[](size_t idx) { return data_[idx]; }
 
-  void Append(T val) { data_.push_back(val); }
+  void Append(T val) { data_.push_back(std::move(val)); }
 
   void Reserve(size_t size) override { data_.reserve(size); }
 
@@ -154,6 +160,15 @@ class ColumnWrapperTmpl : public ColumnWrapper {
     }
   }
 
+  void AppendFromVector(std::vector<T>&& value_vector) {
+    if (data_.empty()) {
+      data_ = std::move(value_vector);
+      return;
+    }
+    data_.insert(data_.end(), std::make_move_iterator(value_vector.begin()),
+                 std::make_move_iterator(value_vector.end()));
+  }
+
   // Return a new SharedColumnWrapper with values according to the spec:
   //    { data[idx[0]], data[idx[1]], data[idx[2]], ... }
   SharedColumnWrapper CopyIndexes(const std::vector<size_t>& indexes) const override {
@@ -275,7 +290,7 @@ inline void ColumnWrapper::Append(TValueType val) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
       << "Expect " << ToString(data_type()) << " got "
       << ToString(ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(std::move(val));
 }
 
 template <class TValueType>
@@ -293,7 +308,7 @@ inline TValueType ColumnWrapper::Get(size_t idx) const {
 template <class TValueType>
 inline void ColumnWrapper::AppendNoTypeCheck(TValueType val) {
   DCHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(std::move(val));
 }
 
 template <class TValueType>
@@ -316,6 +331,14 @@ inline void ColumnWrapper::AppendFromVector(const std::vector<TValueType>& val)
   static_cast<ColumnWrapperTmpl<TValueType>*>(this)->AppendFromVector(val);
 }
 
+template <class TValueType>
+inline void ColumnWrapper::AppendFromVector(std::vector<TValueType>&& val) {
+  CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
+      << "Expect " << ToString(data_type()) << " got "
+      << ToString(ValueTypeTraits<TValueType>::data_type);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->AppendFromVector(std::move(val));
+}
+
 template <DataType DT>
 struct ColumnWrapperType {};
 
@@ -179,6 +179,22 @@ TEST(ColumnWrapperTest, FromVectorInt64) {
   EXPECT_TRUE(actual_arr->Equals(expected_arr));
 }
 
+TEST(ColumnWrapperTest, FromMovedVector) {
+  auto wrapper = ColumnWrapper::Make(DataType::STRING, 0);
+  std::vector<types::StringValue> string_vector({"abc", "def"});
+  const types::StringValue* data = string_vector.data();
+  wrapper->AppendFromVector(std::move(string_vector));
+
+  // Appending to an empty column takes over the vector's buffer.
+  EXPECT_EQ(wrapper->UnsafeRawData(), data);
+
+  wrapper->AppendFromVector(std::vector<types::StringValue>{"ghi"});
+  ASSERT_EQ(wrapper->Size(), 3);
+  EXPECT_EQ(wrapper->Get<types::StringValue>(0), "abc");
+  EXPECT_EQ(wrapper->Get<types::StringValue>(1), "def");
+  EXPECT_EQ(wrapper->Get<types::StringValue>(2), "ghi");
+}
+
 TEST(ColumnWrapperTest, FromVectorString) {
   auto wrapper = ColumnWrapper::Make(DataType::STRING, 4);
   std::vector<types::StringValue> string_vector({"abc", "def", "ghi", "jkl"});
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/data_table.h"
+
+namespace px {
+namespace stirling {
+
+static constexpr DataElement kElements[] = {
+    {"time_", "", types::DataType::TIME64NS, types::SemanticType::ST_NONE,
+     types::PatternType::METRIC_COUNTER},
+    {"x", "", types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"s", "", types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+};
+static constexpr auto kTableSchema = DataTableSchema("bench_table", "", kElements);
+
+struct Columns {
+  std::vector<uint64_t> times;
+  std::vector<types::Int64Value> x;
+  std::vector<types::StringValue> s;
+};
+
+// Generates records whose times are in order, or with every pair of adjacent records swapped.
+Columns GenerateColumns(int num_records, bool in_order) {
+  Columns cols;
+  for (int i = 0; i < num_records; ++i) {
+    uint64_t time = (in_order || i % 2 == 1) ? i : i + 2;
+    cols.times.push_back(time);
+    cols.x.push_back(i);
+    cols.s.push_back(std::string(64, 'a' + i % 26));
+  }
+  return cols;
+}
+
+// NOLINTNEXTLINE(runtime/references)
+static void BM_record_builder(benchmark::State& state, bool in_order) {
+  const Columns cols = GenerateColumns(state.range(0), in_order);
+  DataTable data_table(/*id*/ 0, kTableSchema);
+
+  // Times are shifted on every iteration, as records older than those already consumed are
+  // dropped by ConsumeRecords().
+  uint64_t base_time = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < cols.times.size(); ++i) {
+      uint64_t time = base_time + cols.times[i];
+      DataTable::RecordBuilder<&kTableSchema> r(&data_table, time);
+      r.Append<r.ColIndex("time_")>(time);
+      r.Append<r.ColIndex("x")>(cols.x[i]);
+      r.Append<r.ColIndex("s")>(cols.s[i]);
+    }
+    benchmark::DoNotOptimize(data_table.ConsumeRecords());
+    base_time += cols.times.size() + 2;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// NOLINTNEXTLINE(runtime/references)
+static void BM_columnar_record_builder(benchmark::State& state, bool in_order) {
+  const Columns cols = GenerateColumns(state.range(0), in_order);
+  DataTable data_table(/*id*/ 0, kTableSchema);
+
+  // See BM_record_builder.
+  uint64_t base_time = 0;
+  for (auto _ : state) {
+    // The copies stand in for the columns that a source would build itself.
+    std::vector<uint64_t> times;
+    std::vector<types::Time64NSValue> time_col;
+    times.reserve(cols.times.size());
+    time_col.reserve(cols.times.size());
+    for (uint64_t t : cols.times) {
+      times.push_back(base_time + t);
+      time_col.push_back(base_time + t);
+    }
+    {
+      DataTable::ColumnarRecordBuilder<&kTableSchema> r(&data_table, std::move(times));
+      r.AppendColumn<r.ColIndex("time_")>(std::move(time_col));
+      r.AppendColumn<r.ColIndex("x")>(cols.x);
+      r.AppendColumn<r.ColIndex("s")>(cols.s);
+    }
+    benchmark::DoNotOptimize(data_table.ConsumeRecords());
+    base_time += cols.times.size() + 2;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_record_builder, in_order, true)->Arg(1024)->Arg(16384);
+BENCHMARK_CAPTURE(BM_record_builder, out_of_order, false)->Arg(1024)->Arg(16384);
+BENCHMARK_CAPTURE(BM_columnar_record_builder, in_order, true)->Arg(1024)->Arg(16384);
+BENCHMARK_CAPTURE(BM_columnar_record_builder, out_of_order, false)->Arg(1024)->Arg(16384);
+
+}  // namespace stirling
+}  // namespace px
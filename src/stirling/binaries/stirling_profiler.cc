@@ -20,6 +20,7 @@
 
 #include <csignal>
 #include <iostream>
+#include <string>
 #include <thread>
 
 #include "src/common/base/base.h"
@@ -63,17 +64,34 @@ class Profiler : public UnitConnector<PerfProfileConnector> {
 
  private:
   Status BuildHistogram() {
-    PX_ASSIGN_OR_RETURN(const auto& records, ConsumeRecords(0));
+    // The samples only carry stack trace IDs. The stack trace strings are in the dictionary table.
+    PX_ASSIGN_OR_RETURN(const auto& dict_records,
+                        ConsumeRecords(PerfProfileConnector::kStackTraceDictTableNum));
+    const auto dict_ids_column = dict_records[kStackTraceDictStackTraceIDIdx];
+    const auto dict_traces_column = dict_records[kStackTraceDictStackTraceStrIdx];
+    absl::flat_hash_map<int64_t, std::string> stack_traces_by_id;
+    for (size_t row_idx = 0; row_idx < dict_ids_column->Size(); ++row_idx) {
+      const int64_t id = dict_ids_column->Get<types::Int64Value>(row_idx).val;
+      stack_traces_by_id[id] = dict_traces_column->Get<types::StringValue>(row_idx);
+    }
+
+    PX_ASSIGN_OR_RETURN(const auto& records,
+                        ConsumeRecords(PerfProfileConnector::kPerfProfileTableNum));
 
-    const uint64_t num_rows = records[kStackTraceStackTraceStrIdx]->Size();
-    const auto traces_column = records[kStackTraceStackTraceStrIdx];
+    const uint64_t num_rows = records[kStackTraceStackTraceIDIdx]->Size();
+    const auto ids_column = records[kStackTraceStackTraceIDIdx];
     const auto counts_column = records[kStackTraceCountIdx];
 
     // Build the stack traces histogram.
     for (uint64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
-      const std::string& stack_trace_str = traces_column->Get<types::StringValue>(row_idx);
+      const int64_t id = ids_column->Get<types::Int64Value>(row_idx).val;
       const int64_t count = counts_column->Get<types::Int64Value>(row_idx).val;
-      histo_[stack_trace_str] += count;
+      const auto it = stack_traces_by_id.find(id);
+      if (it == stack_traces_by_id.end()) {
+        LOG(WARNING) << absl::Substitute("Missing stack trace string for stack trace ID $0.", id);
+        continue;
+      }
+      histo_[it->second] += count;
     }
     return Status::OK();
   }
@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -65,8 +66,16 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
   uint64_t next_start_time = start_time_;
 
   for (auto& [tablet_id, tablet] : tablets_) {
-    // Sort based on times.
-    std::vector<size_t> sort_indexes = utils::SortedIndexes(tablet.times);
+    // Sort based on times. Most sources append records in time order, in which case the sort is
+    // skipped.
+    const bool times_sorted = std::is_sorted(tablet.times.begin(), tablet.times.end());
+    std::vector<size_t> sort_indexes;
+    if (times_sorted) {
+      sort_indexes.resize(tablet.times.size());
+      std::iota(sort_indexes.begin(), sort_indexes.end(), 0);
+    } else {
+      sort_indexes = utils::SortedIndexes(tablet.times);
+    }
 
     // End time is cutoff time + 1, so call to SplitSortedVector() produces the following
     // classification: which classified according to:
@@ -92,7 +101,16 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
         num_expired, table_schema_.name(), end_time, tablet.times[sort_indexes[0]]);
 
     // Case 2: Pushable records. Copy to output.
-    if (num_pushable > 0) {
+    // If all the records are pushable and already in order, the columns are moved out as is.
+    // They are shrunk first so the table store does not hold on to the capacity reserved by
+    // InitBuffers(); this is a no-op for columns moved in whole by ColumnarRecordBuilder.
+    if (times_sorted && num_expired == 0 && num_carryover == 0 && num_pushable > 0) {
+      for (auto& col : tablet.records) {
+        col->ShrinkToFit();
+      }
+      next_start_time = std::max(next_start_time, tablet.times.back());
+      tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(tablet.records)});
+    } else if (num_pushable > 0) {
       // TODO(oazizi): Consider VectorView to avoid copying.
       std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
                                        sort_indexes.end() - num_carryover);
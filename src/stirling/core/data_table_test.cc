@@ -69,6 +69,46 @@ TEST_F(DataTableTest, ResultIsSorted) {
   }
 }
 
+TEST_F(DataTableTest, InOrderColumnsAreMovedOut) {
+  std::vector<types::Int64Value> x_vals = {0, 1, 2, 3};
+  const types::BaseValueType* x_data = x_vals.data();
+
+  {
+    DataTable::ColumnarRecordBuilder<&kSchema> r(data_table_.get(), {0, 10, 20, 30});
+    r.AppendColumn<r.ColIndex("time_")>({0, 10, 20, 30});
+    r.AppendColumn<r.ColIndex("x")>(std::move(x_vals));
+    r.AppendColumn<r.ColIndex("s")>({"a", "b", "c", "d"});
+  }
+
+  std::vector<TaggedRecordBatch> record_batches = data_table_->ConsumeRecords();
+
+  ASSERT_EQ(record_batches.size(), 1);
+  types::ColumnWrapperRecordBatch& rb = record_batches[0].records;
+  ASSERT_EQ(rb[0]->Size(), 4);
+
+  // The records were in time order, so the column is pushed out without being copied.
+  EXPECT_EQ(rb[1]->UnsafeRawData(), x_data);
+
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(rb[0]->Get<types::Time64NSValue>(i), 10 * static_cast<int>(i));
+    EXPECT_EQ(rb[1]->Get<types::Int64Value>(i), static_cast<int>(i));
+    EXPECT_EQ(rb[2]->Get<types::StringValue>(i), std::string(1, 'a' + i));
+  }
+
+  // The table is still usable after its columns were moved out.
+  {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), 40);
+    r.Append<r.ColIndex("time_")>(40);
+    r.Append<r.ColIndex("x")>(4);
+    r.Append<r.ColIndex("s")>("e");
+  }
+
+  record_batches = data_table_->ConsumeRecords();
+  ASSERT_EQ(record_batches.size(), 1);
+  ASSERT_EQ(record_batches[0].records[0]->Size(), 1);
+  EXPECT_EQ(record_batches[0].records[2]->Get<types::StringValue>(0), "e");
+}
+
 // No time passed to RecordBuilder, so all timestamps should be zero.
 // That means there should never be any expired or carry-over records.
 // Also, nothing should be sorted in any way.
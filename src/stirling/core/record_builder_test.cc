@@ -103,6 +103,45 @@ TEST(RecordBuilder, UnfilledColNames) {
   EXPECT_THAT(r.UnfilledColNames(), IsEmpty());
 }
 
+TEST(ColumnarRecordBuilder, StringMaxSize) {
+  DataTable data_table(/*id*/ 0, kTableSchema);
+
+  constexpr size_t kMaxStringBytes = 512;
+
+  std::string kLargeString(kMaxStringBytes + 100, 'c');
+  std::string kExpectedString(kMaxStringBytes, 'c');
+
+  DataTable::ColumnarRecordBuilder<&kTableSchema> r(&data_table, {0, 0});
+  r.AppendColumn<r.ColIndex("a")>({1, 2}, kMaxStringBytes);
+  r.AppendColumn<r.ColIndex("b")>({"foo", "bar"}, kMaxStringBytes);
+  r.AppendColumn<r.ColIndex("c")>({"baz", kLargeString}, kMaxStringBytes);
+
+  std::vector<TaggedRecordBatch> tablets = data_table.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  types::ColumnWrapperRecordBatch& record_batch = tablets[0].records;
+
+  ASSERT_THAT(record_batch, RecordBatchSizeIs(2));
+
+  EXPECT_EQ(record_batch[2]->Get<types::StringValue>(0), "baz");
+  EXPECT_THAT(record_batch[2]->Get<types::StringValue>(1), StartsWith(kExpectedString));
+  EXPECT_THAT(record_batch[2]->Get<types::StringValue>(1), EndsWith("[TRUNCATED]"));
+}
+
+TEST(ColumnarRecordBuilder, MissingColumn) {
+  DataTable data_table(/*id*/ 0, kTableSchema);
+
+  auto r_ptr = std::make_unique<DataTable::ColumnarRecordBuilder<&kTableSchema>>(
+      &data_table, std::vector<uint64_t>{0});
+  r_ptr->AppendColumn<0>({1});
+  r_ptr->AppendColumn<2>({"bar"});
+  EXPECT_DEBUG_DEATH(r_ptr.reset(), "");
+
+  // See RecordBuilder.MissingColumn.
+#if DCHECK_IS_ON()
+  r_ptr->AppendColumn<1>({"foo"});
+#endif
+}
+
 TEST(DynamicRecordBuilder, StringMaxSize) {
   DataTable data_table(/*id*/ 0, kTableSchema);
 
@@ -24,9 +24,12 @@
 #include <rapidjson/writer.h>
 
 #include <map>
+#include <optional>
+#include <utility>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/bcc_program_cache.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
 namespace px {
@@ -145,11 +148,54 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
   return elements;
 }
 
-StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
-    std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program) {
+namespace {
+
+StatusOr<dynamic_tracing::BCCProgram> CompileProgramWithCache(
+    dynamic_tracing::ir::logical::TracepointDeployment* program, bool* cache_hit) {
+  *cache_hit = false;
+  if (FLAGS_stirling_bcc_program_cache_dir.empty()) {
+    return dynamic_tracing::CompileProgram(program);
+  }
+
+  dynamic_tracing::BCCProgramCache cache(
+      FLAGS_stirling_bcc_program_cache_dir,
+      int64_t{FLAGS_stirling_bcc_program_cache_max_mb} * 1024 * 1024);
+
+  // The key must be computed before compiling, because CompileProgram() modifies the program.
+  StatusOr<std::string> key = dynamic_tracing::BCCProgramCache::Key(*program);
+  if (!key.ok()) {
+    LOG(WARNING) << absl::Substitute("Not using the BCC program cache, error: $0", key.ToString());
+    return dynamic_tracing::CompileProgram(program);
+  }
+
+  std::optional<dynamic_tracing::BCCProgram> cached = cache.Lookup(key.ValueOrDie());
+  if (cached.has_value()) {
+    LOG(INFO) << absl::Substitute("Found BCC program in cache [key=$0].", key.ValueOrDie());
+    *cache_hit = true;
+    return std::move(cached.value());
+  }
+
   PX_ASSIGN_OR_RETURN(dynamic_tracing::BCCProgram bcc_program,
                       dynamic_tracing::CompileProgram(program));
 
+  Status s = cache.Insert(key.ValueOrDie(), bcc_program);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to add BCC program to cache, error: $0",
+                                               s.ToString());
+  return bcc_program;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
+    std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program,
+    bool* cache_hit) {
+  bool program_cache_hit = false;
+  PX_ASSIGN_OR_RETURN(dynamic_tracing::BCCProgram bcc_program,
+                      CompileProgramWithCache(program, &program_cache_hit));
+  if (cache_hit != nullptr) {
+    *cache_hit = program_cache_hit;
+  }
+
   LOG(INFO) << "BCCProgram:\n" << bcc_program.ToString();
 
   if (bcc_program.perf_buffer_specs.size() != 1) {
@@ -39,8 +39,15 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
 
   ~DynamicTraceConnector() override = default;
 
+  /**
+   * Compiles the program into a BCC program and creates the connector that deploys it.
+   * The BCC program is looked up in, and added to, the on-disk cache in
+   * --stirling_bcc_program_cache_dir, if set. If cache_hit is not null, it is set to whether the
+   * BCC program was found in the cache.
+   */
   static StatusOr<std::unique_ptr<SourceConnector>> Create(
-      std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program);
+      std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program,
+      bool* cache_hit = nullptr);
 
   // Accepts a piece of data from the perf buffer.
   void AcceptDataEvents(std::string data) { data_items_.push_back(std::move(data)); }
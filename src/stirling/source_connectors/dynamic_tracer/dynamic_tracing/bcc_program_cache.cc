@@ -0,0 +1,316 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/bcc_program_cache.h"
+
+#include <farmhash.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_format.h>
+
+#include "src/common/base/file.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/stirling/utils/linux_headers.h"
+
+DEFINE_string(stirling_bcc_program_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_BCC_PROGRAM_CACHE_DIR", ""),
+              "The directory in which the BCC programs generated for dynamic tracepoints are "
+              "cached. Empty (the default) disables the cache.");
+DEFINE_int32(stirling_bcc_program_cache_max_mb,
+             gflags::Int32FromEnv("PL_STIRLING_BCC_PROGRAM_CACHE_MAX_MB", 64),
+             "The maximum size of the BCC program cache. The least recently used programs are "
+             "removed once it is exceeded.");
+
+namespace px {
+namespace stirling {
+namespace dynamic_tracing {
+
+namespace {
+
+// Identifies the serialization format. Changes to the output of CompileProgram() don't need a new
+// version, since the cache key covers the binary that contains the code generator.
+constexpr char kFormatVersion[] = "px_bcc_program_v1";
+
+// The binary that is running CompileProgram().
+constexpr char kSelfExe[] = "/proc/self/exe";
+
+class Encoder {
+ public:
+  template <typename T>
+  void Write(T val) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    buf_.append(reinterpret_cast<const char*>(&val), sizeof(T));
+  }
+
+  void WriteString(std::string_view s) {
+    Write<uint32_t>(s.size());
+    buf_.append(s);
+  }
+
+  std::string Consume() { return std::move(buf_); }
+
+ private:
+  std::string buf_;
+};
+
+class Decoder {
+ public:
+  explicit Decoder(std::string_view buf) : buf_(buf) {}
+
+  template <typename T>
+  StatusOr<T> Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (buf_.size() < sizeof(T)) {
+      return error::DataLoss("Truncated BCC program cache entry.");
+    }
+    T val;
+    std::memcpy(&val, buf_.data(), sizeof(T));
+    buf_.remove_prefix(sizeof(T));
+    return val;
+  }
+
+  StatusOr<std::string> ReadString() {
+    PX_ASSIGN_OR_RETURN(uint32_t size, Read<uint32_t>());
+    if (buf_.size() < size) {
+      return error::DataLoss("Truncated BCC program cache entry.");
+    }
+    std::string s(buf_.substr(0, size));
+    buf_.remove_prefix(size);
+    return s;
+  }
+
+  bool eof() const { return buf_.empty(); }
+
+ private:
+  std::string_view buf_;
+};
+
+}  // namespace
+
+std::string SerializeBCCProgram(const BCCProgram& program) {
+  Encoder enc;
+  enc.WriteString(kFormatVersion);
+
+  enc.Write<uint32_t>(program.uprobe_specs.size());
+  for (const auto& spec : program.uprobe_specs) {
+    enc.WriteString(spec.binary_path.string());
+    enc.WriteString(spec.symbol);
+    enc.Write<uint64_t>(spec.address);
+    enc.Write<int32_t>(spec.pid);
+    enc.Write<int32_t>(static_cast<int32_t>(spec.attach_type));
+    enc.WriteString(spec.probe_fn);
+    enc.Write<uint8_t>(spec.is_optional);
+  }
+
+  enc.Write<uint32_t>(program.perf_buffer_specs.size());
+  for (const auto& spec : program.perf_buffer_specs) {
+    enc.WriteString(spec.name);
+    enc.WriteString(spec.output.SerializeAsString());
+  }
+
+  enc.WriteString(program.code);
+  return enc.Consume();
+}
+
+StatusOr<BCCProgram> ParseBCCProgram(std::string_view data) {
+  Decoder dec(data);
+
+  PX_ASSIGN_OR_RETURN(std::string version, dec.ReadString());
+  if (version != kFormatVersion) {
+    return error::InvalidArgument("Unexpected BCC program cache entry version '$0'.", version);
+  }
+
+  BCCProgram program;
+
+  PX_ASSIGN_OR_RETURN(uint32_t num_uprobe_specs, dec.Read<uint32_t>());
+  for (uint32_t i = 0; i < num_uprobe_specs; ++i) {
+    bpf_tools::UProbeSpec spec;
+    PX_ASSIGN_OR_RETURN(std::string binary_path, dec.ReadString());
+    spec.binary_path = std::move(binary_path);
+    PX_ASSIGN_OR_RETURN(spec.symbol, dec.ReadString());
+    PX_ASSIGN_OR_RETURN(spec.address, dec.Read<uint64_t>());
+    PX_ASSIGN_OR_RETURN(spec.pid, dec.Read<int32_t>());
+    PX_ASSIGN_OR_RETURN(int32_t attach_type, dec.Read<int32_t>());
+    spec.attach_type = static_cast<bpf_tools::BPFProbeAttachType>(attach_type);
+    PX_ASSIGN_OR_RETURN(spec.probe_fn, dec.ReadString());
+    PX_ASSIGN_OR_RETURN(uint8_t is_optional, dec.Read<uint8_t>());
+    spec.is_optional = is_optional != 0;
+    program.uprobe_specs.push_back(std::move(spec));
+  }
+
+  PX_ASSIGN_OR_RETURN(uint32_t num_perf_buffer_specs, dec.Read<uint32_t>());
+  for (uint32_t i = 0; i < num_perf_buffer_specs; ++i) {
+    BCCProgram::PerfBufferSpec spec;
+    PX_ASSIGN_OR_RETURN(spec.name, dec.ReadString());
+    PX_ASSIGN_OR_RETURN(std::string output, dec.ReadString());
+    if (!spec.output.ParseFromString(output)) {
+      return error::DataLoss("Failed to parse the output struct of perf buffer $0.", spec.name);
+    }
+    program.perf_buffer_specs.push_back(std::move(spec));
+  }
+
+  PX_ASSIGN_OR_RETURN(program.code, dec.ReadString());
+
+  if (!dec.eof()) {
+    return error::DataLoss("Unexpected trailing bytes in BCC program cache entry.");
+  }
+  return program;
+}
+
+StatusOr<std::string> BCCProgramCache::Key(const ir::logical::TracepointDeployment& program) {
+  // The TTL does not affect the generated code, so redeploying with a different TTL should still
+  // hit the cache.
+  ir::logical::TracepointDeployment key_program = program;
+  key_program.clear_ttl();
+
+  std::string key_input;
+  {
+    google::protobuf::io::StringOutputStream sos(&key_input);
+    google::protobuf::io::CodedOutputStream cos(&sos);
+    cos.SetSerializationDeterministic(true);
+    key_program.SerializeToCodedStream(&cos);
+  }
+
+  // The generated code depends on the DWARF and ELF contents of the target binaries, which are
+  // identified by their inode, size and modification time.
+  for (const auto& path : program.deployment_spec().path_list().paths()) {
+    PX_ASSIGN_OR_RETURN(struct stat st, fs::Stat(path));
+    absl::StrAppend(&key_input, "\n", path, ":", st.st_ino, ":", st.st_size, ":",
+                    st.st_mtim.tv_sec, ".", st.st_mtim.tv_nsec);
+  }
+
+  absl::StrAppend(&key_input, "\nkernel:", utils::GetCachedKernelVersion().code());
+
+  // The generated code also depends on the code generator, so a new build of it never reuses the
+  // entries of an older one.
+  PX_ASSIGN_OR_RETURN(struct stat self_st, fs::Stat(kSelfExe));
+  absl::StrAppend(&key_input, "\ncodegen:", self_st.st_dev, ":", self_st.st_ino, ":",
+                  self_st.st_size, ":", self_st.st_mtim.tv_sec, ".", self_st.st_mtim.tv_nsec);
+
+  return absl::StrFormat("%016x", ::util::Fingerprint64(key_input));
+}
+
+std::filesystem::path BCCProgramCache::EntryPath(std::string_view key) const {
+  return dir_ / absl::StrCat(key, ".bcc");
+}
+
+std::optional<BCCProgram> BCCProgramCache::Lookup(std::string_view key) const {
+  std::filesystem::path path = EntryPath(key);
+  if (!fs::Exists(path)) {
+    return std::nullopt;
+  }
+
+  StatusOr<std::string> contents =
+      ReadFileToString(path, std::ios_base::in | std::ios_base::binary);
+  if (!contents.ok()) {
+    LOG(WARNING) << absl::Substitute("Failed to read BCC program cache entry $0, error: $1",
+                                     path.string(), contents.ToString());
+    return std::nullopt;
+  }
+
+  StatusOr<BCCProgram> program = ParseBCCProgram(contents.ValueOrDie());
+  if (!program.ok()) {
+    LOG(WARNING) << absl::Substitute("Ignoring invalid BCC program cache entry $0, error: $1",
+                                     path.string(), program.ToString());
+    return std::nullopt;
+  }
+
+  // The modification time of an entry is its last use, which Prune() evicts by.
+  std::error_code ec;
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+  return program.ConsumeValueOrDie();
+}
+
+Status BCCProgramCache::Insert(std::string_view key, const BCCProgram& program) const {
+  PX_RETURN_IF_ERROR(fs::CreateDirectories(dir_));
+
+  // Write to a file unique to this thread and rename it into place, which is atomic, so that
+  // readers never see a partially written entry.
+  std::filesystem::path path = EntryPath(key);
+  std::filesystem::path tmp_path =
+      absl::StrCat(path.string(), ".tmp.", getpid(), ".",
+                   std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  PX_RETURN_IF_ERROR(WriteFileFromString(tmp_path, SerializeBCCProgram(program),
+                                         std::ios_base::out | std::ios_base::binary));
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    PX_UNUSED(fs::Remove(tmp_path));
+    return error::Internal("Failed to rename $0 to $1, error: $2", tmp_path.string(),
+                           path.string(), ec.message());
+  }
+  return Prune();
+}
+
+Status BCCProgramCache::Prune() const {
+  struct Entry {
+    std::filesystem::path path;
+    int64_t size;
+    std::filesystem::file_time_type last_use;
+  };
+  std::vector<Entry> entries;
+  int64_t total_bytes = 0;
+
+  std::error_code ec;
+  for (const auto& dir_entry : std::filesystem::directory_iterator(dir_, ec)) {
+    if (dir_entry.path().extension() != ".bcc") {
+      continue;
+    }
+    // Another deployment may remove the entry concurrently, so skip entries that are gone.
+    std::error_code entry_ec;
+    Entry entry{dir_entry.path(), static_cast<int64_t>(dir_entry.file_size(entry_ec)),
+                dir_entry.last_write_time(entry_ec)};
+    if (entry_ec) {
+      continue;
+    }
+    total_bytes += entry.size;
+    entries.push_back(std::move(entry));
+  }
+  if (ec) {
+    return error::Internal("Failed to list BCC program cache $0, error: $1", dir_.string(),
+                           ec.message());
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.last_use < b.last_use; });
+  for (const auto& entry : entries) {
+    if (total_bytes <= max_bytes_) {
+      break;
+    }
+    PX_UNUSED(fs::Remove(entry.path));
+    total_bytes -= entry.size;
+  }
+  return Status::OK();
+}
+
+}  // namespace dynamic_tracing
+}  // namespace stirling
+}  // namespace px
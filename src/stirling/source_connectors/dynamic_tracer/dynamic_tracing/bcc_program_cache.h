@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/logicalpb/logical.pb.h"
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/types.h"
+
+DECLARE_string(stirling_bcc_program_cache_dir);
+DECLARE_int32(stirling_bcc_program_cache_max_mb);
+
+namespace px {
+namespace stirling {
+namespace dynamic_tracing {
+
+/**
+ * Serializes a BCCProgram into the binary format used by the BCCProgramCache.
+ */
+std::string SerializeBCCProgram(const BCCProgram& program);
+
+/**
+ * Parses the output of SerializeBCCProgram() back into a BCCProgram.
+ */
+StatusOr<BCCProgram> ParseBCCProgram(std::string_view data);
+
+/**
+ * BCCProgramCache is a content-addressed on-disk cache of the BCC programs generated by
+ * CompileProgram().
+ *
+ * Generating a BCC program requires reading the DWARF and ELF information of the target binaries,
+ * which dominates the deployment time of repeat deployments of the same tracepoint. The entries
+ * are keyed by the tracepoint deployment, the identity of the resolved target binaries, the kernel
+ * version and the identity of the running binary, which contains the code generator. So an entry is
+ * only reused when all the inputs to CompileProgram() are the same.
+ *
+ * Only the generated program is cached, since BCC compiles and loads a program in a single call.
+ *
+ * The cache directory is shared by all the tracepoints deployed on a node. Entries are written to
+ * a temporary file and renamed into place, so concurrent deployments never read a partial entry.
+ * Once the entries exceed max_bytes, the least recently used ones are removed.
+ */
+class BCCProgramCache {
+ public:
+  BCCProgramCache(std::filesystem::path dir, int64_t max_bytes)
+      : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+
+  /**
+   * Returns the cache key of the given deployment. The deployment's target paths must already be
+   * resolved with ResolveTargetObjPaths(). Returns an error if a target binary or the running
+   * binary can't be stat'ed.
+   */
+  static StatusOr<std::string> Key(const ir::logical::TracepointDeployment& program);
+
+  /**
+   * Returns the cached program for the key, or std::nullopt if there is no valid entry. A hit
+   * marks the entry as recently used.
+   */
+  std::optional<BCCProgram> Lookup(std::string_view key) const;
+
+  /**
+   * Writes the program to the cache under the key, replacing any existing entry, and then removes
+   * the least recently used entries until the cache fits in max_bytes.
+   */
+  Status Insert(std::string_view key, const BCCProgram& program) const;
+
+  const std::filesystem::path& dir() const { return dir_; }
+
+ private:
+  std::filesystem::path EntryPath(std::string_view key) const;
+  Status Prune() const;
+
+  std::filesystem::path dir_;
+  int64_t max_bytes_;
+};
+
+}  // namespace dynamic_tracing
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/bcc_program_cache.h"
+
+#include <google/protobuf/text_format.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "src/common/base/file.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace dynamic_tracing {
+
+using ::google::protobuf::TextFormat;
+using ::px::testing::TempDir;
+using ::testing::SizeIs;
+using ::testing::StrEq;
+
+constexpr int64_t kMaxBytes = 1024 * 1024;
+
+constexpr char kOutputStruct[] = R"proto(
+  name: "out_table_value_t"
+  fields {
+    name: "tgid_"
+    type: INT32
+  }
+  fields {
+    name: "arg0"
+    type: INT
+  }
+)proto";
+
+BCCProgram TestProgram() {
+  BCCProgram program;
+  program.uprobe_specs.push_back({.binary_path = "/usr/bin/test_binary",
+                                  .symbol = "main.MixedArgTypes",
+                                  .attach_type = bpf_tools::BPFProbeAttachType::kReturnInsts,
+                                  .probe_fn = "probe_entry_MixedArgTypes",
+                                  .is_optional = true});
+  program.uprobe_specs.push_back({.binary_path = "/usr/bin/test_binary",
+                                  .address = 0x1234,
+                                  .pid = 42,
+                                  .probe_fn = "probe_entry_addr"});
+  BCCProgram::PerfBufferSpec spec;
+  spec.name = "out_table";
+  CHECK(TextFormat::ParseFromString(kOutputStruct, &spec.output));
+  program.perf_buffer_specs.push_back(std::move(spec));
+  program.code = "int probe_entry_MixedArgTypes(struct pt_regs* ctx) { return 0; }";
+  return program;
+}
+
+void ExpectProgramsEqual(const BCCProgram& actual, const BCCProgram& expected) {
+  ASSERT_THAT(actual.uprobe_specs, SizeIs(expected.uprobe_specs.size()));
+  for (size_t i = 0; i < expected.uprobe_specs.size(); ++i) {
+    EXPECT_EQ(actual.uprobe_specs[i].ToString(), expected.uprobe_specs[i].ToString());
+  }
+  ASSERT_THAT(actual.perf_buffer_specs, SizeIs(expected.perf_buffer_specs.size()));
+  for (size_t i = 0; i < expected.perf_buffer_specs.size(); ++i) {
+    EXPECT_EQ(actual.perf_buffer_specs[i].ToString(), expected.perf_buffer_specs[i].ToString());
+  }
+  EXPECT_THAT(actual.code, StrEq(expected.code));
+}
+
+TEST(BCCProgramSerializationTest, RoundTrip) {
+  BCCProgram program = TestProgram();
+  ASSERT_OK_AND_ASSIGN(BCCProgram parsed, ParseBCCProgram(SerializeBCCProgram(program)));
+  ExpectProgramsEqual(parsed, program);
+}
+
+TEST(BCCProgramSerializationTest, RejectsTruncatedData) {
+  std::string data = SerializeBCCProgram(TestProgram());
+  EXPECT_NOT_OK(ParseBCCProgram(std::string_view(data).substr(0, data.size() - 1)));
+  EXPECT_NOT_OK(ParseBCCProgram(""));
+}
+
+TEST(BCCProgramCacheTest, InsertAndLookup) {
+  TempDir tmp_dir;
+  BCCProgramCache cache(tmp_dir.path() / "cache", kMaxBytes);
+
+  EXPECT_FALSE(cache.Lookup("0123456789abcdef").has_value());
+
+  BCCProgram program = TestProgram();
+  ASSERT_OK(cache.Insert("0123456789abcdef", program));
+
+  std::optional<BCCProgram> cached = cache.Lookup("0123456789abcdef");
+  ASSERT_TRUE(cached.has_value());
+  ExpectProgramsEqual(cached.value(), program);
+
+  EXPECT_FALSE(cache.Lookup("fedcba9876543210").has_value());
+}
+
+TEST(BCCProgramCacheTest, IgnoresCorruptEntries) {
+  TempDir tmp_dir;
+  BCCProgramCache cache(tmp_dir.path(), kMaxBytes);
+
+  ASSERT_OK(WriteFileFromString(tmp_dir.path() / "0123456789abcdef.bcc", "garbage"));
+  EXPECT_FALSE(cache.Lookup("0123456789abcdef").has_value());
+}
+
+TEST(BCCProgramCacheTest, RemovesLeastRecentlyUsedEntries) {
+  TempDir tmp_dir;
+  BCCProgram program = TestProgram();
+  const int64_t entry_size = SerializeBCCProgram(program).size();
+  BCCProgramCache cache(tmp_dir.path(), 2 * entry_size + entry_size / 2);
+
+  ASSERT_OK(cache.Insert("000000000000000a", program));
+  ASSERT_OK(cache.Insert("000000000000000b", program));
+  // Age both entries, so that the lookup below is clearly their most recent use.
+  auto now = std::filesystem::file_time_type::clock::now();
+  std::filesystem::last_write_time(tmp_dir.path() / "000000000000000a.bcc",
+                                   now - std::chrono::hours(2));
+  std::filesystem::last_write_time(tmp_dir.path() / "000000000000000b.bcc",
+                                   now - std::chrono::hours(1));
+  ASSERT_TRUE(cache.Lookup("000000000000000a").has_value());
+
+  // The third entry doesn't fit, so the least recently used one is removed.
+  ASSERT_OK(cache.Insert("000000000000000c", program));
+  EXPECT_TRUE(cache.Lookup("000000000000000a").has_value());
+  EXPECT_FALSE(cache.Lookup("000000000000000b").has_value());
+  EXPECT_TRUE(cache.Lookup("000000000000000c").has_value());
+}
+
+TEST(BCCProgramCacheTest, KeyDependsOnProgramAndBinary) {
+  TempDir tmp_dir;
+  std::filesystem::path binary = tmp_dir.path() / "binary";
+  ASSERT_OK(WriteFileFromString(binary, "v1"));
+
+  ir::logical::TracepointDeployment program;
+  program.set_name("test_tracepoint");
+  program.mutable_deployment_spec()->mutable_path_list()->add_paths(binary.string());
+  program.add_tracepoints()->set_table_name("out_table");
+
+  ASSERT_OK_AND_ASSIGN(std::string key, BCCProgramCache::Key(program));
+
+  // The TTL does not change the key.
+  ir::logical::TracepointDeployment program_with_ttl = program;
+  program_with_ttl.mutable_ttl()->set_seconds(60);
+  EXPECT_OK_AND_EQ(BCCProgramCache::Key(program_with_ttl), key);
+
+  // The program does.
+  ir::logical::TracepointDeployment other_program = program;
+  other_program.mutable_tracepoints(0)->set_table_name("other_table");
+  ASSERT_OK_AND_ASSIGN(std::string other_key, BCCProgramCache::Key(other_program));
+  EXPECT_NE(other_key, key);
+
+  // So does a change to the binary.
+  ASSERT_OK(WriteFileFromString(binary, "v2 is longer"));
+  ASSERT_OK_AND_ASSIGN(std::string new_binary_key, BCCProgramCache::Key(program));
+  EXPECT_NE(new_binary_key, key);
+
+  // A missing binary is an error.
+  ASSERT_OK(fs::Remove(binary));
+  EXPECT_NOT_OK(BCCProgramCache::Key(program));
+}
+
+}  // namespace dynamic_tracing
+}  // namespace stirling
+}  // namespace px
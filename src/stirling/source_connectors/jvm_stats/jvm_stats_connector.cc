@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/jvm_stats/jvm_stats_connector.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +26,7 @@
 #include "src/common/base/base.h"
 #include "src/common/base/byte_utils.h"
 #include "src/stirling/source_connectors/jvm_stats/jvm_stats_table.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata_reader.h"
 #include "src/stirling/source_connectors/jvm_stats/utils/java.h"
 #include "src/stirling/utils/detect_application.h"
 #include "src/stirling/utils/proc_tracker.h"
@@ -69,21 +71,20 @@ void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   }
 }
 
-Status JVMStatsConnector::ExportStats(const md::UPID& upid,
-                                      const std::filesystem::path& hsperf_data_path,
-                                      DataTable* data_table) const {
-  PX_ASSIGN_OR_RETURN(std::string hsperf_data_str, ReadFileToString(hsperf_data_path));
-
-  if (hsperf_data_str.empty()) {
-    // Assume this is a transient failure.
-    return Status::OK();
+Status JVMStatsConnector::ExportStats(const md::UPID& upid, JavaProcInfo* java_proc,
+                                      DataTable* data_table) {
+  if (java_proc->hsperf_data_reader == nullptr) {
+    java_proc->hsperf_data_reader =
+        std::make_unique<java::HsperfdataReader>(java_proc->hsperf_data_path);
   }
 
-  java::Stats stats(std::move(hsperf_data_str));
-  if (!stats.Parse().ok()) {
-    // Assumes this is a transient failure.
+  StatusOr<java::Stats> stats_or = java_proc->hsperf_data_reader->ReadStats();
+  if (error::IsResourceUnavailable(stats_or.status())) {
+    // Assume this is a transient failure, e.g. the JVM has not yet initialized the file.
     return Status::OK();
   }
+  PX_RETURN_IF_ERROR(stats_or.status());
+  const java::Stats& stats = stats_or.ValueOrDie();
 
   uint64_t time = AdjustedSteadyClockNowNS();
 
@@ -114,7 +115,7 @@ void JVMStatsConnector::TransferDataImpl(ConnectorContext* ctx) {
     JavaProcInfo& java_proc = iter->second;
 
     md::UPID upid_with_asid(ctx->GetASID(), upid.pid(), upid.start_ts());
-    auto status = ExportStats(upid_with_asid, java_proc.hsperf_data_path, data_table);
+    auto status = ExportStats(upid_with_asid, &java_proc, data_table);
     if (!status.ok()) {
       ++java_proc.export_failure_count;
     }
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "src/common/base/byte_utils.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+using ::px::utils::LEndianBytesToInt;
+
+namespace {
+
+constexpr size_t kLongByteSize = 8;
+
+}  // namespace
+
+HsperfdataReader::~HsperfdataReader() { Unmap(); }
+
+void HsperfdataReader::Unmap() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  inode_ = 0;
+  index_.clear();
+  indexed_num_entries_ = 0;
+}
+
+Status HsperfdataReader::Map(const struct stat& st) {
+  Unmap();
+
+  if (st.st_size == 0) {
+    return error::ResourceUnavailable("hsperfdata file $0 is empty.", path_.string());
+  }
+
+  int fd = open(path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return error::Internal("Failed to open $0, error: $1.", path_.string(), std::strerror(errno));
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Failed to mmap $0, error: $1.", path_.string(), std::strerror(errno));
+  }
+
+  data_ = static_cast<const char*>(addr);
+  size_ = st.st_size;
+  inode_ = st.st_ino;
+  ++num_maps_;
+  return Status::OK();
+}
+
+Status HsperfdataReader::BuildIndex() {
+  index_.clear();
+  indexed_num_entries_ = 0;
+
+  hsperf::HsperfData hsperf_data = {};
+  Status s = hsperf::ParseHsperfData(std::string_view(data_, size_), &hsperf_data);
+  if (!s.ok()) {
+    return error::ResourceUnavailable("Failed to parse hsperfdata file $0, error: $1",
+                                      path_.string(), s.msg());
+  }
+
+  for (const auto& entry : hsperf_data.data_entries) {
+    if (entry.header->data_type != static_cast<uint8_t>(hsperf::DataType::kLong) ||
+        entry.data.size() != kLongByteSize || !Stats::IsExportedStat(entry.name)) {
+      continue;
+    }
+    index_.push_back({std::string(entry.name), static_cast<size_t>(entry.data.data() - data_)});
+  }
+  indexed_num_entries_ = hsperf_data.prologue->num_entries;
+  ++num_indexes_;
+  return Status::OK();
+}
+
+StatusOr<Stats> HsperfdataReader::ReadStats() {
+  PX_ASSIGN_OR_RETURN(struct stat st, fs::Stat(path_));
+
+  if (data_ == nullptr || st.st_ino != inode_ || static_cast<size_t>(st.st_size) != size_) {
+    PX_RETURN_IF_ERROR(Map(st));
+  }
+
+  // The JVM only appends entries, so the existing offsets stay valid until the number of entries
+  // changes. The index is also retried if the file was not yet valid when it was last built.
+  const auto* prologue = reinterpret_cast<const hsperf::Prologue*>(data_);
+  if (size_ < sizeof(hsperf::Prologue) || indexed_num_entries_ == 0 ||
+      prologue->num_entries != indexed_num_entries_) {
+    PX_RETURN_IF_ERROR(BuildIndex());
+  }
+
+  std::vector<Stats::Stat> stats;
+  stats.reserve(index_.size());
+  for (const auto& stat : index_) {
+    auto value = LEndianBytesToInt<uint64_t>(std::string_view(data_ + stat.offset, kLongByteSize));
+    stats.push_back({stat.name, value});
+  }
+  return Stats(std::move(stats));
+}
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
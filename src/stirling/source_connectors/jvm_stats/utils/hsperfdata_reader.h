@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/java.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+/**
+ * HsperfdataReader reads the stats exported by java::Stats from a JVM's hsperfdata file.
+ *
+ * The JVM updates the counters in the hsperfdata file in place. So instead of reading and parsing
+ * the whole file on every read, the file is memory-mapped once, and indexed to find the offsets of
+ * the counters used by java::Stats. Subsequent reads only load those counters from the mapping.
+ * The file is re-mapped if it is replaced (e.g. the JVM restarted) or resized, and re-indexed if
+ * the JVM added entries since the last read.
+ */
+class HsperfdataReader : public NotCopyMoveable {
+ public:
+  explicit HsperfdataReader(std::filesystem::path path) : path_(std::move(path)) {}
+  ~HsperfdataReader();
+
+  /**
+   * Returns the current stats. The returned Stats refers to names owned by this reader, and must
+   * not be used after the next call to ReadStats().
+   *
+   * Returns a ResourceUnavailable error if the file is empty or not yet valid, which is expected
+   * while the JVM is starting up.
+   */
+  StatusOr<Stats> ReadStats();
+
+  // How many times the file was mapped and indexed. For testing.
+  int num_maps() const { return num_maps_; }
+  int num_indexes() const { return num_indexes_; }
+
+ private:
+  Status Map(const struct stat& st);
+  void Unmap();
+  Status BuildIndex();
+
+  struct IndexedStat {
+    std::string name;
+    // The offset of the 8-byte value from the start of the file.
+    size_t offset;
+  };
+
+  std::filesystem::path path_;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  ino_t inode_ = 0;
+
+  // The number of entries in the prologue when the index was built.
+  uint32_t indexed_num_entries_ = 0;
+  std::vector<IndexedStat> index_;
+
+  int num_maps_ = 0;
+  int num_indexes_ = 0;
+};
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
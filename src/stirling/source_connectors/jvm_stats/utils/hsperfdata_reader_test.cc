@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata_reader.h"
+
+#include <fstream>
+#include <string>
+
+#include "src/common/base/base.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata.h"
+
+namespace px {
+namespace stirling {
+namespace java {
+
+using ::px::testing::BazelRunfilePath;
+using ::px::testing::TempDir;
+
+constexpr std::string_view kYoungGCTimeName = "sun.gc.collector.0.time";
+
+class HsperfdataReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(hsperf_data_,
+                         ReadFileToString(BazelRunfilePath(
+                             "src/stirling/source_connectors/jvm_stats/utils/test_hsperfdata")));
+    path_ = temp_dir_.path() / "hsperfdata";
+    ASSERT_OK(WriteFileFromString(path_, hsperf_data_));
+  }
+
+  // Overwrites the value of the named long counter in the file, without replacing the file.
+  void UpdateCounter(std::string_view name, uint64_t value) {
+    hsperf::HsperfData data = {};
+    ASSERT_OK(hsperf::ParseHsperfData(hsperf_data_, &data));
+    for (const auto& entry : data.data_entries) {
+      if (entry.name == name) {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(entry.data.data() - hsperf_data_.data());
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        return;
+      }
+    }
+    FAIL() << "No entry named " << name;
+  }
+
+  TempDir temp_dir_;
+  std::filesystem::path path_;
+  std::string hsperf_data_;
+};
+
+TEST_F(HsperfdataReaderTest, MatchesParsedStats) {
+  Stats expected(hsperf_data_);
+  ASSERT_OK(expected.Parse());
+
+  HsperfdataReader reader(path_);
+  ASSERT_OK_AND_ASSIGN(Stats stats, reader.ReadStats());
+  EXPECT_EQ(stats.YoungGCTimeNanos(), expected.YoungGCTimeNanos());
+  EXPECT_EQ(stats.FullGCTimeNanos(), expected.FullGCTimeNanos());
+  EXPECT_EQ(stats.UsedHeapSizeBytes(), expected.UsedHeapSizeBytes());
+  EXPECT_EQ(stats.TotalHeapSizeBytes(), expected.TotalHeapSizeBytes());
+  EXPECT_EQ(stats.MaxHeapSizeBytes(), expected.MaxHeapSizeBytes());
+}
+
+// Tests that counters updated in place are read from the existing mapping and index.
+TEST_F(HsperfdataReaderTest, ReadsUpdatedCountersWithoutReindexing) {
+  HsperfdataReader reader(path_);
+  ASSERT_OK(reader.ReadStats());
+
+  UpdateCounter(kYoungGCTimeName, 12345);
+
+  ASSERT_OK_AND_ASSIGN(Stats stats, reader.ReadStats());
+  EXPECT_EQ(stats.YoungGCTimeNanos(), 12345);
+  EXPECT_EQ(reader.num_maps(), 1);
+  EXPECT_EQ(reader.num_indexes(), 1);
+}
+
+// Tests that a replaced file, like the one of a restarted JVM with the same PID, is re-mapped.
+TEST_F(HsperfdataReaderTest, RemapsReplacedFile) {
+  HsperfdataReader reader(path_);
+  ASSERT_OK(reader.ReadStats());
+
+  std::filesystem::path new_path = temp_dir_.path() / "hsperfdata.new";
+  ASSERT_OK(WriteFileFromString(new_path, hsperf_data_));
+  std::filesystem::rename(new_path, path_);
+
+  ASSERT_OK(reader.ReadStats());
+  EXPECT_EQ(reader.num_maps(), 2);
+  EXPECT_EQ(reader.num_indexes(), 2);
+}
+
+TEST_F(HsperfdataReaderTest, EmptyFileIsUnavailable) {
+  ASSERT_OK(WriteFileFromString(path_, ""));
+
+  HsperfdataReader reader(path_);
+  auto stats_or = reader.ReadStats();
+  EXPECT_TRUE(error::IsResourceUnavailable(stats_or.status()));
+}
+
+TEST_F(HsperfdataReaderTest, MissingFile) {
+  HsperfdataReader reader(temp_dir_.path() / "missing");
+  EXPECT_NOT_OK(reader.ReadStats());
+}
+
+}  // namespace java
+}  // namespace stirling
+}  // namespace px
@@ -20,6 +20,8 @@
 
 #include <absl/strings/match.h>
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
@@ -60,33 +62,54 @@ Status Stats::Parse() {
   return Status::OK();
 }
 
-uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix("gc.collector.0.time"); }
+namespace {
+
+constexpr std::string_view kYoungGCTimeSuffix = "gc.collector.0.time";
+constexpr std::string_view kFullGCTimeSuffix = "gc.collector.1.time";
+constexpr std::string_view kUsedHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.used",
+    "gc.generation.0.space.1.used",
+    "gc.generation.0.space.2.used",
+    "gc.generation.1.space.0.used",
+};
+constexpr std::string_view kTotalHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.capacity",
+    "gc.generation.0.space.1.capacity",
+    "gc.generation.0.space.2.capacity",
+    "gc.generation.1.space.0.capacity",
+};
+constexpr std::string_view kMaxHeapSizeSuffixes[] = {
+    "gc.generation.0.maxCapacity",
+    "gc.generation.1.maxCapacity",
+};
+
+}  // namespace
+
+bool Stats::IsExportedStat(std::string_view name) {
+  auto ends_with = [name](std::string_view suffix) { return absl::EndsWith(name, suffix); };
+  return ends_with(kYoungGCTimeSuffix) || ends_with(kFullGCTimeSuffix) ||
+         std::any_of(std::begin(kUsedHeapSizeSuffixes), std::end(kUsedHeapSizeSuffixes),
+                     ends_with) ||
+         std::any_of(std::begin(kTotalHeapSizeSuffixes), std::end(kTotalHeapSizeSuffixes),
+                     ends_with) ||
+         std::any_of(std::begin(kMaxHeapSizeSuffixes), std::end(kMaxHeapSizeSuffixes), ends_with);
+}
+
+uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix(kYoungGCTimeSuffix); }
 
-uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix("gc.collector.1.time"); }
+uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix(kFullGCTimeSuffix); }
 
 uint64_t Stats::UsedHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.used",
-      "gc.generation.0.space.1.used",
-      "gc.generation.0.space.2.used",
-      "gc.generation.1.space.0.used",
-  });
+  return SumStatsForSuffixes({std::begin(kUsedHeapSizeSuffixes), std::end(kUsedHeapSizeSuffixes)});
 }
 
 uint64_t Stats::TotalHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.capacity",
-      "gc.generation.0.space.1.capacity",
-      "gc.generation.0.space.2.capacity",
-      "gc.generation.1.space.0.capacity",
-  });
+  return SumStatsForSuffixes(
+      {std::begin(kTotalHeapSizeSuffixes), std::end(kTotalHeapSizeSuffixes)});
 }
 
 uint64_t Stats::MaxHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.maxCapacity",
-      "gc.generation.1.maxCapacity",
-  });
+  return SumStatsForSuffixes({std::begin(kMaxHeapSizeSuffixes), std::end(kMaxHeapSizeSuffixes)});
 }
 
 uint64_t Stats::StatForSuffix(std::string_view suffix) const {
@@ -50,6 +50,11 @@ class Stats {
    */
   Status Parse();
 
+  /**
+   * Returns true if the stat with this name is used to compute the exported stats.
+   */
+  static bool IsExportedStat(std::string_view name);
+
   uint64_t YoungGCTimeNanos() const;
   uint64_t FullGCTimeNanos() const;
   uint64_t UsedHeapSizeBytes() const;
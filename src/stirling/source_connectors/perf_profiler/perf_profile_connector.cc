@@ -40,6 +40,14 @@ DEFINE_uint32(stirling_profiler_table_update_period_seconds,
               "Number of seconds between profiler table updates.");
 DEFINE_uint32(stirling_profiler_stack_trace_sample_period_ms, 11,
               "Number of milliseconds between stack trace samples.");
+DEFINE_bool(stirling_profiler_stack_trace_strings,
+            gflags::BoolFromEnv("PL_PROFILER_STACK_TRACE_STRINGS", true),
+            "Whether to also write the stack trace string with every sample in stack_traces.beta. "
+            "The strings are always available by ID in stack_trace_dict.beta. Disabling this saves "
+            "memory, but leaves the stack_trace column of stack_traces.beta empty.");
+DEFINE_uint32(stirling_profiler_stack_trace_dict_refresh_seconds, 60,
+              "Number of seconds after which a stack trace that is still being sampled is recorded "
+              "again in stack_trace_dict.beta, so that its string outlives expired rows.");
 
 // Scaling factor is sized to avoid hash table collisions and timing variations.
 DEFINE_double(stirling_profiler_stack_trace_size_factor, 3.0,
@@ -308,7 +316,7 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 }
 
 void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                                         DataTable* data_table) {
+                                         DataTable* data_table, DataTable* dict_table) {
   constexpr size_t kMaxSymbolSize = 512;
   constexpr size_t kMaxStackDepth = 64;
   constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
@@ -323,23 +331,62 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, Conn
 
   StackTraceHisto stack_trace_histogram = AggregateStackTraces(ctx, stack_traces);
 
+  const uint64_t dict_refresh_ns =
+      std::chrono::nanoseconds(
+          std::chrono::seconds(FLAGS_stirling_profiler_stack_trace_dict_refresh_seconds))
+          .count();
+
   constexpr auto age_tick_period = std::chrono::minutes(5);
   if (sampling_freq_mgr_.count() % (age_tick_period / sampling_period_) == 0) {
     stack_trace_ids_.AgeTick();
+    // Forget the IDs that weren't recorded recently; they are recorded afresh if sampled again.
+    for (auto it = stack_trace_dict_times_.begin(); it != stack_trace_dict_times_.end();) {
+      if (timestamp_ns - it->second >= dict_refresh_ns) {
+        stack_trace_dict_times_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
   }
 
   for (const auto& [key, count] : stack_trace_histogram) {
+    const uint64_t stack_trace_id = stack_trace_ids_.Lookup(key);
+
+    // The string of a stack trace is recorded in the dictionary table when its ID is first
+    // sampled, and again whenever the ID is sampled after its latest dictionary row is older than
+    // the refresh period. The dictionary rows may expire sooner than the samples, so this keeps a
+    // recent row around for every ID that samples still reference.
+    auto dict_time_it = stack_trace_dict_times_.find(stack_trace_id);
+    const bool record_string = dict_time_it == stack_trace_dict_times_.end() ||
+                               timestamp_ns - dict_time_it->second >= dict_refresh_ns;
+    if (dict_table != nullptr && record_string) {
+      stack_trace_dict_times_[stack_trace_id] = timestamp_ns;
+      DataTable::RecordBuilder<&kStackTraceDictTable> r(dict_table, timestamp_ns);
+      r.Append<r.ColIndex("time_")>(timestamp_ns);
+      r.Append<r.ColIndex("upid")>(key.upid.value());
+      r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id);
+      r.Append<r.ColIndex("stack_trace")>(key.stack_trace_str, kMaxStackTraceSize);
+    }
+
+    if (data_table == nullptr) {
+      continue;
+    }
     DataTable::RecordBuilder<&kStackTraceTable> r(data_table, timestamp_ns);
 
     r.Append<r.ColIndex("time_")>(timestamp_ns);
     r.Append<r.ColIndex("upid")>(key.upid.value());
-    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_ids_.Lookup(key));
-    r.Append<r.ColIndex("stack_trace")>(key.stack_trace_str, kMaxStackTraceSize);
+    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id);
+    if (FLAGS_stirling_profiler_stack_trace_strings) {
+      r.Append<r.ColIndex("stack_trace")>(key.stack_trace_str, kMaxStackTraceSize);
+    } else {
+      r.Append<r.ColIndex("stack_trace")>("");
+    }
     r.Append<r.ColIndex("count")>(count);
   }
 }
 
-void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table) {
+void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                                                 DataTable* dict_table) {
   // Choose the maps to consume.
   const bool using_map_set_a = transfer_count_ % 2 == 0;
   auto& stack_traces = using_map_set_a ? stack_traces_a_ : stack_traces_b_;
@@ -358,7 +405,7 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
   LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
   // Read BPF stack traces & histogram, build records, incorporate records to data table.
-  CreateRecords(stack_traces.get(), ctx, data_table);
+  CreateRecords(stack_traces.get(), ctx, data_table, dict_table);
 
   uint64_t num_stack_traces_sampled;
   profiler_state_->get_value(sample_count_idx, num_stack_traces_sampled);
@@ -407,15 +454,16 @@ void PerfProfileConnector::CheckProfilerState(const uint64_t num_stack_traces) {
 }
 
 void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx) {
-  DCHECK_EQ(data_tables_.size(), 1U);
+  DCHECK_EQ(data_tables_.size(), 2U) << "PerfProfileConnector has two data tables.";
 
-  auto* data_table = data_tables_[0];
+  auto* data_table = data_tables_[kPerfProfileTableNum];
+  auto* dict_table = data_tables_[kStackTraceDictTableNum];
 
-  if (data_table == nullptr) {
+  if (data_table == nullptr && dict_table == nullptr) {
     return;
   }
 
-  ProcessBPFStackTraces(ctx, data_table);
+  ProcessBPFStackTraces(ctx, data_table, dict_table);
 
   // Cleanup the symbolizer so we don't leak memory.
   proc_tracker_.Update(ctx->GetUPIDs());
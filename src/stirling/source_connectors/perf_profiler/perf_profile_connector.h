@@ -23,6 +23,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/metrics/metrics.h"
 #include "src/shared/types/types.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
@@ -49,8 +51,9 @@ static constexpr std::string_view kNotSymbolizedMessage = "<not symbolized>";
 class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "perf_profiler";
-  static constexpr auto kTables = MakeArray(kStackTraceTable);
+  static constexpr auto kTables = MakeArray(kStackTraceTable, kStackTraceDictTable);
   static constexpr uint32_t kPerfProfileTableNum = TableNum(kTables, kStackTraceTable);
+  static constexpr uint32_t kStackTraceDictTableNum = TableNum(kTables, kStackTraceDictTable);
 
   static std::unique_ptr<PerfProfileConnector> Create(std::string_view name) {
     return std::unique_ptr<PerfProfileConnector>(new PerfProfileConnector(name));
@@ -91,11 +94,13 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   explicit PerfProfileConnector(std::string_view source_name);
 
-  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table);
+  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                             DataTable* dict_table);
 
-  // Read BPF data structures, build & incorporate records to the table.
+  // Read BPF data structures, build & incorporate records to the tables.
+  // The stack trace strings go to dict_table, once per stack trace ID and generation.
   void CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                     DataTable* data_table);
+                     DataTable* data_table, DataTable* dict_table);
 
   StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces);
 
@@ -123,6 +128,9 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Tracks unique stack trace ids, for the lifetime of Stirling:
   StackTraceIDCache stack_trace_ids_;
 
+  // The time of the latest stack_trace_dict.beta row of each recently sampled stack trace ID.
+  absl::flat_hash_map<uint64_t, uint64_t> stack_trace_dict_times_;
+
   // The raw histogram from BPF; it is populated on each iteration by a call to PollPerfBuffer().
   RawHistoData raw_histo_data_;
 
@@ -31,7 +31,8 @@ namespace stirling {
 // We maintain these IDs for a number of reasons:
 //  1) The IDs enable more efficient aggregations across time samples in Carnot:
 //     aggregations with integers are more efficient than aggregations with strings.
-//  2) The IDs enable table normalization (future work).
+//  2) The IDs enable table normalization: the stack trace strings are written to a separate
+//     dictionary table by ID, instead of with every sample.
 //
 // As a cache, it should be noted that no guarantee is made that a stack trace from one time
 // period is assigned the same stack trace ID. Any consumer of the data can only assume that
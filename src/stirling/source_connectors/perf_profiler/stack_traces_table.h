@@ -38,7 +38,9 @@ static constexpr DataElement kElements[] = {
     {"stack_trace",
      "A stack trace within the sampled process, in folded format. "
      "The call stack symbols are separated by semicolons. "
-     "If symbols cannot be resolved, addresses are populated instead.",
+     "If symbols cannot be resolved, addresses are populated instead. "
+     "Empty if stack trace strings are disabled in the profiler; "
+     "the stack_trace_id can then be looked up in stack_trace_dict.beta.",
      types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"count",
      "Number of times the stack trace has been sampled.",
@@ -60,5 +62,33 @@ constexpr int kStackTraceStackTraceIDIdx = kStackTraceTable.ColIndex("stack_trac
 constexpr int kStackTraceStackTraceStrIdx = kStackTraceTable.ColIndex("stack_trace");
 constexpr int kStackTraceCountIdx = kStackTraceTable.ColIndex("count");
 
+// clang-format off
+static constexpr DataElement kDictElements[] = {
+    canonical_data_elements::kTime,
+    canonical_data_elements::kUPID,
+    {"stack_trace_id",
+     "A unique identifier of the stack trace, as found in stack_traces.beta.",
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"stack_trace",
+     "The stack trace with this ID, in folded format. "
+     "The call stack symbols are separated by semicolons. "
+     "If symbols cannot be resolved, addresses are populated instead.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+};
+
+constexpr auto kStackTraceDictTable = DataTableSchema(
+        "stack_trace_dict.beta",
+        "The stack trace strings of the stack trace IDs in stack_traces.beta. "
+        "A stack trace is recorded here when it is first sampled, and again whenever it is sampled "
+        "after its latest row here is older than the refresh period (a minute by default).",
+        kDictElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(StackTraceDict)
+
+constexpr int kStackTraceDictUPIDIdx = kStackTraceDictTable.ColIndex("upid");
+constexpr int kStackTraceDictStackTraceIDIdx = kStackTraceDictTable.ColIndex("stack_trace_id");
+constexpr int kStackTraceDictStackTraceStrIdx = kStackTraceDictTable.ColIndex("stack_trace");
+
 }  // namespace stirling
 }  // namespace px
@@ -135,9 +135,9 @@ void ProcExitConnector::TransferDataImpl(ConnectorContext* ctx) {
   events_.clear();
 }
 
-void ProcExitConnector::UpdateCrashedJavaProcCounters(
-    uint32_t asid, const proc_exit_event_t& event,
-    const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& upid_pid_info_map) {
+void ProcExitConnector::UpdateCrashedJavaProcCounters(uint32_t asid,
+                                                      const proc_exit_event_t& event,
+                                                      const md::PIDInfoMap& upid_pid_info_map) {
   const uint8_t exit_signal = GetExitSignal(event.exit_code);
 
   const bool is_sig_abrt = exit_signal == SIGABRT;
@@ -40,8 +40,8 @@
 
 const int32_t kInvalidFD = -1;
 
-// This is the amount of activity required on a connection before a new ConnStats event
-// is reported to user-space. It applies to read and write traffic combined.
+// This is the amount of activity required on a connection before its ConnStats are updated in
+// conn_stats_map. It applies to read and write traffic combined.
 const int kConnStatsDataThreshold = 65536;
 
 // This is the perf buffer for BPF program to export data from kernel to user space.
@@ -63,6 +63,13 @@ BPF_PERCPU_ARRAY(control_map, uint64_t, kNumProtocols);
 // Key is {tgid, fd}.
 BPF_HASH(conn_info_map, uint64_t, struct conn_info_t, 131072);
 
+// Map holding the latest ConnStats snapshot of each active connection, which user-space drains
+// once per sampling period. Since the snapshots are cumulative, only the last one matters, so
+// batching them here replaces a perf buffer submission per threshold crossing with a single map
+// update. The final snapshot of a connection is still submitted on conn_stats_events at close().
+// Key is {tgid, fd}.
+BPF_HASH(conn_stats_map, uint64_t, struct conn_stats_event_t, 131072);
+
 // Map to indicate which connections (TGID+FD), user-space has disabled.
 // This is tracked separately from conn_info_map to avoid any read-write races.
 // This particular map is only written from user-space, and only read from BPF.
@@ -719,7 +726,8 @@ static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t*
   if (meets_activity_threshold) {
     struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
     if (event != NULL) {
-      conn_stats_events.perf_submit(ctx, event, sizeof(struct conn_stats_event_t));
+      uint64_t tgid_fd = gen_tgid_fd(conn_info->conn_id.upid.tgid, conn_info->conn_id.fd);
+      conn_stats_map.update(&tgid_fd, event);
     }
 
     conn_info->last_reported_bytes = conn_info->rd_bytes + conn_info->wr_bytes;
@@ -935,6 +943,8 @@ static __inline void process_syscall_close(struct pt_regs* ctx, uint64_t id,
     }
   }
 
+  // The close event above supersedes any snapshot that user-space has not drained yet.
+  conn_stats_map.delete(&tgid_fd);
   conn_info_map.delete(&tgid_fd);
 }
 
@@ -32,11 +32,21 @@ ConnStats::AggKey BuildAggKey(const upid_t& upid, endpoint_role_t role,
   // Both local UPID and remote endpoint must be fully specified.
   DCHECK_NE(upid.pid, 0U);
   DCHECK_NE(upid.start_time_ticks, 0U);
-  DCHECK(remote_endpoint.family != SockAddrFamily::kUnspecified);
   DCHECK(role != kRoleUnknown);
+  DCHECK(remote_endpoint.family == SockAddrFamily::kIPv4 ||
+         remote_endpoint.family == SockAddrFamily::kIPv6);
+
+  struct in6_addr remote_addr;
+  if (remote_endpoint.family == SockAddrFamily::kIPv4) {
+    InetAddr v4_addr{InetAddrFamily::kIPv4, std::get<SockAddrIPv4>(remote_endpoint.addr).addr};
+    remote_addr = std::get<struct in6_addr>(MapIPv4ToIPv6(v4_addr).addr);
+  } else {
+    remote_addr = std::get<SockAddrIPv6>(remote_endpoint.addr).addr;
+  }
+
   return {
       .upid = upid,
-      .remote_addr = remote_endpoint.AddrStr(),
+      .remote_addr = remote_addr,
       // Set port to 0 if this event is from a server process.
       // This avoids creating excessive amount of records from changing ports of K8s services.
       .remote_port = role == kRoleServer ? 0 : remote_endpoint.port(),
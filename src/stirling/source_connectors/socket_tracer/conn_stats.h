@@ -19,12 +19,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 #include <absl/hash/hash.h>
 
+#include "src/common/base/inet_utils.h"
 #include "src/shared/upid/upid.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 #include "src/stirling/upid/upid.h"
@@ -44,9 +46,13 @@ class ConnStats {
   // The upid represents the local process and the remote addr+port represents the remote endpoint.
   // When the local process (upid) represents a servers, the remote port of the client will be
   // set to 0 by BuildAggKey() to collapse multiple connections from the same client to a server.
+  //
+  // The remote address is kept in binary form, with IPv4 addresses mapped to IPv6
+  // (::ffff:x.x.x.x), so that hashing and comparing a key does not touch any strings. It is only
+  // formatted, by RemoteAddrStr(), when the record is exported.
   struct AggKey {
     struct upid_t upid;
-    std::string remote_addr;
+    struct in6_addr remote_addr;
     int remote_port;
 
     bool operator==(const AggKey& rhs) const {
@@ -56,12 +62,20 @@ class ConnStats {
 
     template <typename H>
     friend H AbslHashValue(H h, const AggKey& key) {
-      return H::combine(std::move(h), key.upid.tgid, key.upid.start_time_ticks, key.remote_addr,
+      return H::combine(std::move(h), key.upid.tgid, key.upid.start_time_ticks,
+                        std::string_view(reinterpret_cast<const char*>(&key.remote_addr),
+                                         sizeof(key.remote_addr)),
                         key.remote_port);
     }
 
+    // IPv4 addresses are printed in IPv4 style.
+    std::string RemoteAddrStr() const {
+      return IPv6AddrToString(remote_addr).ValueOr("<Could not decode>");
+    }
+
     std::string ToString() const {
-      return absl::Substitute("[tgid=$0 addr=$1 port=$2]", upid.tgid, remote_addr, remote_port);
+      return absl::Substitute("[tgid=$0 addr=$1 port=$2]", upid.tgid, RemoteAddrStr(),
+                              remote_port);
     }
   };
 
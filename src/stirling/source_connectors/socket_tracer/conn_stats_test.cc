@@ -35,6 +35,7 @@ using ::testing::AllOf;
 using ::testing::Field;
 using ::testing::IsEmpty;
 using ::testing::Pair;
+using ::testing::Property;
 using ::testing::SizeIs;
 
 TEST(HashTest, CanBeUsedInFlatHashMap) {
@@ -43,9 +44,10 @@ TEST(HashTest, CanBeUsedInFlatHashMap) {
 
   ConnStats::AggKey key = {
       .upid = {.tgid = 1, .start_time_ticks = 2},
-      .remote_addr = "test",
+      .remote_addr = {},
       .remote_port = 12345,
   };
+  ASSERT_OK(ParseIPv6Addr("::ffff:1.1.1.1", &key.remote_addr));
 
   map[key] = 1;
   EXPECT_THAT(map, SizeIs(1));
@@ -61,6 +63,20 @@ TEST(HashTest, CanBeUsedInFlatHashMap) {
   EXPECT_THAT(map, SizeIs(2));
 }
 
+TEST(HashTest, RemoteAddrIsFormattedOnDemand) {
+  ConnStats::AggKey key = {
+      .upid = {.tgid = 1, .start_time_ticks = 2},
+      .remote_addr = {},
+      .remote_port = 12345,
+  };
+
+  ASSERT_OK(ParseIPv6Addr("::ffff:1.1.1.1", &key.remote_addr));
+  EXPECT_EQ(key.RemoteAddrStr(), "1.1.1.1");
+
+  ASSERT_OK(ParseIPv6Addr("2001:db8::1", &key.remote_addr));
+  EXPECT_EQ(key.RemoteAddrStr(), "2001:db8::1");
+}
+
 class ConnStatsTest : public ::testing::Test {
  protected:
   ConnStatsTest() : conn_stats_(&conn_trackers_mgr_) {}
@@ -71,7 +87,7 @@ class ConnStatsTest : public ::testing::Test {
 
 auto AggKeyIs(int tgid, std::string_view remote_addr, int remote_port) {
   return AllOf(Field(&ConnStats::AggKey::upid, Field(&upid_t::tgid, tgid)),
-               Field(&ConnStats::AggKey::remote_addr, remote_addr),
+               Property(&ConnStats::AggKey::RemoteAddrStr, remote_addr),
                Field(&ConnStats::AggKey::remote_port, remote_port));
 }
 
@@ -17,11 +17,20 @@
  */
 
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+
+#include <algorithm>
+
 #include "src/common/metrics/metrics.h"
 
 DEFINE_double(
     stirling_conn_tracker_cleanup_threshold, 0.2,
     "Percentage of trackers that are ready for destruction that will trigger a memory cleanup");
+DEFINE_uint64(stirling_datastream_buffer_global_budget_bytes,
+              gflags::Uint64FromEnv("PL_STIRLING_DATASTREAM_BUFFER_GLOBAL_BUDGET_BYTES",
+                                    512 * 1024 * 1024),
+              "The maximum memory retained across iterations by the data stream buffers of all "
+              "connections. Once exceeded, the buffers of the least recently active connections "
+              "are dropped. 0 means no limit.");
 
 namespace px {
 namespace stirling {
@@ -117,7 +126,15 @@ ConnTrackersManager::ConnTrackersManager()
       conn_tracker_destroyed_(BuildCounter("conn_tracker_destroyed",
                                            "Counter that tracks when a conn tracker is destroyed")),
       destroyed_gens_(BuildCounter(
-          "destroyed_gens", "Counter that tracks how many destroyed generations have occurred")) {}
+          "destroyed_gens", "Counter that tracks how many destroyed generations have occurred")),
+      data_buffer_bytes_gauges_(
+          prometheus::BuildGauge()
+              .Name("conn_tracker_data_buffer_bytes")
+              .Help("Memory retained by the data stream buffers of the conn trackers of a protocol")
+              .Register(GetMetricsRegistry())),
+      data_buffer_evicted_bytes_(
+          BuildCounter("conn_tracker_data_buffer_evicted_bytes",
+                       "Bytes of data stream buffers dropped to stay within the global budget")) {}
 
 ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_id) {
   const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
@@ -208,6 +225,64 @@ void ConnTrackersManager::CleanupTrackers() {
   DebugChecks();
 }
 
+namespace {
+
+size_t DataBufferBytes(const ConnTracker& tracker) {
+  return tracker.send_data().data_buffer().capacity() +
+         tracker.recv_data().data_buffer().capacity();
+}
+
+}  // namespace
+
+void ConnTrackersManager::EnforceDataBufferBudget() {
+  data_buffer_bytes_.clear();
+  size_t total_bytes = 0;
+  for (const auto* tracker : active_trackers_) {
+    size_t bytes = DataBufferBytes(*tracker);
+    data_buffer_bytes_[tracker->protocol()] += bytes;
+    total_bytes += bytes;
+  }
+
+  const size_t budget_bytes = FLAGS_stirling_datastream_buffer_global_budget_bytes;
+  if (budget_bytes != 0 && total_bytes > budget_bytes) {
+    // Only trackers with buffered data are worth resetting; an empty buffer still holds a small
+    // fixed capacity.
+    std::vector<ConnTracker*> trackers;
+    for (auto* tracker : active_trackers_) {
+      if (!tracker->send_data().data_buffer().empty() ||
+          !tracker->recv_data().data_buffer().empty()) {
+        trackers.push_back(tracker);
+      }
+    }
+    std::sort(trackers.begin(), trackers.end(), [](ConnTracker* a, ConnTracker* b) {
+      return a->last_update_timestamp() < b->last_update_timestamp();
+    });
+
+    size_t evicted_bytes = 0;
+    for (auto* tracker : trackers) {
+      if (total_bytes <= budget_bytes) {
+        break;
+      }
+      size_t bytes_before = DataBufferBytes(*tracker);
+      tracker->Reset();
+      size_t freed_bytes = bytes_before - std::min(bytes_before, DataBufferBytes(*tracker));
+      data_buffer_bytes_[tracker->protocol()] -= freed_bytes;
+      total_bytes -= freed_bytes;
+      evicted_bytes += freed_bytes;
+    }
+
+    LOG_FIRST_N(WARNING, 10) << absl::Substitute(
+        "Data stream buffers exceeded the global budget of $0 bytes, dropped $1 bytes.",
+        budget_bytes, evicted_bytes);
+    data_buffer_evicted_bytes_.Increment(evicted_bytes);
+  }
+
+  for (auto protocol : magic_enum::enum_values<traffic_protocol_t>()) {
+    data_buffer_bytes_gauges_.Add({{"protocol", std::string(magic_enum::enum_name(protocol))}})
+        .Set(data_buffer_bytes(protocol));
+  }
+}
+
 void ConnTrackersManager::DebugChecks() const {
   DCHECK_EQ(stats_.Get(StatKey::kTotal), static_cast<int64_t>(active_trackers_.size()) +
                                              stats_.Get(StatKey::kReadyForDestruction));
@@ -27,6 +27,7 @@
 #include <vector>
 
 #include <prometheus/counter.h>
+#include <prometheus/family.h>
 #include <prometheus/gauge.h>
 
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
@@ -34,6 +35,7 @@
 #include "src/stirling/utils/stat_counter.h"
 
 DECLARE_double(stirling_conn_tracker_cleanup_threshold);
+DECLARE_uint64(stirling_datastream_buffer_global_budget_bytes);
 
 namespace px {
 namespace stirling {
@@ -123,6 +125,25 @@ class ConnTrackersManager {
    */
   void CleanupTrackers();
 
+  /**
+   * Accounts the memory held by the data stream buffers of all active trackers, and publishes it
+   * per protocol. If the total exceeds --stirling_datastream_buffer_global_budget_bytes, the
+   * least recently active trackers are reset until the total fits the budget again.
+   *
+   * Call this after the trackers were cleaned up for the iteration, so that only the data retained
+   * across iterations is accounted.
+   */
+  void EnforceDataBufferBudget();
+
+  /**
+   * Returns the data stream buffer memory of the active trackers of the protocol, as of the last
+   * call to EnforceDataBufferBudget().
+   */
+  size_t data_buffer_bytes(traffic_protocol_t protocol) const {
+    auto iter = data_buffer_bytes_.find(protocol);
+    return iter == data_buffer_bytes_.end() ? 0 : iter->second;
+  }
+
   /**
    * Returns extensive debug information about the connection trackers.
    */
@@ -157,9 +178,14 @@ class ConnTrackersManager {
   utils::StatCounter<StatKey> stats_;
   utils::StatCounter<traffic_protocol_t> protocol_stats_;
 
+  // Data stream buffer memory per protocol, as of the last EnforceDataBufferBudget().
+  absl::flat_hash_map<traffic_protocol_t, size_t> data_buffer_bytes_;
+
   prometheus::Counter& conn_tracker_created_;
   prometheus::Counter& conn_tracker_destroyed_;
   prometheus::Counter& destroyed_gens_;
+  prometheus::Family<prometheus::Gauge>& data_buffer_bytes_gauges_;
+  prometheus::Counter& data_buffer_evicted_bytes_;
 };
 
 }  // namespace stirling
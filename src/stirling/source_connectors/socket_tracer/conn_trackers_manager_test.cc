@@ -17,9 +17,12 @@
  */
 
 #include <random>
+#include <string>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
 
 namespace px {
 namespace stirling {
@@ -112,6 +115,42 @@ TEST_F(ConnTrackersManagerTest, DebugInfo) {
   EXPECT_THAT(debug_info, HasSubstr("conn_tracker=conn_id=[upid=1:1 fd=1 gen=1]"));
 }
 
+// Tests that the data stream buffers are accounted per protocol, and that the buffers of the least
+// recently active trackers are dropped once the global budget is exceeded.
+TEST_F(ConnTrackersManagerTest, DataBufferBudget) {
+  const std::string msg(1000, 'x');
+  const auto start_time = std::chrono::steady_clock::now();
+
+  testing::MockClock mock_clock;
+  std::vector<ConnTracker*> trackers;
+  for (uint32_t i = 0; i < 3; ++i) {
+    testing::EventGenerator event_gen(&mock_clock, /* pid */ i + 1);
+    struct socket_control_event_t conn = event_gen.InitConn();
+    ConnTracker& tracker = trackers_mgr_.GetOrCreateConnTracker(conn.conn_id);
+    // The first tracker is the least recently active.
+    tracker.set_current_time(start_time + std::chrono::seconds(i));
+    tracker.AddDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(msg));
+    trackers.push_back(&tracker);
+  }
+
+  {
+    PX_SET_FOR_SCOPE(FLAGS_stirling_datastream_buffer_global_budget_bytes, 0);
+    trackers_mgr_.EnforceDataBufferBudget();
+    EXPECT_GE(trackers_mgr_.data_buffer_bytes(kProtocolHTTP), 3 * msg.size());
+    EXPECT_EQ(trackers_mgr_.data_buffer_bytes(kProtocolMySQL), 0);
+  }
+
+  {
+    PX_SET_FOR_SCOPE(FLAGS_stirling_datastream_buffer_global_budget_bytes, 5 * msg.size() / 2);
+    trackers_mgr_.EnforceDataBufferBudget();
+    EXPECT_TRUE(trackers[0]->send_data().data_buffer().empty());
+    EXPECT_FALSE(trackers[1]->send_data().data_buffer().empty());
+    EXPECT_FALSE(trackers[2]->send_data().data_buffer().empty());
+    EXPECT_GE(trackers_mgr_.data_buffer_bytes(kProtocolHTTP), 2 * msg.size());
+    EXPECT_LE(trackers_mgr_.data_buffer_bytes(kProtocolHTTP), 5 * msg.size() / 2);
+  }
+}
+
 class ConnTrackerGenerationsTest : public ::testing::Test {
  protected:
   ConnTrackerGenerationsTest() : tracker_pool(1024) {
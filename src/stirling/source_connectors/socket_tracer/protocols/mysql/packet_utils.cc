@@ -25,6 +25,65 @@ namespace stirling {
 namespace protocols {
 namespace mysql {
 
+namespace {
+
+// Advances the offset past a value of the given length, without decoding it.
+Status SkipFixedLengthParam(std::string_view msg, size_t length, size_t* offset) {
+  if (msg.size() < *offset + length) {
+    return error::Internal("Not enough bytes to skip $0 byte param.", length);
+  }
+  *offset += length;
+  return Status::OK();
+}
+
+// Advances the offset past a binary protocol value of the given column type. Resultset rows are
+// only validated, so the values are not decoded or copied.
+Status SkipBinaryResultsetValue(std::string_view msg, ColType column_type, size_t* offset) {
+  switch (column_type) {
+    case ColType::kString:
+    case ColType::kVarChar:
+    case ColType::kVarString:
+    case ColType::kEnum:
+    case ColType::kSet:
+    case ColType::kLongBlob:
+    case ColType::kMediumBlob:
+    case ColType::kBlob:
+    case ColType::kTinyBlob:
+    case ColType::kGeometry:
+    case ColType::kBit:
+    case ColType::kDecimal:
+    case ColType::kNewDecimal: {
+      std::string_view val;
+      return DissectStringParam(msg, offset, &val);
+    }
+    case ColType::kLongLong:
+    case ColType::kDouble:
+      return SkipFixedLengthParam(msg, 8, offset);
+    case ColType::kLong:
+    case ColType::kInt24:
+    case ColType::kFloat:
+      return SkipFixedLengthParam(msg, 4, offset);
+    case ColType::kShort:
+    case ColType::kYear:
+      return SkipFixedLengthParam(msg, 2, offset);
+    case ColType::kTiny:
+      return SkipFixedLengthParam(msg, 1, offset);
+    case ColType::kDate:
+    case ColType::kDateTime:
+    case ColType::kTimestamp:
+    case ColType::kTime: {
+      // Date and time values are prefixed with their length.
+      uint8_t length = 0;
+      PX_RETURN_IF_ERROR(DissectInt<1>(msg, offset, &length));
+      return SkipFixedLengthParam(msg, length, offset);
+    }
+    default:
+      return error::Internal("Unrecognized result column type.");
+  }
+}
+
+}  // namespace
+
 /**
  * https://dev.mysql.com/doc/internals/en/packet-EOF_Packet.html
  */
@@ -101,7 +160,7 @@ Status ProcessTextResultsetRowPacket(const Packet& packet, size_t num_col) {
   if ((packet.msg.length() == 1) && (packet.msg.front() == kResultsetRowNullPrefix)) {
     return Status::OK();
   }
-  std::string result;
+  std::string_view result;
   size_t offset = 0;
   for (size_t i = 0; i < num_col; ++i) {
     PX_RETURN_IF_ERROR(DissectStringParam(packet.msg, &offset, &result));
@@ -147,53 +206,7 @@ Status ProcessBinaryResultsetRowPacket(const Packet& packet,
       continue;
     }
 
-    std::string val;
-    switch (column_defs[i].column_type) {
-      case ColType::kString:
-      case ColType::kVarChar:
-      case ColType::kVarString:
-      case ColType::kEnum:
-      case ColType::kSet:
-      case ColType::kLongBlob:
-      case ColType::kMediumBlob:
-      case ColType::kBlob:
-      case ColType::kTinyBlob:
-      case ColType::kGeometry:
-      case ColType::kBit:
-      case ColType::kDecimal:
-      case ColType::kNewDecimal:
-        PX_RETURN_IF_ERROR(DissectStringParam(packet.msg, &offset, &val));
-        break;
-      case ColType::kLongLong:
-        PX_RETURN_IF_ERROR(DissectIntParam<8>(packet.msg, &offset, &val));
-        break;
-      case ColType::kLong:
-      case ColType::kInt24:
-        PX_RETURN_IF_ERROR(DissectIntParam<4>(packet.msg, &offset, &val));
-        break;
-      case ColType::kShort:
-      case ColType::kYear:
-        PX_RETURN_IF_ERROR(DissectIntParam<2>(packet.msg, &offset, &val));
-        break;
-      case ColType::kTiny:
-        PX_RETURN_IF_ERROR(DissectIntParam<1>(packet.msg, &offset, &val));
-        break;
-      case ColType::kDouble:
-        PX_RETURN_IF_ERROR(DissectFloatParam<double>(packet.msg, &offset, &val));
-        break;
-      case ColType::kFloat:
-        PX_RETURN_IF_ERROR(DissectFloatParam<float>(packet.msg, &offset, &val));
-        break;
-      case ColType::kDate:
-      case ColType::kDateTime:
-      case ColType::kTimestamp:
-      case ColType::kTime:
-        // TODO(chengruizhe): Implement DissectDateTime correctly.
-        PX_RETURN_IF_ERROR(DissectDateTimeParam(packet.msg, &offset, &val));
-        break;
-      default:
-        return error::Internal("Unrecognized result column type.");
-    }
+    PX_RETURN_IF_ERROR(SkipBinaryResultsetValue(packet.msg, column_defs[i].column_type, &offset));
   }
 
   if (offset != packet.msg.size()) {
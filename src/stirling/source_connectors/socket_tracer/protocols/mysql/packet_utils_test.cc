@@ -17,6 +17,10 @@
  */
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/packet_utils.h"
+
+#include <string>
+#include <vector>
+
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_data.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_utils.h"
@@ -52,6 +56,27 @@ TEST(ProcessBinaryResultsetRow, Basics) {
   EXPECT_OK(ProcessBinaryResultsetRowPacket(resultset_row_packet, col_defs));
 }
 
+TEST(ProcessBinaryResultsetRow, FixedLengthAndDateTimeValues) {
+  std::vector<ColDefinition> col_defs(5);
+  col_defs[0].column_type = ColType::kLongLong;
+  col_defs[1].column_type = ColType::kTiny;
+  col_defs[2].column_type = ColType::kDouble;
+  col_defs[3].column_type = ColType::kDateTime;
+  col_defs[4].column_type = ColType::kVarString;
+
+  // Header, null bitmap, then the values: 8 bytes, 1 byte, 8 bytes, length-prefixed date time and
+  // length-encoded string.
+  std::string row = absl::StrCat(std::string(2, '\x00'), std::string(8, '\x01'), "\x02",
+                                 std::string(8, '\x03'), "\x04", std::string(4, '\x05'),
+                                 testutils::LengthEncodedString("name"));
+  EXPECT_OK(ProcessBinaryResultsetRowPacket(testutils::GenResultsetRow(0, ResultsetRow{row}),
+                                            col_defs));
+
+  std::string truncated_row = row.substr(0, row.size() - 1);
+  EXPECT_NOT_OK(ProcessBinaryResultsetRowPacket(
+      testutils::GenResultsetRow(0, ResultsetRow{truncated_row}), col_defs));
+}
+
 TEST(ProcessTextResultsetRow, Basics) {
   ResultsetRow r = testdata::kQueryResultsetRows[0];
   Packet resultset_row_packet = testutils::GenResultsetRow(0, r);
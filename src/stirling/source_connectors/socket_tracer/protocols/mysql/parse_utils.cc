@@ -86,6 +86,13 @@ StatusOr<int64_t> ProcessLengthEncodedInt(std::string_view s, size_t* offset) {
 }
 
 Status DissectStringParam(std::string_view msg, size_t* param_offset, std::string* param) {
+  std::string_view param_view;
+  PX_RETURN_IF_ERROR(DissectStringParam(msg, param_offset, &param_view));
+  *param = param_view;
+  return Status::OK();
+}
+
+Status DissectStringParam(std::string_view msg, size_t* param_offset, std::string_view* param) {
   PX_ASSIGN_OR_RETURN(int param_length, ProcessLengthEncodedInt(msg, param_offset));
   if (msg.size() < *param_offset + param_length) {
     return error::Internal("Not enough bytes to dissect string param.");
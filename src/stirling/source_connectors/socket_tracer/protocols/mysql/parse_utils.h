@@ -50,6 +50,9 @@ StatusOr<int64_t> ProcessLengthEncodedInt(std::string_view s, size_t* offset);
 
 Status DissectStringParam(std::string_view msg, size_t* param_offset, std::string* packet);
 
+// Same as above, but the param points into msg rather than being copied out of it.
+Status DissectStringParam(std::string_view msg, size_t* param_offset, std::string_view* param);
+
 template <size_t length>
 Status DissectIntParam(std::string_view msg, size_t* param_offset, std::string* packet);
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/handler.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_utils.h"
+
+using ::px::stirling::protocols::mysql::HandleResultsetResponse;
+using ::px::stirling::protocols::mysql::Packet;
+using ::px::stirling::protocols::mysql::Record;
+using ::px::stirling::protocols::mysql::Resultset;
+namespace testdata = ::px::stirling::protocols::mysql::testdata;
+namespace testutils = ::px::stirling::protocols::mysql::testutils;
+
+namespace {
+
+// Returns the packets of a resultset with num_rows rows, which repeat the rows of the template.
+std::deque<Packet> GenResultsetPackets(const Resultset& tmpl, int num_rows) {
+  Resultset resultset = tmpl;
+  resultset.results.clear();
+  for (int i = 0; i < num_rows; ++i) {
+    resultset.results.push_back(tmpl.results[i % tmpl.results.size()]);
+  }
+  return testutils::GenResultset(resultset);
+}
+
+// NOLINTNEXTLINE(runtime/references)
+void BenchmarkResultsetResponse(benchmark::State& state, const Resultset& tmpl, bool binary) {
+  std::deque<Packet> resp_packets = GenResultsetPackets(tmpl, state.range(0));
+  size_t resp_bytes = 0;
+  for (const auto& packet : resp_packets) {
+    resp_bytes += packet.msg.size();
+  }
+
+  for (auto _ : state) {
+    Record entry;
+    auto result = HandleResultsetResponse(resp_packets, &entry, binary);
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(entry);
+  }
+  state.SetBytesProcessed(state.iterations() * resp_bytes);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE(runtime/references)
+static void BM_text_resultset(benchmark::State& state) {
+  BenchmarkResultsetResponse(state, testdata::kQueryResultset, /* binary */ false);
+}
+
+// NOLINTNEXTLINE(runtime/references)
+static void BM_binary_resultset(benchmark::State& state) {
+  BenchmarkResultsetResponse(state, testdata::kStmtExecuteResultset, /* binary */ true);
+}
+
+BENCHMARK(BM_text_resultset)->RangeMultiplier(16)->Range(16, 64 << 10);
+BENCHMARK(BM_binary_resultset)->RangeMultiplier(16)->Range(16, 64 << 10);
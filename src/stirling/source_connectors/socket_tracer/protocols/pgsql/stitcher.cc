@@ -28,6 +28,16 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/parse.h"
 #include "src/stirling/utils/binary_decoder.h"
 
+DEFINE_uint32(stirling_pgsql_max_resultset_rows,
+              gflags::Uint32FromEnv("PL_STIRLING_PGSQL_MAX_RESULTSET_ROWS", 1024),
+              "The maximal number of rows of a PgSQL result set that are parsed into the response. "
+              "The remaining rows are only counted.");
+DEFINE_uint32(stirling_pgsql_max_resultset_bytes,
+              gflags::Uint32FromEnv("PL_STIRLING_PGSQL_MAX_RESULTSET_BYTES", 1024),
+              "The maximal size of the formatted rows of a PgSQL result set. Once reached, the "
+              "remaining rows are only counted. The response column is truncated to about this "
+              "size anyway.");
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -71,6 +81,24 @@ class DequeView {
 // TODO(yzhao): Format in JSON.
 // TODO(yzhao): Do not call parsing code inside.
 
+// Parses a DataRow message into the response, or only counts it if the response already holds
+// as many rows or bytes as the result set budget allows.
+Status AppendDataRow(const RegularMessage& msg, QueryReqResp::QueryResp* resp) {
+  if (resp->data_rows.size() >= FLAGS_stirling_pgsql_max_resultset_rows ||
+      resp->data_rows_bytes >= FLAGS_stirling_pgsql_max_resultset_bytes) {
+    ++resp->num_omitted_rows;
+    resp->omitted_bytes += msg.payload.size();
+    return Status::OK();
+  }
+
+  DataRow data_row;
+  PX_RETURN_IF_ERROR(ParseDataRow(msg, &data_row));
+  // Includes the newline that separates the rows.
+  resp->data_rows_bytes += data_row.ToStringSize() + 1;
+  resp->data_rows.push_back(std::move(data_row));
+  return Status::OK();
+}
+
 }  // namespace
 
 // Find the messages of query response. The result argument begin is advanced past the right most
@@ -123,9 +151,7 @@ Status FillQueryResp(MsgDeqIter* resp_iter, const MsgDeqIter& end, QueryReqResp:
     // CommandComplete. Therefore we should not break out of the for loop once the first DataRow
     // message is parsed.
     if (iter->tag == Tag::kDataRow) {
-      DataRow data_row;
-      PX_RETURN_IF_ERROR(ParseDataRow(*iter, &data_row));
-      resp->data_rows.push_back(std::move(data_row));
+      PX_RETURN_IF_ERROR(AppendDataRow(*iter, resp));
       iter->consumed = true;
     }
   }
@@ -198,12 +224,10 @@ Status HandleQuery(const RegularMessage& msg, MsgDeqIter* resp_iter, const MsgDe
     // CommandComplete. Therefore we should not break out of the for loop once the first DataRow
     // message is parsed.
     if (iter->tag == Tag::kDataRow) {
-      DataRow data_row;
-      PX_RETURN_IF_ERROR(ParseDataRow(*iter, &data_row));
+      PX_RETURN_IF_ERROR(AppendDataRow(*iter, &req_resp->resp));
 
       iter->consumed = true;
-      req_resp->resp.timestamp_ns = data_row.timestamp_ns;
-      req_resp->resp.data_rows.push_back(std::move(data_row));
+      req_resp->resp.timestamp_ns = iter->timestamp_ns;
     }
   }
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/stitcher.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/test_data.h"
+
+using ::px::stirling::ParseState;
+using ::px::stirling::protocols::pgsql::HandleQuery;
+using ::px::stirling::protocols::pgsql::kDataRowTestData;
+using ::px::stirling::protocols::pgsql::kRowDescTestData;
+using ::px::stirling::protocols::pgsql::MsgDeqIter;
+using ::px::stirling::protocols::pgsql::ParseRegularMessage;
+using ::px::stirling::protocols::pgsql::QueryReqResp;
+using ::px::stirling::protocols::pgsql::RegularMessage;
+using ::px::stirling::protocols::pgsql::Tag;
+
+// Stitches a simple query with a result set of range(0) rows. With the default budget, only the
+// first rows are parsed; set --stirling_pgsql_max_resultset_rows and
+// --stirling_pgsql_max_resultset_bytes to a large value to measure parsing all the rows.
+// NOLINTNEXTLINE(runtime/references)
+static void BM_query_resultset(benchmark::State& state) {
+  auto row_desc_data = kRowDescTestData;
+  auto data_row_data = kDataRowTestData;
+
+  RegularMessage query = {};
+  query.tag = Tag::kQuery;
+  query.payload = "SELECT * FROM pg_database";
+
+  RegularMessage row_desc = {};
+  RegularMessage data_row = {};
+  RegularMessage cmd_cmpl = {};
+  cmd_cmpl.tag = Tag::kCmdComplete;
+  cmd_cmpl.payload = "SELECT";
+  CHECK(ParseRegularMessage(&row_desc_data, &row_desc) == ParseState::kSuccess);
+  CHECK(ParseRegularMessage(&data_row_data, &data_row) == ParseState::kSuccess);
+
+  std::deque<RegularMessage> resps = {row_desc};
+  for (int i = 0; i < state.range(0); ++i) {
+    resps.push_back(data_row);
+  }
+  resps.push_back(cmd_cmpl);
+
+  for (auto _ : state) {
+    QueryReqResp req_resp;
+    MsgDeqIter iter = resps.begin();
+    CHECK_OK(HandleQuery(query, &iter, resps.end(), &req_resp));
+    benchmark::DoNotOptimize(req_resp);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * data_row.payload.size());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_query_resultset)->RangeMultiplier(16)->Range(16, 64 << 10);
@@ -19,6 +19,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/stitcher.h"
 
 #include <string>
+#include <string_view>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/parse.h"
@@ -68,6 +69,51 @@ TEST(PGSQLParseTest, FillQueryResp) {
   EXPECT_EQ(begin, resps.end());
 }
 
+TEST(PGSQLParseTest, FillQueryRespResultsetBudget) {
+  auto row_desc_data = kRowDescTestData;
+  auto data_row_data = kDataRowTestData;
+
+  RegularMessage row_desc = {};
+  RegularMessage data_row = {};
+  RegularMessage cmd_cmpl = {};
+  cmd_cmpl.tag = Tag::kCmdComplete;
+  cmd_cmpl.payload = "SELECT 4";
+
+  EXPECT_EQ(ParseState::kSuccess, ParseRegularMessage(&row_desc_data, &row_desc));
+  EXPECT_EQ(ParseState::kSuccess, ParseRegularMessage(&data_row_data, &data_row));
+
+  constexpr std::string_view kRow = "postgres,postgres,UTF8,en_US.utf8,en_US.utf8,[NULL]\n";
+
+  {
+    PX_SET_FOR_SCOPE(FLAGS_stirling_pgsql_max_resultset_rows, 2);
+
+    std::deque<RegularMessage> resps = {row_desc, data_row, data_row, data_row, data_row, cmd_cmpl};
+    QueryReqResp::QueryResp query_resp;
+    auto begin = resps.begin();
+    ASSERT_OK(FillQueryResp(&begin, resps.end(), &query_resp));
+    EXPECT_EQ(begin, resps.end());
+    EXPECT_EQ(query_resp.data_rows.size(), 2);
+    EXPECT_EQ(query_resp.data_rows_bytes, 2 * kRow.size());
+    EXPECT_EQ(query_resp.num_omitted_rows, 2);
+    EXPECT_EQ(query_resp.omitted_bytes, 2 * data_row.payload.size());
+    EXPECT_EQ(absl::StrCat("Name,Owner,Encoding,Collate,Ctype,Access privileges\n", kRow, kRow,
+                           "[2 more rows, ", 2 * data_row.payload.size(), " bytes]\n", "SELECT 4"),
+              query_resp.ToString());
+  }
+
+  {
+    // The row that reaches the byte budget is still kept.
+    PX_SET_FOR_SCOPE(FLAGS_stirling_pgsql_max_resultset_bytes, kRow.size() + 1);
+
+    std::deque<RegularMessage> resps = {row_desc, data_row, data_row, data_row, data_row, cmd_cmpl};
+    QueryReqResp::QueryResp query_resp;
+    auto begin = resps.begin();
+    ASSERT_OK(FillQueryResp(&begin, resps.end(), &query_resp));
+    EXPECT_EQ(query_resp.data_rows.size(), 2);
+    EXPECT_EQ(query_resp.num_omitted_rows, 2);
+  }
+}
+
 TEST(PGSQLParseTest, FillQueryRespFailures) {
   std::deque<RegularMessage> resps;
   auto begin = resps.begin();
@@ -399,6 +399,16 @@ struct DataRow {
       out->append(d.has_value() ? d.value() : "[NULL]");
     });
   }
+
+  // Returns the size of ToString(), without formatting the row.
+  size_t ToStringSize() const {
+    constexpr size_t kNullSize = std::string_view("[NULL]").size();
+    size_t size = cols.empty() ? 0 : cols.size() - 1;
+    for (const auto& col : cols) {
+      size += col.has_value() ? col->size() : kNullSize;
+    }
+    return size;
+  }
 };
 
 struct CmdCmpl {
@@ -440,6 +450,14 @@ struct QueryReqResp {
     bool is_err_resp = false;
 
     std::vector<DataRow> data_rows;
+    // The size of the formatted data_rows.
+    size_t data_rows_bytes = 0;
+
+    // The DataRow messages after the row or byte budget was reached, which are counted but not
+    // parsed. omitted_bytes is the total size of their payloads.
+    size_t num_omitted_rows = 0;
+    size_t omitted_bytes = 0;
+
     CmdCmpl cmd_cmpl;
     ErrResp err_resp;
 
@@ -450,7 +468,7 @@ struct QueryReqResp {
 
       std::string res;
 
-      if (!data_rows.empty()) {
+      if (!data_rows.empty() || num_omitted_rows > 0) {
         std::vector<std::string_view> field_names = row_desc.FieldNames();
 
         if (!field_names.empty()) {
@@ -458,8 +476,13 @@ struct QueryReqResp {
           absl::StrAppend(&res, "\n");
         }
 
-        absl::StrAppend(&res, absl::StrJoin(data_rows, "\n", ToStringFormatter<DataRow>()));
-        absl::StrAppend(&res, "\n");
+        if (!data_rows.empty()) {
+          absl::StrAppend(&res, absl::StrJoin(data_rows, "\n", ToStringFormatter<DataRow>()));
+          absl::StrAppend(&res, "\n");
+        }
+        if (num_omitted_rows > 0) {
+          absl::StrAppend(&res, "[", num_omitted_rows, " more rows, ", omitted_bytes, " bytes]\n");
+        }
       }
 
       absl::StrAppend(&res, cmd_cmpl.cmd_tag);
@@ -117,5 +117,17 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
   }
 }
 
+ConnStatsMapManager::ConnStatsMapManager(bpf_tools::BCCWrapper* bcc)
+    : conn_stats_map_(bcc->GetHashTable<uint64_t, struct conn_stats_event_t>("conn_stats_map")) {}
+
+std::vector<struct conn_stats_event_t> ConnStatsMapManager::Drain() {
+  constexpr bool kClearTable = true;
+  std::vector<struct conn_stats_event_t> events;
+  for (const auto& [tgid_fd, event] : conn_stats_map_.get_table_offline(kClearTable)) {
+    events.push_back(event);
+  }
+  return events;
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -54,5 +54,25 @@ class ConnInfoMapManager {
   }
 };
 
+/**
+ * Drains the ConnStats snapshots that the BPF code batches in conn_stats_map.
+ */
+class ConnStatsMapManager {
+ public:
+  explicit ConnStatsMapManager(bpf_tools::BCCWrapper* bcc);
+
+  /**
+   * Returns the snapshots currently in the map and removes them from it.
+   *
+   * A snapshot written by the BPF code between the read and the removal is dropped, which only
+   * delays its counters: the snapshots are cumulative, and the final one is always sent on
+   * conn_stats_events when the connection is closed.
+   */
+  std::vector<struct conn_stats_event_t> Drain();
+
+ private:
+  ebpf::BPFHashTable<uint64_t, struct conn_stats_event_t> conn_stats_map_;
+};
+
 }  // namespace stirling
 }  // namespace px
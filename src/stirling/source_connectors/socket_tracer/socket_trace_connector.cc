@@ -492,6 +492,7 @@ Status SocketTraceConnector::InitImpl() {
 
   conn_info_map_mgr_ = std::make_shared<ConnInfoMapManager>(this);
   ConnTracker::SetConnInfoMapManager(conn_info_map_mgr_);
+  conn_stats_map_mgr_ = std::make_unique<ConnStatsMapManager>(this);
 
   uprobe_mgr_.Init(FLAGS_stirling_disable_golang_tls_tracing,
                    protocol_transfer_specs_[kProtocolHTTP2].enabled,
@@ -607,6 +608,14 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // It may be worth noting during debug.
   PollPerfBuffers();
 
+  // ConnStats snapshots are batched in a BPF map instead of being sent on a perf buffer, except
+  // for the final snapshot of each connection.
+  if (conn_stats_map_mgr_ != nullptr) {
+    for (const auto& event : conn_stats_map_mgr_->Drain()) {
+      AcceptConnStatsEvent(event);
+    }
+  }
+
   // Set-up current state for connection inference purposes.
   if (socket_info_mgr_ != nullptr) {
     socket_info_mgr_->Flush();
@@ -753,6 +762,10 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx) {
     conn_tracker->IterationPostTick();
   }
 
+  // The trackers have trimmed their buffers to the retention size above, so this only accounts the
+  // data retained until the next iteration.
+  conn_trackers_mgr_.EnforceDataBufferBudget();
+
   CheckTracerState();
 
   // Once we've cleared all the debug trace levels for this pid, we can remove it from the list.
@@ -1644,7 +1657,7 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
 
       r.Append<idx::kTime>(time);
       r.Append<idx::kUPID>(upid.value());
-      r.Append<idx::kRemoteAddr>(key.remote_addr);
+      r.Append<idx::kRemoteAddr>(key.RemoteAddrStr());
       r.Append<idx::kRemotePort>(key.remote_port);
       r.Append<idx::kAddrFamily>(static_cast<int>(stats.addr_family));
       r.Append<idx::kProtocol>(stats.protocol);
@@ -288,6 +288,8 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   std::shared_ptr<ConnInfoMapManager> conn_info_map_mgr_;
 
+  std::unique_ptr<ConnStatsMapManager> conn_stats_map_mgr_;
+
   UProbeManager uprobe_mgr_;
 
   enum class StatKey {
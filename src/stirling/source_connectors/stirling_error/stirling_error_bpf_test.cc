@@ -18,6 +18,9 @@
 
 #include <absl/functional/bind_front.h>
 #include <absl/strings/substitute.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 #include <type_traits>
 
 #include "src/carnot/planner/probes/tracepoint_generator.h"
@@ -87,6 +90,21 @@ std::vector<SourceStatusRecord> ToSourceRecordVector(
   return result;
 }
 
+// Removes the deployment timings from a probe status info JSON, since they vary between runs.
+std::string StripDeployTimes(const std::string& info) {
+  rapidjson::Document d;
+  d.Parse(info.c_str());
+  if (d.HasParseError() || !d.IsObject()) {
+    return info;
+  }
+  d.RemoveMember("compile_time_us");
+  d.RemoveMember("deploy_time_us");
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  d.Accept(writer);
+  return sb.GetString();
+}
+
 std::vector<ProbeStatusRecord> ToProbeRecordVector(
     const std::vector<std::unique_ptr<ColumnWrapperRecordBatch>>& record_batches) {
   std::vector<ProbeStatusRecord> result;
@@ -99,7 +117,7 @@ std::vector<ProbeStatusRecord> ToProbeRecordVector(
       r.tracepoint = rb[3]->Get<StringValue>(idx).string();
       r.status = static_cast<px::statuspb::Code>(rb[4]->Get<Int64Value>(idx).val);
       r.error = rb[5]->Get<StringValue>(idx).string();
-      r.info = rb[6]->Get<StringValue>(idx).string();
+      r.info = StripDeployTimes(rb[6]->Get<StringValue>(idx).string());
       result.push_back(r);
     }
   }
@@ -23,12 +23,16 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/functional/bind_front.h>
+#include <absl/strings/str_split.h>
 
 #include "src/common/base/base.h"
 #include "src/common/json/json.h"
@@ -58,6 +62,7 @@
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
 #include "src/stirling/source_connectors/stirling_error/stirling_error_connector.h"
 
+#include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/bcc_program_cache.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 #include "src/stirling/source_connectors/tcp_stats/tcp_stats_connector.h"
 
@@ -65,6 +70,11 @@ DEFINE_string(stirling_sources, gflags::StringFromEnv("PL_STIRLING_SOURCES", "kP
               "Choose sources to enable. [kAll|kProd|kMetrics|kTracers|kProfiler|kTCPStats] or "
               "comma separated list of "
               "sources (find them the header files of source connector classes).");
+DEFINE_string(stirling_dedicated_thread_sources,
+              gflags::StringFromEnv("PL_STIRLING_DEDICATED_THREAD_SOURCES", "perf_profiler"),
+              "Comma separated list of sources that run on their own thread instead of the main "
+              "Stirling loop, so that their slow TransferData() calls do not delay the other "
+              "sources.");
 
 namespace px {
 namespace stirling {
@@ -239,9 +249,41 @@ class StirlingImpl final : public Stirling {
   // Destroys a dynamic tracing source created by DeployDynamicTraceConnector.
   void DestroyDynamicTraceConnector(sole::uuid trace_id);
 
+  // A source connector that runs on its own thread, instead of in the RunCore() loop.
+  //
+  // The executor only touches its own source and the source's data tables, never sources_ or
+  // info_class_mgrs_, so it does not need info_class_mgrs_lock_ to run concurrently with
+  // AddSource(). RemoveSource() stops the executor before it destroys the source.
+  struct SourceExecutor {
+    explicit SourceExecutor(SourceConnector* source) : source(source), stats(source->name()) {}
+
+    SourceConnector* source;
+    std::thread thread;
+    // Cleared to stop just this executor, e.g. when its source is removed.
+    std::atomic<bool> run_enable = true;
+    RunCoreStats stats;
+  };
+
   // Main run implementation.
   void RunCore();
 
+  // Run loop of a source connector with its own thread.
+  void RunSourceExecutor(SourceExecutor* executor);
+
+  // If the named source runs on its own thread, stops that thread and waits for it to exit.
+  // The source stays in executor_sources_, so that the RunCore() loop does not pick it up.
+  void StopSourceExecutor(std::string_view source_name);
+
+  // Calls TransferData() and PushData() on the source, if they are due by the time run_until.
+  // Updates *now after any call.
+  void RunSourceIfDue(SourceConnector* source, ConnectorContext* ctx, time_point run_until,
+                      time_point* now, RunCoreStats* stats);
+
+  // Pushes data to the agent. Sources with their own thread push data concurrently with the
+  // RunCore() loop, so this serializes the calls to data_push_callback_.
+  Status PushDataToAgent(uint32_t table_id, types::TabletID tablet_id,
+                         std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch);
+
   // Computes the amount of time to sleep based on the next source connector that needs to wakeup.
   std::chrono::milliseconds TimeUntilNextTick(const time_point now);
 
@@ -253,6 +295,8 @@ class StirlingImpl final : public Stirling {
 
   std::atomic<bool> run_enable_ = false;
   std::atomic<bool> running_ = false;
+  // Set once the threads of all the sources that run on their own thread have been started.
+  std::atomic<bool> executors_running_ = false;
   std::vector<std::unique_ptr<SourceConnector>> sources_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
   InfoClassManagerVec info_class_mgrs_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
@@ -260,6 +304,14 @@ class StirlingImpl final : public Stirling {
   // Lock to protect both info_class_mgrs_ and sources_.
   absl::base_internal::SpinLock info_class_mgrs_lock_;
 
+  // The sources in sources_ that run on their own thread, and are skipped by the RunCore() loop.
+  std::vector<std::unique_ptr<SourceExecutor>> executors_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
+  absl::flat_hash_set<const SourceConnector*> executor_sources_
+      ABSL_GUARDED_BY(info_class_mgrs_lock_);
+
+  // Guards calls to data_push_callback_.
+  std::mutex data_push_mutex_;
+
   std::unique_ptr<SourceRegistry> registry_;
 
   /**
@@ -270,6 +322,9 @@ class StirlingImpl final : public Stirling {
    */
   DataPushCallback data_push_callback_ = nullptr;
 
+  // Calls data_push_callback_ through PushDataToAgent(). Passed to the sources' PushData().
+  const DataPushCallback serialized_data_push_callback_;
+
   AgentMetadataCallback agent_metadata_callback_ = nullptr;
   AgentMetadataType agent_metadata_;
 
@@ -283,6 +338,12 @@ class StirlingImpl final : public Stirling {
     std::string source_connector;
     std::string tracepoint;
     std::string output_table;
+    // Time spent compiling the tracepoint into a BPF program, and attaching the BPF program.
+    int64_t compile_time_us = 0;
+    int64_t deploy_time_us = 0;
+    // Whether the BCC program was found in the BCC program cache ("hit" or "miss").
+    // Empty if the cache was not used.
+    std::string bcc_program_cache;
   };
 
   absl::flat_hash_map<sole::uuid, DynamicTraceInfo> trace_id_info_map_
@@ -371,7 +432,8 @@ void UserSignalHandler(int /* signum */, siginfo_t* info, void* /* context */) {
 }
 
 StirlingImpl::StirlingImpl(std::unique_ptr<SourceRegistry> registry)
-    : registry_(std::move(registry)) {}
+    : registry_(std::move(registry)),
+      serialized_data_push_callback_(absl::bind_front(&StirlingImpl::PushDataToAgent, this)) {}
 
 StirlingImpl::~StirlingImpl() { Stop(); }
 
@@ -448,7 +510,29 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   return Status::OK();
 }
 
+void StirlingImpl::StopSourceExecutor(std::string_view source_name) {
+  std::unique_ptr<SourceExecutor> executor;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    auto iter = std::find_if(executors_.begin(), executors_.end(),
+                             [&source_name](const std::unique_ptr<SourceExecutor>& e) {
+                               return e->source->name() == source_name;
+                             });
+    if (iter == executors_.end()) {
+      return;
+    }
+    executor = std::move(*iter);
+    executors_.erase(iter);
+  }
+
+  // Join outside of the lock, as the executor may be in the middle of a slow TransferData().
+  executor->run_enable = false;
+  executor->thread.join();
+}
+
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
+  StopSourceExecutor(source_name);
+
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   // Find the source.
@@ -470,6 +554,7 @@ Status StirlingImpl::RemoveSource(std::string_view source_name) {
 
   // Now perform the removal.
   PX_RETURN_IF_ERROR(source->Stop());
+  executor_sources_.erase(source.get());
   sources_.erase(source_iter);
 
   return Status::OK();
@@ -501,8 +586,8 @@ namespace {
 constexpr char kDynTraceSourcePrefix[] = "DT_";
 
 StatusOr<std::unique_ptr<SourceConnector>> CreateDynamicSourceConnector(
-    sole::uuid trace_id,
-    dynamic_tracing::ir::logical::TracepointDeployment* tracepoint_deployment) {
+    sole::uuid trace_id, dynamic_tracing::ir::logical::TracepointDeployment* tracepoint_deployment,
+    bool* bcc_program_cache_hit) {
   if (tracepoint_deployment->tracepoints().empty()) {
     return error::Internal("Nothing defined in the input tracepoint_deployment.");
   }
@@ -530,7 +615,7 @@ StatusOr<std::unique_ptr<SourceConnector>> CreateDynamicSourceConnector(
 
     return DynamicBPFTraceConnector::Create(source_name, tracepoint);
   }
-  return DynamicTraceConnector::Create(source_name, tracepoint_deployment);
+  return DynamicTraceConnector::Create(source_name, tracepoint_deployment, bcc_program_cache_hit);
 }
 
 }  // namespace
@@ -543,11 +628,14 @@ void StirlingImpl::DeployDynamicTraceConnector(
 
   // Try creating the DynamicTraceConnector--which compiles BCC code.
   // On failure, set status and exit.
-  ASSIGN_OR_RETURN_ERROR(std::unique_ptr<SourceConnector> source,
-                         CreateDynamicSourceConnector(trace_id, program.get()));
+  bool bcc_program_cache_hit = false;
+  ASSIGN_OR_RETURN_ERROR(
+      std::unique_ptr<SourceConnector> source,
+      CreateDynamicSourceConnector(trace_id, program.get(), &bcc_program_cache_hit));
 
+  int64_t compile_time_us = timer.ElapsedTime_us();
   LOG(INFO) << absl::Substitute("DynamicTraceConnector [$0] created in $1 ms.", source->name(),
-                                timer.ElapsedTime_us() / 1000.0);
+                                compile_time_us / 1000.0);
 
   // Cache table schema name as source will be moved below.
   std::string output_name(source->table_schemas()[0].name());
@@ -556,7 +644,12 @@ void StirlingImpl::DeployDynamicTraceConnector(
     absl::base_internal::SpinLockHolder lock(&dynamic_trace_status_map_lock_);
     auto it = trace_id_info_map_.find(trace_id);
     if (it != trace_id_info_map_.end()) {
-      trace_id_info_map_[trace_id].output_table = output_name;
+      it->second.output_table = output_name;
+      it->second.compile_time_us = compile_time_us;
+      if (it->second.source_connector == "dynamic_trace" &&
+          !FLAGS_stirling_bcc_program_cache_dir.empty()) {
+        it->second.bcc_program_cache = bcc_program_cache_hit ? "hit" : "miss";
+      }
     }
   }
 
@@ -564,8 +657,17 @@ void StirlingImpl::DeployDynamicTraceConnector(
   // Next, try adding the source (this actually tries to deploy BPF code).
   // On failure, set status and exit, but do this outside the lock for efficiency reasons.
   RETURN_IF_ERROR(AddSource(std::move(source)));
+  int64_t deploy_time_us = timer.ElapsedTime_us();
   LOG(INFO) << absl::Substitute("DynamicTrace [$0]: Deployed BPF program in $1 ms.", trace_id.str(),
-                                timer.ElapsedTime_us() / 1000.0);
+                                deploy_time_us / 1000.0);
+
+  {
+    absl::base_internal::SpinLockHolder lock(&dynamic_trace_status_map_lock_);
+    auto it = trace_id_info_map_.find(trace_id);
+    if (it != trace_id_info_map_.end()) {
+      it->second.deploy_time_us = deploy_time_us;
+    }
+  }
 
   stirlingpb::Publish publication;
   {
@@ -732,16 +834,31 @@ void StirlingImpl::Run() {
   RunCore();
 }
 
+namespace {
+
+// Worst case, wake-up every so often.
+// This is important if there are no subscribed info classes, to avoid sleeping eternally.
+constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
+
+// To batch up work, the run loops run a source's data transfer or push data if its desired run
+// time is anywhere between time "now" and time "now + window".
+constexpr std::chrono::milliseconds kRunWindow{1};
+
+// The update period of the k8s context passed to the sources.
+constexpr std::chrono::milliseconds kContextUpdatePeriod{200};
+
+}  // namespace
+
 std::chrono::milliseconds StirlingImpl::TimeUntilNextTick(const time_point now)
     ABSL_SHARED_LOCKS_REQUIRED(info_class_mgrs_lock_) {
   // The amount to sleep depends on when the earliest Source needs to be sampled again.
   // Do this to avoid burning CPU cycles unnecessarily
-
-  // Worst case, wake-up every so often.
-  // This is important if there are no subscribed info classes, to avoid sleeping eternally.
-  constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
   auto wakeup_time = now + kMaxSleepDuration;
   for (const auto& source : sources_) {
+    // Sources with their own thread sleep on their own.
+    if (executor_sources_.contains(source.get())) {
+      continue;
+    }
     wakeup_time = std::min(wakeup_time, source->sampling_freq_mgr().next());
     wakeup_time = std::min(wakeup_time, source->push_freq_mgr().next());
   }
@@ -772,6 +889,77 @@ bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
 
 }  // namespace
 
+Status StirlingImpl::PushDataToAgent(
+    uint32_t table_id, types::TabletID tablet_id,
+    std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+  const std::lock_guard<std::mutex> lock(data_push_mutex_);
+  return data_push_callback_(table_id, std::move(tablet_id), std::move(record_batch));
+}
+
+void StirlingImpl::RunSourceIfDue(SourceConnector* source, ConnectorContext* ctx,
+                                  const time_point run_until, time_point* now,
+                                  RunCoreStats* stats) {
+  // Phase 1: Probe the source for its data.
+  if (source->sampling_freq_mgr().Expired(run_until)) {
+    const time_point start = *now;
+    source->TransferData(ctx);
+
+    // TransferData() is normally a significant amount of work: update "time now".
+    *now = std::chrono::steady_clock::now();
+    source->sampling_freq_mgr().Reset(*now);
+    stats->RecordTransferData(source->name(), *now - start);
+  }
+  // Phase 2: Push Data upstream.
+  if (source->push_freq_mgr().Expired(run_until) || DataExceedsThreshold(source->data_tables())) {
+    const time_point start = *now;
+    source->PushData(serialized_data_push_callback_);
+
+    // PushData() is normally a significant amount of work: update "time now".
+    *now = std::chrono::steady_clock::now();
+    source->push_freq_mgr().Reset(*now);
+    stats->RecordPushData(source->name(), *now - start);
+  }
+}
+
+// Run loop of a source with its own thread. Same as the RunCore() loop, but for just one source,
+// so that its TransferData() and PushData() calls do not delay the other sources.
+void StirlingImpl::RunSourceExecutor(SourceExecutor* executor) {
+  SourceConnector* source = executor->source;
+  LOG(INFO) << absl::Substitute("Source connector $0 is running on its own thread.",
+                                source->name());
+
+  auto now = std::chrono::steady_clock::now();
+
+  FrequencyManager ctx_freq_mgr;
+  ctx_freq_mgr.set_period(kContextUpdatePeriod);
+  std::unique_ptr<ConnectorContext> ctx = GetContext();
+
+  while (run_enable_ && executor->run_enable) {
+    const auto now_plus_run_window = now + kRunWindow;
+
+    if (ctx_freq_mgr.Expired(now_plus_run_window)) {
+      ctx = GetContext();
+      now = std::chrono::steady_clock::now();
+      ctx_freq_mgr.Reset(now);
+    }
+
+    RunSourceIfDue(source, ctx.get(), now_plus_run_window, &now, &executor->stats);
+
+    auto wakeup_time = std::min({now + kMaxSleepDuration, source->sampling_freq_mgr().next(),
+                                 source->push_freq_mgr().next()});
+    auto time_until_next_tick =
+        std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now);
+
+    if (time_until_next_tick >= kRunWindow) {
+      std::this_thread::sleep_for(time_until_next_tick);
+      executor->stats.EndIter(time_until_next_tick);
+      now = std::chrono::steady_clock::now();
+    } else {
+      executor->stats.EndIter(std::chrono::milliseconds::zero());
+    }
+  }
+}
+
 // Main Data Collector loop.
 // Poll on Data Source Through connectors, when appropriate, then go to sleep.
 // Must run as a thread, so only call from Run() as a thread.
@@ -788,6 +976,24 @@ void StirlingImpl::RunCore() {
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
+  // Hand the sources that are configured to run on their own thread over to their executors.
+  {
+    const std::vector<std::string_view> dedicated_thread_sources =
+        absl::StrSplit(FLAGS_stirling_dedicated_thread_sources, ",", absl::SkipWhitespace());
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    for (const auto& s : sources_) {
+      if (std::find(dedicated_thread_sources.begin(), dedicated_thread_sources.end(),
+                    s->name()) != dedicated_thread_sources.end()) {
+        executors_.push_back(std::make_unique<SourceExecutor>(s.get()));
+        executor_sources_.insert(s.get());
+      }
+    }
+    for (auto& executor : executors_) {
+      executor->thread = std::thread(&StirlingImpl::RunSourceExecutor, this, executor.get());
+    }
+  }
+  executors_running_ = true;
+
   // Indicates completion of initialization, and start of data collection.
   LOG(INFO) << "Stirling is running.";
 
@@ -801,11 +1007,10 @@ void StirlingImpl::RunCore() {
   // a time period has expired and a call to TransferData() or PushData() is required).
   auto now = std::chrono::steady_clock::now();
   auto time_until_next_tick = std::chrono::milliseconds::zero();
-  constexpr auto kRunWindow = std::chrono::milliseconds{1};
 
   // The ctx_freq_mgr controls the update period for the k8s context "ctx".
   FrequencyManager ctx_freq_mgr;
-  ctx_freq_mgr.set_period(std::chrono::milliseconds{200});
+  ctx_freq_mgr.set_period(kContextUpdatePeriod);
   std::unique_ptr<ConnectorContext> ctx = GetContext();
 
   while (run_enable_) {
@@ -825,27 +1030,13 @@ void StirlingImpl::RunCore() {
       // Needed to avoid race with main thread update info_class_mgrs_ on new subscription.
       absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
-      // Run through every SourceConnector and InfoClassManager being managed.
+      // Run through every SourceConnector and InfoClassManager being managed,
+      // except those that run on their own thread.
       for (auto& source : sources_) {
-        // Phase 1: Probe each source for its data.
-        if (source->sampling_freq_mgr().Expired(now_plus_run_window)) {
-          source->TransferData(ctx.get());
-
-          // TransferData() is normally a significant amount of work: update "time now".
-          now = std::chrono::steady_clock::now();
-          source->sampling_freq_mgr().Reset(now);
-          run_core_stats_.IncrementTransferDataCount();
-        }
-        // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired(now_plus_run_window) ||
-            DataExceedsThreshold(source->data_tables())) {
-          source->PushData(data_push_callback_);
-
-          // PushData() is normally a significant amount of work: update "time now".
-          now = std::chrono::steady_clock::now();
-          source->push_freq_mgr().Reset(now);
-          run_core_stats_.IncrementPushDataCount();
+        if (executor_sources_.contains(source.get())) {
+          continue;
         }
+        RunSourceIfDue(source.get(), ctx.get(), now_plus_run_window, &now, &run_core_stats_);
       }
 
       // Figure the time remaining until the next required data sample or push data.
@@ -870,10 +1061,27 @@ void StirlingImpl::RunCore() {
       run_core_stats_.EndIter(std::chrono::milliseconds::zero());
     }
   }
+
+  // The executors exit their loops when run_enable_ is cleared; wait for them, so that Stop()
+  // does not stop their sources while they are still running.
+  executors_running_ = false;
+  std::vector<std::unique_ptr<SourceExecutor>> executors;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    executors = std::move(executors_);
+    executors_.clear();
+    executor_sources_.clear();
+  }
+  for (auto& executor : executors) {
+    executor->thread.join();
+  }
+
   running_ = false;
 }
 
-bool StirlingImpl::IsRunning() const { return running_; }
+// Stirling is running once both the RunCore() loop and the threads of the sources that run on
+// their own thread have started.
+bool StirlingImpl::IsRunning() const { return running_ && executors_running_; }
 
 Status StirlingImpl::WaitUntilRunning(std::chrono::milliseconds timeout) const {
   const auto timeout_time = std::chrono::steady_clock::now() + timeout;
@@ -941,6 +1149,11 @@ void StirlingImpl::UpdateDynamicTraceStatus(const sole::uuid& trace_id,
     builder.WriteKV("trace_id", trace_id.str());
     if (s.ok()) {
       builder.WriteKV("output_table", trace_info.output_table);
+      builder.WriteKV("compile_time_us", trace_info.compile_time_us);
+      builder.WriteKV("deploy_time_us", trace_info.deploy_time_us);
+      if (!trace_info.bcc_program_cache.empty()) {
+        builder.WriteKV("bcc_program_cache", trace_info.bcc_program_cache);
+      }
     }
 
     monitor_.AppendProbeStatusRecord(trace_info.source_connector, trace_info.tracepoint, s.status(),
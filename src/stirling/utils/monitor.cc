@@ -35,14 +35,19 @@ StirlingMonitor::StirlingMonitor()
           BuildCounter(kJavaProcCrashedDuringAttach,
                        "Count of Java process crashes during symbolization agent attach.")) {}
 
-void StirlingMonitor::ResetJavaProcessAttachTrackers() { java_proc_attach_times_.clear(); }
+void StirlingMonitor::ResetJavaProcessAttachTrackers() {
+  absl::base_internal::SpinLockHolder lock(&java_proc_attach_lock_);
+  java_proc_attach_times_.clear();
+}
 
 void StirlingMonitor::NotifyJavaProcessAttach(const struct upid_t& upid) {
+  absl::base_internal::SpinLockHolder lock(&java_proc_attach_lock_);
   DCHECK(java_proc_attach_times_.find(upid) == java_proc_attach_times_.end());
   java_proc_attach_times_[upid] = std::chrono::steady_clock::now();
 }
 
 void StirlingMonitor::NotifyJavaProcessCrashed(const struct upid_t& upid) {
+  absl::base_internal::SpinLockHolder lock(&java_proc_attach_lock_);
   const auto iter = java_proc_attach_times_.find(upid);
   if (iter != java_proc_attach_times_.end()) {
     const auto& t_attach = iter->second;
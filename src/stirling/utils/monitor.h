@@ -75,7 +75,9 @@ class StirlingMonitor : NotCopyMoveable {
  private:
   StirlingMonitor();
   using timestamp_t = std::chrono::time_point<std::chrono::steady_clock>;
-  absl::flat_hash_map<struct upid_t, timestamp_t> java_proc_attach_times_;
+  // The perf profiler and the proc exit tracer may run on different threads.
+  absl::flat_hash_map<struct upid_t, timestamp_t> java_proc_attach_times_
+      ABSL_GUARDED_BY(java_proc_attach_lock_);
 
   // Records of probe deployment status.
   std::vector<ProbeStatusRecord> probe_status_records_ ABSL_GUARDED_BY(probe_status_lock_);
@@ -85,6 +87,7 @@ class StirlingMonitor : NotCopyMoveable {
   // Lock to protect probe and source records.
   absl::base_internal::SpinLock probe_status_lock_;
   absl::base_internal::SpinLock source_status_lock_;
+  absl::base_internal::SpinLock java_proc_attach_lock_;
 
   prometheus::Counter& java_proc_crashed_during_attach_;
 };
@@ -18,11 +18,15 @@
 
 #include "src/stirling/utils/run_core_stats.h"
 
+#include <map>
+
 namespace px {
 namespace stirling {
 
 namespace {
 
+// Buckets of the sleep duration histograms. Also used for the TransferData() and PushData()
+// latency histograms.
 static constexpr std::array<std::chrono::nanoseconds, 23> kSleepBuckets = {
     std::chrono::nanoseconds{0},
     std::chrono::nanoseconds{10000},
@@ -51,7 +55,7 @@ static constexpr std::array<std::chrono::nanoseconds, 23> kSleepBuckets = {
 std::string CreateHeaderString() {
   std::stringstream s;
 
-  s << "|main_loop_iters,no_work_iters,useful_iters,push+transfer";
+  s << "|loop,main_loop_iters,no_work_iters,useful_iters,push+transfer";
   s << ",transfer,push,min_push+transfer,max_push+transfer";
 
   for (const auto bucket : kSleepBuckets) {
@@ -60,14 +64,35 @@ std::string CreateHeaderString() {
   for (const auto bucket : kSleepBuckets) {
     s << absl::StrFormat(",no_work_%.2f_ms", static_cast<double>(bucket.count()) / 1e6);
   }
-  // header_string_ = s.str();
   return s.str();
 }
 
+std::string CreateLatencyHeaderString() {
+  std::stringstream s;
+
+  s << "|loop,source,call";
+  for (const auto bucket : kSleepBuckets) {
+    s << absl::StrFormat(",latency_%.2f_ms", static_cast<double>(bucket.count()) / 1e6);
+  }
+  return s.str();
+}
+
+uint64_t CountForDuration(const std::vector<uint64_t>& histo, const std::chrono::nanoseconds d) {
+  uint32_t bucket_idx = 0;
+  for (const auto bucket_value : kSleepBuckets) {
+    if (d <= bucket_value) {
+      return histo[bucket_idx];
+    }
+    ++bucket_idx;
+  }
+  return 0;
+}
+
 }  // namespace
 
-RunCoreStats::RunCoreStats()
-    : header_string_(CreateHeaderString()),
+RunCoreStats::RunCoreStats(std::string_view name)
+    : name_(name),
+      header_string_(CreateHeaderString()),
       sleep_histo_(kSleepBuckets.size(), 0),
       no_work_histo_(kSleepBuckets.size(), 0) {}
 
@@ -81,25 +106,48 @@ void RunCoreStats::IncrementPushDataCount() {
   ++push_or_transfer_this_iter_;
 }
 
+void RunCoreStats::RecordTransferData(std::string_view source_name,
+                                      const std::chrono::nanoseconds latency) {
+  IncrementTransferDataCount();
+  UpdateDurationHisto(latency, LatencyHisto(source_name, &transfer_data_latency_histos_));
+}
+
+void RunCoreStats::RecordPushData(std::string_view source_name,
+                                  const std::chrono::nanoseconds latency) {
+  IncrementPushDataCount();
+  UpdateDurationHisto(latency, LatencyHisto(source_name, &push_data_latency_histos_));
+}
+
 void RunCoreStats::LogStats() const {
   std::string s = absl::StrJoin(sleep_histo_, ",");
   absl::StrAppend(&s, ",", absl::StrJoin(no_work_histo_, ","));
 
-  LOG(INFO) << absl::Substitute("|$0,$1,$2,$3,$4,$5,$6,$7,$8", num_main_loop_iters_,
+  LOG(INFO) << absl::Substitute("|$0,$1,$2,$3,$4,$5,$6,$7,$8,$9", name_, num_main_loop_iters_,
                                 num_no_work_iters_, (num_main_loop_iters_ - num_no_work_iters_),
                                 (num_transfer_data_ + num_push_data_), num_transfer_data_,
                                 num_push_data_, min_push_or_transfer_, max_push_or_transfer_, s);
+
+  // Sort by source name, so the printouts of successive periods line up.
+  for (const auto& [source_name, histo] : std::map(transfer_data_latency_histos_.begin(),
+                                                   transfer_data_latency_histos_.end())) {
+    LOG(INFO) << absl::Substitute("|$0,$1,transfer,$2", name_, source_name,
+                                  absl::StrJoin(histo, ","));
+  }
+  for (const auto& [source_name, histo] :
+       std::map(push_data_latency_histos_.begin(), push_data_latency_histos_.end())) {
+    LOG(INFO) << absl::Substitute("|$0,$1,push,$2", name_, source_name, absl::StrJoin(histo, ","));
+  }
 }
 
 void RunCoreStats::EndIter(const std::chrono::milliseconds sleep_duration) {
-  UpdateSleepDurationHisto(sleep_duration, &sleep_histo_);
+  UpdateDurationHisto(sleep_duration, &sleep_histo_);
   ++num_main_loop_iters_;
   min_push_or_transfer_ = std::min(push_or_transfer_this_iter_, min_push_or_transfer_);
   max_push_or_transfer_ = std::max(push_or_transfer_this_iter_, max_push_or_transfer_);
 
   if (push_or_transfer_this_iter_ == 0) {
     ++num_no_work_iters_;
-    UpdateSleepDurationHisto(sleep_duration, &no_work_histo_);
+    UpdateDurationHisto(sleep_duration, &no_work_histo_);
   }
   push_or_transfer_this_iter_ = 0;
 
@@ -109,6 +157,7 @@ void RunCoreStats::EndIter(const std::chrono::milliseconds sleep_duration) {
   // Will subtract 1 from iter count to make sure we print the headers immediately.
   if ((num_main_loop_iters_ - 1) % kHeaderPeriod == 0) {
     LOG(INFO) << header_string_;
+    LOG(INFO) << CreateLatencyHeaderString();
   }
   if (num_main_loop_iters_ % kPrintPeriod == 0) {
     LogStats();
@@ -116,30 +165,37 @@ void RunCoreStats::EndIter(const std::chrono::milliseconds sleep_duration) {
 }
 
 uint64_t RunCoreStats::SleepCountForDuration(const std::chrono::nanoseconds d) const {
-  uint32_t bucket_idx = 0;
-  for (const auto bucket_value : kSleepBuckets) {
-    if (d <= bucket_value) {
-      return sleep_histo_[bucket_idx];
-    }
-    ++bucket_idx;
-  }
-  return 0;
+  return CountForDuration(sleep_histo_, d);
 }
 
 uint64_t RunCoreStats::NoWorkCountForDuration(const std::chrono::nanoseconds d) const {
-  uint32_t bucket_idx = 0;
-  for (const auto bucket_value : kSleepBuckets) {
-    if (d <= bucket_value) {
-      return no_work_histo_[bucket_idx];
-    }
-    ++bucket_idx;
+  return CountForDuration(no_work_histo_, d);
+}
+
+uint64_t RunCoreStats::TransferDataLatencyCount(std::string_view source_name,
+                                                const std::chrono::nanoseconds d) const {
+  auto iter = transfer_data_latency_histos_.find(source_name);
+  return iter == transfer_data_latency_histos_.end() ? 0 : CountForDuration(iter->second, d);
+}
+
+uint64_t RunCoreStats::PushDataLatencyCount(std::string_view source_name,
+                                            const std::chrono::nanoseconds d) const {
+  auto iter = push_data_latency_histos_.find(source_name);
+  return iter == push_data_latency_histos_.end() ? 0 : CountForDuration(iter->second, d);
+}
+
+std::vector<uint64_t>* RunCoreStats::LatencyHisto(
+    std::string_view source_name, absl::flat_hash_map<std::string, std::vector<uint64_t>>* m) {
+  auto iter = m->find(source_name);
+  if (iter == m->end()) {
+    iter = m->try_emplace(std::string(source_name), kSleepBuckets.size(), 0).first;
   }
-  return 0;
+  return &iter->second;
 }
 
-void RunCoreStats::UpdateSleepDurationHisto(const std::chrono::milliseconds d,
-                                            std::vector<uint64_t>* h) {
-  // "d" is the sleep duration and "h" is the histogram that we will upate.
+void RunCoreStats::UpdateDurationHisto(const std::chrono::nanoseconds d,
+                                       std::vector<uint64_t>* h) {
+  // "d" is the duration and "h" is the histogram that we will upate.
   // The histogram is designed to always find a valid bucket (there is no fall through case).
   uint32_t bucket_idx = 0;
   for (const auto bucket_value : kSleepBuckets) {
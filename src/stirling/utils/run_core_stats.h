@@ -21,8 +21,10 @@
 #include <algorithm>
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_join.h>
 
@@ -31,17 +33,24 @@
 namespace px {
 namespace stirling {
 
-// RunCoreStats tracks the work done in each iteration of StirlingImpl::RunCore.
+// RunCoreStats tracks the work done in each iteration of StirlingImpl::RunCore, or of the loop of
+// a source connector that runs on its own thread.
 // It counts the number of PushData() and TransferData() calls.
-// It also keeps a histogram of sleep durations: total, and those sleeps where no work is done.
+// It also keeps a histogram of sleep durations: total, and those sleeps where no work is done,
+// and per source connector histograms of the TransferData() and PushData() latencies.
 class RunCoreStats {
  public:
-  RunCoreStats();
+  // The name identifies the loop in the stats printouts.
+  explicit RunCoreStats(std::string_view name = "main");
 
   // Increment totals and per iteration counts.
   void IncrementTransferDataCount();
   void IncrementPushDataCount();
 
+  // Increment the counts, and record the latency of the call in the source's histograms.
+  void RecordTransferData(std::string_view source_name, std::chrono::nanoseconds latency);
+  void RecordPushData(std::string_view source_name, std::chrono::nanoseconds latency);
+
   // Logs the stats.
   void LogStats() const;
 
@@ -61,10 +70,19 @@ class RunCoreStats {
   // For now, they are useful only for the test case in run_core_stats_test.cc.
   uint64_t SleepCountForDuration(std::chrono::nanoseconds d) const;
   uint64_t NoWorkCountForDuration(std::chrono::nanoseconds d) const;
+  uint64_t TransferDataLatencyCount(std::string_view source_name,
+                                    std::chrono::nanoseconds d) const;
+  uint64_t PushDataLatencyCount(std::string_view source_name, std::chrono::nanoseconds d) const;
 
  private:
-  // Update a particular sleep histogram (passed in as *h). Called by EndIter().
-  void UpdateSleepDurationHisto(std::chrono::milliseconds d, std::vector<uint64_t>* h);
+  // Update a particular duration histogram (passed in as *h).
+  void UpdateDurationHisto(std::chrono::nanoseconds d, std::vector<uint64_t>* h);
+
+  // Returns the latency histogram of the source, creating it if needed.
+  std::vector<uint64_t>* LatencyHisto(std::string_view source_name,
+                                      absl::flat_hash_map<std::string, std::vector<uint64_t>>* m);
+
+  const std::string name_;
 
   // Header string used for stats printouts, populated in the ctor.
   const std::string header_string_;
@@ -78,6 +96,10 @@ class RunCoreStats {
   uint64_t push_or_transfer_this_iter_ = 0;
   std::vector<uint64_t> sleep_histo_;
   std::vector<uint64_t> no_work_histo_;
+
+  // Latency histograms of TransferData() and PushData(), keyed by source connector name.
+  absl::flat_hash_map<std::string, std::vector<uint64_t>> transfer_data_latency_histos_;
+  absl::flat_hash_map<std::string, std::vector<uint64_t>> push_data_latency_histos_;
 };
 
 }  // namespace stirling
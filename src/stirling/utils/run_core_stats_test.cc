@@ -67,5 +67,27 @@ TEST(RunCoreStatsTest, RunCoreStatsTest) {
   stats.LogStats();
 }
 
+TEST(RunCoreStatsTest, LatencyHistograms) {
+  RunCoreStats stats("test");
+
+  stats.RecordTransferData("socket_tracer", std::chrono::milliseconds{2});
+  stats.RecordTransferData("socket_tracer", std::chrono::milliseconds{2});
+  stats.RecordTransferData("perf_profiler", std::chrono::milliseconds{500});
+  stats.RecordPushData("socket_tracer", std::chrono::microseconds{50});
+  stats.EndIter(std::chrono::milliseconds{0});
+
+  EXPECT_EQ(3, stats.num_transfer_data());
+  EXPECT_EQ(1, stats.num_push_data());
+  EXPECT_EQ(0, stats.num_no_work_iters());
+
+  EXPECT_EQ(2, stats.TransferDataLatencyCount("socket_tracer", std::chrono::milliseconds{2}));
+  EXPECT_EQ(0, stats.TransferDataLatencyCount("socket_tracer", std::chrono::milliseconds{500}));
+  EXPECT_EQ(1, stats.TransferDataLatencyCount("perf_profiler", std::chrono::milliseconds{500}));
+  EXPECT_EQ(1, stats.PushDataLatencyCount("socket_tracer", std::chrono::microseconds{50}));
+  EXPECT_EQ(0, stats.PushDataLatencyCount("perf_profiler", std::chrono::microseconds{50}));
+
+  stats.LogStats();
+}
+
 }  // namespace stirling
 }  // namespace px
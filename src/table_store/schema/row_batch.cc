@@ -22,6 +22,8 @@
 #include <string>
 #include <vector>
 
+#include <utility>
+
 #include <absl/strings/str_format.h>
 #include "src/common/base/base.h"
 #include "src/shared/types/arrow_adapter.h"
@@ -34,20 +36,129 @@ namespace schema {
 
 using types::DataType;
 
-std::shared_ptr<arrow::Array> RowBatch::ColumnAt(int64_t i) const { return columns_[i]; }
+namespace {
+
+template <DataType T>
+Status GatherValues(const arrow::Array* input, const SelectionVector& selection,
+                    arrow::MemoryPool* mem_pool, std::shared_ptr<arrow::Array>* output) {
+  auto builder_generic = types::MakeArrowBuilder(T, mem_pool);
+  auto* builder =
+      static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(builder_generic.get());
+  PX_RETURN_IF_ERROR(builder->Reserve(selection.size()));
+  if constexpr (T == DataType::STRING) {
+    // Size the data buffer exactly, so that large string columns are copied only once.
+    const auto* input_strings = static_cast<const arrow::StringArray*>(input);
+    int64_t data_size = 0;
+    for (int64_t idx : selection) {
+      data_size += input_strings->value_length(idx);
+    }
+    PX_RETURN_IF_ERROR(builder->ReserveData(data_size));
+  }
+  for (int64_t idx : selection) {
+    builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input, idx));
+  }
+  PX_RETURN_IF_ERROR(builder->Finish(output));
+  return Status::OK();
+}
+
+template <DataType T>
+int64_t SelectedBytes(const arrow::Array* input, const SelectionVector& selection) {
+  if constexpr (T == DataType::STRING) {
+    const auto* input_strings = static_cast<const arrow::StringArray*>(input);
+    int64_t total_bytes = 0;
+    for (int64_t idx : selection) {
+      total_bytes += input_strings->value_length(idx);
+    }
+    return total_bytes;
+  } else {
+    return selection.size() * types::ArrowTypeToBytes(types::ToArrowType(T));
+  }
+}
+
+}  // namespace
+
+Status RowBatch::GatherColumn(int64_t i) const {
+  DCHECK(selection_ != nullptr);
+  if (gathered_columns_[i] != nullptr) {
+    return Status::OK();
+  }
+#define TYPE_CASE(_dt_)   \
+  PX_RETURN_IF_ERROR(     \
+      GatherValues<_dt_>(columns_[i].get(), *selection_, mem_pool_, &gathered_columns_[i]));
+  PX_SWITCH_FOREACH_DATATYPE(desc_.type(i), TYPE_CASE);
+#undef TYPE_CASE
+  return Status::OK();
+}
+
+std::shared_ptr<arrow::Array> RowBatch::ColumnAt(int64_t i) const {
+  if (selection_ == nullptr) {
+    return columns_[i];
+  }
+  CHECK(gathered_columns_[i] != nullptr) << absl::Substitute("Column $0 is not materialized", i);
+  return gathered_columns_[i];
+}
+
+Status RowBatch::Materialize() const {
+  if (selection_ == nullptr) {
+    return Status::OK();
+  }
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    PX_RETURN_IF_ERROR(GatherColumn(i));
+  }
+  return Status::OK();
+}
+
+Status RowBatch::MaterializeColumns(const std::vector<int64_t>& cols) const {
+  if (selection_ == nullptr) {
+    return Status::OK();
+  }
+  for (int64_t i : cols) {
+    PX_RETURN_IF_ERROR(GatherColumn(i));
+  }
+  return Status::OK();
+}
+
+bool RowBatch::is_materialized() const {
+  if (selection_ == nullptr) {
+    return true;
+  }
+  for (const auto& col : gathered_columns_) {
+    if (col == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::shared_ptr<arrow::Array>> RowBatch::columns() const {
+  if (selection_ == nullptr) {
+    return columns_;
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns;
+  columns.reserve(columns_.size());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    columns.push_back(ColumnAt(i));
+  }
+  return columns;
+}
 
 Status RowBatch::AddColumn(const std::shared_ptr<arrow::Array>& col) {
   if (columns_.size() >= desc_.size()) {
     return error::InvalidArgument("Schema only allows $0 columns", desc_.size());
   }
-  if (col->length() != num_rows_) {
-    return error::InvalidArgument("Schema only allows $0 rows, got $1", num_rows_, col->length());
+  int64_t expected_rows = selection_ == nullptr ? num_rows_ : num_input_rows_;
+  if (col->length() != expected_rows) {
+    return error::InvalidArgument("Schema only allows $0 rows, got $1", expected_rows,
+                                  col->length());
   }
   if (col->type_id() != types::ToArrowType(desc_.type(columns_.size()))) {
     return error::InvalidArgument("Column[$0] was given incorrect type", columns_.size());
   }
 
   columns_.emplace_back(col);
+  if (selection_ != nullptr) {
+    gathered_columns_.emplace_back(nullptr);
+  }
   return Status::OK();
 }
 
@@ -58,7 +169,11 @@ std::string RowBatch::DebugString() const {
     return "RowBatch: <empty>";
   }
   std::string debug_string = absl::StrFormat("RowBatch(eow=%d, eos=%d):\n", eow_, eos_);
-  for (const auto& col : columns_) {
+  auto s = Materialize();
+  if (!s.ok()) {
+    return debug_string + absl::StrFormat("  <failed to materialize: %s>\n", s.msg());
+  }
+  for (const auto& col : columns()) {
     debug_string += absl::StrFormat("  %s\n", col->ToString());
   }
   return debug_string;
@@ -70,6 +185,15 @@ int64_t RowBatch::NumBytes() const {
   }
 
   int64_t total_bytes = 0;
+  if (selection_ != nullptr) {
+    // Count the selected bytes without materializing the columns.
+    for (const auto& [i, col] : Enumerate(columns_)) {
+#define TYPE_CASE(_dt_) total_bytes += SelectedBytes<_dt_>(col.get(), *selection_);
+      PX_SWITCH_FOREACH_DATATYPE(desc_.type(i), TYPE_CASE);
+#undef TYPE_CASE
+    }
+    return total_bytes;
+  }
   for (auto col : columns_) {
 #define TYPE_CASE(_dt_) total_bytes += types::GetArrowArrayBytes<_dt_>(col.get());
     PX_SWITCH_FOREACH_DATATYPE(types::ArrowToDataType(col->type_id()), TYPE_CASE);
@@ -159,6 +283,7 @@ Status CopyFromInputPB(std::shared_ptr<arrow::Array>* output_column,
 }
 
 Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
+  PX_RETURN_IF_ERROR(Materialize());
   proto->set_num_rows(num_rows_);
   proto->set_eow(eow_);
   proto->set_eos(eos_);
@@ -257,6 +382,20 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::Slice(int64_t offset, int64_t leng
     return error::InvalidArgument("Slice(offset=$0, length=$1) on rowbatch of length $2 is invalid",
                                   offset, length, num_rows());
   }
+  if (selection_ != nullptr) {
+    // Slice the selection vector, and only the columns that were already materialized.
+    auto selection = std::make_shared<SelectionVector>(selection_->begin() + offset,
+                                                       selection_->begin() + offset + length);
+    auto output_rb = std::make_unique<RowBatch>(desc(), std::move(selection), num_input_rows_,
+                                                mem_pool_);
+    for (const auto& [i, col] : Enumerate(columns_)) {
+      PX_RETURN_IF_ERROR(output_rb->AddColumn(col));
+      if (gathered_columns_[i] != nullptr) {
+        output_rb->gathered_columns_[i] = gathered_columns_[i]->Slice(offset, length);
+      }
+    }
+    return output_rb;
+  }
   std::unique_ptr<RowBatch> output_rb = std::make_unique<RowBatch>(desc(), length);
   for (int64_t input_col_idx = 0; input_col_idx < num_columns(); ++input_col_idx) {
     auto col = ColumnAt(input_col_idx);
@@ -265,6 +404,44 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::Slice(int64_t offset, int64_t leng
   return output_rb;
 }
 
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::Project(const RowDescriptor& desc,
+                                                      const std::vector<int64_t>& cols) const {
+  if (selection_ == nullptr) {
+    auto output_rb = std::make_unique<RowBatch>(desc, num_rows_);
+    for (int64_t col_idx : cols) {
+      PX_RETURN_IF_ERROR(output_rb->AddColumn(columns_[col_idx]));
+    }
+    return output_rb;
+  }
+  auto output_rb = std::make_unique<RowBatch>(desc, selection_, num_input_rows_, mem_pool_);
+  for (const auto& [output_col_idx, input_col_idx] : Enumerate(cols)) {
+    PX_RETURN_IF_ERROR(output_rb->AddColumn(columns_[input_col_idx]));
+    output_rb->gathered_columns_[output_col_idx] = gathered_columns_[input_col_idx];
+  }
+  return output_rb;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::Select(const RowDescriptor& desc,
+                                                     const std::vector<int64_t>& cols,
+                                                     SelectionVector rows,
+                                                     arrow::MemoryPool* mem_pool) const {
+  int64_t num_input_rows = num_rows_;
+  if (selection_ != nullptr) {
+    // Compose with the existing selection, so that the rows are gathered from the input columns
+    // directly.
+    for (auto& row : rows) {
+      row = (*selection_)[row];
+    }
+    num_input_rows = num_input_rows_;
+  }
+  auto output_rb = std::make_unique<RowBatch>(
+      desc, std::make_shared<const SelectionVector>(std::move(rows)), num_input_rows, mem_pool);
+  for (int64_t col_idx : cols) {
+    PX_RETURN_IF_ERROR(output_rb->AddColumn(columns_[col_idx]));
+  }
+  return output_rb;
+}
+
 }  // namespace schema
 }  // namespace table_store
 }  // namespace px
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <arrow/array.h>
+#include <arrow/memory_pool.h>
 #include <arrow/type.h>
 #include <map>
 #include <memory>
@@ -33,9 +34,17 @@ namespace px {
 namespace table_store {
 namespace schema {
 
+// Indices of the rows selected from a set of input columns.
+using SelectionVector = std::vector<int64_t>;
+
 /**
  * A RowBatch is a table-like structure which consists of equal-length arrays
  * that match the schema described by the RowDescriptor.
+ *
+ * A RowBatch can also carry a selection vector over its columns (see the selection constructor),
+ * in which case the columns are only materialized into dense arrays when they are accessed. This
+ * lets operators like Filter and Limit pass rows through without copying columns that nothing
+ * downstream reads.
  */
 class RowBatch {
  public:
@@ -49,6 +58,23 @@ class RowBatch {
     columns_.reserve(desc_.size());
   }
 
+  /**
+   * Creates a row batch whose rows are the rows at the `selection` indices of its columns. The
+   * columns added with AddColumn must have `num_input_rows` rows, while the row batch itself has
+   * selection->size() rows. Each column is gathered into a dense array allocated from `mem_pool`
+   * by Materialize.
+   */
+  RowBatch(RowDescriptor desc, std::shared_ptr<const SelectionVector> selection,
+           int64_t num_input_rows, arrow::MemoryPool* mem_pool)
+      : desc_(std::move(desc)),
+        num_rows_(selection->size()),
+        selection_(std::move(selection)),
+        num_input_rows_(num_input_rows),
+        mem_pool_(mem_pool) {
+    columns_.reserve(desc_.size());
+    gathered_columns_.reserve(desc_.size());
+  }
+
   Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
@@ -76,6 +102,28 @@ class RowBatch {
    */
   StatusOr<std::unique_ptr<RowBatch>> Slice(int64_t offset, int64_t length) const;
 
+  /**
+   * @brief Returns a row batch with the columns `cols` of this row batch, in that order.
+   *
+   * Columns that have not been materialized yet stay unmaterialized in the returned row batch.
+   * Does not set eow and eos.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> Project(const RowDescriptor& desc,
+                                              const std::vector<int64_t>& cols) const;
+
+  /**
+   * @brief Returns a row batch with the columns `cols` restricted to the rows `rows`.
+   *
+   * No data is copied: the returned row batch carries a selection vector over this row batch's
+   * input columns and gathers each column from `mem_pool` on first access. Does not set eow and
+   * eos.
+   *
+   * @param rows indices into this row batch, in increasing order.
+   */
+  StatusOr<std::unique_ptr<RowBatch>> Select(const RowDescriptor& desc,
+                                             const std::vector<int64_t>& cols, SelectionVector rows,
+                                             arrow::MemoryPool* mem_pool) const;
+
   /**
    * Adds the given column to the row batch, given that it correctly fits the schema.
    * param col ptr to the arrow array that should be added to the row batch.
@@ -84,10 +132,31 @@ class RowBatch {
 
   /**
    * @ param i the index of the column to be accessed.
-   * @ returns the Arrow array for the column at the given index.
+   * @ returns the Arrow array for the column at the given index. If the row batch has a selection
+   * vector, the column must have been materialized first; accessing a column that wasn't is a
+   * fatal error.
    */
   std::shared_ptr<arrow::Array> ColumnAt(int64_t i) const;
 
+  /**
+   * Materializes all columns of a row batch with a selection vector. Gathering allocates from the
+   * row batch's memory pool, which fails once the query hits its memory limit. ExecNode calls this
+   * before handing a row batch to an operator that reads its columns.
+   */
+  Status Materialize() const;
+
+  /**
+   * Materializes only the columns `cols` of a row batch with a selection vector, for operators
+   * that read a subset of their input columns.
+   */
+  Status MaterializeColumns(const std::vector<int64_t>& cols) const;
+
+  // Whether the columns of this row batch can be accessed with ColumnAt.
+  bool is_materialized() const;
+
+  // Whether the columns of this row batch are accessed through a selection vector.
+  bool has_selection() const { return selection_ != nullptr; }
+
   /**
    * @ param i the index of the column to check.
    * @ returns whether the rowbatch contains a column at the given index.
@@ -116,7 +185,7 @@ class RowBatch {
   const RowDescriptor& desc() const { return desc_; }
 
   std::string DebugString() const;
-  std::vector<std::shared_ptr<arrow::Array>> columns() const { return columns_; }
+  std::vector<std::shared_ptr<arrow::Array>> columns() const;
 
   int64_t NumBytes() const;
 
@@ -126,6 +195,15 @@ class RowBatch {
   bool eow_ = false;
   bool eos_ = false;
   std::vector<std::shared_ptr<arrow::Array>> columns_;
+
+  Status GatherColumn(int64_t i) const;
+
+  // Only set for row batches with a selection vector. columns_ then holds the input columns.
+  std::shared_ptr<const SelectionVector> selection_;
+  int64_t num_input_rows_ = 0;
+  arrow::MemoryPool* mem_pool_ = nullptr;
+  // The columns gathered through selection_, filled in by Materialize.
+  mutable std::vector<std::shared_ptr<arrow::Array>> gathered_columns_;
 };
 
 // Append a scalar value to an arrow::Array.
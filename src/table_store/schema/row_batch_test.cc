@@ -231,6 +231,87 @@ TEST_F(RowBatchTest, slice) {
   ASSERT_EQ(status2.msg(), "Slice(offset=-1, length=3) on rowbatch of length 3 is invalid");
 }
 
+TEST_F(RowBatchTest, select) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::BOOLEAN});
+  ASSERT_OK_AND_ASSIGN(auto selected_rb,
+                       rb_->Select(rd, {1, 0}, {0, 2}, arrow::default_memory_pool()));
+  EXPECT_TRUE(selected_rb->has_selection());
+  EXPECT_EQ(2, selected_rb->num_rows());
+  EXPECT_EQ(2, selected_rb->num_columns());
+  // Counting bytes does not need the columns to be gathered.
+  EXPECT_EQ(18, selected_rb->NumBytes());
+  EXPECT_FALSE(selected_rb->is_materialized());
+  ASSERT_OK(selected_rb->Materialize());
+  EXPECT_TRUE(selected_rb->is_materialized());
+  EXPECT_EQ(2, selected_rb->ColumnAt(0)->length());
+  EXPECT_EQ("RowBatch(eow=0, eos=0):\n  [\n  3,\n  5\n]\n  [\n  true,\n  true\n]\n",
+            selected_rb->DebugString());
+
+  // Selecting from a selected row batch composes the selections.
+  RowDescriptor rd2({types::DataType::INT64});
+  ASSERT_OK_AND_ASSIGN(auto selected_rb2,
+                       selected_rb->Select(rd2, {0}, {1}, arrow::default_memory_pool()));
+  EXPECT_EQ("RowBatch(eow=0, eos=0):\n  [\n  5\n]\n", selected_rb2->DebugString());
+}
+
+TEST_F(RowBatchTest, materialize_columns) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::BOOLEAN});
+  ASSERT_OK_AND_ASSIGN(auto selected_rb,
+                       rb_->Select(rd, {1, 0}, {0, 2}, arrow::default_memory_pool()));
+  ASSERT_OK(selected_rb->MaterializeColumns({1}));
+  EXPECT_FALSE(selected_rb->is_materialized());
+  EXPECT_EQ(2, selected_rb->ColumnAt(1)->length());
+  EXPECT_DEATH(selected_rb->ColumnAt(0), "Column 0 is not materialized");
+  ASSERT_OK(selected_rb->MaterializeColumns({0}));
+  EXPECT_TRUE(selected_rb->is_materialized());
+}
+
+TEST_F(RowBatchTest, select_project_and_slice) {
+  std::vector<types::StringValue> strs = {"aaaa", "b", "cc", "ddd"};
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING});
+  RowBatch rb(rd, 4);
+  std::vector<types::Int64Value> ints = {1, 2, 3, 4};
+  ASSERT_OK(rb.AddColumn(types::ToArrow(ints, arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(types::ToArrow(strs, arrow::default_memory_pool())));
+
+  ASSERT_OK_AND_ASSIGN(auto selected_rb,
+                       rb.Select(rd, {0, 1}, {0, 2, 3}, arrow::default_memory_pool()));
+  EXPECT_EQ(33, selected_rb->NumBytes());
+
+  RowDescriptor string_rd({types::DataType::STRING});
+  ASSERT_OK_AND_ASSIGN(auto projected_rb, selected_rb->Project(string_rd, {1}));
+  EXPECT_TRUE(projected_rb->has_selection());
+  ASSERT_OK_AND_ASSIGN(auto sliced_rb, projected_rb->Slice(1, 2));
+  EXPECT_TRUE(sliced_rb->has_selection());
+  EXPECT_EQ(2, sliced_rb->num_rows());
+  EXPECT_FALSE(sliced_rb->is_materialized());
+  ASSERT_OK(sliced_rb->Materialize());
+  EXPECT_EQ("cc", types::GetValueFromArrowArray<types::DataType::STRING>(
+                      sliced_rb->ColumnAt(0).get(), 0));
+  EXPECT_EQ("ddd", types::GetValueFromArrowArray<types::DataType::STRING>(
+                       sliced_rb->ColumnAt(0).get(), 1));
+
+  // Materialized batches round trip through protos like regular ones.
+  ASSERT_OK(selected_rb->Materialize());
+  table_store::schemapb::RowBatchData pb;
+  ASSERT_OK(selected_rb->ToProto(&pb));
+  ASSERT_OK_AND_ASSIGN(auto from_proto_rb, RowBatch::FromProto(pb));
+  EXPECT_FALSE(from_proto_rb->has_selection());
+  EXPECT_EQ(from_proto_rb->DebugString(), selected_rb->DebugString());
+}
+
+TEST_F(RowBatchTest, selection_add_column_checks_input_rows) {
+  auto selection = std::make_shared<SelectionVector>(SelectionVector{1});
+  RowBatch rb(RowDescriptor({types::DataType::INT64}), selection, 3, arrow::default_memory_pool());
+  std::vector<types::Int64Value> ints = {1, 2};
+  EXPECT_NOT_OK(rb.AddColumn(types::ToArrow(ints, arrow::default_memory_pool())));
+  std::vector<types::Int64Value> ints2 = {1, 2, 3};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(ints2, arrow::default_memory_pool())));
+  EXPECT_EQ(1, rb.num_rows());
+  ASSERT_OK(rb.Materialize());
+  EXPECT_EQ(2, types::GetValueFromArrowArray<types::DataType::INT64>(rb.ColumnAt(0).get(), 0));
+}
+
 }  // namespace schema
 }  // namespace table_store
 }  // namespace px
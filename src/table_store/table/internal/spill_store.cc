@@ -0,0 +1,500 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/internal/spill_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <absl/strings/substitute.h>
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace table_store {
+namespace internal {
+
+namespace {
+
+// The file starts and ends with kMagic. The footer is followed by its offset in the file.
+constexpr std::string_view kMagic = "PXSPILL1";
+constexpr int64_t kBufferAlignment = 64;
+constexpr char kPadding[kBufferAlignment] = {};
+
+template <typename T>
+void Append(std::string* out, T val) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+class FooterDecoder {
+ public:
+  FooterDecoder(std::string_view buf, const std::filesystem::path& path) : buf_(buf), path_(path) {}
+
+  template <typename T>
+  StatusOr<T> Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (buf_.size() < sizeof(T)) {
+      return error::DataLoss("Truncated footer in spilled batch $0.", path_.string());
+    }
+    T val;
+    std::memcpy(&val, buf_.data(), sizeof(T));
+    buf_.remove_prefix(sizeof(T));
+    return val;
+  }
+
+ private:
+  std::string_view buf_;
+  const std::filesystem::path& path_;
+};
+
+// Writes a file sequentially, straight from the given buffers.
+class FileWriter : public NotCopyable {
+ public:
+  explicit FileWriter(const std::filesystem::path& path) : path_(path) {}
+  ~FileWriter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  Status Open() {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+      return error::Internal("Failed to create spilled batch $0: $1", path_.string(),
+                             std::strerror(errno));
+    }
+    return Status::OK();
+  }
+
+  Status Append(const void* data, int64_t size) {
+    const char* pos = static_cast<const char*>(data);
+    while (size > 0) {
+      ssize_t written = write(fd_, pos, size);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return error::Internal("Failed to write spilled batch $0: $1", path_.string(),
+                               std::strerror(errno));
+      }
+      pos += written;
+      size -= written;
+      offset_ += written;
+    }
+    return Status::OK();
+  }
+
+  // Pads the file with zeros up to the next multiple of kBufferAlignment.
+  Status Align() {
+    return Append(kPadding, (kBufferAlignment - offset_ % kBufferAlignment) % kBufferAlignment);
+  }
+
+  Status Close() {
+    int fd = fd_;
+    fd_ = -1;
+    if (close(fd) != 0) {
+      return error::Internal("Failed to write spilled batch $0: $1", path_.string(),
+                             std::strerror(errno));
+    }
+    return Status::OK();
+  }
+
+  int64_t offset() const { return offset_; }
+
+ private:
+  const std::filesystem::path& path_;
+  int fd_ = -1;
+  int64_t offset_ = 0;
+};
+
+// Writes the buffers of each column to the file as they are laid out in memory, and builds the
+// footer as it goes. Only the footer is staged in memory.
+Status WriteBatchFile(const std::filesystem::path& path, const ColdBatch& batch, int64_t* bytes) {
+  for (const auto& col : batch) {
+    if (!col->data()->child_data.empty()) {
+      return error::Unimplemented("Spilling arrays of type $0 is not supported.",
+                                  col->type()->ToString());
+    }
+  }
+
+  FileWriter file(path);
+  PX_RETURN_IF_ERROR(file.Open());
+  PX_RETURN_IF_ERROR(file.Append(kMagic.data(), kMagic.size()));
+  std::string footer;
+  Append<int32_t>(&footer, batch.size());
+  for (const auto& col : batch) {
+    const auto& data = col->data();
+    Append<int64_t>(&footer, col->length());
+    Append<int64_t>(&footer, col->offset());
+    Append<int64_t>(&footer, col->null_count());
+    Append<int32_t>(&footer, data->buffers.size());
+    for (const auto& buf : data->buffers) {
+      if (buf == nullptr) {
+        Append<int64_t>(&footer, -1);
+        Append<int64_t>(&footer, 0);
+        continue;
+      }
+      PX_RETURN_IF_ERROR(file.Align());
+      Append<int64_t>(&footer, file.offset());
+      Append<int64_t>(&footer, buf->size());
+      PX_RETURN_IF_ERROR(file.Append(buf->data(), buf->size()));
+    }
+  }
+  Append<int64_t>(&footer, file.offset());
+  footer.append(kMagic);
+  PX_RETURN_IF_ERROR(file.Append(footer.data(), footer.size()));
+  *bytes = file.offset();
+  return file.Close();
+}
+
+// A buffer over a read-only mapping of a whole file. The file is unmapped once the last array that
+// references the buffer is destroyed.
+class MappedFileBuffer : public arrow::Buffer {
+ public:
+  MappedFileBuffer(const uint8_t* data, int64_t size) : arrow::Buffer(data, size) {}
+  ~MappedFileBuffer() override { munmap(const_cast<uint8_t*>(data()), size()); }
+};
+
+}  // namespace
+
+StatusOr<std::shared_ptr<SpilledBatch>> SpilledBatch::Write(std::filesystem::path path,
+                                                            RowID first_row_id,
+                                                            const ColdBatch& batch,
+                                                            int64_t time_col_idx) {
+  DCHECK(!batch.empty());
+  int64_t bytes = 0;
+  auto s = WriteBatchFile(path, batch, &bytes);
+  if (!s.ok()) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return s;
+  }
+  return Create(std::move(path), first_row_id, batch, time_col_idx, bytes, {});
+}
+
+std::shared_ptr<SpilledBatch> SpilledBatch::Pending(RowID first_row_id, ColdBatch batch,
+                                                    int64_t time_col_idx) {
+  DCHECK(!batch.empty());
+  int64_t bytes = 0;
+  for (const auto& col : batch) {
+    for (const auto& buf : col->data()->buffers) {
+      if (buf != nullptr) {
+        bytes += buf->size();
+      }
+    }
+  }
+  return Create({}, first_row_id, batch, time_col_idx, bytes, batch);
+}
+
+StatusOr<std::shared_ptr<SpilledBatch>> SpilledBatch::WriteTo(std::filesystem::path path) const {
+  DCHECK(pending());
+  return Write(std::move(path), row_ids_.first, pending_batch_, time_col_idx_);
+}
+
+std::shared_ptr<SpilledBatch> SpilledBatch::Create(std::filesystem::path path, RowID first_row_id,
+                                                   const ColdBatch& batch, int64_t time_col_idx,
+                                                   int64_t bytes, ColdBatch pending_batch) {
+  std::vector<std::shared_ptr<arrow::DataType>> types;
+  for (const auto& col : batch) {
+    types.push_back(col->type());
+  }
+  RowIDInterval row_ids(first_row_id, first_row_id + batch[0]->length() - 1);
+  TimeInterval times(-1, -1);
+  if (time_col_idx != -1) {
+    const auto* time_col = batch[time_col_idx].get();
+    times.first = types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col, 0);
+    times.second =
+        types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col, time_col->length() - 1);
+  }
+  // Create naked pointer, because std::make_shared() cannot access the private ctor.
+  return std::shared_ptr<SpilledBatch>(new SpilledBatch(std::move(path), row_ids, times,
+                                                        time_col_idx, bytes, std::move(types),
+                                                        std::move(pending_batch)));
+}
+
+SpilledBatch::~SpilledBatch() {
+  if (pending()) {
+    return;
+  }
+  std::error_code ec;
+  std::filesystem::remove(path_, ec);
+  if (ec) {
+    LOG(WARNING) << absl::Substitute("Failed to remove spilled batch $0: $1", path_.string(),
+                                     ec.message());
+  }
+}
+
+StatusOr<ColdBatch> SpilledBatch::Read() const {
+  if (pending()) {
+    return pending_batch_;
+  }
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Failed to open spilled batch $0: $1", path_.string(),
+                           std::strerror(errno));
+  }
+  void* addr = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+  int mmap_errno = errno;
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Failed to map spilled batch $0: $1", path_.string(),
+                           std::strerror(mmap_errno));
+  }
+  auto file = std::make_shared<MappedFileBuffer>(static_cast<const uint8_t*>(addr), bytes_);
+
+  std::string_view contents(reinterpret_cast<const char*>(file->data()), file->size());
+  const int64_t footer_end = bytes_ - static_cast<int64_t>(kMagic.size() + sizeof(int64_t));
+  if (footer_end < static_cast<int64_t>(kMagic.size()) ||
+      contents.substr(0, kMagic.size()) != kMagic ||
+      contents.substr(bytes_ - kMagic.size()) != kMagic) {
+    return error::DataLoss("Spilled batch $0 is corrupted.", path_.string());
+  }
+  int64_t footer_offset;
+  std::memcpy(&footer_offset, contents.data() + footer_end, sizeof(int64_t));
+  if (footer_offset < static_cast<int64_t>(kMagic.size()) || footer_offset > footer_end) {
+    return error::DataLoss("Spilled batch $0 is corrupted.", path_.string());
+  }
+
+  FooterDecoder footer(contents.substr(footer_offset, footer_end - footer_offset), path_);
+  PX_ASSIGN_OR_RETURN(int32_t num_cols, footer.Read<int32_t>());
+  if (num_cols != static_cast<int32_t>(types_.size())) {
+    return error::DataLoss("Spilled batch $0 has $1 columns, expected $2.", path_.string(),
+                           num_cols, types_.size());
+  }
+
+  ColdBatch batch;
+  for (const auto& type : types_) {
+    PX_ASSIGN_OR_RETURN(int64_t length, footer.Read<int64_t>());
+    PX_ASSIGN_OR_RETURN(int64_t offset, footer.Read<int64_t>());
+    PX_ASSIGN_OR_RETURN(int64_t null_count, footer.Read<int64_t>());
+    PX_ASSIGN_OR_RETURN(int32_t num_buffers, footer.Read<int32_t>());
+    std::vector<std::shared_ptr<arrow::Buffer>> buffers;
+    for (int32_t i = 0; i < num_buffers; ++i) {
+      PX_ASSIGN_OR_RETURN(int64_t buf_offset, footer.Read<int64_t>());
+      PX_ASSIGN_OR_RETURN(int64_t buf_size, footer.Read<int64_t>());
+      if (buf_offset == -1) {
+        buffers.push_back(nullptr);
+        continue;
+      }
+      if (buf_offset < 0 || buf_size < 0 || buf_offset + buf_size > footer_offset) {
+        return error::DataLoss("Spilled batch $0 is corrupted.", path_.string());
+      }
+      buffers.push_back(arrow::SliceBuffer(file, buf_offset, buf_size));
+    }
+    batch.push_back(arrow::MakeArray(
+        arrow::ArrayData::Make(type, length, std::move(buffers), null_count, offset)));
+  }
+  return batch;
+}
+
+void SpilledBatch::Prefetch() const {
+  if (pending()) {
+    return;
+  }
+  int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, bytes_, POSIX_FADV_WILLNEED);
+  close(fd);
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> SpilledBatch::GetNextRowBatch(
+    const schema::Relation& rel, RowID* last_read_row_id, std::optional<RowID> stop_row_id,
+    const std::vector<int64_t>& cols) const {
+  auto start_row_id = *last_read_row_id + 1;
+  DCHECK_GE(start_row_id, row_ids_.first);
+  DCHECK_LE(start_row_id, row_ids_.second);
+  if (DCHECK_IS_ON() && stop_row_id.has_value()) {
+    DCHECK_LT(start_row_id, stop_row_id.value());
+  }
+
+  PX_ASSIGN_OR_RETURN(ColdBatch batch, Read());
+
+  size_t row_offset = start_row_id - row_ids_.first;
+  size_t batch_size = row_ids_.second - start_row_id + 1;
+  if (stop_row_id.has_value() && row_ids_.second >= stop_row_id.value()) {
+    // Reduce batch size if the batch extends past the given stop row.
+    batch_size -= (row_ids_.second - stop_row_id.value()) + 1;
+  }
+
+  std::vector<types::DataType> col_types;
+  for (int64_t col_idx : cols) {
+    DCHECK(static_cast<size_t>(col_idx) < rel.NumColumns());
+    col_types.push_back(rel.col_types()[col_idx]);
+  }
+  auto output_rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(col_types), batch_size);
+  for (auto col_idx : cols) {
+    PX_RETURN_IF_ERROR(output_rb->AddColumn(batch[col_idx]->Slice(row_offset, batch_size)));
+  }
+
+  *last_read_row_id = start_row_id + batch_size - 1;
+  return output_rb;
+}
+
+StatusOr<int64_t> SpilledBatch::FindTimeOffset(Time time, bool strict) const {
+  DCHECK_NE(time_col_idx_, -1);
+  PX_ASSIGN_OR_RETURN(ColdBatch batch, Read());
+  const auto* time_col = batch[time_col_idx_].get();
+  if (strict) {
+    return types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(time_col, time) + 1;
+  }
+  return types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(time_col, time);
+}
+
+int64_t SpillStore::PushBack(std::shared_ptr<SpilledBatch> batch) {
+  if (batch->pending()) {
+    pending_bytes_ += batch->bytes();
+    ++num_pending_;
+  } else {
+    DCHECK_EQ(num_pending_, 0U);
+    bytes_ += batch->bytes();
+  }
+  batches_.push_back(std::move(batch));
+  return Evict();
+}
+
+std::shared_ptr<SpilledBatch> SpillStore::NextPending() const {
+  if (num_pending_ == 0) {
+    return nullptr;
+  }
+  return batches_[batches_.size() - num_pending_];
+}
+
+int64_t SpillStore::FinishWrite(const std::shared_ptr<SpilledBatch>& pending,
+                                std::shared_ptr<SpilledBatch> written) {
+  if (num_pending_ == 0) {
+    return 0;
+  }
+  auto it = batches_.end() - num_pending_;
+  if (*it != pending) {
+    return 0;
+  }
+  pending_bytes_ -= pending->bytes();
+  --num_pending_;
+  if (written == nullptr) {
+    batches_.erase(it);
+    return 0;
+  }
+  bytes_ += written->bytes();
+  *it = std::move(written);
+  return Evict();
+}
+
+int64_t SpillStore::SetMaxBytes(int64_t max_bytes) {
+  max_bytes_ = max_bytes;
+  return Evict();
+}
+
+int64_t SpillStore::SetMaxPendingBytes(int64_t max_pending_bytes) {
+  max_pending_bytes_ = max_pending_bytes;
+  return Evict();
+}
+
+int64_t SpillStore::Evict() {
+  int64_t evicted = 0;
+  // The oldest pending batch directly follows the written batches. The newest pending batch is
+  // always kept, so that a batch larger than the limit can still be spilled.
+  while (pending_bytes_ > max_pending_bytes_ && num_pending_ > 1) {
+    auto it = batches_.end() - num_pending_;
+    pending_bytes_ -= (*it)->bytes();
+    --num_pending_;
+    batches_.erase(it);
+    ++evicted;
+  }
+  while (bytes_ > max_bytes_ && batches_.size() > num_pending_) {
+    bytes_ -= batches_.front()->bytes();
+    batches_.pop_front();
+    ++evicted;
+  }
+  return evicted;
+}
+
+std::shared_ptr<SpilledBatch> SpillStore::Find(RowID row_id) const {
+  auto it = std::lower_bound(
+      batches_.begin(), batches_.end(), row_id,
+      [](const std::shared_ptr<SpilledBatch>& b, RowID val) { return b->row_ids().second < val; });
+  if (it == batches_.end()) {
+    return nullptr;
+  }
+  return *it;
+}
+
+std::optional<RowID> SpillStore::FindRowIDFromTimeFirstGreaterThanOrEqual(Time time) const {
+  return FindRowIDFromTime(time, /* strict */ false);
+}
+
+std::optional<RowID> SpillStore::FindRowIDFromTimeFirstGreaterThan(Time time) const {
+  return FindRowIDFromTime(time, /* strict */ true);
+}
+
+std::optional<RowID> SpillStore::FindRowIDFromTime(Time time, bool strict) const {
+  if (time_col_idx_ == -1) {
+    return std::nullopt;
+  }
+  auto it = strict ? std::upper_bound(batches_.begin(), batches_.end(), time,
+                                      [](Time val, const std::shared_ptr<SpilledBatch>& b) {
+                                        return val < b->times().second;
+                                      })
+                   : std::lower_bound(batches_.begin(), batches_.end(), time,
+                                      [](const std::shared_ptr<SpilledBatch>& b, Time val) {
+                                        return b->times().second < val;
+                                      });
+  if (it == batches_.end()) {
+    return std::nullopt;
+  }
+  const auto& batch = *it;
+  auto offset = batch->FindTimeOffset(time, strict);
+  if (!offset.ok()) {
+    // Falling back to the start of the batch may include rows before the given time, but never
+    // skips any.
+    LOG(WARNING) << absl::Substitute("Failed to search spilled batch by time: $0", offset.msg());
+    return batch->row_ids().first;
+  }
+  return batch->row_ids().first + offset.ValueOrDie();
+}
+
+Time SpillStore::MinTime() const {
+  if (time_col_idx_ == -1 || batches_.empty()) {
+    return -1;
+  }
+  return batches_.front()->times().first;
+}
+
+Time SpillStore::MaxTime() const {
+  if (time_col_idx_ == -1 || batches_.empty()) {
+    return -1;
+  }
+  return batches_.back()->times().second;
+}
+
+}  // namespace internal
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/type.h>
+
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/table/internal/types.h"
+
+namespace px {
+namespace table_store {
+namespace internal {
+
+/**
+ * SpilledBatch is a cold batch that was expired from memory and is, or is about to be, written to a
+ * file on local disk. A pending batch still holds its columns in memory: expiring a batch only
+ * creates the pending batch, and the file is written later by WriteTo() off the ingest path.
+ *
+ * The file holds the arrow buffers of each column, 64-byte aligned, followed by a footer that
+ * describes which buffers make up each column. Reading the batch maps the file and wraps the mapped
+ * buffers in arrow arrays, so no data is copied and only the pages of the columns that are actually
+ * accessed are read from disk.
+ *
+ * The file is removed when the SpilledBatch is destroyed, ie. once it was evicted from the
+ * SpillStore and the last reader holding it is done.
+ */
+class SpilledBatch : public NotCopyable {
+ public:
+  /**
+   * Writes the batch to a new file at the given path.
+   * @param path the file to write the batch to.
+   * @param first_row_id the unique RowID of the first row of the batch.
+   * @param batch the columns of the batch. Nested arrow types are not supported.
+   * @param time_col_idx the index of the time column, or -1 if the table has none.
+   */
+  static StatusOr<std::shared_ptr<SpilledBatch>> Write(std::filesystem::path path,
+                                                       RowID first_row_id, const ColdBatch& batch,
+                                                       int64_t time_col_idx);
+
+  /**
+   * Creates a pending batch, which keeps the given columns in memory until it is written.
+   * The arguments are the same as for Write().
+   */
+  static std::shared_ptr<SpilledBatch> Pending(RowID first_row_id, ColdBatch batch,
+                                               int64_t time_col_idx);
+
+  /**
+   * Writes a pending batch to a new file at the given path. The pending batch is unchanged, so
+   * readers holding it can keep using it.
+   * @return the written batch.
+   */
+  StatusOr<std::shared_ptr<SpilledBatch>> WriteTo(std::filesystem::path path) const;
+
+  ~SpilledBatch();
+
+  /**
+   * Maps the file and returns the columns of the batch. Pending batches return their in-memory
+   * columns.
+   */
+  StatusOr<ColdBatch> Read() const;
+
+  /**
+   * Asks the kernel to start reading the file into the page cache, so that a later Read() doesn't
+   * block on disk. Used to prefetch the next batch of a sequential scan.
+   */
+  void Prefetch() const;
+
+  /**
+   * GetNextRowBatch has the same semantics as StoreWithRowTimeAccounting::GetNextRowBatch, for a
+   * store that only holds this batch. The row after last_read_row_id must be in this batch.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetNextRowBatch(
+      const schema::Relation& rel, RowID* last_read_row_id, std::optional<RowID> stop_row_id,
+      const std::vector<int64_t>& cols) const;
+
+  /**
+   * Returns the offset within the batch of the first row with time greater than or equal to (or
+   * strictly greater than, if `strict`) the given time. The batch must have a time column.
+   */
+  StatusOr<int64_t> FindTimeOffset(Time time, bool strict) const;
+
+  const RowIDInterval& row_ids() const { return row_ids_; }
+  const TimeInterval& times() const { return times_; }
+  // The size of the file in bytes, or of the in-memory buffers for a pending batch.
+  int64_t bytes() const { return bytes_; }
+  bool pending() const { return path_.empty(); }
+
+ private:
+  SpilledBatch(std::filesystem::path path, RowIDInterval row_ids, TimeInterval times,
+               int64_t time_col_idx, int64_t bytes,
+               std::vector<std::shared_ptr<arrow::DataType>> types, ColdBatch pending_batch)
+      : path_(std::move(path)),
+        row_ids_(row_ids),
+        times_(times),
+        time_col_idx_(time_col_idx),
+        bytes_(bytes),
+        types_(std::move(types)),
+        pending_batch_(std::move(pending_batch)) {}
+
+  static std::shared_ptr<SpilledBatch> Create(std::filesystem::path path, RowID first_row_id,
+                                              const ColdBatch& batch, int64_t time_col_idx,
+                                              int64_t bytes, ColdBatch pending_batch);
+
+  // Empty for a pending batch.
+  const std::filesystem::path path_;
+  const RowIDInterval row_ids_;
+  const TimeInterval times_;
+  const int64_t time_col_idx_;
+  const int64_t bytes_;
+  // The arrow type of each column, which is not stored in the file.
+  const std::vector<std::shared_ptr<arrow::DataType>> types_;
+  // The columns of a pending batch. Empty once the batch is written.
+  const ColdBatch pending_batch_;
+};
+
+/**
+ * SpillStore is the on-disk tier of a Table. It holds the batches that were expired from the cold
+ * store, oldest first, and evicts the oldest ones once the total size of their files exceeds
+ * max_bytes. Only the RowID and time index of each written batch is kept in memory.
+ *
+ * Expired batches are added as pending batches, which are written to disk in order by a background
+ * writer (see NextPending and FinishWrite). The pending batches always follow the written ones. If
+ * the writer falls behind and the pending batches hold more than max_pending_bytes of memory, the
+ * oldest pending batches are dropped, except for the newest one.
+ *
+ * SpillStore is not thread-safe, the Table synchronizes access to it. The batches it returns stay
+ * readable after they are evicted, until the caller drops them.
+ */
+class SpillStore : public NotCopyable {
+ public:
+  SpillStore(int64_t time_col_idx, int64_t max_bytes, int64_t max_pending_bytes)
+      : time_col_idx_(time_col_idx), max_bytes_(max_bytes), max_pending_bytes_(max_pending_bytes) {}
+
+  /**
+   * Adds a batch after the existing batches, and evicts the oldest batches until the store fits in
+   * its limits again. Written batches can only be added while there are no pending batches.
+   * @return the number of evicted batches.
+   */
+  int64_t PushBack(std::shared_ptr<SpilledBatch> batch);
+
+  /**
+   * Returns the oldest pending batch, or nullptr if all batches are written.
+   */
+  std::shared_ptr<SpilledBatch> NextPending() const;
+
+  /**
+   * Replaces a pending batch returned by NextPending with its written copy, or removes it if
+   * `written` is nullptr because writing it failed. Does nothing if the pending batch was dropped
+   * in the meantime.
+   * @return the number of evicted batches.
+   */
+  int64_t FinishWrite(const std::shared_ptr<SpilledBatch>& pending,
+                      std::shared_ptr<SpilledBatch> written);
+
+  /**
+   * Changes the limits of the store, evicting the oldest batches if it no longer fits.
+   * @return the number of evicted batches.
+   */
+  int64_t SetMaxBytes(int64_t max_bytes);
+  int64_t SetMaxPendingBytes(int64_t max_pending_bytes);
+
+  /**
+   * Returns the first batch whose last row has a RowID greater than or equal to the given RowID,
+   * ie. the batch holding that row or, if the row isn't in the store, the batch after it. Returns
+   * nullptr if there is no such batch.
+   */
+  std::shared_ptr<SpilledBatch> Find(RowID row_id) const;
+
+  /**
+   * Same as the methods of the same name on StoreWithRowTimeAccounting. These read the time column
+   * of a single batch from disk.
+   */
+  std::optional<RowID> FindRowIDFromTimeFirstGreaterThanOrEqual(Time time) const;
+  std::optional<RowID> FindRowIDFromTimeFirstGreaterThan(Time time) const;
+
+  // The number of batches, including pending ones.
+  size_t Size() const { return batches_.size(); }
+  // The size of the written batches on disk.
+  int64_t Bytes() const { return bytes_; }
+  int64_t MaxBytes() const { return max_bytes_; }
+  // The size of the pending batches in memory.
+  int64_t PendingBytes() const { return pending_bytes_; }
+
+  RowID FirstRowID() const {
+    DCHECK(!batches_.empty());
+    return batches_.front()->row_ids().first;
+  }
+  RowID LastRowID() const {
+    DCHECK(!batches_.empty());
+    return batches_.back()->row_ids().second;
+  }
+
+  /**
+   * Returns the time of the first (or last) row in the store, or -1 if the store is empty or there
+   * is no time column.
+   */
+  Time MinTime() const;
+  Time MaxTime() const;
+
+ private:
+  std::optional<RowID> FindRowIDFromTime(Time time, bool strict) const;
+  // Evicts written batches over max_bytes_ and pending batches over max_pending_bytes_.
+  int64_t Evict();
+
+  const int64_t time_col_idx_;
+  int64_t max_bytes_;
+  int64_t max_pending_bytes_;
+  int64_t bytes_ = 0;
+  int64_t pending_bytes_ = 0;
+  size_t num_pending_ = 0;
+  std::deque<std::shared_ptr<SpilledBatch>> batches_;
+};
+
+}  // namespace internal
+}  // namespace table_store
+}  // namespace px
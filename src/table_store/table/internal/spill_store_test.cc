@@ -0,0 +1,210 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/table_store/table/internal/spill_store.h"
+#include "src/table_store/table/internal/test_utils.h"
+
+namespace px {
+namespace table_store {
+namespace internal {
+
+class SpillStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rel_ = std::make_unique<schema::Relation>(
+        std::vector<types::DataType>{types::DataType::TIME64NS, types::DataType::BOOLEAN,
+                                     types::DataType::STRING},
+        std::vector<std::string>{"col0", "col1", "col2"});
+  }
+
+  ColdBatch MakeColdBatch(const std::vector<types::Time64NSValue>& times,
+                          const std::vector<types::BoolValue>& bools,
+                          const std::vector<types::StringValue>& strings) {
+    return {types::ToArrow(times, arrow::default_memory_pool()),
+            types::ToArrow(bools, arrow::default_memory_pool()),
+            types::ToArrow(strings, arrow::default_memory_pool())};
+  }
+
+  std::shared_ptr<SpilledBatch> Spill(RowID first_row_id, const ColdBatch& batch) {
+    auto path = temp_dir_.path() / std::to_string(next_file_id_++);
+    auto spilled_or_s = SpilledBatch::Write(path, first_row_id, batch, /* time_col_idx */ 0);
+    EXPECT_OK(spilled_or_s);
+    return spilled_or_s.ConsumeValueOrDie();
+  }
+
+  testing::TempDir temp_dir_;
+  int64_t next_file_id_ = 0;
+  std::unique_ptr<schema::Relation> rel_;
+};
+
+TEST_F(SpillStoreTest, WriteAndRead) {
+  auto batch = MakeColdBatch({1, 2, 3}, {true, false, true}, {"ab", "", "cdefg"});
+  auto spilled = Spill(10, batch);
+
+  EXPECT_EQ(RowIDInterval(10, 12), spilled->row_ids());
+  EXPECT_EQ(TimeInterval(1, 3), spilled->times());
+
+  ASSERT_OK_AND_ASSIGN(ColdBatch read, spilled->Read());
+  ASSERT_EQ(3, read.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    EXPECT_TRUE(read[i]->Equals(batch[i])) << i;
+  }
+}
+
+TEST_F(SpillStoreTest, FileRemovedWithBatch) {
+  auto spilled = Spill(0, MakeColdBatch({1}, {true}, {"a"}));
+  auto path = temp_dir_.path() / "0";
+  EXPECT_TRUE(std::filesystem::exists(path));
+
+  // Arrays that were read keep the file mapped after it is removed.
+  ASSERT_OK_AND_ASSIGN(ColdBatch read, spilled->Read());
+  spilled.reset();
+  EXPECT_FALSE(std::filesystem::exists(path));
+  EXPECT_EQ("a", types::GetValueFromArrowArray<types::DataType::STRING>(read[2].get(), 0));
+}
+
+TEST_F(SpillStoreTest, GetNextRowBatch) {
+  auto spilled = Spill(10, MakeColdBatch({1, 2, 3, 4}, {true, false, true, false},
+                                         {"a", "b", "c", "d"}));
+
+  RowID last_read_row_id = 10;
+  ASSERT_OK_AND_ASSIGN(auto rb, spilled->GetNextRowBatch(*rel_, &last_read_row_id,
+                                                         /* stop_row_id */ 13, {2, 0}));
+  EXPECT_EQ(12, last_read_row_id);
+  ASSERT_EQ(2, rb->num_columns());
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(std::vector<types::StringValue>{"b", "c"},
+                                                     arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(std::vector<types::Time64NSValue>{2, 3},
+                                                     arrow::default_memory_pool())));
+}
+
+TEST_F(SpillStoreTest, FindAndEvict) {
+  auto batch0 = Spill(0, MakeColdBatch({1, 1, 10, 11}, {true, false, true, false},
+                                       {"ab", "cd", "ef", "gh"}));
+  auto batch1 = Spill(4, MakeColdBatch({20, 20, 21}, {false, false, false}, {"", "", ""}));
+  // Rows 7 to 9 are missing, eg. because they failed to spill.
+  auto batch2 = Spill(10, MakeColdBatch({30}, {true}, {"i"}));
+
+  SpillStore store(/* time_col_idx */ 0, batch0->bytes() + batch1->bytes() + batch2->bytes(),
+                   /* max_pending_bytes */ 0);
+  EXPECT_EQ(0, store.PushBack(batch0));
+  EXPECT_EQ(0, store.PushBack(batch1));
+  EXPECT_EQ(0, store.PushBack(batch2));
+  EXPECT_EQ(3, store.Size());
+  EXPECT_EQ(0, store.FirstRowID());
+  EXPECT_EQ(10, store.LastRowID());
+  EXPECT_EQ(1, store.MinTime());
+  EXPECT_EQ(30, store.MaxTime());
+
+  EXPECT_EQ(batch0, store.Find(0));
+  EXPECT_EQ(batch1, store.Find(4));
+  EXPECT_EQ(batch1, store.Find(6));
+  EXPECT_EQ(batch2, store.Find(8));
+  EXPECT_EQ(nullptr, store.Find(11));
+
+  EXPECT_EQ(2, store.FindRowIDFromTimeFirstGreaterThanOrEqual(2));
+  EXPECT_EQ(2, store.FindRowIDFromTimeFirstGreaterThan(1));
+  EXPECT_EQ(6, store.FindRowIDFromTimeFirstGreaterThan(20));
+  EXPECT_EQ(10, store.FindRowIDFromTimeFirstGreaterThanOrEqual(22));
+  EXPECT_FALSE(store.FindRowIDFromTimeFirstGreaterThan(30).has_value());
+
+  // Going over the size limit evicts the oldest batches.
+  auto batch3 = Spill(11, MakeColdBatch({40}, {true}, {"j"}));
+  EXPECT_EQ(1, store.PushBack(batch3));
+  EXPECT_EQ(3, store.Size());
+  EXPECT_EQ(4, store.FirstRowID());
+  EXPECT_EQ(20, store.MinTime());
+
+  // Lowering the limit evicts more batches.
+  EXPECT_EQ(1, store.SetMaxBytes(batch2->bytes() + batch3->bytes()));
+  EXPECT_EQ(2, store.Size());
+  EXPECT_EQ(10, store.FirstRowID());
+}
+
+TEST_F(SpillStoreTest, PendingBatches) {
+  auto written0 = Spill(0, MakeColdBatch({1, 2}, {true, false}, {"a", "b"}));
+  auto pending1 = SpilledBatch::Pending(2, MakeColdBatch({3, 4}, {true, true}, {"c", "d"}),
+                                        /* time_col_idx */ 0);
+  auto pending2 =
+      SpilledBatch::Pending(4, MakeColdBatch({5}, {false}, {"e"}), /* time_col_idx */ 0);
+  EXPECT_TRUE(pending1->pending());
+  EXPECT_EQ(TimeInterval(3, 4), pending1->times());
+
+  SpillStore store(/* time_col_idx */ 0, /* max_bytes */ 1024 * 1024,
+                   pending1->bytes() + pending2->bytes());
+  EXPECT_EQ(0, store.PushBack(written0));
+  EXPECT_EQ(nullptr, store.NextPending());
+  EXPECT_EQ(0, store.PushBack(pending1));
+  EXPECT_EQ(0, store.PushBack(pending2));
+  EXPECT_EQ(3, store.Size());
+  EXPECT_EQ(written0->bytes(), store.Bytes());
+  EXPECT_EQ(pending1->bytes() + pending2->bytes(), store.PendingBytes());
+  EXPECT_EQ(5, store.MaxTime());
+
+  // Pending batches are readable before they are written.
+  EXPECT_EQ(pending1, store.Find(3));
+  EXPECT_EQ(3, store.FindRowIDFromTimeFirstGreaterThan(3));
+  RowID last_read_row_id = 1;
+  ASSERT_OK_AND_ASSIGN(auto rb, pending1->GetNextRowBatch(*rel_, &last_read_row_id,
+                                                          /* stop_row_id */ std::nullopt, {2}));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(std::vector<types::StringValue>{"c", "d"},
+                                                     arrow::default_memory_pool())));
+
+  // Pending batches are written oldest first, and replaced by their written copy.
+  ASSERT_EQ(pending1, store.NextPending());
+  ASSERT_OK_AND_ASSIGN(auto written1, pending1->WriteTo(temp_dir_.path() / "written1"));
+  EXPECT_FALSE(written1->pending());
+  EXPECT_EQ(0, store.FinishWrite(pending1, written1));
+  EXPECT_EQ(written1, store.Find(3));
+  EXPECT_EQ(written0->bytes() + written1->bytes(), store.Bytes());
+  EXPECT_EQ(pending2->bytes(), store.PendingBytes());
+  ASSERT_OK_AND_ASSIGN(ColdBatch read, written1->Read());
+  EXPECT_TRUE(read[2]->Equals(types::ToArrow(std::vector<types::StringValue>{"c", "d"},
+                                             arrow::default_memory_pool())));
+
+  // Over the pending limit the oldest pending batch is dropped, and finishing its write is a no-op.
+  // The newest pending batch is always kept.
+  ASSERT_EQ(pending2, store.NextPending());
+  auto pending3 = SpilledBatch::Pending(5, MakeColdBatch({6, 7, 8}, {false, false, false},
+                                                         {"f", "g", "h"}),
+                                        /* time_col_idx */ 0);
+  EXPECT_EQ(0, store.SetMaxPendingBytes(pending3->bytes()));
+  EXPECT_EQ(1, store.PushBack(pending3));
+  EXPECT_EQ(3, store.Size());
+  EXPECT_EQ(pending3, store.Find(4));
+  ASSERT_OK_AND_ASSIGN(auto written2, pending2->WriteTo(temp_dir_.path() / "written2"));
+  EXPECT_EQ(0, store.FinishWrite(pending2, written2));
+  EXPECT_EQ(pending3, store.NextPending());
+
+  // A failed write removes the pending batch.
+  EXPECT_EQ(0, store.FinishWrite(pending3, nullptr));
+  EXPECT_EQ(2, store.Size());
+  EXPECT_EQ(0, store.PendingBytes());
+  EXPECT_EQ(nullptr, store.NextPending());
+}
+
+}  // namespace internal
+}  // namespace table_store
+}  // namespace px
@@ -154,6 +154,17 @@ class StoreWithRowTimeAccounting {
     return batches_.front();
   }
 
+  /**
+   * at gets a reference to the i-th batch in the store. Since batches are stored in a deque, the
+   * reference stays valid when batches are added to the back of the store, and is only invalidated
+   * when this batch is removed.
+   * @return reference to the i-th batch in the store.
+   */
+  const TBatch& at(size_t i) const {
+    DCHECK_LT(i, batches_.size());
+    return batches_[i];
+  }
+
   /**
    * PopFront removes the first batch in the store, and returns an rvalue reference to it.
    * @return rvalue reference to the removed batch.
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/memory_governor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "src/common/metrics/metrics.h"
+
+namespace px {
+namespace table_store {
+
+MemoryGovernor::MemoryGovernor(const MemoryGovernorConfig& config)
+    : config_(config),
+      overcommit_gauge_(&prometheus::BuildGauge()
+                             .Name("table_store_overcommit_bytes")
+                             .Help("Bytes by which the governed tables' max sizes exceed the "
+                                   "table store budget, because of their minimum sizes")
+                             .Register(GetMetricsRegistry())
+                             .Add({})) {}
+
+void MemoryGovernor::AddTable(const std::string& table_name, std::shared_ptr<Table> table,
+                              std::chrono::nanoseconds min_retention) {
+  GovernedTable t;
+  t.name = table_name;
+  t.table = std::move(table);
+  t.min_retention = min_retention;
+  t.target_size = t.table->GetTableStats().max_table_size;
+  t.ingest_rate_gauge = &prometheus::BuildGauge()
+                             .Name("table_ingest_rate_bytes_per_sec")
+                             .Help("Smoothed rate at which data is written to the table")
+                             .Register(GetMetricsRegistry())
+                             .Add({{"name", table_name}});
+  t.expected_retention_gauge =
+      &prometheus::BuildGauge()
+           .Name("table_expected_retention_ns")
+           .Help("Retention window the table can hold at its current size and ingest rate")
+           .Register(GetMetricsRegistry())
+           .Add({{"name", table_name}});
+  tables_.push_back(std::move(t));
+  // Force a fresh sample, since the new table has no ingest history yet.
+  sampled_ = false;
+}
+
+std::vector<int64_t> MemoryGovernor::TargetSizes() const {
+  std::vector<int64_t> sizes;
+  sizes.reserve(tables_.size());
+  for (const auto& t : tables_) {
+    sizes.push_back(t.target_size);
+  }
+  return sizes;
+}
+
+std::vector<int64_t> MemoryGovernor::ComputeTargets(
+    std::chrono::steady_clock::time_point now) const {
+  const size_t n = tables_.size();
+  const double budget = static_cast<double>(config_.total_bytes);
+
+  std::vector<double> floors(n);
+  std::vector<double> reserved(n);
+  std::vector<double> weights(n);
+  double total_floor = 0;
+  double total_reserved = 0;
+  double total_weight = 0;
+  for (const auto& [i, t] : Enumerate(tables_)) {
+    double min_retention_sec = std::chrono::duration<double>(t.min_retention).count();
+    floors[i] = static_cast<double>(std::max(config_.min_table_bytes, t.max_batch_bytes));
+    reserved[i] = std::max(floors[i], t.ingest_rate_bytes_per_sec * min_retention_sec);
+    total_floor += floors[i];
+    total_reserved += reserved[i];
+
+    auto last_access = t.table->LastAccessTime();
+    bool recently_accessed = last_access.time_since_epoch().count() > 0 &&
+                             now - last_access <= config_.access_recency_window;
+    weights[i] =
+        t.ingest_rate_bytes_per_sec * (recently_accessed ? config_.recent_access_boost : 1.0);
+    total_weight += weights[i];
+  }
+
+  double spare = budget - total_reserved;
+  if (spare < 0) {
+    LOG_FIRST_N(WARNING, 1) << absl::Substitute(
+        "Table store budget ($0 bytes) cannot satisfy minimum retention of governed tables ($1 "
+        "bytes). Scaling down reservations.",
+        config_.total_bytes, static_cast<int64_t>(total_reserved));
+    // Only the part of each reservation above its floor is scaled down.
+    double scale = std::max(0.0, (budget - total_floor) / (total_reserved - total_floor));
+    for (size_t i = 0; i < n; ++i) {
+      reserved[i] = floors[i] + (reserved[i] - floors[i]) * scale;
+    }
+    spare = 0;
+  }
+
+  std::vector<int64_t> targets(n);
+  for (size_t i = 0; i < n; ++i) {
+    double share = total_weight > 0 ? spare * weights[i] / total_weight : spare / n;
+    targets[i] = static_cast<int64_t>(std::floor(reserved[i] + share));
+  }
+  return targets;
+}
+
+Status MemoryGovernor::Rebalance(std::chrono::steady_clock::time_point now) {
+  if (tables_.empty()) {
+    return Status::OK();
+  }
+
+  if (!sampled_) {
+    for (auto& t : tables_) {
+      t.last_bytes_added = t.table->GetTableStats().bytes_added;
+    }
+    last_sample_time_ = now;
+    sampled_ = true;
+    return Status::OK();
+  }
+
+  double elapsed_sec = std::chrono::duration<double>(now - last_sample_time_).count();
+  if (elapsed_sec <= 0) {
+    return Status::OK();
+  }
+  for (auto& t : tables_) {
+    auto stats = t.table->GetTableStats();
+    int64_t bytes_added = stats.bytes_added;
+    t.max_batch_bytes = stats.max_batch_bytes;
+    double rate = (bytes_added - t.last_bytes_added) / elapsed_sec;
+    t.ingest_rate_bytes_per_sec = config_.ingest_rate_alpha * rate +
+                                  (1 - config_.ingest_rate_alpha) * t.ingest_rate_bytes_per_sec;
+    t.last_bytes_added = bytes_added;
+  }
+  last_sample_time_ = now;
+
+  std::vector<int64_t> targets = ComputeTargets(now);
+  int64_t total_target = 0;
+  for (int64_t target : targets) {
+    total_target += target;
+  }
+  overcommit_bytes_ = std::max<int64_t>(0, total_target - config_.total_bytes);
+  overcommit_gauge_->Set(overcommit_bytes_);
+  if (overcommit_bytes_ > 0) {
+    LOG_EVERY_N(WARNING, 100) << absl::Substitute(
+        "Minimum sizes of governed tables exceed the table store budget ($0 bytes) by $1 bytes.",
+        config_.total_bytes, overcommit_bytes_);
+  }
+
+  // Apply shrinks before grows, so that the sum of all max sizes stays within the budget.
+  for (bool shrink : {true, false}) {
+    for (const auto& [i, t] : Enumerate(tables_)) {
+      int64_t current = t.table->GetTableStats().max_table_size;
+      int64_t target = targets[i];
+      if (shrink != (target < current)) {
+        continue;
+      }
+      if (std::abs(target - current) < config_.min_change_fraction * current) {
+        continue;
+      }
+      PX_RETURN_IF_ERROR(t.table->SetMaxTableSize(target));
+      if (config_.total_spill_bytes > 0) {
+        PX_RETURN_IF_ERROR(t.table->SetMaxSpillBytes(static_cast<int64_t>(
+            static_cast<double>(config_.total_spill_bytes) * target / config_.total_bytes)));
+      }
+    }
+  }
+
+  for (const auto& [i, t] : Enumerate(tables_)) {
+    t.target_size = targets[i];
+    t.ingest_rate_gauge->Set(t.ingest_rate_bytes_per_sec);
+    double expected_retention_ns = 0;
+    if (t.ingest_rate_bytes_per_sec > 0) {
+      expected_retention_ns = 1e9 * t.target_size / t.ingest_rate_bytes_per_sec;
+    }
+    t.expected_retention_gauge->Set(expected_retention_ns);
+  }
+  return Status::OK();
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <prometheus/gauge.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/table.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * MemoryGovernorConfig controls how the MemoryGovernor distributes its budget.
+ */
+struct MemoryGovernorConfig {
+  // Total number of bytes shared by all governed tables.
+  int64_t total_bytes = 0;
+  // No governed table is shrunk below this size, or below the largest batch written to it.
+  int64_t min_table_bytes = 4 * 1024 * 1024;
+  // Tables accessed by a query within this window get their share of the spare budget boosted.
+  std::chrono::nanoseconds access_recency_window = std::chrono::minutes(10);
+  // Multiplier applied to the ingest-rate weight of recently accessed tables.
+  double recent_access_boost = 2.0;
+  // Smoothing factor for the exponentially weighted ingest rate, in (0, 1].
+  double ingest_rate_alpha = 0.5;
+  // Size changes smaller than this fraction of the current size are skipped to avoid churn.
+  double min_change_fraction = 0.01;
+  // If non-zero, the governed tables spill to disk and share this many bytes of spilled data. Each
+  // table's spill limit is kept in proportion to its share of total_bytes.
+  int64_t total_spill_bytes = 0;
+};
+
+/**
+ * MemoryGovernor redistributes a fixed memory budget across a set of tables. Each call to
+ * Rebalance samples every table's ingest rate and last query access, and then:
+ *   1. Reserves for each table enough bytes to hold its configured minimum retention at the
+ *      current ingest rate (never less than min_table_bytes, nor than the largest batch written to
+ *      the table). If the reservations do not fit in the budget, the part of each reservation above
+ *      that floor is scaled down proportionally. The floors themselves are never scaled down, since
+ *      a table that can't hold a single batch rejects every write. If the floors alone exceed the
+ *      budget, the tables are overcommitted: the excess is logged and exported as the
+ *      table_store_overcommit_bytes gauge.
+ *   2. Splits the remaining budget proportionally to ingest rate, boosted for recently queried
+ *      tables.
+ * Tables that shrink are resized first, so that the sum of all max sizes never exceeds the budget
+ * (or the sum of the floors, when overcommitted).
+ * Shrinking a table expires its oldest batches through Table::ExpireBatch. If total_spill_bytes is
+ * set, the spill limit of each resized table is rescaled along with its max size.
+ *
+ * This class is not thread-safe; Rebalance should be called periodically from a single thread.
+ */
+class MemoryGovernor : public NotCopyable {
+ public:
+  explicit MemoryGovernor(const MemoryGovernorConfig& config);
+
+  /**
+   * Places the table under the control of the governor.
+   * @param table_name the name of the table, used for metrics.
+   * @param table the table to govern.
+   * @param min_retention the amount of data (in time) the governor tries to keep in the table.
+   */
+  void AddTable(const std::string& table_name, std::shared_ptr<Table> table,
+                std::chrono::nanoseconds min_retention);
+
+  /**
+   * Recomputes and applies the max size of every governed table.
+   * @param now the current time, used to compute ingest rates and access recency.
+   */
+  Status Rebalance(std::chrono::steady_clock::time_point now);
+  Status Rebalance() { return Rebalance(std::chrono::steady_clock::now()); }
+
+  /**
+   * Returns the max table size computed for each table on the last call to Rebalance, in the order
+   * the tables were added.
+   */
+  std::vector<int64_t> TargetSizes() const;
+
+  /**
+   * Returns how many bytes the targets of the last call to Rebalance exceed the budget by, which
+   * is only non-zero when the floors of the governed tables don't fit in the budget.
+   */
+  int64_t OvercommitBytes() const { return overcommit_bytes_; }
+
+ private:
+  struct GovernedTable {
+    std::string name;
+    std::shared_ptr<Table> table;
+    std::chrono::nanoseconds min_retention;
+    int64_t last_bytes_added = 0;
+    int64_t max_batch_bytes = 0;
+    double ingest_rate_bytes_per_sec = 0;
+    int64_t target_size = 0;
+    prometheus::Gauge* ingest_rate_gauge;
+    prometheus::Gauge* expected_retention_gauge;
+  };
+
+  std::vector<int64_t> ComputeTargets(std::chrono::steady_clock::time_point now) const;
+
+  const MemoryGovernorConfig config_;
+  std::vector<GovernedTable> tables_;
+  std::chrono::steady_clock::time_point last_sample_time_;
+  bool sampled_ = false;
+  int64_t overcommit_bytes_ = 0;
+  prometheus::Gauge* overcommit_gauge_;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/table/memory_governor.h"
+#include "src/table_store/table/table.h"
+
+namespace px {
+namespace table_store {
+
+using ::testing::ElementsAre;
+
+class MemoryGovernorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rel_ = schema::Relation({types::DataType::INT64}, {"col1"});
+    table_a_ = std::make_shared<Table>("table_a", rel_, 10000);
+    table_b_ = std::make_shared<Table>("table_b", rel_, 10000);
+  }
+
+  // Writes `num_batches` batches of 100 int64 values (800 bytes each) to the table.
+  void WriteBatches(Table* table, int num_batches) {
+    for (int i = 0; i < num_batches; ++i) {
+      auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+      auto col = std::make_shared<types::Int64ValueColumnWrapper>(100);
+      batch->push_back(col);
+      EXPECT_OK(table->TransferRecordBatch(std::move(batch)));
+    }
+  }
+
+  MemoryGovernorConfig Config(int64_t total_bytes) {
+    MemoryGovernorConfig config;
+    config.total_bytes = total_bytes;
+    config.min_table_bytes = 1000;
+    return config;
+  }
+
+  schema::Relation rel_;
+  std::shared_ptr<Table> table_a_;
+  std::shared_ptr<Table> table_b_;
+};
+
+TEST_F(MemoryGovernorTest, first_rebalance_only_samples) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  EXPECT_OK(governor.Rebalance(std::chrono::steady_clock::now()));
+  EXPECT_EQ(10000, table_a_->GetTableStats().max_table_size);
+  EXPECT_EQ(10000, table_b_->GetTableStats().max_table_size);
+}
+
+TEST_F(MemoryGovernorTest, budget_moves_to_active_table) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 10);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  EXPECT_THAT(governor.TargetSizes(), ElementsAre(19000, 1000));
+  EXPECT_EQ(19000, table_a_->GetTableStats().max_table_size);
+  EXPECT_EQ(1000, table_b_->GetTableStats().max_table_size);
+}
+
+TEST_F(MemoryGovernorTest, shrinking_expires_batches) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  // table_b holds data but stops ingesting, so its share should move to table_a.
+  WriteBatches(table_b_.get(), 10);
+  EXPECT_EQ(8000, table_b_->GetTableStats().bytes);
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 12);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  auto stats = table_b_->GetTableStats();
+  EXPECT_LE(stats.bytes, stats.max_table_size);
+  EXPECT_EQ(stats.max_table_size, 1000);
+  EXPECT_GT(stats.batches_expired, 0);
+}
+
+TEST_F(MemoryGovernorTest, min_retention_is_reserved) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(10));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 10);
+  WriteBatches(table_b_.get(), 1);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  // table_b ingests 400 B/s after smoothing, so 10s of retention needs 4000 bytes.
+  auto targets = governor.TargetSizes();
+  EXPECT_GE(targets[1], 4000);
+  EXPECT_LE(targets[0] + targets[1], 20000);
+}
+
+TEST_F(MemoryGovernorTest, tables_fit_their_largest_batch) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 10);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+  EXPECT_EQ(1000, table_b_->GetTableStats().max_table_size);
+
+  // A 1600 byte batch doesn't fit in table_b's floor, so it's rejected, but the next rebalance
+  // grows table_b to fit it.
+  auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  batch->push_back(std::make_shared<types::Int64ValueColumnWrapper>(200));
+  EXPECT_NOT_OK(table_b_->TransferRecordBatch(std::move(batch)));
+  EXPECT_EQ(1600, table_b_->GetTableStats().max_batch_bytes);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(2)));
+
+  auto targets = governor.TargetSizes();
+  EXPECT_GE(targets[1], 1600);
+  EXPECT_LE(targets[0] + targets[1], 20000);
+  batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  batch->push_back(std::make_shared<types::Int64ValueColumnWrapper>(200));
+  EXPECT_OK(table_b_->TransferRecordBatch(std::move(batch)));
+}
+
+TEST_F(MemoryGovernorTest, floors_over_budget_are_overcommitted) {
+  MemoryGovernor governor(Config(2000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  batch->push_back(std::make_shared<types::Int64ValueColumnWrapper>(200));
+  EXPECT_OK(table_b_->TransferRecordBatch(std::move(batch)));
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  // The floors (1000 for table_a, 1600 for table_b's largest batch) don't fit in the budget, so
+  // both tables are kept at their floor and the excess is reported.
+  EXPECT_THAT(governor.TargetSizes(), ElementsAre(1000, 1600));
+  EXPECT_EQ(600, governor.OvercommitBytes());
+  EXPECT_EQ(1600, table_b_->GetTableStats().bytes);
+}
+
+TEST_F(MemoryGovernorTest, spill_limits_follow_max_sizes) {
+  testing::TempDir tmp_dir;
+  ASSERT_OK(table_a_->EnableDiskSpill(tmp_dir.path() / "table_a", 100000));
+  ASSERT_OK(table_b_->EnableDiskSpill(tmp_dir.path() / "table_b", 100000));
+  auto config = Config(20000);
+  config.total_spill_bytes = 200000;
+  MemoryGovernor governor(config);
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 10);
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  EXPECT_THAT(governor.TargetSizes(), ElementsAre(19000, 1000));
+  EXPECT_EQ(190000, table_a_->GetTableStats().max_spill_bytes);
+  EXPECT_EQ(10000, table_b_->GetTableStats().max_spill_bytes);
+}
+
+TEST_F(MemoryGovernorTest, recently_accessed_table_gets_larger_share) {
+  MemoryGovernor governor(Config(20000));
+  governor.AddTable("table_a", table_a_, std::chrono::seconds(0));
+  governor.AddTable("table_b", table_b_, std::chrono::seconds(0));
+
+  auto now = std::chrono::steady_clock::now();
+  EXPECT_OK(governor.Rebalance(now));
+  WriteBatches(table_a_.get(), 5);
+  WriteBatches(table_b_.get(), 5);
+  Table::Cursor cursor(table_b_.get());
+  EXPECT_OK(governor.Rebalance(now + std::chrono::seconds(1)));
+
+  auto targets = governor.TargetSizes();
+  EXPECT_GT(targets[1], targets[0]);
+}
+
+}  // namespace table_store
+}  // namespace px
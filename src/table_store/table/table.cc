@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <filesystem>
 #include <iterator>
 #include <memory>
 #include <optional>
@@ -26,10 +27,12 @@
 #include <variant>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 #include "internal/store_with_row_accounting.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
+#include "src/common/fs/fs_wrapper.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/relation.h"
@@ -50,6 +53,7 @@ namespace table_store {
 
 Table::Cursor::Cursor(const Table* table, StartSpec start, StopSpec stop)
     : table_(table), hints_(internal::BatchHints{}) {
+  table_->RecordAccess();
   AdvanceToStart(start);
   StopStateFromSpec(std::move(stop));
 }
@@ -212,6 +216,38 @@ Status Table::ToProto(table_store::schemapb::Table* table_proto) const {
 StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetNextRowBatch(
     Cursor* cursor, const std::vector<int64_t>& cols) const {
   DCHECK(!cursor->Done()) << "Calling GetNextRowBatch on an exhausted Cursor";
+  std::shared_ptr<internal::SpilledBatch> spilled;
+  std::shared_ptr<internal::SpilledBatch> next_spilled;
+  {
+    absl::ReaderMutexLock spill_lock(&spill_lock_);
+    if (spill_store_ != nullptr) {
+      spilled = spill_store_->Find(*cursor->LastReadRowID() + 1);
+    }
+    if (spilled == nullptr) {
+      return GetNextInMemoryRowBatch(cursor, cols);
+    }
+    if (spilled->row_ids().first > *cursor->LastReadRowID() + 1) {
+      // The rows after the cursor were evicted from disk (or dropped before they were spilled), so
+      // continue from the next row that is still in the table.
+      *cursor->LastReadRowID() = spilled->row_ids().first - 1;
+      // Cursor::Done() can call back into the table, so check the stop row directly.
+      auto stop_row_id = cursor->StopRowID();
+      if (stop_row_id.has_value() && spilled->row_ids().first >= stop_row_id.value()) {
+        return error::InvalidArgument("Data after Cursor is not in the table.");
+      }
+    }
+    next_spilled = spill_store_->Find(spilled->row_ids().second + 1);
+  }
+  // Scans read the table sequentially, so start reading the next spilled batch from disk while
+  // this one is being processed.
+  if (next_spilled != nullptr) {
+    next_spilled->Prefetch();
+  }
+  return spilled->GetNextRowBatch(rel_, cursor->LastReadRowID(), cursor->StopRowID(), cols);
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetNextInMemoryRowBatch(
+    Cursor* cursor, const std::vector<int64_t>& cols) const {
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   PX_ASSIGN_OR_RETURN(auto rb,
                       cold_store_->GetNextRowBatch(cursor->LastReadRowID(), cursor->Hints(),
@@ -238,16 +274,23 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetNextRowBatch(
 }
 
 Status Table::ExpireRowBatches(int64_t row_batch_size) {
-  if (row_batch_size > max_table_size_) {
+  // Recorded before the size check, so that a governor can grow the table to fit the batch.
+  int64_t max_batch_bytes = max_batch_bytes_.load();
+  while (row_batch_size > max_batch_bytes &&
+         !max_batch_bytes_.compare_exchange_weak(max_batch_bytes, row_batch_size)) {
+  }
+  int64_t max_table_size = max_table_size_.load();
+  if (row_batch_size > max_table_size) {
     return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
-                                  row_batch_size, max_table_size_);
+                                  row_batch_size, max_table_size);
   }
+  absl::MutexLock expire_lock(&expire_lock_);
   int64_t bytes;
   {
     absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
     bytes = batch_size_accountant_->HotBytes() + batch_size_accountant_->ColdBytes();
   }
-  while (bytes + row_batch_size > max_table_size_) {
+  while (bytes + row_batch_size > max_table_size) {
     PX_RETURN_IF_ERROR(ExpireBatch());
     {
       absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
@@ -322,6 +365,10 @@ Status Table::WriteHot(internal::RecordOrRowBatch&& record_or_row_batch) {
 }
 
 Table::RowID Table::FirstRowID() const {
+  absl::ReaderMutexLock spill_lock(&spill_lock_);
+  if (spill_store_ != nullptr && spill_store_->Size() > 0) {
+    return spill_store_->FirstRowID();
+  }
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   if (cold_store_->Size() > 0) {
     return cold_store_->FirstRowID();
@@ -334,6 +381,7 @@ Table::RowID Table::FirstRowID() const {
 }
 
 Table::RowID Table::LastRowID() const {
+  absl::ReaderMutexLock spill_lock(&spill_lock_);
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
   if (hot_store_->Size() > 0) {
@@ -342,10 +390,14 @@ Table::RowID Table::LastRowID() const {
   if (cold_store_->Size() > 0) {
     return cold_store_->LastRowID();
   }
+  if (spill_store_ != nullptr && spill_store_->Size() > 0) {
+    return spill_store_->LastRowID();
+  }
   return -1;
 }
 
 Table::Time Table::MaxTime() const {
+  absl::ReaderMutexLock spill_lock(&spill_lock_);
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
   if (hot_store_->Size() > 0) {
@@ -354,10 +406,20 @@ Table::Time Table::MaxTime() const {
   if (cold_store_->Size() > 0) {
     return cold_store_->MaxTime();
   }
+  if (spill_store_ != nullptr) {
+    return spill_store_->MaxTime();
+  }
   return -1;
 }
 
 Table::RowID Table::FindRowIDFromTimeFirstGreaterThanOrEqual(Time time) const {
+  absl::ReaderMutexLock spill_lock(&spill_lock_);
+  if (spill_store_ != nullptr) {
+    auto optional_row_id = spill_store_->FindRowIDFromTimeFirstGreaterThanOrEqual(time);
+    if (optional_row_id.has_value()) {
+      return optional_row_id.value();
+    }
+  }
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   auto optional_row_id = cold_store_->FindRowIDFromTimeFirstGreaterThanOrEqual(time);
   if (optional_row_id.has_value()) {
@@ -372,6 +434,13 @@ Table::RowID Table::FindRowIDFromTimeFirstGreaterThanOrEqual(Time time) const {
 }
 
 Table::RowID Table::FindRowIDFromTimeFirstGreaterThan(Time time) const {
+  absl::ReaderMutexLock spill_lock(&spill_lock_);
+  if (spill_store_ != nullptr) {
+    auto optional_row_id = spill_store_->FindRowIDFromTimeFirstGreaterThan(time);
+    if (optional_row_id.has_value()) {
+      return optional_row_id.value();
+    }
+  }
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   auto optional_row_id = cold_store_->FindRowIDFromTimeFirstGreaterThan(time);
   if (optional_row_id.has_value()) {
@@ -393,9 +462,23 @@ TableStats Table::GetTableStats() const {
   int64_t num_batches = 0;
   int64_t hot_bytes = 0;
   int64_t cold_bytes = 0;
+  int64_t spilled_bytes = 0;
+  int64_t max_spill_bytes = 0;
+  int64_t pending_spill_bytes = 0;
+  int64_t num_spilled_batches = 0;
   {
+    absl::ReaderMutexLock spill_lock(&spill_lock_);
+    if (spill_store_ != nullptr) {
+      min_time = spill_store_->MinTime();
+      spilled_bytes = spill_store_->Bytes();
+      max_spill_bytes = spill_store_->MaxBytes();
+      pending_spill_bytes = spill_store_->PendingBytes();
+      num_spilled_batches = spill_store_->Size();
+    }
     absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
-    min_time = cold_store_->MinTime();
+    if (min_time == -1) {
+      min_time = cold_store_->MinTime();
+    }
     num_batches += cold_store_->Size();
     absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
     num_batches += hot_store_->Size();
@@ -416,71 +499,120 @@ TableStats Table::GetTableStats() const {
   info.cold_bytes = cold_bytes;
   info.compacted_batches = compacted_batches_;
   info.max_table_size = max_table_size_;
+  info.max_batch_bytes = max_batch_bytes_;
   info.min_time = min_time;
+  info.spilled_bytes = spilled_bytes;
+  info.max_spill_bytes = max_spill_bytes;
+  info.pending_spill_bytes = pending_spill_bytes;
+  info.num_spilled_batches = num_spilled_batches;
 
   return info;
 }
 
-Status Table::CompactSingleBatchUnlocked(arrow::MemoryPool*) {
-  const auto& compaction_spec = batch_size_accountant_->GetNextCompactedBatchSpec();
-
-  PX_RETURN_IF_ERROR(
-      compactor_.Reserve(compaction_spec.num_rows, compaction_spec.variable_col_bytes));
+StatusOr<bool> Table::CompactSingleBatch(arrow::MemoryPool*) {
+  absl::MutexLock compaction_lock(&compaction_lock_);
 
+  internal::BatchSizeAccountant::CompactedBatchSpec compaction_spec;
+  std::vector<const internal::RecordOrRowBatch*> hot_batches;
   RowID first_row_id = -1;
-  for (auto hot_slice : compaction_spec.hot_slices) {
-    if (first_row_id == -1) {
-      first_row_id = hot_store_->FirstRowID() + hot_slice.start_row;
+  auto lock_start = std::chrono::steady_clock::now();
+  {
+    absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
+    // We have to check CompactedBatchReady() under the lock, in case hot batches were expired
+    // since the last check.
+    if (!batch_size_accountant_->CompactedBatchReady()) {
+      return false;
     }
-
-    compactor_.UnsafeAppendBatchSlice(hot_store_->front(), hot_slice.start_row, hot_slice.end_row);
-    if (hot_slice.last_slice_for_batch) {
-      hot_store_->PopFront();
+    compaction_spec = batch_size_accountant_->GetNextCompactedBatchSpec();
+    first_row_id = hot_store_->FirstRowID() + compaction_spec.hot_slices.front().start_row;
+    // Each slice of the spec corresponds to consecutive hot batches starting at the front. Hot
+    // batches are only removed from the front by compaction or expiration, both of which are
+    // excluded by compaction_lock_, so these references stay valid after hot_lock_ is released.
+    for (size_t i = 0; i < compaction_spec.hot_slices.size(); ++i) {
+      hot_batches.push_back(&hot_store_->at(i));
     }
   }
+  auto lock_hold = std::chrono::steady_clock::now() - lock_start;
 
+  // Build the compacted batch without holding the hot or cold locks.
+  PX_RETURN_IF_ERROR(
+      compactor_.Reserve(compaction_spec.num_rows, compaction_spec.variable_col_bytes));
+  for (const auto& [i, hot_slice] : Enumerate(compaction_spec.hot_slices)) {
+    if (compaction_cancelled_.load()) {
+      // Finish resets the builders. The hot batches are left as they are, and whatever is left of
+      // them after expiration is compacted on a later call.
+      PX_RETURN_IF_ERROR(compactor_.Finish().status());
+      return false;
+    }
+    compactor_.UnsafeAppendBatchSlice(*hot_batches[i], hot_slice.start_row, hot_slice.end_row);
+  }
   PX_ASSIGN_OR_RETURN(std::vector<ArrowArrayPtr> out_columns, compactor_.Finish());
 
-  cold_store_->EmplaceBack(first_row_id, out_columns);
+  // Atomically swap the compacted batch in for the hot slices it was built from.
+  lock_start = std::chrono::steady_clock::now();
+  {
+    absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
+    absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
+    for (const auto& hot_slice : compaction_spec.hot_slices) {
+      if (hot_slice.last_slice_for_batch) {
+        hot_store_->PopFront();
+      }
+    }
+    cold_store_->EmplaceBack(first_row_id, std::move(out_columns));
 
-  auto num_rows_to_remove = batch_size_accountant_->FinishCompactedBatch();
-  if (num_rows_to_remove > 0) {
-    hot_store_->RemovePrefix(num_rows_to_remove);
+    auto num_rows_to_remove = batch_size_accountant_->FinishCompactedBatch();
+    if (num_rows_to_remove > 0) {
+      hot_store_->RemovePrefix(num_rows_to_remove);
+    }
   }
+  lock_hold += std::chrono::steady_clock::now() - lock_start;
+  metrics_.compaction_lock_hold_histogram.Observe(
+      std::chrono::duration<double>(lock_hold).count());
 
   {
     absl::base_internal::SpinLockHolder stat_lock(&stats_lock_);
     compacted_batches_++;
     metrics_.compacted_batches_counter.Increment();
   }
-  return Status::OK();
+  return true;
 }
 
-Status Table::CompactHotToCold(arrow::MemoryPool* mem_pool) {
+Status Table::CompactHotToCold(arrow::MemoryPool* mem_pool,
+                               std::chrono::steady_clock::time_point deadline) {
   bool next_ready = false;
   {
     absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
     next_ready = batch_size_accountant_->CompactedBatchReady();
   }
-  while (next_ready) {
-    absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
-    absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
-    // We have to check CompactedBatchReady() again, in case hot batches were expired since the last
-    // check.
-    if (!batch_size_accountant_->CompactedBatchReady()) {
+  if (!next_ready) {
+    return Status::OK();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < kMaxBatchesPerCompactionCall; ++i) {
+    PX_ASSIGN_OR_RETURN(bool compacted, CompactSingleBatch(mem_pool));
+    if (!compacted || std::chrono::steady_clock::now() >= deadline) {
       break;
     }
-    PX_RETURN_IF_ERROR(CompactSingleBatchUnlocked(mem_pool));
-    next_ready = batch_size_accountant_->CompactedBatchReady();
   }
+  metrics_.compaction_latency_histogram.Observe(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
   return Status::OK();
 }
 
 StatusOr<bool> Table::ExpireCold() {
+  // Queueing the batch for spilling doesn't touch the disk, so that writers that expire data never
+  // wait on file I/O. Readers find the queued batch in the spill store once it leaves the cold
+  // store, since both happen under spill_lock_.
+  absl::MutexLock spill_lock(&spill_lock_);
   absl::base_internal::SpinLockHolder cold_lock(&cold_lock_);
   if (cold_store_->Size() == 0) {
     return false;
   }
+  if (spill_store_ != nullptr) {
+    spill_store_->PushBack(internal::SpilledBatch::Pending(cold_store_->FirstRowID(),
+                                                           cold_store_->at(0), time_col_idx_));
+  }
   cold_store_->PopFront();
   absl::base_internal::SpinLockHolder hot_lock(&hot_lock_);
   batch_size_accountant_->ExpireColdBatch();
@@ -503,10 +635,95 @@ Status Table::ExpireBatch() {
     return Status::OK();
   }
   // If we get to this point then there were no cold batches to expire, so we try to expire a hot
-  // batch.
+  // batch. An in-progress compaction may be reading the front hot batches, so cancel it and wait
+  // for it to stop, which takes at most one slice. A compaction that finished in the meantime
+  // moved data to the cold store, so check the cold store again first.
+  compaction_cancelled_ = true;
+  absl::MutexLock compaction_lock(&compaction_lock_);
+  compaction_cancelled_ = false;
+  PX_ASSIGN_OR_RETURN(expired_cold, ExpireCold());
+  if (expired_cold) {
+    return Status::OK();
+  }
   return ExpireHot();
 }
 
+Status Table::SetMaxTableSize(int64_t max_table_size) {
+  max_table_size_ = max_table_size;
+  // Expiring with a zero-sized incoming batch shrinks the table down to the new limit.
+  PX_RETURN_IF_ERROR(ExpireRowBatches(0));
+  {
+    absl::MutexLock spill_lock(&spill_lock_);
+    if (spill_store_ != nullptr) {
+      spill_store_->SetMaxPendingBytes(max_table_size / kMaxPendingSpillFraction);
+    }
+  }
+  return UpdateTableMetricGauges();
+}
+
+Status Table::EnableDiskSpill(const std::filesystem::path& dir, int64_t max_bytes) {
+  if (fs::Exists(dir)) {
+    PX_RETURN_IF_ERROR(fs::RemoveAll(dir));
+  }
+  PX_RETURN_IF_ERROR(fs::CreateDirectories(dir));
+
+  absl::MutexLock expire_lock(&expire_lock_);
+  absl::MutexLock spill_write_lock(&spill_write_lock_);
+  absl::MutexLock spill_lock(&spill_lock_);
+  spill_dir_ = dir;
+  spill_store_ = std::make_unique<internal::SpillStore>(
+      time_col_idx_, max_bytes, max_table_size_.load() / kMaxPendingSpillFraction);
+  return Status::OK();
+}
+
+Status Table::SetMaxSpillBytes(int64_t max_bytes) {
+  {
+    absl::MutexLock spill_lock(&spill_lock_);
+    if (spill_store_ == nullptr) {
+      return error::FailedPrecondition("Disk spilling is not enabled for this table.");
+    }
+    spill_store_->SetMaxBytes(max_bytes);
+  }
+  return UpdateTableMetricGauges();
+}
+
+Status Table::WriteSpilledBatches(std::chrono::steady_clock::time_point deadline) {
+  absl::MutexLock spill_write_lock(&spill_write_lock_);
+  if (spill_dir_.empty()) {
+    return Status::OK();
+  }
+  while (std::chrono::steady_clock::now() < deadline) {
+    std::shared_ptr<internal::SpilledBatch> pending;
+    {
+      absl::ReaderMutexLock spill_lock(&spill_lock_);
+      pending = spill_store_->NextPending();
+    }
+    if (pending == nullptr) {
+      break;
+    }
+    // The file is written without holding spill_lock_. Readers keep reading the queued batch from
+    // memory until it is swapped for the written one.
+    auto written = pending->WriteTo(spill_dir_ / absl::StrCat(next_spill_file_id_++, ".batch"));
+    if (!written.ok()) {
+      LOG(WARNING) << absl::Substitute("Failed to spill a cold batch to $0, dropping it: $1",
+                                       spill_dir_.string(), written.msg());
+    }
+    absl::MutexLock spill_lock(&spill_lock_);
+    spill_store_->FinishWrite(pending, written.ok() ? written.ConsumeValueOrDie() : nullptr);
+  }
+  return UpdateTableMetricGauges();
+}
+
+void Table::RecordAccess() const {
+  last_access_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+}
+
+std::chrono::steady_clock::time_point Table::LastAccessTime() const {
+  return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(last_access_ns_.load()));
+}
+
 Status Table::UpdateTableMetricGauges() {
   // Update table-level gauge values.
   auto stats = GetTableStats();
@@ -515,6 +732,7 @@ Status Table::UpdateTableMetricGauges() {
   metrics_.hot_bytes_gauge.Set(stats.hot_bytes);
   metrics_.num_batches_gauge.Set(stats.num_batches);
   metrics_.max_table_size_gauge.Set(stats.max_table_size);
+  metrics_.spilled_bytes_gauge.Set(stats.spilled_bytes);
   // Compute retention gauge
   int64_t current_retention_ns = 0;
   // If min_time is 0, there is no data in the table.
@@ -22,7 +22,10 @@
 #include <arrow/array.h>
 #include <arrow/record_batch.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
@@ -44,6 +47,7 @@
 #include "src/table_store/table/internal/arrow_array_compactor.h"
 #include "src/table_store/table/internal/batch_size_accountant.h"
 #include "src/table_store/table/internal/record_or_row_batch.h"
+#include "src/table_store/table/internal/spill_store.h"
 #include "src/table_store/table/internal/store_with_row_accounting.h"
 #include "src/table_store/table/internal/types.h"
 #include "src/table_store/table/table_metrics.h"
@@ -65,7 +69,14 @@ struct TableStats {
   int64_t bytes_added;
   int64_t compacted_batches;
   int64_t max_table_size;
+  // The largest batch written to the table, including batches rejected for exceeding
+  // max_table_size.
+  int64_t max_batch_bytes;
   int64_t min_time;
+  int64_t spilled_bytes;
+  int64_t max_spill_bytes;
+  int64_t pending_spill_bytes;
+  int64_t num_spilled_batches;
 };
 
 /**
@@ -80,6 +91,14 @@ struct TableStats {
  * Synchronization Scheme:
  * The hot and cold partitions are synchronized separately with spinlocks.
  *
+ * Disk Spilling:
+ * If EnableDiskSpill was called, cold batches that are expired to make room for new data are
+ * written to a local directory instead of being dropped, and are only discarded once the spilled
+ * data exceeds its own byte limit (see `internal::SpillStore`). Expiring a batch only queues it for
+ * spilling; the file is written by WriteSpilledBatches, which should be called periodically off the
+ * ingest path, like the compaction routine. Cursors read spilled and queued batches transparently,
+ * before the cold and hot partitions.
+ *
  * Compaction Scheme:
  * Hot batches are compacted into batches of size roughly `compacted_batch_size_` +/- the size of a
  * single row.  The compaction routine should be called periodically but that is not the
@@ -115,6 +134,9 @@ class Table : public NotCopyable {
 
  public:
   static inline constexpr int64_t kMaxBatchesPerCompactionCall = 256;
+  // Batches queued for spilling may use at most max_table_size / kMaxPendingSpillFraction bytes of
+  // memory. If WriteSpilledBatches falls further behind, the oldest queued batches are dropped.
+  static inline constexpr int64_t kMaxPendingSpillFraction = 4;
   using StopPosition = int64_t;
   static inline std::shared_ptr<Table> Create(std::string_view table_name,
                                               const schema::Relation& relation) {
@@ -297,9 +319,53 @@ class Table : public NotCopyable {
   /**
    * Compacts hot batches into compacted_batch_size_ sized cold batches. Each call to
    * CompactHotToCold will create a maximum of kMaxBatchesPerCompactionCall cold batches.
+   * The cold batches are built without holding the hot or cold locks, and are then swapped into
+   * the cold store, so writers and readers are only blocked for the duration of the swap.
    * @param mem_pool arrow MemoryPool to be used for creating new cold batches.
+   * @param deadline compaction stops (leaving the remaining hot batches for the next call) once
+   * this time is reached.
+   */
+  Status CompactHotToCold(arrow::MemoryPool* mem_pool,
+                          std::chrono::steady_clock::time_point deadline);
+  Status CompactHotToCold(arrow::MemoryPool* mem_pool) {
+    return CompactHotToCold(mem_pool, std::chrono::steady_clock::time_point::max());
+  }
+
+  /**
+   * Changes the maximum number of bytes the table can hold. If the table currently holds more than
+   * the new limit, the oldest batches are expired until the table fits.
+   * @param max_table_size the new maximum size of the table in bytes.
+   */
+  Status SetMaxTableSize(int64_t max_table_size);
+
+  /**
+   * Returns the last time a Cursor was created on this table, i.e. the last time a query accessed
+   * it. Returns the epoch of steady_clock if the table has never been read.
+   */
+  std::chrono::steady_clock::time_point LastAccessTime() const;
+
+  /**
+   * Enables spilling of expired cold batches to disk. Any existing contents of the directory are
+   * removed, since spilled batches are only readable by the table that wrote them.
+   * @param dir the directory to write the spilled batches to. Must not be shared with other tables.
+   * @param max_bytes the maximum number of bytes of spilled batches to keep on disk.
+   */
+  Status EnableDiskSpill(const std::filesystem::path& dir, int64_t max_bytes);
+
+  /**
+   * Changes the maximum number of bytes of spilled batches to keep on disk, removing the oldest
+   * spilled batches if the table is over the new limit. Spilling must be enabled.
+   */
+  Status SetMaxSpillBytes(int64_t max_bytes);
+
+  /**
+   * Writes the batches queued for spilling to disk, oldest first. Queued batches that are not
+   * written by the deadline stay queued for the next call.
    */
-  Status CompactHotToCold(arrow::MemoryPool* mem_pool);
+  Status WriteSpilledBatches(std::chrono::steady_clock::time_point deadline);
+  Status WriteSpilledBatches() {
+    return WriteSpilledBatches(std::chrono::steady_clock::time_point::max());
+  }
 
  private:
   TableMetrics metrics_;
@@ -311,8 +377,11 @@ class Table : public NotCopyable {
   int64_t batches_added_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t bytes_added_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t compacted_batches_ ABSL_GUARDED_BY(stats_lock_) = 0;
-  int64_t max_table_size_ = 0;
+  std::atomic<int64_t> max_table_size_ = 0;
+  std::atomic<int64_t> max_batch_bytes_ = 0;
   const int64_t compacted_batch_size_;
+  // Nanoseconds (steady_clock) of the last Cursor creation. Updated from const read paths.
+  mutable std::atomic<int64_t> last_access_ns_ = 0;
   mutable absl::base_internal::SpinLock hot_lock_;
   std::unique_ptr<internal::StoreWithRowTimeAccounting<internal::StoreType::Hot>> hot_store_
       ABSL_GUARDED_BY(hot_lock_);
@@ -322,6 +391,30 @@ class Table : public NotCopyable {
       ABSL_GUARDED_BY(cold_lock_);
   std::deque<int64_t> cold_batch_bytes_ ABSL_GUARDED_BY(cold_lock_);
 
+  // Serializes expiration, which can be triggered by both writers and SetMaxTableSize.
+  absl::Mutex expire_lock_;
+
+  // Held while a compacted batch is built outside of the hot/cold locks, so that the hot batches
+  // being read by the compactor cannot be expired from under it. Lock order is expire_lock_, then
+  // compaction_lock_, then spill_write_lock_, then spill_lock_, then cold_lock_, then hot_lock_.
+  absl::Mutex compaction_lock_;
+  // Set by a writer that has to expire a hot batch, so that an in-progress compaction gives up
+  // after the slice it is appending instead of holding compaction_lock_ until it is done.
+  std::atomic<bool> compaction_cancelled_ = false;
+
+  // Serializes writing queued batches to disk. It is held while a file is written, so it must
+  // never be taken on the ingest path.
+  absl::Mutex spill_write_lock_;
+  // Empty if spilling is disabled.
+  std::filesystem::path spill_dir_ ABSL_GUARDED_BY(spill_write_lock_);
+  int64_t next_spill_file_id_ ABSL_GUARDED_BY(spill_write_lock_) = 0;
+
+  // Readers hold spill_lock_ across their lookups in the spill and cold stores, so that a batch
+  // moving from the cold store to disk is never missed by both lookups. Reading a spilled batch
+  // from disk happens after spill_lock_ is released.
+  mutable absl::Mutex spill_lock_;
+  std::unique_ptr<internal::SpillStore> spill_store_ ABSL_GUARDED_BY(spill_lock_);
+
   // Counter to assign a unique row ID to each row. Synchronized by hot_lock_ since its only
   // accessed on a hot write.
   int64_t next_row_id_ ABSL_GUARDED_BY(hot_lock_) = 0;
@@ -329,19 +422,24 @@ class Table : public NotCopyable {
 
   Status WriteHot(internal::RecordOrRowBatch&& record_or_row_batch);
 
-  Status ExpireBatch();
+  Status ExpireBatch() ABSL_EXCLUSIVE_LOCKS_REQUIRED(expire_lock_);
   Status ExpireHot();
-  StatusOr<bool> ExpireCold();
+  void RecordAccess() const;
+  // Expires the oldest cold batch, queueing it to be written to disk if spilling is enabled.
+  StatusOr<bool> ExpireCold() ABSL_EXCLUSIVE_LOCKS_REQUIRED(expire_lock_);
   Status ExpireRowBatches(int64_t row_batch_size);
-  Status CompactSingleBatchUnlocked(arrow::MemoryPool* mem_pool)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_) ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
+  // Compacts a single cold batch if one is ready. Returns false if there was nothing to compact.
+  StatusOr<bool> CompactSingleBatch(arrow::MemoryPool* mem_pool);
   Status UpdateTableMetricGauges();
+  // Gets the next row batch after the cursor from the cold and hot stores.
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetNextInMemoryRowBatch(
+      Cursor* cursor, const std::vector<int64_t>& cols) const;
 
   Time MaxTime() const;
 
   std::unique_ptr<internal::BatchSizeAccountant> batch_size_accountant_ ABSL_GUARDED_BY(hot_lock_);
 
-  internal::ArrowArrayCompactor compactor_;
+  internal::ArrowArrayCompactor compactor_ ABSL_GUARDED_BY(compaction_lock_);
 
   friend class Cursor;
 };
@@ -20,6 +20,13 @@
 #include <prometheus/counter.h>
 #include <string>
 
+namespace {
+// Buckets (in seconds) for compaction timings, from 10us to ~1s.
+prometheus::Histogram::BucketBoundaries CompactionTimeBuckets() {
+  return {1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 1e-1, 5e-1, 1};
+}
+}  // namespace
+
 TableMetrics::TableMetrics(prometheus::Registry* registry, std::string table_name)
     : bytes_added_counter(prometheus::BuildCounter()
                               .Name("table_bytes_added")
@@ -67,4 +74,21 @@ TableMetrics::TableMetrics(prometheus::Registry* registry, std::string table_nam
                              .Name("min_time")
                              .Help("The current retention window for data in this table")
                              .Register(*registry)
-                             .Add({{"name", table_name}})) {}
+                             .Add({{"name", table_name}})),
+      spilled_bytes_gauge(prometheus::BuildGauge()
+                              .Name("table_spilled_bytes")
+                              .Help("Current bytes of the table's data spilled to disk")
+                              .Register(*registry)
+                              .Add({{"name", table_name}})),
+      compaction_latency_histogram(
+          prometheus::BuildHistogram()
+              .Name("table_compaction_latency_seconds")
+              .Help("Time taken by a call to compact the table's hot batches into cold batches")
+              .Register(*registry)
+              .Add({{"name", table_name}}, CompactionTimeBuckets())),
+      compaction_lock_hold_histogram(
+          prometheus::BuildHistogram()
+              .Name("table_compaction_lock_hold_seconds")
+              .Help("Time the table's locks are held while compacting a single cold batch")
+              .Register(*registry)
+              .Add({{"name", table_name}}, CompactionTimeBuckets())) {}
@@ -17,6 +17,7 @@
  */
 
 #pragma once
+#include <prometheus/histogram.h>
 #include <prometheus/registry.h>
 #include <string>
 
@@ -34,4 +35,7 @@ struct TableMetrics {
   prometheus::Counter& compacted_batches_counter;
   prometheus::Gauge& max_table_size_gauge;
   prometheus::Gauge& retention_ns_gauge;
+  prometheus::Gauge& spilled_bytes_gauge;
+  prometheus::Histogram& compaction_latency_histogram;
+  prometheus::Histogram& compaction_lock_hold_histogram;
 };
@@ -158,12 +158,58 @@ std::vector<uint64_t> TableStore::GetTableIDs() const {
   return ids;
 }
 
-Status TableStore::RunCompaction(arrow::MemoryPool* mem_pool) {
+TableCompaction::TableCompaction(std::vector<std::shared_ptr<Table>> tables,
+                                 const CompactionOptions& options)
+    : tables_(std::move(tables)) {
+  if (options.time_budget != std::chrono::milliseconds::max()) {
+    deadline_ = std::chrono::steady_clock::now() + options.time_budget;
+  }
+}
+
+Status TableCompaction::Compact(arrow::MemoryPool* mem_pool) {
+  for (size_t i = next_table_++; i < tables_.size(); i = next_table_++) {
+    if (std::chrono::steady_clock::now() >= deadline_) {
+      return Status::OK();
+    }
+    PX_RETURN_IF_ERROR(tables_[i]->CompactHotToCold(mem_pool, deadline_));
+    PX_RETURN_IF_ERROR(tables_[i]->WriteSpilledBatches(deadline_));
+  }
+  return Status::OK();
+}
+
+std::shared_ptr<TableCompaction> TableStore::StartCompaction(
+    const CompactionOptions& options) const {
+  std::vector<std::shared_ptr<Table>> tables;
+  tables.reserve(name_to_table_map_.size());
   for (const auto& it : name_to_table_map_) {
-    PX_RETURN_IF_ERROR(it.second->CompactHotToCold(mem_pool));
+    tables.push_back(it.second);
   }
+  return std::make_shared<TableCompaction>(std::move(tables), options);
+}
+
+void TableStore::EnableMemoryGovernor(const MemoryGovernorConfig& config) {
+  memory_governor_ = std::make_unique<MemoryGovernor>(config);
+}
+
+Status TableStore::GovernTable(const std::string& table_name,
+                               std::chrono::nanoseconds min_retention) {
+  if (memory_governor_ == nullptr) {
+    return error::FailedPrecondition("Memory governor is not enabled.");
+  }
+  auto table_iter = name_to_table_map_.find(NameTablet{table_name, kDefaultTablet});
+  if (table_iter == name_to_table_map_.end()) {
+    return error::NotFound("Table $0 does not exist.", table_name);
+  }
+  memory_governor_->AddTable(table_name, table_iter->second, min_retention);
   return Status::OK();
 }
 
+Status TableStore::RebalanceMemory() {
+  if (memory_governor_ == nullptr) {
+    return Status::OK();
+  }
+  return memory_governor_->Rebalance();
+}
+
 }  // namespace table_store
 }  // namespace px
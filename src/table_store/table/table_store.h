@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -31,6 +33,7 @@
 #include "src/shared/types/hash_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/schema/schema.h"
+#include "src/table_store/table/memory_governor.h"
 #include "src/table_store/table/table.h"
 #include "src/table_store/table/tablets_group.h"
 
@@ -67,6 +70,31 @@ struct TableIDTablet {
   types::TabletID tablet_id_;
 };
 
+// CompactionOptions bounds the CPU spent by a single table store compaction.
+struct CompactionOptions {
+  // Wall-clock budget of a single compaction. Tables that still have hot data to compact once the
+  // budget is spent continue on the next compaction.
+  std::chrono::milliseconds time_budget = std::chrono::milliseconds::max();
+};
+
+/**
+ * TableCompaction compacts the hot data of a fixed set of tables into cold batches, and writes the
+ * batches each table queued for spilling to disk (see Table::WriteSpilledBatches). Compact may be
+ * called concurrently from several threads: each call claims tables no other call has claimed
+ * until every table is compacted or the time budget is spent.
+ */
+class TableCompaction {
+ public:
+  TableCompaction(std::vector<std::shared_ptr<Table>> tables, const CompactionOptions& options);
+
+  Status Compact(arrow::MemoryPool* mem_pool);
+
+ private:
+  const std::vector<std::shared_ptr<Table>> tables_;
+  std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
+  std::atomic<size_t> next_table_ = 0;
+};
+
 // TableNameAndRelation contains a string name and a relation for a table.
 struct TableInfo {
   std::string table_name;
@@ -165,7 +193,41 @@ class TableStore {
     return "";
   }
 
-  Status RunCompaction(arrow::MemoryPool* mem_pool);
+  /**
+   * Snapshots the tables currently in the table store into a compaction. Must be called from the
+   * thread that adds tables, but the returned compaction may then run on any thread(s).
+   */
+  std::shared_ptr<TableCompaction> StartCompaction(const CompactionOptions& options) const;
+
+  /**
+   * Compacts the hot data of every table into cold batches on the calling thread, stopping once
+   * options.time_budget is spent.
+   */
+  Status RunCompaction(arrow::MemoryPool* mem_pool, const CompactionOptions& options) {
+    return StartCompaction(options)->Compact(mem_pool);
+  }
+  Status RunCompaction(arrow::MemoryPool* mem_pool) {
+    return RunCompaction(mem_pool, CompactionOptions{});
+  }
+
+  /**
+   * Enables the memory governor, which redistributes the given budget across the tables registered
+   * with GovernTable each time RebalanceMemory is called.
+   */
+  void EnableMemoryGovernor(const MemoryGovernorConfig& config);
+
+  /**
+   * Places the (default tablet of the) table under the control of the memory governor.
+   * @param table_name the name of the table to govern.
+   * @param min_retention the retention the governor tries to guarantee for the table.
+   * @return Error if the governor is not enabled or the table does not exist.
+   */
+  Status GovernTable(const std::string& table_name, std::chrono::nanoseconds min_retention);
+
+  /**
+   * Rebalances the max sizes of the governed tables. This is a no-op if the governor is disabled.
+   */
+  Status RebalanceMemory();
 
  private:
   void RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
@@ -197,6 +259,8 @@ class TableStore {
   absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_;
   // Mapping from id to name and relation pair for adding new tablets.
   absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_;
+  // Optional governor that rebalances table sizes online.
+  std::unique_ptr<MemoryGovernor> memory_governor_;
 };
 
 }  // namespace table_store
@@ -20,6 +20,7 @@
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <thread>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -204,6 +205,53 @@ TEST_F(TableStoreTest, to_proto) {
   EXPECT_TRUE(google::protobuf::util::MessageDifferencer::Equals(actual_schema, expected_schema));
 }
 
+TEST_F(TableStoreTest, parallel_compaction) {
+  auto table_store = TableStore();
+  std::vector<std::shared_ptr<Table>> tables;
+  for (int i = 0; i < 8; ++i) {
+    // Use a small compacted batch size, so that every couple of writes form a cold batch.
+    auto table = std::make_shared<Table>("test_table1", rel1, 1024 * 1024, 32);
+    table_store.AddTable(table, absl::Substitute("table_$0", i));
+    for (int j = 0; j < 10; ++j) {
+      EXPECT_OK(table->TransferRecordBatch(MakeRel1ColumnWrapperBatch()));
+    }
+    tables.push_back(table);
+  }
+
+  auto compaction = table_store.StartCompaction(CompactionOptions{});
+  std::vector<std::thread> workers;
+  for (int i = 0; i < 4; ++i) {
+    workers.emplace_back([&]() { EXPECT_OK(compaction->Compact(arrow::default_memory_pool())); });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (const auto& table : tables) {
+    auto stats = table->GetTableStats();
+    EXPECT_GT(stats.compacted_batches, 0);
+    EXPECT_GT(stats.cold_bytes, 0);
+    EXPECT_EQ(stats.bytes, static_cast<int64_t>(10 * 3 * (sizeof(bool) + sizeof(double))));
+  }
+}
+
+TEST_F(TableStoreTest, compaction_respects_time_budget) {
+  auto table_store = TableStore();
+  auto table = std::make_shared<Table>("test_table1", rel1, 1024 * 1024, 32);
+  table_store.AddTable(table, "a");
+  for (int j = 0; j < 10; ++j) {
+    EXPECT_OK(table->TransferRecordBatch(MakeRel1ColumnWrapperBatch()));
+  }
+
+  CompactionOptions options;
+  options.time_budget = std::chrono::milliseconds(0);
+  EXPECT_OK(table_store.RunCompaction(arrow::default_memory_pool(), options));
+  EXPECT_EQ(0, table->GetTableStats().compacted_batches);
+
+  EXPECT_OK(table_store.RunCompaction(arrow::default_memory_pool()));
+  EXPECT_GT(table->GetTableStats().compacted_batches, 0);
+}
+
 class TableStoreTabletsTest : public TableStoreTest {
  protected:
   void SetUp() override {
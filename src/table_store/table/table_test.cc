@@ -939,6 +939,122 @@ TEST(TableTest, GetNextRowBatch_after_expiry) {
   EXPECT_TRUE(rb1->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, spill_expired_cold_batches_to_disk) {
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::INT64}, {"time_", "col2"});
+  // Rows are 16 bytes, so the table holds two compacted batches of two rows each.
+  Table table("test_table", rel, 64, 32);
+  testing::TempDir tmp_dir;
+  ASSERT_OK(table.EnableDiskSpill(tmp_dir.path() / "test_table", 1024 * 1024));
+
+  auto write_batch = [&](const std::vector<int64_t>& vals) {
+    schema::RowBatch rb(schema::RowDescriptor(rel.col_types()), vals.size());
+    std::vector<types::Time64NSValue> times(vals.begin(), vals.end());
+    std::vector<types::Int64Value> values(vals.begin(), vals.end());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(values, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+    EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+    EXPECT_OK(table.WriteSpilledBatches());
+  };
+  write_batch({1, 2});
+  write_batch({3, 4});
+  // These writes expire the two oldest batches, which are spilled instead of dropped.
+  write_batch({5, 6});
+  write_batch({7, 8});
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(64, stats.bytes);
+  EXPECT_EQ(2, stats.num_spilled_batches);
+  EXPECT_GT(stats.spilled_bytes, 0);
+  EXPECT_EQ(0, stats.pending_spill_bytes);
+  EXPECT_EQ(1, stats.min_time);
+
+  // A scan reads the spilled batches before the in-memory ones.
+  Table::Cursor cursor(&table);
+  std::vector<int64_t> read;
+  while (!cursor.Done()) {
+    ASSERT_OK_AND_ASSIGN(auto rb, cursor.GetNextRowBatch({1}));
+    for (int64_t i = 0; i < rb->num_rows(); ++i) {
+      read.push_back(
+          types::GetValueFromArrowArray<types::DataType::INT64>(rb->ColumnAt(0).get(), i));
+    }
+  }
+  EXPECT_THAT(read, ::testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8));
+
+  // Time lookups find rows in the spilled batches.
+  Table::Cursor time_cursor(
+      &table, Table::Cursor::StartSpec{Table::Cursor::StartSpec::StartAtTime, 4},
+      Table::Cursor::StopSpec{Table::Cursor::StopSpec::StopAtTimeOrEndOfTable, 5});
+  ASSERT_OK_AND_ASSIGN(auto rb, time_cursor.GetNextRowBatch({1}));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(
+      types::ToArrow(std::vector<types::Int64Value>{4}, arrow::default_memory_pool())));
+  ASSERT_OK_AND_ASSIGN(rb, time_cursor.GetNextRowBatch({1}));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(
+      types::ToArrow(std::vector<types::Int64Value>{5}, arrow::default_memory_pool())));
+  EXPECT_TRUE(time_cursor.Done());
+}
+
+TEST(TableTest, expiring_queues_batches_for_spill) {
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::INT64}, {"time_", "col2"});
+  // Rows are 16 bytes, so the table holds two compacted batches of two rows each, and at most
+  // 64 / Table::kMaxPendingSpillFraction bytes wait to be spilled.
+  Table table("test_table", rel, 64, 32);
+  testing::TempDir tmp_dir;
+  ASSERT_OK(table.EnableDiskSpill(tmp_dir.path() / "test_table", 1024 * 1024));
+
+  auto write_batch = [&](const std::vector<int64_t>& vals) {
+    schema::RowBatch rb(schema::RowDescriptor(rel.col_types()), vals.size());
+    std::vector<types::Time64NSValue> times(vals.begin(), vals.end());
+    std::vector<types::Int64Value> values(vals.begin(), vals.end());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(values, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+    EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  };
+  auto read_all = [&]() {
+    Table::Cursor cursor(&table);
+    std::vector<int64_t> read;
+    while (!cursor.Done()) {
+      auto rb_or_s = cursor.GetNextRowBatch({1});
+      EXPECT_OK(rb_or_s);
+      auto rb = rb_or_s.ConsumeValueOrDie();
+      for (int64_t i = 0; i < rb->num_rows(); ++i) {
+        read.push_back(
+            types::GetValueFromArrowArray<types::DataType::INT64>(rb->ColumnAt(0).get(), i));
+      }
+    }
+    return read;
+  };
+  write_batch({1, 2});
+  write_batch({3, 4});
+  // Expiring the oldest batch only queues it, nothing is written to disk yet.
+  write_batch({5, 6});
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(64, stats.bytes);
+  EXPECT_EQ(1, stats.num_spilled_batches);
+  EXPECT_EQ(0, stats.spilled_bytes);
+  int64_t pending_bytes = stats.pending_spill_bytes;
+  EXPECT_GT(pending_bytes, 64 / Table::kMaxPendingSpillFraction);
+  EXPECT_EQ(1, stats.min_time);
+  EXPECT_THAT(read_all(), ::testing::ElementsAre(1, 2, 3, 4, 5, 6));
+
+  // The queue is over its limit once a second batch is expired, so the oldest queued batch is
+  // dropped.
+  write_batch({7, 8});
+  stats = table.GetTableStats();
+  EXPECT_EQ(1, stats.num_spilled_batches);
+  EXPECT_EQ(pending_bytes, stats.pending_spill_bytes);
+  EXPECT_EQ(3, stats.min_time);
+
+  ASSERT_OK(table.WriteSpilledBatches());
+  stats = table.GetTableStats();
+  EXPECT_EQ(1, stats.num_spilled_batches);
+  EXPECT_GT(stats.spilled_bytes, 0);
+  EXPECT_EQ(0, stats.pending_spill_bytes);
+  EXPECT_THAT(read_all(), ::testing::ElementsAre(3, 4, 5, 6, 7, 8));
+}
+
 struct CursorTestCase {
   std::string name;
   std::vector<std::vector<int64_t>> initial_time_batches;
@@ -18,6 +18,8 @@
 
 #include "src/vizier/services/agent/pem/pem_manager.h"
 
+#include <filesystem>
+
 #include "src/common/system/config.h"
 #include "src/vizier/services/agent/shared/manager/exec.h"
 #include "src/vizier/services/agent/shared/manager/manager.h"
@@ -43,6 +45,25 @@ DEFINE_int32(table_store_proc_exit_events_limit_bytes,
              gflags::Int32FromEnv("PL_TABLE_STORE_PROC_EXIT_EVENTS_LIMIT_BYTES", 10 * 1024 * 1024),
              "The maximum amount of data to store in the proc_exit_events table.");
 
+DEFINE_bool(table_store_memory_governor,
+            gflags::BoolFromEnv("PL_TABLE_STORE_MEMORY_GOVERNOR", false),
+            "If true, the table store data limit (minus the fixed-size Stirling error and "
+            "proc_exit_events tables) is rebalanced online across tables based on ingest rate and "
+            "query access, instead of using a static split.");
+
+DEFINE_int32(table_store_min_retention_seconds,
+             gflags::Int32FromEnv("PL_TABLE_STORE_MIN_RETENTION_SECONDS", 60),
+             "The retention the memory governor tries to guarantee for every governed table.");
+
+DEFINE_string(table_store_spill_dir, gflags::StringFromEnv("PL_TABLE_STORE_SPILL_DIR", ""),
+              "If set, data expired from the in-memory tables (other than the fixed-size Stirling "
+              "error and proc_exit_events tables) is spilled to this node-local directory, and "
+              "remains queryable until the spill limit is reached.");
+
+DEFINE_int32(table_store_spill_limit, gflags::Int32FromEnv("PL_TABLE_STORE_SPILL_LIMIT_MB", 4096),
+             "The maximum amount of data to spill to disk, split across tables in proportion to "
+             "their in-memory size. Only used if table_store_spill_dir is set.");
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -66,6 +87,7 @@ Status PEMManager::PostRegisterHookImpl() {
       std::bind(&px::md::AgentMetadataStateManager::CurrentAgentMetadataState, mds_manager()));
 
   PX_RETURN_IF_ERROR(InitSchemas());
+  StartTableStoreMemoryGovernor();
   PX_RETURN_IF_ERROR(stirling_->RunAsThread());
 
   auto execute_query_handler = std::make_shared<ExecuteQueryMessageHandler>(
@@ -102,14 +124,31 @@ Status PEMManager::InitSchemas() {
                               probe_status_table_size - proc_exit_events_table_size) /
                              (num_tables - 4);
 
+  // The data limit of the tables that are neither fixed-size nor reserved for Stirling errors.
+  int64_t shared_table_bytes = memory_limit - stirling_error_table_size - probe_status_table_size -
+                               proc_exit_events_table_size;
+  int64_t spill_limit = int64_t{FLAGS_table_store_spill_limit} * 1024 * 1024;
+  if (FLAGS_table_store_memory_governor) {
+    table_store::MemoryGovernorConfig config;
+    config.total_bytes = shared_table_bytes;
+    if (!FLAGS_table_store_spill_dir.empty()) {
+      // The governor keeps each table's spill limit in proportion to its rebalanced max size.
+      config.total_spill_bytes = spill_limit;
+    }
+    table_store()->EnableMemoryGovernor(config);
+  }
+
   for (const auto& relation_info : relation_info_vec) {
     std::shared_ptr<table_store::Table> table_ptr;
+    // Tables with a fixed budget are never rebalanced by the memory governor.
+    bool fixed_size = true;
     if (relation_info.name == "http_events") {
       // Special case to set the max size of the http_events table differently from the other
       // tables. For now, the min cold batch size is set to 256kB to be consistent with previous
       // behaviour.
       table_ptr = std::make_shared<table_store::Table>(relation_info.name, relation_info.relation,
                                                        http_table_size, 256 * 1024);
+      fixed_size = false;
     } else if (relation_info.name == "stirling_error") {
       table_ptr = std::make_shared<table_store::Table>(relation_info.name, relation_info.relation,
                                                        stirling_error_table_size);
@@ -122,9 +161,23 @@ Status PEMManager::InitSchemas() {
     } else {
       table_ptr = std::make_shared<table_store::Table>(relation_info.name, relation_info.relation,
                                                        other_table_size);
+      fixed_size = false;
+    }
+
+    if (!fixed_size && !FLAGS_table_store_spill_dir.empty()) {
+      int64_t table_spill_limit = static_cast<int64_t>(
+          static_cast<double>(spill_limit) * table_ptr->GetTableStats().max_table_size /
+          shared_table_bytes);
+      PX_RETURN_IF_ERROR(table_ptr->EnableDiskSpill(
+          std::filesystem::path(FLAGS_table_store_spill_dir) / relation_info.name,
+          table_spill_limit));
     }
 
     table_store()->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
+    if (FLAGS_table_store_memory_governor && !fixed_size) {
+      PX_RETURN_IF_ERROR(table_store()->GovernTable(
+          relation_info.name, std::chrono::seconds(FLAGS_table_store_min_retention_seconds)));
+    }
     PX_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(relation_info));
   }
   return Status::OK();
@@ -143,6 +196,20 @@ Status PEMManager::InitClockConverters() {
   return Status::OK();
 }
 
+void PEMManager::StartTableStoreMemoryGovernor() {
+  if (!FLAGS_table_store_memory_governor) {
+    return;
+  }
+  table_store_governor_timer_ = dispatcher()->CreateTimer([this]() {
+    auto s = table_store()->RebalanceMemory();
+    LOG_IF(ERROR, !s.ok()) << "Failed to rebalance table store memory: " << s.msg();
+    if (table_store_governor_timer_) {
+      table_store_governor_timer_->EnableTimer(kTableStoreRebalancePeriod);
+    }
+  });
+  table_store_governor_timer_->EnableTimer(kTableStoreRebalancePeriod);
+}
+
 void PEMManager::StartNodeMemoryCollector() {
   node_memory_timer_ = dispatcher()->CreateTimer([this]() {
     px::system::ProcParser proc_parser;
@@ -37,6 +37,7 @@ namespace vizier {
 namespace agent {
 
 constexpr auto kNodeMemoryCollectionPeriod = std::chrono::minutes(1);
+constexpr auto kTableStoreRebalancePeriod = std::chrono::seconds(30);
 
 class PEMManager : public Manager {
  public:
@@ -85,6 +86,7 @@ class PEMManager : public Manager {
   Status InitSchemas();
   Status InitClockConverters();
   void StartNodeMemoryCollector();
+  void StartTableStoreMemoryGovernor();
   static services::shared::agent::AgentCapabilities Capabilities() {
     services::shared::agent::AgentCapabilities capabilities;
     capabilities.set_collects_data(true);
@@ -105,6 +107,8 @@ class PEMManager : public Manager {
   px::event::TimerUPtr clock_converter_timer_;
   // Timer for collecting info about the node's available memory.
   px::event::TimerUPtr node_memory_timer_;
+  // Timer for rebalancing table sizes with the table store memory governor.
+  px::event::TimerUPtr table_store_governor_timer_;
   prometheus::Gauge& node_available_memory_;
   prometheus::Gauge& node_total_memory_;
 };
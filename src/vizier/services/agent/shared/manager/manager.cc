@@ -20,6 +20,7 @@
 
 #include <limits.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <random>
@@ -44,6 +45,16 @@
 #include "src/vizier/services/agent/shared/manager/ssl.h"
 #include "src/vizier/services/metadata/metadatapb/service.grpc.pb.h"
 
+DEFINE_int32(table_store_compaction_threads,
+             gflags::Int32FromEnv("PL_TABLE_STORE_COMPACTION_THREADS", 2),
+             "The number of dedicated threads that compact the table store, which is the maximum "
+             "number of tables compacted concurrently.");
+
+DEFINE_int32(table_store_compaction_time_budget_ms,
+             gflags::Int32FromEnv("PL_TABLE_STORE_COMPACTION_TIME_BUDGET_MS", 10 * 1000),
+             "The wall-clock budget of a single table store compaction run. Data left over is "
+             "compacted on the next run.");
+
 namespace {
 
 px::StatusOr<std::string> GetHostname() {
@@ -186,6 +197,15 @@ Status Manager::Run() {
   return Status::OK();
 }
 
+Manager::~Manager() { JoinTableStoreCompactionThreads(); }
+
+void Manager::JoinTableStoreCompactionThreads() {
+  for (auto& thread : tablestore_compaction_threads_) {
+    thread.join();
+  }
+  tablestore_compaction_threads_.clear();
+}
+
 Status Manager::Stop(std::chrono::milliseconds timeout) {
   // Already stopping, protect against multiple calls.
   if (stop_called_) {
@@ -325,13 +345,30 @@ Status Manager::PostRegisterHook(uint32_t asid) {
   PX_RETURN_IF_ERROR(metrics_nats_connector_->Connect(dispatcher_.get()));
 
   tablestore_compaction_timer_ = dispatcher()->CreateTimer([this]() {
-    // TODO(james): when we change ExecState::exec_mem_pool to not return just the default pool, we
-    // will need to figure out how to use the correct memory pool here, but for now we can just use
-    // the default pool.
-    auto status = table_store()->RunCompaction(arrow::default_memory_pool());
-    LOG_IF(ERROR, !status.ok()) << status.msg();
-    if (tablestore_compaction_timer_) {
-      tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
+    // The tables are snapshotted here, on the event loop that adds them, before the compaction is
+    // handed to the compaction threads. The timer is re-armed once every thread is done, so runs
+    // never overlap.
+    px::table_store::CompactionOptions options;
+    options.time_budget = std::chrono::milliseconds(FLAGS_table_store_compaction_time_budget_ms);
+    auto compaction = table_store()->StartCompaction(options);
+    tablestore_compaction_threads_running_ = std::max(FLAGS_table_store_compaction_threads, 1);
+    for (size_t i = 0; i < tablestore_compaction_threads_running_; ++i) {
+      tablestore_compaction_threads_.emplace_back([this, compaction]() {
+        // TODO(james): when we change ExecState::exec_mem_pool to not return just the default
+        // pool, we will need to figure out how to use the correct memory pool here, but for now we
+        // can just use the default pool.
+        auto status = compaction->Compact(arrow::default_memory_pool());
+        LOG_IF(ERROR, !status.ok()) << status.msg();
+        dispatcher()->Post([this]() {
+          if (--tablestore_compaction_threads_running_ > 0) {
+            return;
+          }
+          JoinTableStoreCompactionThreads();
+          if (tablestore_compaction_timer_) {
+            tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
+          }
+        });
+      });
     }
   });
   tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
@@ -24,6 +24,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "src/carnot/carnot.h"
 #include "src/common/base/base.h"
@@ -94,7 +95,7 @@ class Manager : public BaseManager {
   using ResultSinkStub = px::carnotpb::ResultSinkService::StubInterface;
 
   Manager() = delete;
-  virtual ~Manager() = default;
+  virtual ~Manager();
 
   // Forward decleration to prevent circular dependency on MessageHandler.
   class MessageHandler;
@@ -152,6 +153,8 @@ class Manager : public BaseManager {
                                                           const std::string& ssl_targetname);
   void NATSMessageHandler(VizierNATSConnector::MsgType msg);
   Status RegisterBackgroundHelpers();
+  // Waits for the threads of the last table store compaction to exit.
+  void JoinTableStoreCompactionThreads();
   Status PostRegisterHook(uint32_t asid);
   Status ReregisterHook();
   Status PostReregisterHook(uint32_t asid);
@@ -212,6 +215,10 @@ class Manager : public BaseManager {
 
   // Timer to manage table store compaction.
   px::event::TimerUPtr tablestore_compaction_timer_;
+  // The threads of the in-flight table store compaction. Compaction gets its own threads rather
+  // than the dispatcher's threadpool, which query execution shares.
+  std::vector<std::thread> tablestore_compaction_threads_;
+  size_t tablestore_compaction_threads_running_ = 0;
 
   px::metrics::MemoryMetrics memory_metrics_;
   // Timer to collect MemoryMetrics for this agent.
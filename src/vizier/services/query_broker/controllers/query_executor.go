@@ -378,6 +378,7 @@ func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vi
 
 func (q *QueryExecutorImpl) buildAgentPlanMap(plan *distributedpb.DistributedPlan) (map[uuid.UUID]*planpb.Plan, error) {
 	planMap := make(map[uuid.UUID]*planpb.Plan)
+	numPEMs := 0
 
 	for carnotID, agentPlan := range plan.QbAddressToPlan {
 		u, err := uuid.FromString(carnotID)
@@ -386,10 +387,13 @@ func (q *QueryExecutorImpl) buildAgentPlanMap(plan *distributedpb.DistributedPla
 			return planMap, err
 		}
 		planMap[u] = agentPlan
+		// The PEMs are the only agents that don't receive data from other agents. Every Kelvin plan,
+		// including the ones that run a partition of the query, has incoming agents.
+		if len(agentPlan.IncomingAgentIDs) == 0 {
+			numPEMs++
+		}
 	}
-	// Plan map includes an entry for Kelvin, so the number of pems queried should be 1 less than the number of plans.
-	// TODO(james): update this to support multiple Kelvin plans.
-	q.numPEMsQueried = len(planMap) - 1
+	q.numPEMsQueried = numPEMs
 	return planMap, nil
 }
 